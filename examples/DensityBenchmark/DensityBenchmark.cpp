@@ -0,0 +1,138 @@
+/**
+ * @file        DensityBenchmark.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        17 October 2026
+ *
+ * @brief       Example benchmarking the geometry shader and the vertex pulling paths
+ *              of density rendering.
+ *
+ * @example     DensityBenchmark.cpp
+ *
+ * This example renders the same density images by the geometry shader path and by the vertex
+ * pulling path and compares GPU times of both paths measured by the pass timers of the renderer.
+ * The vertex pulling path precomputes inverse matrices of tetrahedra after every change of shape,
+ * so both the case with fixed shape and the case with shape changed every frame are measured.
+ * Average cache miss ratios of triangles before and after ordering for post-transform vertex
+ * cache are reported as well.
+ * Other models (e.g. with 500k tetrahedra) can be given on the command line:
+ *
+ *     DensityBenchmark [mesh.mesh shape.mat density.mat [frames]]
+ *
+ * For further details about loading the models please have a look at the example
+ * called "DensityImage".
+ */
+
+#include <QApplication>
+#include <QDebug>
+#include <ssimrenderer.h>
+
+/**
+ * @brief Renders frames and prints GPU times of density passes
+ * @param renderer Renderer with loaded models
+ * @param shapeFile Shape model
+ * @param frames Number of rendered frames
+ * @param changeShape Change shape before every frame?
+ */
+void benchmark(SSIMRenderer::OffscreenRenderer *renderer, SSIMRenderer::MatStatisticalDataFile *shapeFile, int frames, bool changeShape)
+{
+    // Warm up - programs are built and data are recomputed on the first use.
+    renderer->renderNow();
+    renderer->resetPassTimers();
+
+    for (int i = 0; i < frames; i++) {
+        if (changeShape) {
+            shapeFile->updatePcsMatrix(0, (i % 2) ? 500 : -500);
+            renderer->updateVertices(shapeFile);
+        }
+        renderer->renderNow();
+    }
+
+    // Inverse matrices are recomputed only by the vertex pulling path.
+    QStringList passes;
+    passes << "recomputePositions" << "recomputeTetrahedraInverse" << "renderDensity";
+    foreach (const QString &pass, passes) {
+        SSIMRenderer::PassTimer::Stats stats = renderer->getPassTimerStats(pass);
+        if (stats.count == 0)
+            continue;
+        qDebug() << "   " << pass.toLatin1().constData() << "mean" << stats.mean << "ms, p95" << stats.p95 << "ms," << stats.count << "samples";
+    }
+}
+
+/**
+ * @brief Main function
+ * @param argc An integer argument count of the command line arguments
+ * @param argv An argument vector of the command line arguments
+ * @return An integer 0 upon exit success
+ */
+int main(int argc, char *argv[])
+{
+    // Initialization of Qt-based application, QCoreApplication is not sufficient.
+    QApplication a(argc, argv);
+    Q_UNUSED(a);
+
+    // Initialization of the offscreen renderer.
+    SSIMRenderer::OffscreenRenderer *renderer = new SSIMRenderer::OffscreenRenderer(1024, 1024);
+
+    SSIMRenderer::Lm6MeshFile *meshFile = NULL;
+    SSIMRenderer::MatStatisticalDataFile *shapeFile   = NULL;
+    SSIMRenderer::MatStatisticalDataFile *densityFile = NULL;
+
+    int frames = argc > 4 ? QString(argv[4]).toInt() : 100;
+
+    try {
+        // Loads the models, the default models are used without arguments.
+        meshFile    = new SSIMRenderer::Lm6MeshFile(argc > 3 ? argv[1] : DATA_PATH "/model.mesh");
+        shapeFile   = new SSIMRenderer::MatStatisticalDataFile(argc > 3 ? argv[2] : DATA_PATH "/shape.mat");
+        densityFile = new SSIMRenderer::MatStatisticalDataFile(argc > 3 ? argv[3] : DATA_PATH "/density.b3.mat");
+
+    } catch (std::exception &e) {
+        // Wrong file
+        qFatal(e.what());
+        exit(EXIT_FAILURE);
+    }
+
+    // Sets the tetrahedral and statistical models to the renderer.
+    renderer->setMesh(meshFile);
+    renderer->setVertices(shapeFile);
+    renderer->setCoefficients(densityFile);
+
+    // Only density is rendered and measured.
+    renderer->enableSilhouettes(false);
+    renderer->enableDensity(true);
+    renderer->enablePostprocessing(false);
+    renderer->enablePyramid(false);
+    renderer->enablePolygonal(false);
+    renderer->enablePassTimers(true);
+
+    // The same perspective and pose as in the "DensityImage" example.
+    QVector3D eye(        102.8380004f,  551.2176983f, -430.5f);
+    QVector3D leftTop(   -408.6619996f, -448.7823017f, -942.f);
+    QVector3D leftBottom(-408.6619996f, -448.7823017f,   81.f);
+    QVector3D rightTop(   614.3380004f, -448.7823017f, -942.f);
+    QVector3D rightBottom(614.3380004f, -448.7823017f,   81.f);
+    renderer->setPerspective(leftTop, leftBottom, rightTop, rightBottom, eye);
+    renderer->setRotation(1.4756f, 3.0457f, 30.784f);
+    renderer->setTranslation(111.81f, 47.057f, -437.07f);
+
+    qDebug() << "Number of tetrahedra:" << meshFile->getNumberOfTetrahedra() << ", frames:" << frames;
+
+    // Triangles are ordered for post-transform vertex cache when the mesh is set.
+    qDebug() << "Triangles ACMR:" << renderer->getTrianglesACMR(false, false) << "->" << renderer->getTrianglesACMR(false, true);
+    qDebug() << "Triangles adjacency ACMR:" << renderer->getTrianglesACMR(true, false) << "->" << renderer->getTrianglesACMR(true, true);
+
+    for (int pulling = 0; pulling < 2; pulling++) {
+        renderer->enableDensityVertexPulling(pulling);
+        for (int changeShape = 0; changeShape < 2; changeShape++) {
+            qDebug() << (pulling ? "Vertex pulling path" : "Geometry shader path") << (changeShape ? "(shape changed every frame):" : "(fixed shape):");
+            benchmark(renderer, shapeFile, frames, changeShape);
+        }
+    }
+
+    delete densityFile;
+    delete shapeFile;
+    delete meshFile;
+    delete renderer;
+
+    return EXIT_SUCCESS;
+}
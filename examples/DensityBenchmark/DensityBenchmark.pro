@@ -0,0 +1,11 @@
+#-------------------------------------------------
+#
+# Qt project file
+#
+# SSIMRenderer DensityBenchmark example
+#
+#-------------------------------------------------
+
+include($$PWD/../example.pri)
+TARGET = DensityBenchmark
+SOURCES += DensityBenchmark.cpp
@@ -70,6 +70,12 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
+    // Reorders the models along a space-filling curve for better GPU cache locality.
+    // Recomputed vertices are still returned in the original order.
+    meshFile->reorderSpatially();
+    shapeFile->reorderRows(meshFile->getVertexOrder());
+    densityFile->reorderRows(meshFile->getTetrahedronOrder());
+
     // Sets the tetrahedral and statistical models to the renderer.
     renderer->setMesh(meshFile);
     renderer->setVertices(shapeFile);
@@ -82,6 +88,9 @@ int main(int argc, char *argv[])
     renderer->enablePyramid(true);
     renderer->enablePolygonal(false);
 
+    // Skips clusters of tetrahedra outside of the rendered window.
+    renderer->enableDensityCulling(true);
+
     // Initialization of the perspective.
     QVector3D eye(        102.8380004f,  551.2176983f, -430.5f);
     QVector3D leftTop(   -408.6619996f, -448.7823017f, -942.f);
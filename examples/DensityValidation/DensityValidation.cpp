@@ -0,0 +1,127 @@
+/**
+ * @file        DensityValidation.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        17 October 2026
+ *
+ * @brief       Example validating density images rendered by OpenGL against the CPU renderer.
+ *
+ * @example     DensityValidation.cpp
+ *
+ * This example renders the same density image by the OpenGL renderer and by the multithreaded
+ * CPU renderer (DensityRendererCPU) and compares them. The CPU renderer uses the final matrix
+ * of the OpenGL density pass (getDensityMatrix()) and the size of the crop window, so both
+ * images have the same pixels. The example returns a nonzero exit code if the relative error
+ * exceeds DensityRendererCPU::DENSITY_TOLERANCE, so it can validate OpenGL output in CI.
+ * For further details about loading the models please have a look at the example
+ * called "DensityImage".
+ */
+
+#include <QApplication>
+#include <QDebug>
+#include <ssimrenderer.h>
+
+/**
+ * @brief Main function
+ * @param argc An integer argument count of the command line arguments
+ * @param argv An argument vector of the command line arguments
+ * @return An integer 0 upon exit success, 1 if images differ
+ */
+int main(int argc, char *argv[])
+{
+    // Initialization of Qt-based application, QCoreApplication is not sufficient.
+    QApplication a(argc, argv);
+    Q_UNUSED(a);
+
+    // Initialization of the offscreen renderer.
+    SSIMRenderer::OffscreenRenderer *renderer = new SSIMRenderer::OffscreenRenderer(1024, 1024);
+
+    SSIMRenderer::Lm6MeshFile *meshFile = NULL;
+    SSIMRenderer::MatStatisticalDataFile *shapeFile   = NULL;
+    SSIMRenderer::MatStatisticalDataFile *densityFile = NULL;
+
+    try {
+        // Loads the shape, density and tetrahedral models.
+        shapeFile   = new SSIMRenderer::MatStatisticalDataFile(DATA_PATH "/shape.mat");
+        densityFile = new SSIMRenderer::MatStatisticalDataFile(DATA_PATH "/density.b3.mat");
+        meshFile    = new SSIMRenderer::Lm6MeshFile(DATA_PATH "/model.mesh");
+
+    } catch (std::exception &e) {
+        // Wrong file
+        qFatal(e.what());
+        exit(EXIT_FAILURE);
+    }
+
+    // Some particular shape and density parameters.
+    shapeFile->updatePcsMatrix(0,  500);
+    shapeFile->updatePcsMatrix(1, -500);
+    shapeFile->updatePcsMatrix(2,  250);
+    densityFile->updatePcsMatrix(0, -98299);
+    densityFile->updatePcsMatrix(1, 73185);
+
+    // Sets the tetrahedral and statistical models to the OpenGL renderer.
+    renderer->setMesh(meshFile);
+    renderer->setVertices(shapeFile);
+    renderer->setCoefficients(densityFile);
+
+    // Only density is rendered, the tolerance is stated for 32-bit float density.
+    renderer->enableSilhouettes(false);
+    renderer->enableDensity(true);
+    renderer->enablePostprocessing(false);
+    renderer->enablePyramid(false);
+    renderer->enablePolygonal(false);
+    renderer->setDensityFormat(GL_RGBA32F);
+
+    // The same perspective and pose as in the "DensityImage" example.
+    QVector3D eye(        102.8380004f,  551.2176983f, -430.5f);
+    QVector3D leftTop(   -408.6619996f, -448.7823017f, -942.f);
+    QVector3D leftBottom(-408.6619996f, -448.7823017f,   81.f);
+    QVector3D rightTop(   614.3380004f, -448.7823017f, -942.f);
+    QVector3D rightBottom(614.3380004f, -448.7823017f,   81.f);
+    renderer->setPerspective(leftTop, leftBottom, rightTop, rightBottom, eye);
+    renderer->setRotation(1.4756f, 3.0457f, 30.784f);
+    renderer->setTranslation(111.81f, 47.057f, -437.07f);
+
+    // The CPU renderer gets the same models.
+    SSIMRenderer::DensityRendererCPU *rendererCPU = new SSIMRenderer::DensityRendererCPU(1024, 1024);
+    rendererCPU->setMesh(meshFile);
+    rendererCPU->setVertices(shapeFile);
+    rendererCPU->setCoefficients(densityFile);
+
+    // The whole image and a crop window (sub-frustum) are compared.
+    QList<QRect> cropWindows;
+    cropWindows << QRect(0, 0, 1024, 1024) << QRect(300, 200, 256, 384);
+
+    bool passed = true;
+    foreach (const QRect &cropWindow, cropWindows) {
+        renderer->setCropWindow(cropWindow);
+        renderer->renderNow();
+
+        long size = long(renderer->getCropWidth()) * renderer->getCropHeight();
+        QVector<float> densityOpenGL(size);
+        QVector<float> densityCPU(size);
+        renderer->getCurrentDensityData(densityOpenGL.data(), size);
+
+        rendererCPU->setRenderSize(renderer->getCropWidth(), renderer->getCropHeight());
+        rendererCPU->setMatrix(renderer->getDensityMatrix());
+        rendererCPU->enableXMirroring(renderer->isXMirroringEnabled());
+        rendererCPU->renderNow();
+        rendererCPU->getCurrentDensityData(densityCPU.data(), size);
+
+        float error = SSIMRenderer::DensityRendererCPU::getDensityError(densityOpenGL.constData(), densityCPU.constData(), size);
+        bool ok = error >= 0 && error <= SSIMRenderer::DensityRendererCPU::DENSITY_TOLERANCE;
+        passed = passed && ok;
+
+        qDebug() << "Crop window" << cropWindow << "relative error" << error
+                 << "tolerance" << SSIMRenderer::DensityRendererCPU::DENSITY_TOLERANCE
+                 << (ok ? "passed" : "FAILED");
+    }
+
+    delete rendererCPU;
+    delete densityFile;
+    delete shapeFile;
+    delete meshFile;
+    delete renderer;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
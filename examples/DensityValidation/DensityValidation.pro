@@ -0,0 +1,11 @@
+#-------------------------------------------------
+#
+# Qt project file
+#
+# SSIMRenderer DensityValidation example
+#
+#-------------------------------------------------
+
+include($$PWD/../example.pri)
+TARGET = DensityValidation
+SOURCES += DensityValidation.cpp
@@ -12,6 +12,8 @@ SUBDIRS += \
     SimpleStatismoModel \
     IntensityShapeModel \
     ImageMetrics \
-    DensityImage
+    DensityImage \
+    DensityBenchmark \
+    DensityValidation
 
 CONFIG += ordered
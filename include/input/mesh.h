@@ -68,6 +68,9 @@ public:
     // Returns tetrahedra data
     unsigned int *getTableOfTetrahedra() const;
 
+    // Returns tetrahedra face adjacency (generated)
+    QVector<int> getTetrahedraAdjacency() const;
+
     // Returns number of vertices
     long getNumberOfVertices() const;
 
@@ -80,6 +83,16 @@ public:
     // Returns number of tetrahedra
     long getNumberOfTetrahedra() const;
 
+    // Reorders tetrahedra, vertices and triangles along Morton curve for cache locality
+    void reorderSpatially();
+
+    // Returns original index of every vertex and tetrahedron (empty if mesh is not reordered)
+    const QVector<unsigned int> &getVertexOrder() const;
+    const QVector<unsigned int> &getTetrahedronOrder() const;
+
+    // Restores original order of vertex data with given number of components
+    void restoreVertexOrder(float *data, int components = 3) const;
+
 protected:
     // Generates triangles adjacency data
     void generateTableOfTrianglesAdjacency();
@@ -120,11 +133,18 @@ protected:
     /// Tetrahedra data
     unsigned int *tableOfTetrahedra;
 
+    /// Original indices of reordered vertices
+    QVector<unsigned int> vertexOrder;
+
+    /// Original indices of reordered tetrahedra
+    QVector<unsigned int> tetrahedronOrder;
+
     /// Size of one vertex
     const unsigned int VERTEX_SIZE = 3;
 
 private:
     QVector3D getVectorOfTrianglePoint(long triangleIndex, int index) const;
+    quint64 getMortonCode(const QVector3D &point) const;
     void assign(const Mesh &mesh, bool deleteFlag);
 };
 }
@@ -0,0 +1,78 @@
+/**
+ * @file        shapereconstructioncpu.h
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The header file with ShapeReconstructionCPU class declaration.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef SSIMR_SHAPERECONSTRUCTIONCPU_H
+#define SSIMR_SHAPERECONSTRUCTIONCPU_H
+
+#include "../ssimrenderer_global.h"
+
+#include "statisticaldata.h"
+
+#include <QMatrix4x4>
+#include <QDebug>
+
+#include <functional>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief The ShapeReconstructionCPU class represents multithreaded CPU reconstruction of shape (mean + T * pcs)
+ *
+ * No OpenGL context is needed.
+ */
+class SHARED_EXPORT ShapeReconstructionCPU
+{
+public:
+    // Creates ShapeReconstructionCPU with number of threads (0 = number of CPU cores)
+    ShapeReconstructionCPU(int numberOfThreads = 0);
+
+    // Destructor of ShapeReconstructionCPU object
+    virtual ~ShapeReconstructionCPU();
+
+    // Number of used threads
+    void setNumberOfThreads(int value);
+    int getNumberOfThreads() const;
+
+    // Computes mean + T * pcs to caller-owned array
+    long reconstruct(const StatisticalData *statisticalData, float *output, long size, const float *pcs = 0) const;
+
+    // Computes vertices with optional x mirroring and affine transformation to caller-owned array
+    long reconstructVertices(const StatisticalData *statisticalData, float *vertices, long size, bool xMirroring = false, const QMatrix4x4 *transformation = 0, const float *pcs = 0) const;
+
+    // Batched affine transformation of vertices
+    void transform(float *vertices, long numberOfVertices, const QMatrix4x4 &transformation, bool xMirroring = false) const;
+
+private:
+    // Block sizes of GEMV (rows, columns) and minimal work of one thread
+    static const long ROW_BLOCK = 256;
+    static const int COLUMN_BLOCK = 1024;
+    static const long MIN_THREAD_WORK = 1 << 16;
+
+    void parallelFor(long count, long grain, long work, const std::function<void(long, long)> &function) const;
+    void gemv(const float *t, const float *mean, const float *pcs, int numberOfParameters, float *output, long begin, long end) const;
+    void transformRange(float *vertices, long begin, long end, const float *matrix, bool xMirroring) const;
+    static float dot(const float *a, const float *b, int n);
+
+    int numberOfThreads;
+
+    Q_DISABLE_COPY(ShapeReconstructionCPU)
+};
+}
+
+#endif // SSIMR_SHAPERECONSTRUCTIONCPU_H
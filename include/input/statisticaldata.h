@@ -23,6 +23,7 @@
 #include "../ssimrenderer_global.h"
 
 #include <QObject>
+#include <QVector>
 #include <QDebug>
 
 namespace SSIMRenderer
@@ -59,6 +60,9 @@ public:
     int getNumberOfParameters() const;
     long getNumberOfRows() const;
 
+    // Reorders blocks of rows by original indices of elements (Mesh::getVertexOrder, Mesh::getTetrahedronOrder)
+    bool reorderRows(const QVector<unsigned int> &order);
+
     // Matrix names
     static const QString T;
     static const QString MEAN;
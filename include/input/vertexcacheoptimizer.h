@@ -0,0 +1,69 @@
+/**
+ * @file        vertexcacheoptimizer.h
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        17 October 2026
+ *
+ * @brief       The header file with VertexCacheOptimizer class declaration.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef SSIMR_VERTEXCACHEOPTIMIZER_H
+#define SSIMR_VERTEXCACHEOPTIMIZER_H
+
+#include "../ssimrenderer_global.h"
+
+#include <QVector>
+#include <QDebug>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief The VertexCacheOptimizer class represents ordering of primitives for post-transform vertex cache
+ *
+ * Primitives are ordered by Tipsify algorithm (Sander et al., Fast Triangle Reordering for Vertex
+ * Locality and Reduced Overdraw, 2007). Primitives have 3 (triangles) or 6 (triangles adjacency)
+ * indices, all indices of primitive are fetched by vertex shader, layout of primitive is kept.
+ */
+class SHARED_EXPORT VertexCacheOptimizer
+{
+public:
+    // Creates VertexCacheOptimizer with size of simulated FIFO vertex cache
+    VertexCacheOptimizer(int cacheSize = DEFAULT_CACHE_SIZE);
+
+    // Destructor of VertexCacheOptimizer object
+    virtual ~VertexCacheOptimizer();
+
+    // Size of simulated vertex cache
+    void setCacheSize(int value);
+    int getCacheSize() const;
+
+    // Returns order of primitives (original index for every new position)
+    QVector<unsigned int> optimize(const unsigned int *indices, long numberOfPrimitives, int primitiveSize, long numberOfVertices) const;
+
+    // Reorders primitives in place by order
+    static void reorder(unsigned int *indices, int primitiveSize, const QVector<unsigned int> &order);
+
+    // Average cache miss ratio (transformed vertices per primitive) with FIFO cache
+    double getACMR(const unsigned int *indices, long numberOfPrimitives, int primitiveSize, long numberOfVertices) const;
+
+    // Default cache size
+    static const int DEFAULT_CACHE_SIZE = 32;
+
+private:
+    int cacheSize;
+
+    Q_DISABLE_COPY(VertexCacheOptimizer)
+};
+}
+
+#endif // SSIMR_VERTEXCACHEOPTIMIZER_H
@@ -28,10 +28,13 @@
 #include <QOpenGLDebugLogger>
 #include <QWindow>
 #include <QOffscreenSurface>
+#include <QGuiApplication>
 #include <QElapsedTimer>
 
 namespace SSIMRenderer
 {
+class ProgramBinaryCache;
+
 // Set OpenGL version and profile
 /// OpenGL major version
 static const unsigned int OPENGL_MAJOR = 3;
@@ -45,12 +48,24 @@ static const QSurfaceFormat::OpenGLContextProfile OPENGL_PROFILE = QSurfaceForma
 /// Qt OpenGL functions selection (QOpenGLFunctions_3_3_Core)
 typedef QOpenGLFunctions_3_3_Core OPENGL_FUNCTIONS;
 
+#ifndef Q_OS_WIN
+/// Native WGL handles are used only for OpenCL sharing on Windows
+typedef void *HGLRC;
+typedef void *HDC;
+#endif
+
 /**
  * @brief The OpenGLWrapper class represents the wrapper for OpenGL
  */
 class SHARED_EXPORT OpenGLWrapper : public OPENGL_FUNCTIONS
 {
 public:
+    // OpenGL context backends
+    enum ContextBackend {
+        CONTEXT_BACKEND_QT,     // Platform plugin of application (Windows, X11, Wayland)
+        CONTEXT_BACKEND_EGL     // Headless EGL (surfaceless or pbuffer), no display server
+    };
+
     // Creates a OpenGLWrapper object with surface and optional parental OpenGLWrapper
     OpenGLWrapper(QSurface *surface, OpenGLWrapper *parentOpenGLWrapper = 0);
 
@@ -60,9 +75,17 @@ public:
     // Main render function
     virtual int renderNow() final;
 
+    // Non-blocking render function, frame is finished by fence
+    virtual GLsync renderNowAsync() final;
+    virtual bool isFrameReady() final;
+    virtual int waitForFrame() final;
+
     // Is used shared context?
     virtual bool hasSharedContext() final;
 
+    // Can OpenGL context be created? False without QGuiApplication, calls are skipped then
+    virtual bool isValid() const final;
+
     // Is surface class QSurface::Window?
     virtual bool isWindow() final;
 
@@ -90,6 +113,14 @@ public:
     // Returns HDC - handle to the device context
     virtual HDC getHDC() const final;
 
+    // Directory of on-disk program binary cache (empty disables cache, set before initialization)
+    virtual void setProgramBinaryCacheDirectory(const QString &directory) final;
+    virtual QString getProgramBinaryCacheDirectory() const final;
+
+    // Context backend selection (call before application and first OpenGLWrapper are created)
+    static void setContextBackend(ContextBackend backend);
+    static ContextBackend getContextBackend();
+
 protected:
     /// Pure virtual render function
     virtual void render() = 0;
@@ -98,18 +129,22 @@ protected:
     virtual void initialize() = 0;
 
     // Checks initialization of OpenGL context and makes context current
-    virtual void checkInitAndMakeCurrentContext() final;
+    virtual bool checkInitAndMakeCurrentContext() final;
 
     // Get GL error strings
     virtual QString getGLErrorString(GLenum errorCode) const final;
     virtual QString getGLFramebufferStatusString(GLenum errorCode) const final;
 
     // Helper functions for creating and linking shaders
-    virtual void addShader(QOpenGLShaderProgram *program, QOpenGLShader::ShaderType type, QString filename) final;
+    virtual void addShader(QOpenGLShaderProgram *program, QOpenGLShader::ShaderType type, QString filename, QString defines = QString()) final;
     virtual void addShaderFromSource(QOpenGLShaderProgram *program, QOpenGLShader *shader, QString source) final;
-    virtual void linkProgram(QOpenGLShaderProgram *program) final;
+    virtual void removeShader(QOpenGLShaderProgram *program, QOpenGLShader *shader) final;
+    virtual void linkProgram(QOpenGLShaderProgram *program, int degree = -1) final;
 
 private:
+    static void selectDefaultContextBackend();
+    static void setEGLPlatformEnvironment();
+    static bool checkApplication();
     void initSurface(QSurface *surface);
     void createContext();
     bool isOpenGLVersionSupported();
@@ -117,6 +152,8 @@ private:
     bool hasDebugExtension();
     void qSleep(int ms);
     static void messageLogged(const QOpenGLDebugMessage &message);
+    bool isProgramDeferred(QOpenGLShaderProgram *program);
+    void addDeferredShaderSource(QOpenGLShaderProgram *program, QOpenGLShader::ShaderType type, QString source);
 
     QOpenGLContext *context;
     QSurface *activeSurface;
@@ -126,8 +163,17 @@ private:
     OpenGLWrapper *parentOpenGLWrapper;
     QList<OpenGLWrapper *> childOpenGLWrappers;
     bool initialized;
+    bool valid;
     int lastRenderTime;
     float lastRenderTimeDouble;
+    GLsync frameFence;
+    GLuint frameQueries[2];
+    QString programBinaryCacheDirectory;
+    ProgramBinaryCache *programBinaryCache;
+
+    static ContextBackend contextBackend;
+    static bool contextBackendSelected;
+    static QGuiApplication *headlessApplication;
 
     Q_DISABLE_COPY(OpenGLWrapper)
 };
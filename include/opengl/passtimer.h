@@ -0,0 +1,100 @@
+/**
+ * @file        passtimer.h
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The header file with PassTimer class declaration.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef SSIMR_PASSTIMER_H
+#define SSIMR_PASSTIMER_H
+
+#include "../ssimrenderer_global.h"
+
+#include "openglwrapper.h"
+
+#include <QQueue>
+#include <QMap>
+#include <QStringList>
+#include <QDebug>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief The PassTimer class represents GPU timers (GL_TIME_ELAPSED queries) of rendering passes
+ *
+ * Queries are collected asynchronously, only finished queries are read.
+ */
+class SHARED_EXPORT PassTimer
+{
+public:
+    /// Rolling statistics of pass times in milliseconds
+    struct Stats {
+        double min;
+        double mean;
+        double p95;
+        double last;
+        int count;
+    };
+
+    // Creates PassTimer with size of rolling window
+    PassTimer(int windowSize = 100);
+
+    // Destructor of PassTimer object
+    virtual ~PassTimer();
+
+    // Initializes and destroys timer with current OpenGL context
+    void initialize(OPENGL_FUNCTIONS *functions);
+    void destroy();
+
+    // Enables timers
+    void setEnabled(bool value);
+    bool isEnabled() const;
+
+    // Measuring of pass (passes cannot be nested)
+    void begin(const QString &pass);
+    void end();
+
+    // Reads finished queries without waiting
+    void collect();
+
+    // Statistics
+    Stats getStats(const QString &pass) const;
+    QStringList getPasses() const;
+    void reset();
+
+private:
+    struct PendingQuery {
+        QString pass;
+        GLuint query;
+    };
+
+    OPENGL_FUNCTIONS *functions;
+    bool enabled;
+    int windowSize;
+
+    QVector<GLuint> queries;
+    QVector<GLuint> freeQueries;
+    QQueue<PendingQuery> pendingQueries;
+    PendingQuery activeQuery;
+    bool active;
+
+    QStringList passes;
+    QMap<QString, QQueue<double>> samples;
+
+    Q_DISABLE_COPY(PassTimer)
+};
+}
+
+#endif // SSIMR_PASSTIMER_H
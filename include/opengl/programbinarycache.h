@@ -0,0 +1,87 @@
+/**
+ * @file        programbinarycache.h
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The header file with ProgramBinaryCache class declaration.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef SSIMR_PROGRAMBINARYCACHE_H
+#define SSIMR_PROGRAMBINARYCACHE_H
+
+#include "../ssimrenderer_global.h"
+
+#include "openglwrapper.h"
+
+#include <QOpenGLContext>
+#include <QStringList>
+#include <QByteArray>
+#include <QDebug>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief The ProgramBinaryCache class represents the on-disk cache of linked shader programs
+ *
+ * Binaries are keyed by driver string, shader sources and degree of Bernstein polynomial,
+ * cache needs OpenGL 4.1 or GL_ARB_get_program_binary extension.
+ */
+class SHARED_EXPORT ProgramBinaryCache
+{
+public:
+    // Creates ProgramBinaryCache stored in directory
+    ProgramBinaryCache(const QString &directory);
+
+    // Destructor of ProgramBinaryCache object
+    virtual ~ProgramBinaryCache();
+
+    // Initializes cache with current OpenGL context, returns false if program binaries are not supported
+    bool initialize(OPENGL_FUNCTIONS *functions);
+    bool isSupported() const;
+
+    QString getDirectory() const;
+
+    // Computes cache key of program
+    QByteArray key(const QStringList &sources, int degree = -1) const;
+
+    // Sets hint for retrieving of binary before linking
+    void setRetrievableHint(GLuint program);
+
+    // Loads binary to program, returns true if program is linked
+    bool load(GLuint program, const QByteArray &key);
+
+    // Stores binary of linked program
+    bool save(GLuint program, const QByteArray &key);
+
+private:
+    typedef void (QOPENGLF_APIENTRYP GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+    typedef void (QOPENGLF_APIENTRYP ProgramBinary)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+    typedef void (QOPENGLF_APIENTRYP ProgramParameteri)(GLuint program, GLenum pname, GLint value);
+
+    QString filePath(const QByteArray &key) const;
+
+    OPENGL_FUNCTIONS *functions;
+    GetProgramBinary glGetProgramBinary;
+    ProgramBinary glProgramBinary;
+    ProgramParameteri glProgramParameteri;
+
+    QString directory;
+    QByteArray driver;
+    bool supported;
+
+    Q_DISABLE_COPY(ProgramBinaryCache)
+};
+}
+
+#endif // SSIMR_PROGRAMBINARYCACHE_H
@@ -0,0 +1,99 @@
+/**
+ * @file        rendertargetpool.h
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The header file with RenderTargetPool class declaration.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef SSIMR_RENDERTARGETPOOL_H
+#define SSIMR_RENDERTARGETPOOL_H
+
+#include "../ssimrenderer_global.h"
+
+#include "openglwrapper.h"
+
+#include <QVector>
+#include <QHash>
+#include <QDebug>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief The RenderTargetPool class represents the pool of render textures and renderbuffers
+ *
+ * Targets are keyed by (format, width, height) and reused after release,
+ * the pool can be shared by renderers with shared OpenGL context. Every renderer
+ * attaches to the pool, the last detached renderer destroys and deletes it.
+ */
+class SHARED_EXPORT RenderTargetPool
+{
+public:
+    // Creates RenderTargetPool with max number of unused targets kept in pool
+    RenderTargetPool(int maxFreeTargets = 16);
+
+    // Destructor of RenderTargetPool object
+    virtual ~RenderTargetPool();
+
+    // Attaches and detaches OpenGL functions of renderer, detach returns true for the last renderer
+    void attach(OPENGL_FUNCTIONS *functions);
+    bool detach(OPENGL_FUNCTIONS *functions);
+
+    // Destroys pool with current OpenGL context
+    void destroy();
+
+    // 2D textures with nearest filtering
+    GLuint acquireTexture(GLenum internalFormat, GLuint width, GLuint height);
+    void releaseTexture(GLuint texture);
+
+    // Renderbuffers
+    GLuint acquireRenderbuffer(GLenum internalFormat, GLuint width, GLuint height);
+    void releaseRenderbuffer(GLuint renderbuffer);
+
+    // Deletes unused targets over limit
+    void trim(int maxFreeTargets = 0);
+
+    // Numbers of targets
+    int getNumberOfTargets() const;
+    int getNumberOfFreeTargets() const;
+
+    // Returns base format (GL_RED, GL_RG, GL_RGBA) of supported texture format, 0 otherwise
+    static GLenum getBaseFormat(GLenum internalFormat);
+
+private:
+    struct Target {
+        GLuint id;
+        GLenum internalFormat;
+        GLuint width;
+        GLuint height;
+        bool renderbuffer;
+    };
+
+    GLuint acquire(GLenum internalFormat, GLuint width, GLuint height, bool renderbuffer);
+    void release(QHash<GLuint, Target> &usedTargets, GLuint id);
+    void deleteTarget(const Target &target);
+
+    OPENGL_FUNCTIONS *functions;
+    QVector<OPENGL_FUNCTIONS *> attachedFunctions;
+    int maxFreeTargets;
+
+    QVector<Target> freeTargets;
+    QHash<GLuint, Target> usedTextures;
+    QHash<GLuint, Target> usedRenderbuffers;
+
+    Q_DISABLE_COPY(RenderTargetPool)
+};
+}
+
+#endif // SSIMR_RENDERTARGETPOOL_H
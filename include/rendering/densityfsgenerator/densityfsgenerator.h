@@ -23,6 +23,8 @@
 #include "../../ssimrenderer_global.h"
 
 #include <QDebug>
+#include <QVector>
+#include <QStringList>
 
 namespace SSIMRenderer
 {
@@ -48,6 +50,21 @@ public:
     // Generates fragment shader source code for density rendering
     const QString generateFragmentShaderSourceCode(const int coeffsCount, const bool debugFlag = false);
 
+    // Generates fragment shader source code for density rendering with vertex pulling
+    const QString generateVertexPullingFragmentShaderSourceCode(const int coeffsCount, const bool loop = false);
+
+    // Generates compact fragment shader source code looping over table of weights
+    const QString generateLoopFragmentShaderSourceCode(const int coeffsCount);
+
+    // Generates std140 data of BernsteinWeights uniform block for loop fragment shader
+    QVector<unsigned int> generateLoopWeightsData(const int coeffsCount);
+
+    // Generates fragment shader source code evaluating density at barycentric coords (volume baking)
+    const QString generateVolumeFragmentShaderSourceCode(const int coeffsCount);
+
+    // Max degree of loop fragment shader (4 bit exponents and 16 bit multinomials)
+    static const int MAX_LOOP_DEGREE = 10;
+
     // Computes number of coefficients from degree
     int coeffsCountFromDegree(const int degree) const;
 
@@ -57,6 +74,11 @@ public:
 private:
     int factorial(const int n) const;
 
+    QString headerSourceCode() const;
+    QString traversalSourceCode() const;
+
+    void generateLoopTerms(const int coeffsCount, QVector<unsigned int> &termsEnd, QVector<unsigned int> &terms);
+
     QString powString(const int x, const QString y) const;
     QString powVariables(const int degree, const QString b, const QString c) const;
     QString powStringVariable(const int x, const QString b, const QString c) const;
@@ -0,0 +1,97 @@
+/**
+ * @file        densityraycastercpu.h
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The header file with DensityRayCasterCPU class declaration.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef SSIMR_DENSITYRAYCASTERCPU_H
+#define SSIMR_DENSITYRAYCASTERCPU_H
+
+#include "../ssimrenderer_global.h"
+
+#include "densityrenderercpu.h"
+
+#include <QRect>
+
+#include <atomic>
+#include <vector>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief The DensityRayCasterCPU class represents multithreaded CPU ray casting of density (DRR)
+ *
+ * Ray of every requested pixel enters the mesh through boundary faces and walks through
+ * the tetrahedra by face adjacency. Density of every crossed tetrahedron is integrated
+ * exactly as by DensityRendererCPU, so the cost depends on the region of interest,
+ * not on the number of tetrahedra.
+ */
+class SHARED_EXPORT DensityRayCasterCPU : public DensityRendererCPU
+{
+public:
+    // Creates DensityRayCasterCPU with render width and height and number of threads (0 = number of CPU cores)
+    DensityRayCasterCPU(unsigned int renderWidth, unsigned int renderHeight, int numberOfThreads = 0);
+
+    // Destructor of DensityRayCasterCPU object
+    virtual ~DensityRayCasterCPU();
+
+    // Sets mesh and generates its adjacency
+    virtual void setMesh(Mesh *mesh);
+
+    // Region of interest in pixels (rows in OpenGL bottom-up order), null rect = whole image
+    void setRegionOfInterest(const QRect &rect);
+    QRect getRegionOfInterest() const;
+
+    // Main render function, returns elapsed time in milliseconds
+    virtual int renderNow();
+
+private:
+    // Tile size in pixels and number of rays in packet
+    static const int TILE_SIZE = 16;
+    static const int PACKET_SIZE = 4;
+
+    // Boundary face in window space with counter-clockwise vertices
+    struct BoundaryFace {
+        float x[3];
+        float y[3];
+        unsigned int face;
+    };
+
+    // Ray from near to far plane in world space
+    struct Ray {
+        float origin[3];
+        float direction[3];
+    };
+
+    void setupBoundaryFaces(const QRect &roi);
+    void castTile(int tile, const QRect &roi, const QMatrix4x4 &matrixInv);
+    float castRay(const Ray &ray, unsigned int face, const QMatrix4x4 &matrixInv) const;
+
+    std::vector<int> adjacency;
+    std::vector<unsigned int> boundaryFaces;
+    std::vector<BoundaryFace> projectedFaces;
+    std::vector<std::vector<unsigned int> > bins;
+    std::vector<std::atomic<int> > queueNext;
+    std::vector<int> queueEnd;
+
+    QRect regionOfInterest;
+    int roiTilesX;
+
+    Q_DISABLE_COPY(DensityRayCasterCPU)
+};
+}
+
+#endif // SSIMR_DENSITYRAYCASTERCPU_H
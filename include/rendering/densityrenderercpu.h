@@ -0,0 +1,177 @@
+/**
+ * @file        densityrenderercpu.h
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The header file with DensityRendererCPU class declaration.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#ifndef SSIMR_DENSITYRENDERERCPU_H
+#define SSIMR_DENSITYRENDERERCPU_H
+
+#include "../ssimrenderer_global.h"
+
+#include "../input/mesh.h"
+#include "../input/statisticaldata.h"
+#include "../input/shapereconstructioncpu.h"
+
+#include <QMatrix4x4>
+#include <QDebug>
+
+#include <functional>
+#include <vector>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief The DensityRendererCPU class represents multithreaded CPU rendering of density (DRR)
+ *
+ * Tetrahedra are projected and rasterized to tiles as by density.geom and the density line
+ * integral of DensityFSGenerator is evaluated for every covered pixel. No OpenGL context is needed.
+ */
+class SHARED_EXPORT DensityRendererCPU
+{
+public:
+    // Creates DensityRendererCPU with render width and height and number of threads (0 = number of CPU cores)
+    DensityRendererCPU(unsigned int renderWidth, unsigned int renderHeight, int numberOfThreads = 0);
+
+    // Destructor of DensityRendererCPU object
+    virtual ~DensityRendererCPU();
+
+    // Mesh, vertices, coefficients
+    virtual void setMesh(Mesh *mesh);
+    void setCoefficients(StatisticalData *statisticalData);
+    void setVertices(StatisticalData *statisticalData);
+    void updateCoefficients(StatisticalData *statisticalData);
+    void updateVertices(StatisticalData *statisticalData);
+
+    // Final matrix to clip space (MainRenderer::getDensityMatrix() with crop size as render size)
+    void setMatrix(const QMatrix4x4 &matrix);
+    QMatrix4x4 getMatrix() const;
+
+    // Render size
+    void setRenderWidth(unsigned int renderWidth);
+    void setRenderHeight(unsigned int renderHeight);
+    void setRenderSize(unsigned int renderWidth, unsigned int renderHeight);
+    unsigned int getRenderWidth() const;
+    unsigned int getRenderHeight() const;
+
+    // Rendering settings
+    void enableXMirroring(bool value);
+    bool isXMirroringEnabled() const;
+
+    // Number of used threads
+    void setNumberOfThreads(int value);
+    int getNumberOfThreads() const;
+
+    // Main render function, returns elapsed time in milliseconds
+    virtual int renderNow();
+
+    // Last render time
+    int getLastRenderTime() const;
+    double getLastRenderTimeDouble() const;
+
+    // Raw density (rows in OpenGL bottom-up order)
+    void getCurrentDensityData(float *&data) const;
+    bool getCurrentDensityData(float *data, long size, unsigned int rowStride = 0) const;
+
+    // RMS difference of density images relative to max of reference
+    static float getDensityError(const float *reference, const float *data, long size);
+
+    // Max getDensityError against GPU density with 32-bit float format
+    static const float DENSITY_TOLERANCE;
+
+protected:
+    bool prepareData();
+    void parallelRun(int threads, const std::function<void(int)> &function) const;
+    float integrate(const float *attributes, const float *coefficients) const;
+
+    Mesh *mesh;
+    std::vector<float> positions;
+    std::vector<float> coefficients;
+    std::vector<float> density;
+
+    QMatrix4x4 matrix;
+    unsigned int renderWidth;
+    unsigned int renderHeight;
+    int coeffsCount;
+    bool xMirroringEnabled;
+    int numberOfThreads;
+    int lastRenderTime;
+    double lastRenderTimeDouble;
+
+private:
+    // Tile size in pixels and size of setup vertex (x, y, 1 / w, unused, b / w, bEyedir / w, eEyedir / w)
+    static const int TILE_SIZE = 32;
+    static const int VERTEX_SIZE = 16;
+
+    // Number of monomials of 4 variables up to DensityFSGenerator::MAX_LOOP_DEGREE
+    static const int MAX_MONOMIALS = 1001;
+
+    struct Triangle {
+        unsigned int vertices[3];
+        unsigned int tetrahedron;
+    };
+
+    // Monomial with multinomial of Bernstein basis, powers are indices of power tables
+    struct Monomial {
+        unsigned short powers[4];
+        float multinomial;
+    };
+
+    // Term of integral, product of entry and exit monomials
+    struct Term {
+        unsigned short in;
+        unsigned short out;
+    };
+
+    // Per-thread output of geometry setup, triangles are binned to tiles in primitive order
+    struct SetupBuffer {
+        std::vector<float> vertices;
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<unsigned int> > bins;
+    };
+
+    bool prepareTerms(int coeffsCount);
+    void setupTetrahedra(SetupBuffer &buffer, long begin, long end, const QMatrix4x4 &matrixInv) const;
+    void setupClippedFace(SetupBuffer &buffer, const float (*vertices)[VERTEX_SIZE], int i, int j, int k, unsigned int tetrahedron) const;
+    void addTriangle(SetupBuffer &buffer, unsigned int v0, unsigned int v1, unsigned int v2, unsigned int tetrahedron) const;
+    unsigned int addVertex(SetupBuffer &buffer, const float *vertex) const;
+    void toWindow(const float *clip, float *window) const;
+    static float signedArea(const float *v0, const float *v1, const float *v2);
+    void rasterizeTile(int tile);
+    void rasterizeTriangle(const float *v0, const float *v1, const float *v2, const float *coefficients, int x0, int y0, int x1, int y1);
+    void shadePixel(const float *v0, const float *v1, const float *v2, const float *coefficients, const float *lambda, float &output) const;
+
+    StatisticalData *coefficientsStatisticalData;
+    StatisticalData *verticesStatisticalData;
+    ShapeReconstructionCPU reconstruction;
+
+    std::vector<int> termsEnd;
+    std::vector<Term> terms;
+    std::vector<Monomial> monomials;
+    std::vector<SetupBuffer> setupBuffers;
+
+    int tilesX;
+    int tilesY;
+    int degree;
+    float integralFactor;
+    bool recomputeCoefficientsFlag;
+    bool recomputeVerticesFlag;
+
+    Q_DISABLE_COPY(DensityRendererCPU)
+};
+}
+
+#endif // SSIMR_DENSITYRENDERERCPU_H
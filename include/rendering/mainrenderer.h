@@ -25,9 +25,13 @@
 
 #include "densityfsgenerator/densityfsgenerator.h"
 #include "../opengl/openglwrapper.h"
+#include "../opengl/passtimer.h"
+#include "../opengl/rendertargetpool.h"
 #include "../input/pyramid.h"
 #include "../input/mesh.h"
 #include "../input/statisticaldata.h"
+#include "../input/shapereconstructioncpu.h"
+#include "../input/vertexcacheoptimizer.h"
 #include "../input/csvcoeffsfile.h"
 
 #include <QOpenGLBuffer>
@@ -69,6 +73,7 @@ public:
 
     // Outputs
     virtual long getRecomputedVertices(float *&vertices, bool transformed = false) final;
+    virtual long getRecomputedVertices(float *vertices, long size, bool transformed) final;
     virtual QVector<QVector3D> getRecomputedVertices(bool transformed = false) final;
     QVector<bool> getVerticesMask(float *vertices = 0, int numberOfVertices = 0, const QRectF &cropRectangle = QRectF());
 
@@ -79,10 +84,64 @@ public:
     virtual void saveRenderedImage(const QString &filePath) final;
     virtual QImage getRenderedImage() final;
     virtual void getRenderedRedChannel(float *&data) final;
+    virtual bool getRenderedRedChannel(float *data, long size, GLuint rowStride = 0) final;
     virtual void getCurrentSilhouettesImage(float *&image) final;
+    virtual bool getCurrentSilhouettesImage(float *image, long size, GLuint rowStride = 0) final;
+
+    // Raw layers of crop window (without postprocessing and output texture)
+    virtual void getCurrentDensityData(float *&data) final;
+    virtual bool getCurrentDensityData(float *data, long size, GLuint rowStride = 0) final;
+    virtual bool getCurrentPolygonalImage(float *image, long size, GLuint rowStride = 0) final;
+    virtual long readCurrentDensityDataAsync(bool flip = false) final;
     GLuint getOutputTextureId() const;
     virtual void saveRedChannelToOpenExr(const QString &filePath) final;
 
+    // Asynchronous export of output
+    virtual long readRenderedImageAsync() final;
+    virtual long readRenderedRedChannelAsync(bool flip = false) final;
+    virtual bool isReadbackReady(long handle) final;
+    virtual QImage waitForRenderedImage(long handle) final;
+    virtual bool waitForRenderedRedChannel(long handle, float *&data) final;
+    virtual bool waitForRenderedRedChannel(long handle, float *data, long size) final;
+
+    // Batch rendering of multiple poses
+    void renderBatch(const QVector<QMatrix4x4> &poses);
+    virtual long getBatchRedChannel(float *&data) final;
+    virtual long getBatchRedChannel(float *data, long size) final;
+    virtual GLuint getBatchSize() const final;
+    virtual GLuint getMaxBatchSize() const final;
+
+    // Density basis images - density is linear in coefficients pcs
+    void renderDensityBasis(StatisticalData *statisticalData);
+    void renderFromDensityBasis(StatisticalData *statisticalData);
+    virtual long getDensityBasis(float *&data) final;
+    virtual bool hasDensityBasis() final;
+    virtual void invalidateDensityBasis() final;
+
+    // Fused SSD metric - density of crop window is compared with reference image on GPU
+    void setReferenceImage(const float *data, GLuint width, GLuint height);
+    void setReferenceImage(const QImage &image);
+    void enableFusedSSD(bool value);
+    virtual bool isFusedSSDEnabled() const final;
+    virtual float getFusedSSD() final;
+
+    // Density volume - deformed density is baked to 3D texture and poses are rendered by ray marching
+    void enableDensityVolume(bool value);
+    virtual bool isDensityVolumeEnabled() const final;
+    void setDensityVolumeVoxelSize(float value);
+    virtual float getDensityVolumeVoxelSize() const final;
+    void bakeDensityVolume();
+    virtual bool hasDensityVolume() const final;
+    virtual void invalidateDensityVolume() final;
+
+    // Density culling - clusters of tetrahedra outside of crop window frustum are not drawn
+    void enableDensityCulling(bool value);
+    virtual bool isDensityCullingEnabled() const final;
+    virtual long getNumberOfDrawnTetrahedra() const final;
+
+    // Post-transform vertex cache - average cache miss ratio of mesh order and uploaded order
+    virtual double getTrianglesACMR(bool adjacency = false, bool optimized = true) final;
+
     // Rendering parameters
     void setIntensity(double value);
     void setLineWidth(double value);
@@ -114,19 +173,53 @@ public:
     // Rendering settings
     void enableDensity(bool value);
     void enablePostprocessing(bool value);
+    void enableOutput(bool value);
     void enableSilhouettes(bool value);
     void enablePyramid(bool value);
     void enablePolygonal(bool value);
     void enableXMirroring(bool value);
     void enablePolygonalLighting(bool value);
+    void enableDensityVertexPulling(bool value);
+    void enableDensityLoopGenerator(bool value);
 
     virtual bool isDensityEnabled() const final;
+    virtual bool isOutputEnabled() const final;
     virtual bool isPostprocessingEnabled() const final;
     virtual bool isSilhouettesEnabled() const final;
     virtual bool isPyramidEnabled() const final;
     virtual bool isPolygonalEnabled() const final;
     virtual bool isXMirroringEnabled() const final;
     virtual bool isLightingEnabled() const final;
+    virtual bool isDensityVertexPullingEnabled() const final;
+    virtual bool isDensityLoopGeneratorEnabled() const final;
+
+    // Storage formats of layers (GL_RGBA32F by default)
+    void setDensityFormat(GLenum internalFormat);
+    void setSilhouettesFormat(GLenum internalFormat);
+    void setPolygonalFormat(GLenum internalFormat);
+    void setPyramidFormat(GLenum internalFormat);
+
+    virtual GLenum getDensityFormat() const final;
+    virtual GLenum getSilhouettesFormat() const final;
+    virtual GLenum getPolygonalFormat() const final;
+    virtual GLenum getPyramidFormat() const final;
+
+    // GPU timers of rendering passes
+    void enablePassTimers(bool value);
+    virtual bool isPassTimersEnabled() const final;
+    virtual PassTimer::Stats getPassTimerStats(const QString &pass) final;
+    virtual QStringList getTimedPasses() final;
+    virtual void resetPassTimers() final;
+
+    // Deletes unused render targets of shared pool
+    void releaseUnusedRenderTargets();
+
+    // Builds all shader programs upfront (otherwise they are built on first use)
+    void warmUp();
+
+    // CPU reconstruction of vertices (no OpenGL round-trip)
+    void enableCPUReconstruction(bool value, int numberOfThreads = 0);
+    virtual bool isCPUReconstructionEnabled() const final;
 
     // Flag for sharing transformations between multiple windows
     void setFlagShareTransformations(bool value);
@@ -170,6 +263,9 @@ public:
     virtual void setPerspective(QVector3D leftTop, QVector3D leftBottom, QVector3D rightTop, QVector3D rightBottom, QVector3D eye) final;
     virtual SSIMRenderer::Pyramid getPerspective() final;
 
+    // Final matrix of density rendering with crop sub-frustum (for DensityRendererCPU)
+    virtual QMatrix4x4 getDensityMatrix() final;
+
     // Control points
     void addPoint(const QVector3D &value);
     void setPoints(QVector<QVector3D> points);
@@ -188,13 +284,18 @@ protected:
 
     // Render functions
     virtual void renderDensity() final;
+    virtual void renderDensityPulling() final;
     virtual void renderSilhouettes() final;
     virtual void renderPolygonal() final;
     virtual void renderPyramid(SSIMRenderer::Pyramid pyramid) final;
     virtual void renderPostprocessing() final;
+    virtual void renderDensityBatch() final;
+    virtual void renderFusedSSD() final;
+    virtual void renderDensityVolume() final;
 
     virtual void prepareRendering() final;
     virtual void clearViewport() final;
+    virtual void setCropViewport() final;
     virtual void clearTexture(GLuint id) final;
 
     // Get Matrices
@@ -211,23 +312,85 @@ protected:
     bool event(QEvent *event);
 
 private:
+    // Applied pcs of diff for incremental updates
+    struct DiffState {
+        StatisticalData *statisticalData;
+        QVector<GLfloat> pcs;
+        GLuint width;
+        GLuint height;
+        int deltaUpdates;
+    };
+
+    // Limits of incremental updates - max changed modes (defined in computingdelta.frag) and max updates between full recomputes
+    static const int MAX_DELTA_MODES = 8;
+    static const int MAX_DELTA_UPDATES = 64;
+
+    // Size of tile summed by one fragment of fused SSD (defined in ssdtiles.frag and reducetiles.frag)
+    static const GLuint SSD_TILE_SIZE = 16;
+
+    // Size of block of density volume occupancy grid (same as BLOCK_SIZE in densityvolume.frag and densityvolumeoccupancy.frag)
+    static const GLuint DENSITY_VOLUME_BLOCK_SIZE = 8;
+
+    // Number of voxels along longest side of mesh for default voxel size
+    static const GLuint DENSITY_VOLUME_DEFAULT_RESOLUTION = 128;
+
+    // Number of consecutive tetrahedra in one culling cluster
+    static const GLuint DENSITY_CLUSTER_SIZE = 256;
+
+    // Density fragment shaders loop over table of weights from this degree (unrolled code below)
+    static const int DENSITY_LOOP_MIN_DEGREE = 4;
+
+    // Binding point of BernsteinWeights uniform block
+    static const GLuint BERNSTEIN_WEIGHTS_BINDING = 0;
+
+    // Groups of shader programs built on first use
+    enum Programs {
+        PROGRAMS_DENSITY = 0x001,
+        PROGRAMS_DENSITY_BATCH = 0x002,
+        PROGRAMS_DENSITY_PULLING = 0x004,
+        PROGRAMS_DENSITY_BASIS = 0x008,
+        PROGRAMS_SILHOUETTES = 0x010,
+        PROGRAMS_COMPUTING = 0x020,
+        PROGRAMS_PYRAMID = 0x040,
+        PROGRAMS_POLYGONAL = 0x080,
+        PROGRAMS_POSTPROCESSING = 0x100,
+        PROGRAMS_FUSED_SSD = 0x200,
+        PROGRAMS_DENSITY_VOLUME = 0x400,
+        PROGRAMS_ALL = 0x7FF
+    };
+
     // Private stuff
     void init();
 
     void getVariablesLocations();
     void initUniformVariables();
 
-    void generateScreenTexture(GLuint *id);
+    void requirePrograms(int programs);
+    bool hasPrograms(int programs);
+    void buildPrograms(int programs);
+
+    void updateDensityPrograms(int bernCoeffsCount);
+    void linkDensityProgram(QOpenGLShaderProgram *program, QOpenGLShader *fragmentShader, bool vertexPulling);
+    void linkDensityVolumeProgram();
+    void bindBernsteinWeightsBlock(QOpenGLShaderProgram *program);
 
     void setStatisticalData(StatisticalData *statisticalData);
 
-    void recomputeDiff();
-    void recomputeCoefficientsDiff();
+    void recomputeDiff(GLuint texture, DiffState &state, const GLfloat *pcs = 0);
+    void recomputeCoefficientsDiff(const GLfloat *pcs = 0);
     void recomputeVerticesDiff();
+    void recomputePositions();
+    void recomputeTetrahedraInverse();
+    void recomputeClusterBounds();
+    void updateDensityRanges();
 
     void recomputeStatisticalDataIfNeeded();
 
     void resizeTexturesAndRenderbuffer();
+    void allocateLayerTexture(GLuint &texture, GLenum internalFormat, bool enabled);
+    void allocateCropTexture(GLuint &texture);
+    bool checkLayerFormat(const char *function, GLenum internalFormat, bool alphaRequired) const;
+    static bool hasAlphaChannel(GLenum internalFormat);
     void setRelativeTextureStep();
 
     void prepareTransformation();
@@ -236,10 +399,32 @@ private:
     void debugTexture(GLuint id);
 
     QImage getCurrentImage();
+
+    long readbackAsync(GLuint texture, GLuint x, GLuint y, GLenum format, GLenum type, GLuint bytesPerPixel, bool flip);
+    bool readLayer(const char *function, GLuint texture, bool enabled, GLenum format, GLuint channels, float *data, long size, GLuint rowStride);
+    const GLubyte *mapReadback(long handle, GLenum format, GLenum type, GLuint &width, GLuint &height, GLuint &size);
+    void unmapReadback();
+
+    bool checkOutputArray(const char *function, const float *data, long size, GLuint width, GLuint height, GLuint channels, GLuint rowStride = 0) const;
+    void allocateOptimizedElements(QOpenGLBuffer &buffer, const GLuint *elements, long numberOfPrimitives, int primitiveSize, long numberOfVertices);
     QVector3D getAngles(QMatrix4x4 matrix);
 
     DensityFSGenerator fsGenerator;
 
+    // GPU timers of passes
+    PassTimer passTimer;
+
+    // Pool of layer textures and depth buffers (shared)
+    RenderTargetPool *renderTargetPool;
+
+    // CPU reconstruction of vertices
+    ShapeReconstructionCPU shapeReconstructionCPU;
+    StatisticalData *verticesStatisticalData;
+    bool cpuReconstructionEnabled;
+
+    // Ordering of triangles for post-transform vertex cache
+    VertexCacheOptimizer vertexCacheOptimizer;
+
     // Rendering density
     struct Density {
         QOpenGLShaderProgram *program;
@@ -247,7 +432,6 @@ private:
         GLuint aPosition;
         //GLuint aIndicesX;
         //GLuint aIndicesY;
-        GLuint uPositionDiff;
         GLuint uMatrix;
         GLuint uMatrixInv;
         GLuint uBernCoeffs;
@@ -256,18 +440,73 @@ private:
         GLuint uPositionDiffLengthLog2;
         GLuint uParam;
         GLuint uXMirror;
+        GLuint uPrimitiveOffset;
+
+        // Bounding boxes of clusters of tetrahedra for culling, output is captured by transform feedback
+        QOpenGLShaderProgram *programBounds;
+        GLuint uBoundsPositions;
+        GLuint uBoundsElements;
+        GLuint uBoundsClusterSize;
+        GLuint uBoundsNumberOfTetrahedra;
+
+        // Bounds of clusters (min xyz, max xyz) read back from vboClusterBounds and their shape generation
+        QVector<GLfloat> clusterBounds;
+        long clusterBoundsGeneration;
     } *density;
 
+    // Rendering density of multiple poses to layers
+    struct DensityBatch {
+        QOpenGLShaderProgram *program;
+        QOpenGLShader *fragmentShader;
+        GLuint aPosition;
+        GLuint uMatrices;
+        GLuint uBernCoeffs;
+        GLuint uBernCoeffsDiff;
+        GLuint uPositionDiffLengthMinus1;
+        GLuint uPositionDiffLengthLog2;
+        GLuint uXMirror;
+    } *densityBatch;
+
+    // Rendering density by vertex pulling (12 vertices per tetrahedron, without geometry shader)
+    struct DensityPulling {
+        QOpenGLShaderProgram *program;
+        QOpenGLShader *fragmentShader;
+        QOpenGLShaderProgram *programInverse;
+        GLuint uMatrix;
+        GLuint uMatrixInv;
+        GLuint uPositions;
+        GLuint uElements;
+        GLuint uTetrahedraInverse;
+        GLuint uBernCoeffs;
+        GLuint uBernCoeffsDiff;
+        GLuint uPositionDiffLengthMinus1;
+        GLuint uPositionDiffLengthLog2;
+        GLuint uParam;
+        GLuint uXMirror;
+        GLuint uInversePositions;
+        GLuint uInverseElements;
+        GLuint uInstanceOffset;
+
+        // Shape generation of inverse matrices in vboTetrahedraInverse
+        long inverseGeneration;
+    } *densityPulling;
+
+    // Composing density from basis images
+    struct DensityBasis {
+        QOpenGLShaderProgram *program;
+        GLuint uBasisTexture;
+        GLuint uWeights;
+    } *densityBasis;
+
     // Rendering silhouettes
     struct Silhouettes {
         QOpenGLShaderProgram *program;
         GLuint aPosition;
         //GLuint aIndicesX;
         //GLuint aIndicesY;
-        GLuint uPositionDiff;
-        GLuint uPositionDiffLengthMinus1;
-        GLuint uPositionDiffLengthLog2;
         GLuint uMatrix;
+        GLuint uAreaScale;
+        GLuint uCoverageOnly;
         //GLuint uLineWidth;
         //GLuint uRatio;
         GLuint uXMirror;
@@ -276,12 +515,37 @@ private:
     // Computing diffs
     struct Computing {
         QOpenGLShaderProgram *program;
+        QOpenGLShaderProgram *programDelta;
         GLuint uT;
         GLuint uPcs;
         GLuint uWidth;
         GLuint uHeight;
+
+        GLuint uDeltaT;
+        GLuint uDeltaModes;
+        GLuint uDeltaValues;
+        GLuint uDeltaCount;
+        GLuint uDeltaNumberOfParameters;
+        GLuint uDeltaWidth;
+        GLuint uDeltaHeight;
+
+        // Shared state of diff textures
+        DiffState coefficientsState;
+        DiffState verticesState;
     } *computing;
 
+    // Final vertex positions (mean + diff) by transform feedback
+    struct Positions {
+        QOpenGLShaderProgram *program;
+        GLuint aPosition;
+        GLuint uPositionDiff;
+        GLuint uPositionDiffLengthMinus1;
+        GLuint uPositionDiffLengthLog2;
+
+        // Shape generation, incremented after every recompute of positions (shared by all renderers)
+        long generation;
+    } *positions;
+
     // Rendering pyramid
     struct Pyramid {
         QOpenGLShaderProgram *program;
@@ -300,9 +564,6 @@ private:
         //GLuint aIndicesY;
         GLuint aColor;
         GLuint aNormal;
-        GLuint uPositionDiff;
-        GLuint uPositionDiffLengthMinus1;
-        GLuint uPositionDiffLengthLog2;
         GLuint uMatrix;
         GLuint uNormalMatrix;
         GLuint uXMirror;
@@ -324,6 +585,9 @@ private:
         GLuint uPolygonalEnabled;
         GLuint uPyramidEnabled;
 
+        GLuint uDensityHasAlpha;
+        GLuint uSilhouettesHasAlpha;
+
         GLuint uOutputTexture;
 
         GLuint uLeftBottomCorner;
@@ -334,10 +598,57 @@ private:
         GLuint uTextureStep;
     } *postprocessing;
 
+    // Fused SSD - partial sums of tiles and their reduction
+    struct FusedSSD {
+        QOpenGLShaderProgram *program;
+        QOpenGLShaderProgram *programReduce;
+        GLuint uDensityTexture;
+        GLuint uReferenceTexture;
+        GLuint uOffset;
+        GLuint uSize;
+        GLuint uInputTexture;
+        GLuint uInputSize;
+    } *fusedSSD;
+
+    // Density volume - baking by slices, occupancy grid and ray marching (shared with baked volume)
+    struct DensityVolume {
+        QOpenGLShaderProgram *programBake;
+        QOpenGLShader *fragmentShader;
+        QOpenGLShaderProgram *programOccupancy;
+        QOpenGLShaderProgram *program;
+        GLuint aPosition;
+        GLuint uSliceMatrix;
+        GLuint uSliceZ;
+        GLuint uBernCoeffs;
+        GLuint uBernCoeffsDiff;
+        GLuint uPositionDiffLengthMinus1;
+        GLuint uPositionDiffLengthLog2;
+        GLuint uBakeXMirror;
+        GLuint uOccupancyVolumeTexture;
+        GLuint uOccupancyLayer;
+        GLuint uVolumeTexture;
+        GLuint uOccupancyTexture;
+        GLuint uMatrix;
+        GLuint uMatrixInv;
+        GLuint uViewport;
+        GLuint uOrigin;
+        GLuint uVoxelSize;
+        GLuint uXMirror;
+
+        // Baked volume
+        GLuint toVolume;
+        GLuint toOccupancy;
+        QVector3D origin;
+        GLfloat voxelSize;
+        bool valid;
+    } *densityVolume;
+
     // Frame Buffer Objects
     GLuint fbo;
     GLuint fboOutput;
     GLuint fboComputing;
+    GLuint fboBatch;
+    GLuint fboReadback;
 
     // Texture Objects
     GLuint toDensity;
@@ -346,12 +657,23 @@ private:
     GLuint toPolygonal;
     GLuint toOutput;
     GLuint toPyramidImage;
+    GLuint toBatch;
+    GLuint toBatchMatrices;
+    GLuint toDensityBasis;
+    GLuint toBasisWeights;
+    GLuint toReadback;
+    GLuint toReference;
+    GLuint toSSDTiles[2];
+    GLuint toSSDResult;
     // Shared
     GLuint toCompCoeffs;
     GLuint toCompVertices;
     GLuint toBerncoeffs;
     GLuint toT;
     GLuint toPcs;
+    GLuint toPositions;
+    GLuint toElementsTetrahedra;
+    GLuint toTetrahedraInverse;
 
     // Element Buffer Objects
     QOpenGLBuffer iboElementsTetrahedra;
@@ -360,15 +682,39 @@ private:
 
     // Vertex Buffer Objects
     QOpenGLBuffer vboVertices;
+    QOpenGLBuffer vboPositions;
     QOpenGLBuffer vboVerticesColors;
     //QOpenGLBuffer vboComputeIndicesX;
     //QOpenGLBuffer vboComputeIndicesY;
     QOpenGLBuffer vboNormals;
+    QOpenGLBuffer vboTetrahedraInverse;
+    QOpenGLBuffer vboClusterBounds;
 
     // Texture Buffer Objects
     GLuint tboBerncoeffs;
     GLuint tboT;
     GLuint tboPcs;
+    GLuint tboBatchMatrices;
+    GLuint tboBasisWeights;
+
+    // Uniform Buffer Object with weights of loop density fragment shaders
+    GLuint uboBernsteinWeights;
+
+    // Pixel Buffer Objects ring for asynchronous readback
+    static const int READBACK_RING_SIZE = 3;
+    struct Readback {
+        GLuint pbo;
+        GLsync fence;
+        long handle;
+        GLenum format;
+        GLenum type;
+        GLuint width;
+        GLuint height;
+        GLuint size;
+    } readbacks[READBACK_RING_SIZE];
+    long lastReadbackHandle;
+    GLuint readbackWidth;
+    GLuint readbackHeight;
 
     // Render Buffer Object
     GLuint rbo;
@@ -385,6 +731,11 @@ private:
     // Last coefficients count
     GLuint lastBernCoeffsCount;
 
+    // Built groups of programs and state of density fragment shaders (main context)
+    int builtPrograms;
+    int densityShadersCoeffsCount;
+    bool densityShadersLoop;
+
     // Compute sizes
     GLuint maxTextureOrRenderSize[2];
     GLuint positionDiffLengthLog2;
@@ -392,6 +743,44 @@ private:
     GLuint cWidth;
     GLuint cHeight;
 
+    // Batch sizes
+    GLuint maxBatchSize;
+    GLuint batchSize;
+    GLuint batchWidth;
+    GLuint batchHeight;
+
+    // Density basis sizes
+    GLuint basisSize;
+    GLuint basisWidth;
+    GLuint basisHeight;
+
+    // Final matrix, shape generation and mirroring of density basis
+    QMatrix4x4 basisMatrix;
+    long basisShapeGeneration;
+    bool basisXMirroring;
+
+    // Fused SSD sizes
+    GLuint referenceWidth;
+    GLuint referenceHeight;
+    GLuint ssdTilesWidth;
+    GLuint ssdTilesHeight;
+    bool fusedSSDEnabled;
+    bool fusedSSDWarningLogged;
+
+    // Density volume settings (0 = voxel size from DENSITY_VOLUME_DEFAULT_RESOLUTION)
+    GLfloat densityVolumeVoxelSize;
+    bool densityVolumeEnabled;
+
+    // Density culling, ranges of consecutive visible tetrahedra (first, count) are kept
+    // with final matrix, mirroring, shape generation and culling flag they were computed for
+    long drawnTetrahedra;
+    bool densityCullingEnabled;
+    QVector<GLint> densityRanges;
+    QMatrix4x4 densityRangesMatrix;
+    long densityRangesGeneration;
+    bool densityRangesXMirroring;
+    bool densityRangesCulling;
+
     // Points for lines
     QVector<QVector3D> points;
 
@@ -402,15 +791,25 @@ private:
 
     bool densityEnabled;
     bool postprocessingEnabled;
+    bool outputEnabled;
     bool silhouettesEnabled;
     bool pyramidEnabled;
     bool polygonalEnabled;
     bool xMirroringEnabled;
     bool polygonalLightingEnabled;
+    bool densityVertexPullingEnabled;
+    bool densityLoopGeneratorEnabled;
+
+    // Storage formats of layers
+    GLenum densityFormat;
+    GLenum silhouettesFormat;
+    GLenum polygonalFormat;
+    GLenum pyramidFormat;
 
     // Flags for computing
     bool recomputeCoefficientsDiffFlag;
     bool recomputeVerticesDiffFlag;
+    bool recomputePositionsFlag;
 
     // Render size stuff
     GLuint renderWidth;
@@ -422,10 +821,12 @@ private:
     float ratio;
     QVector2D step;
     bool sizeChanged;
+    bool cropSizeChanged;
 
     // Transformation
     QMatrix4x4 matrix;
     QMatrix4x4 perspectiveMatrix;
+    QMatrix4x4 cropMatrix;
     SSIMRenderer::Pyramid perspective;
     QMatrix4x4 cameraMatrix;
     QVector3D eye;
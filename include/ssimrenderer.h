@@ -35,6 +35,7 @@ namespace SSIMRenderer {}
 #include "input/pyramid.h"
 #include "input/mesh.h"
 #include "input/statisticaldata.h"
+#include "input/shapereconstructioncpu.h"
 
 #include "input/csvcoeffsfile.h"
 #include "input/csvpyramidfile.h"
@@ -48,6 +49,9 @@ namespace SSIMRenderer {}
 #include "input/xmlcalibsfile.h"
 
 #include "opengl/openglwrapper.h"
+#include "opengl/passtimer.h"
+#include "opengl/rendertargetpool.h"
+#include "opengl/programbinarycache.h"
 
 #include "rendering/densityfsgenerator/densityfsgenerator.h"
 
@@ -55,6 +59,8 @@ namespace SSIMRenderer {}
 #include "rendering/offscreenrenderer.h"
 #include "rendering/sharedwindow.h"
 #include "rendering/window.h"
+#include "rendering/densityrenderercpu.h"
+#include "rendering/densityraycastercpu.h"
 
 #include "metric/metricwrapper.h"
 #include "metric/nmiwrapper.h"
@@ -21,6 +21,10 @@
 
 #include "input/mesh.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 namespace SSIMRenderer
 {
 /**
@@ -165,6 +169,51 @@ unsigned int *Mesh::getTableOfTetrahedra() const
     return tableOfTetrahedra;
 }
 
+/**
+ * @brief Returns tetrahedra face adjacency
+ * @return Neighbour tetrahedron across every face, -1 for boundary face
+ *
+ * Face i of tetrahedron is the face opposite to its vertex i, value of face i
+ * of tetrahedron t is at index t * 4 + i. Adjacency is generated from tetrahedra data
+ * in every call.
+ */
+QVector<int> Mesh::getTetrahedraAdjacency() const
+{
+    // Sorted vertices of face and face index, equal faces are neighbours after sorting
+    struct Face {
+        unsigned int vertices[3];
+        long index;
+
+        bool operator<(const Face &face) const
+        {
+            return std::lexicographical_compare(vertices, vertices + 3, face.vertices, face.vertices + 3);
+        }
+    };
+
+    std::vector<Face> faces(numberOfTetrahedra * 4);
+    for (long i = 0; i < numberOfTetrahedra * 4; i++) {
+        Face &face = faces[i];
+        for (int j = 0, k = 0; j < 4; j++) {
+            if (j != i % 4)
+                face.vertices[k++] = tableOfTetrahedra[i / 4 * 4 + j];
+        }
+        std::sort(face.vertices, face.vertices + 3);
+        face.index = i;
+    }
+    std::sort(faces.begin(), faces.end());
+
+    QVector<int> result(int(numberOfTetrahedra * 4), -1);
+    for (size_t i = 0; i + 1 < faces.size(); i++) {
+        if (!(faces[i] < faces[i + 1])) {
+            result[int(faces[i].index)] = int(faces[i + 1].index / 4);
+            result[int(faces[i + 1].index)] = int(faces[i].index / 4);
+            i++;
+        }
+    }
+
+    return result;
+}
+
 /**
  * @brief Returns the number of vertices
  * @return Number of vertices
@@ -201,6 +250,155 @@ long Mesh::getNumberOfTetrahedra() const
     return numberOfTetrahedra;
 }
 
+/**
+ * @brief Reorders tetrahedra, vertices and triangles along Morton curve
+ *
+ * Tetrahedra are sorted by Morton code of their centroids, vertices are numbered by the first
+ * use in sorted tetrahedra (vertices without tetrahedra follow sorted by Morton code) and
+ * triangles are sorted by Morton code of their centroids. Neighbouring primitives then
+ * fetch neighbouring vertices and Bernstein coefficients. Statistical data of the mesh must
+ * be reordered by StatisticalData::reorderRows with getVertexOrder and getTetrahedronOrder.
+ */
+void Mesh::reorderSpatially()
+{
+    // Sorted Morton code and index of primitive
+    typedef std::pair<quint64, unsigned int> Key;
+    const unsigned int unassigned = ~0u;
+
+    std::vector<Key> keys(numberOfTetrahedra);
+    for (long i = 0; i < numberOfTetrahedra; i++) {
+        QVector3D centroid;
+        for (int j = 0; j < 4; j++) {
+            long v = tableOfTetrahedra[i * 4 + j];
+            centroid += QVector3D(tableOfVertices[v * 3 + 0], tableOfVertices[v * 3 + 1], tableOfVertices[v * 3 + 2]);
+        }
+        keys[i] = Key(getMortonCode(centroid / 4.0f), (unsigned int) i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    // Vertices in order of the first use
+    std::vector<unsigned int> vertexIndex(numberOfVertices, unassigned);
+    QVector<unsigned int> vertexPermutation;
+    vertexPermutation.reserve(int(numberOfVertices));
+    for (long i = 0; i < numberOfTetrahedra; i++) {
+        for (int j = 0; j < 4; j++) {
+            unsigned int v = tableOfTetrahedra[keys[i].second * 4 + j];
+            if (vertexIndex[v] == unassigned) {
+                vertexIndex[v] = (unsigned int) vertexPermutation.size();
+                vertexPermutation.append(v);
+            }
+        }
+    }
+
+    std::vector<Key> vertexKeys;
+    for (long i = 0; i < numberOfVertices; i++) {
+        if (vertexIndex[i] == unassigned)
+            vertexKeys.push_back(Key(getMortonCode(QVector3D(tableOfVertices[i * 3 + 0], tableOfVertices[i * 3 + 1], tableOfVertices[i * 3 + 2])), (unsigned int) i));
+    }
+    std::sort(vertexKeys.begin(), vertexKeys.end());
+    for (size_t i = 0; i < vertexKeys.size(); i++) {
+        vertexIndex[vertexKeys[i].second] = (unsigned int) vertexPermutation.size();
+        vertexPermutation.append(vertexKeys[i].second);
+    }
+
+    // Tetrahedra
+    QVector<unsigned int> tetrahedronPermutation((int) numberOfTetrahedra);
+    unsigned int *tableOfTetrahedraReordered = new unsigned int[numberOfTetrahedra * 4];
+    for (long i = 0; i < numberOfTetrahedra; i++) {
+        tetrahedronPermutation[int(i)] = keys[i].second;
+        for (int j = 0; j < 4; j++)
+            tableOfTetrahedraReordered[i * 4 + j] = vertexIndex[tableOfTetrahedra[keys[i].second * 4 + j]];
+    }
+    delete[] tableOfTetrahedra;
+    tableOfTetrahedra = tableOfTetrahedraReordered;
+
+    // Vertices and normals
+    float *tableOfVerticesReordered = new float[numberOfVertices * 3];
+    float *tableOfNormalsReordered = new float[numberOfVertices * 3];
+    for (long i = 0; i < numberOfVertices; i++) {
+        for (int j = 0; j < 3; j++) {
+            tableOfVerticesReordered[i * 3 + j] = tableOfVertices[vertexPermutation[int(i)] * 3 + j];
+            tableOfNormalsReordered[i * 3 + j] = tableOfNormals ? tableOfNormals[vertexPermutation[int(i)] * 3 + j] : 0.0f;
+        }
+    }
+    delete[] tableOfVertices;
+    delete[] tableOfNormals;
+    tableOfVertices = tableOfVerticesReordered;
+    tableOfNormals = tableOfNormalsReordered;
+
+    // Triangles, rows of triangles adjacency belong to triangles
+    keys.resize(numberOfTriangles);
+    for (long i = 0; i < numberOfTriangles; i++) {
+        QVector3D centroid;
+        for (int j = 0; j < 3; j++) {
+            tableOfTriangles[i * 3 + j] = vertexIndex[tableOfTriangles[i * 3 + j]];
+            centroid += getVectorOfTrianglePoint(i, j);
+        }
+        keys[i] = Key(getMortonCode(centroid / 3.0f), (unsigned int) i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    bool adjacencyRows = numberOfTrianglesAdjacency == numberOfTriangles;
+    unsigned int *tableOfTrianglesReordered = new unsigned int[numberOfTriangles * 3];
+    unsigned int *tableOfTrianglesAdjacencyReordered = new unsigned int[numberOfTrianglesAdjacency * 6];
+    for (long i = 0; i < numberOfTriangles; i++)
+        std::memcpy(tableOfTrianglesReordered + i * 3, tableOfTriangles + keys[i].second * 3, 3 * sizeof(unsigned int));
+    for (long i = 0; i < numberOfTrianglesAdjacency; i++) {
+        long row = adjacencyRows ? keys[i].second : i;
+        for (int j = 0; j < 6; j++)
+            tableOfTrianglesAdjacencyReordered[i * 6 + j] = vertexIndex[tableOfTrianglesAdjacency[row * 6 + j]];
+    }
+    delete[] tableOfTriangles;
+    delete[] tableOfTrianglesAdjacency;
+    tableOfTriangles = tableOfTrianglesReordered;
+    tableOfTrianglesAdjacency = tableOfTrianglesAdjacencyReordered;
+
+    // Compose with previous reordering
+    if (!vertexOrder.isEmpty()) {
+        for (int i = 0; i < vertexPermutation.size(); i++)
+            vertexPermutation[i] = vertexOrder[vertexPermutation[i]];
+    }
+    if (!tetrahedronOrder.isEmpty()) {
+        for (int i = 0; i < tetrahedronPermutation.size(); i++)
+            tetrahedronPermutation[i] = tetrahedronOrder[tetrahedronPermutation[i]];
+    }
+    vertexOrder = vertexPermutation;
+    tetrahedronOrder = tetrahedronPermutation;
+}
+
+/**
+ * @brief Returns original index of every vertex
+ * @return Original vertex index for every vertex, empty if mesh is not reordered
+ */
+const QVector<unsigned int> &Mesh::getVertexOrder() const
+{
+    return vertexOrder;
+}
+
+/**
+ * @brief Returns original index of every tetrahedron
+ * @return Original tetrahedron index for every tetrahedron, empty if mesh is not reordered
+ */
+const QVector<unsigned int> &Mesh::getTetrahedronOrder() const
+{
+    return tetrahedronOrder;
+}
+
+/**
+ * @brief Restores original order of vertex data
+ * @param[in, out] data Vertex data in mesh order (numberOfVertices * components values)
+ * @param[in] components Number of values of one vertex
+ */
+void Mesh::restoreVertexOrder(float *data, int components) const
+{
+    if (vertexOrder.isEmpty())
+        return;
+
+    std::vector<float> reordered(data, data + numberOfVertices * components);
+    for (long i = 0; i < numberOfVertices; i++)
+        std::memcpy(data + long(vertexOrder[int(i)]) * components, reordered.data() + i * components, components * sizeof(float));
+}
+
 /**
  * @brief Generates triangles adjacency data
  */
@@ -302,6 +500,30 @@ QVector3D Mesh::getVectorOfTrianglePoint(const long triangleIndex, const int ind
     return QVector3D(tableOfVertices[i * 3 + 0], tableOfVertices[i * 3 + 1], tableOfVertices[i * 3 + 2]);
 }
 
+/**
+ * @brief Computes Morton code of point in bounding box of the mesh
+ * @param[in] point Point to encode
+ * @return 63-bit Morton code with 21 bits per coordinate
+ */
+quint64 Mesh::getMortonCode(const QVector3D &point) const
+{
+    quint64 code = 0;
+    for (int i = 0; i < 3; i++) {
+        float extent = maxVertex[i] - minVertex[i];
+        float t = extent > 0.0f ? (point[i] - minVertex[i]) / extent : 0.0f;
+        quint64 x = quint64(qBound(0.0f, t, 1.0f) * float((1 << 21) - 1));
+
+        // Spread 21 bits to every third bit
+        x = (x | x << 32) & 0x1f00000000ffffULL;
+        x = (x | x << 16) & 0x1f0000ff0000ffULL;
+        x = (x | x << 8) & 0x100f00f00f00f00fULL;
+        x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+        x = (x | x << 2) & 0x1249249249249249ULL;
+        code |= x << i;
+    }
+    return code;
+}
+
 /**
  * @brief Helper function for copy and assign constructors
  * @param[in] statisticalData Original StatisticalData object to copy
@@ -339,14 +561,14 @@ void Mesh::assign(const Mesh &mesh, const bool deleteFlag)
     numberOfTrianglesAdjacency = mesh.numberOfTrianglesAdjacency;
     numberOfTetrahedra = mesh.numberOfTetrahedra;
 
-    if (maxVertex) {
-        maxVertex = new float[VERTEX_SIZE]();
-        std::memcpy(maxVertex, mesh.maxVertex, VERTEX_SIZE * sizeof(float));
-    }
+    vertexOrder = mesh.vertexOrder;
+    tetrahedronOrder = mesh.tetrahedronOrder;
 
-    if (minVertex) {
-        minVertex = new float[VERTEX_SIZE]();
-        std::memcpy(minVertex, mesh.minVertex, VERTEX_SIZE * sizeof(float));
-    }
+    // Min/max vertex are uninitialized in copy constructor, always allocated
+    maxVertex = new float[VERTEX_SIZE]();
+    std::memcpy(maxVertex, mesh.maxVertex, VERTEX_SIZE * sizeof(float));
+
+    minVertex = new float[VERTEX_SIZE]();
+    std::memcpy(minVertex, mesh.minVertex, VERTEX_SIZE * sizeof(float));
 }
 }
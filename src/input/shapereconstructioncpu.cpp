@@ -0,0 +1,304 @@
+/**
+ * @file        shapereconstructioncpu.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The implementation file containing the ShapeReconstructionCPU class.
+ *
+ * Shape is computed as cache-blocked GEMV (mean + T * pcs) split across threads.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "input/shapereconstructioncpu.h"
+
+#include <thread>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define SSIMR_USE_SSE
+#endif
+
+namespace SSIMRenderer
+{
+/**
+ * @brief Creates ShapeReconstructionCPU with number of threads
+ * @param[in] numberOfThreads Number of threads (0 = number of CPU cores)
+ */
+ShapeReconstructionCPU::ShapeReconstructionCPU(int numberOfThreads)
+{
+    setNumberOfThreads(numberOfThreads);
+}
+
+/**
+ * @brief Destructor of ShapeReconstructionCPU object
+ *
+ * Does nothing.
+ */
+ShapeReconstructionCPU::~ShapeReconstructionCPU()
+{
+
+}
+
+/**
+ * @brief Sets number of used threads
+ * @param[in] value Number of threads (0 = number of CPU cores)
+ */
+void ShapeReconstructionCPU::setNumberOfThreads(int value)
+{
+    if (value <= 0)
+        value = int(std::thread::hardware_concurrency());
+    numberOfThreads = qMax(1, value);
+}
+
+/**
+ * @brief Returns number of used threads
+ * @return Number of threads
+ */
+int ShapeReconstructionCPU::getNumberOfThreads() const
+{
+    return numberOfThreads;
+}
+
+/**
+ * @brief Computes mean + T * pcs to caller-owned array
+ * @param[in] statisticalData Statistical data
+ * @param[out] output Output array
+ * @param[in] size Size of output array (at least number of rows)
+ * @param[in] pcs Optional pcs vector, pcs of statistical data are used by default
+ * @return Number of computed rows, 0 on error
+ */
+long ShapeReconstructionCPU::reconstruct(const StatisticalData *statisticalData, float *output, long size, const float *pcs) const
+{
+    if (!statisticalData) {
+        qCritical() << "ShapeReconstructionCPU::reconstruct error: null StatisticalData";
+        return 0;
+    }
+
+    long numberOfRows = statisticalData->getNumberOfRows();
+    if (!output || size < numberOfRows) {
+        qCritical() << "ShapeReconstructionCPU::reconstruct error: output array is too small";
+        return 0;
+    }
+
+    if (!pcs)
+        pcs = statisticalData->getPcsMatrix();
+
+    const float *t = statisticalData->getTMatrix();
+    const float *mean = statisticalData->getMeanMatrix();
+    int numberOfParameters = statisticalData->getNumberOfParameters();
+
+    parallelFor(numberOfRows, ROW_BLOCK, numberOfRows * qMax(1, numberOfParameters), [&](long begin, long end) {
+        gemv(t, mean, pcs, numberOfParameters, output, begin, end);
+    });
+
+    return numberOfRows;
+}
+
+/**
+ * @brief Computes vertices with optional x mirroring and affine transformation
+ * @param[in] statisticalData Statistical data of vertices
+ * @param[out] vertices Output array with vertices (x, y, z)
+ * @param[in] size Size of output array (at least number of rows)
+ * @param[in] xMirroring Inverts x coordinate before transformation
+ * @param[in] transformation Optional affine transformation
+ * @param[in] pcs Optional pcs vector, pcs of statistical data are used by default
+ * @return Number of vertices, 0 on error
+ *
+ * Every thread reconstructs and transforms its own block of vertices while it is in cache.
+ */
+long ShapeReconstructionCPU::reconstructVertices(const StatisticalData *statisticalData, float *vertices, long size, bool xMirroring, const QMatrix4x4 *transformation, const float *pcs) const
+{
+    if (!statisticalData) {
+        qCritical() << "ShapeReconstructionCPU::reconstructVertices error: null StatisticalData";
+        return 0;
+    }
+
+    long numberOfRows = statisticalData->getNumberOfRows();
+    if (numberOfRows % 3 != 0) {
+        qCritical() << "ShapeReconstructionCPU::reconstructVertices error: number of rows is not divisible by 3";
+        return 0;
+    }
+
+    if (!vertices || size < numberOfRows) {
+        qCritical() << "ShapeReconstructionCPU::reconstructVertices error: output array is too small";
+        return 0;
+    }
+
+    if (!pcs)
+        pcs = statisticalData->getPcsMatrix();
+
+    const float *t = statisticalData->getTMatrix();
+    const float *mean = statisticalData->getMeanMatrix();
+    int numberOfParameters = statisticalData->getNumberOfParameters();
+    long numberOfVertices = numberOfRows / 3;
+    const float *matrix = transformation ? transformation->constData() : 0;
+
+    parallelFor(numberOfVertices, ROW_BLOCK / 3, numberOfRows * qMax(1, numberOfParameters), [&](long begin, long end) {
+        gemv(t, mean, pcs, numberOfParameters, vertices, begin * 3, end * 3);
+
+        if (matrix) {
+            transformRange(vertices, begin, end, matrix, xMirroring);
+        } else if (xMirroring) {
+            for (long i = begin; i < end; i++)
+                vertices[i * 3] = -vertices[i * 3];
+        }
+    });
+
+    return numberOfVertices;
+}
+
+/**
+ * @brief Batched affine transformation of vertices
+ * @param[in,out] vertices Array with vertices (x, y, z)
+ * @param[in] numberOfVertices Number of vertices
+ * @param[in] transformation Affine transformation (last row is not used)
+ * @param[in] xMirroring Inverts x coordinate before transformation
+ */
+void ShapeReconstructionCPU::transform(float *vertices, long numberOfVertices, const QMatrix4x4 &transformation, bool xMirroring) const
+{
+    if (!vertices) {
+        qCritical() << "ShapeReconstructionCPU::transform error: null vertices";
+        return;
+    }
+
+    const float *matrix = transformation.constData();
+
+    parallelFor(numberOfVertices, ROW_BLOCK, numberOfVertices * 12, [&](long begin, long end) {
+        transformRange(vertices, begin, end, matrix, xMirroring);
+    });
+}
+
+/**
+ * @brief Splits range to threads
+ * @param[in] count Number of items
+ * @param[in] grain Granularity of items ranges
+ * @param[in] work Estimated work of whole range (number of multiply-adds)
+ * @param[in] function Function called with range [begin, end)
+ *
+ * Small ranges are processed in calling thread.
+ */
+void ShapeReconstructionCPU::parallelFor(long count, long grain, long work, const std::function<void(long, long)> &function) const
+{
+    if (count <= 0)
+        return;
+
+    long threads = qMin(long(numberOfThreads), qMax(1L, work / MIN_THREAD_WORK));
+    threads = qMin(threads, (count + grain - 1) / grain);
+
+    if (threads <= 1) {
+        function(0, count);
+        return;
+    }
+
+    // Chunks are aligned to grain
+    long chunk = ((count + threads - 1) / threads + grain - 1) / grain * grain;
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (long begin = chunk; begin < count; begin += chunk)
+        workers.push_back(std::thread(function, begin, qMin(begin + chunk, count)));
+
+    function(0, qMin(chunk, count));
+
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+/**
+ * @brief Computes rows [begin, end) of mean + T * pcs
+ * @param[in] t T matrix (row-major, numberOfParameters columns)
+ * @param[in] mean Mean vector
+ * @param[in] pcs Pcs vector
+ * @param[in] numberOfParameters Number of parameters
+ * @param[out] output Output vector
+ * @param[in] begin First row
+ * @param[in] end Row after last row
+ *
+ * Rows are processed in blocks, long rows are split to column blocks
+ * so that the used part of pcs stays in L1 cache.
+ */
+void ShapeReconstructionCPU::gemv(const float *t, const float *mean, const float *pcs, int numberOfParameters, float *output, long begin, long end) const
+{
+    for (long blockBegin = begin; blockBegin < end; blockBegin += ROW_BLOCK) {
+        long blockEnd = qMin(blockBegin + ROW_BLOCK, end);
+
+        for (long r = blockBegin; r < blockEnd; r++)
+            output[r] = mean[r];
+
+        for (int c = 0; c < numberOfParameters; c += COLUMN_BLOCK) {
+            int columns = qMin(int(COLUMN_BLOCK), numberOfParameters - c);
+            for (long r = blockBegin; r < blockEnd; r++)
+                output[r] += dot(t + r * numberOfParameters + c, pcs + c, columns);
+        }
+    }
+}
+
+/**
+ * @brief Transforms vertices [begin, end) by affine matrix
+ * @param[in,out] vertices Array with vertices (x, y, z)
+ * @param[in] begin First vertex
+ * @param[in] end Vertex after last vertex
+ * @param[in] matrix Column-major 4x4 matrix
+ * @param[in] xMirroring Inverts x coordinate before transformation
+ */
+void ShapeReconstructionCPU::transformRange(float *vertices, long begin, long end, const float *matrix, bool xMirroring) const
+{
+    const float m00 = xMirroring ? -matrix[0] : matrix[0];
+    const float m10 = xMirroring ? -matrix[1] : matrix[1];
+    const float m20 = xMirroring ? -matrix[2] : matrix[2];
+
+    for (long i = begin; i < end; i++) {
+        float *v = vertices + i * 3;
+        float x = v[0], y = v[1], z = v[2];
+        v[0] = m00 * x + matrix[4] * y + matrix[8] * z + matrix[12];
+        v[1] = m10 * x + matrix[5] * y + matrix[9] * z + matrix[13];
+        v[2] = m20 * x + matrix[6] * y + matrix[10] * z + matrix[14];
+    }
+}
+
+/**
+ * @brief Dot product of two vectors
+ * @param[in] a First vector
+ * @param[in] b Second vector
+ * @param[in] n Length of vectors
+ * @return Dot product
+ */
+float ShapeReconstructionCPU::dot(const float *a, const float *b, int n)
+{
+    int i = 0;
+    float sum = 0;
+
+#ifdef SSIMR_USE_SSE
+    // Two independent accumulators hide latency of additions
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    if (i + 4 <= n) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        i += 4;
+    }
+    float partial[4];
+    _mm_storeu_ps(partial, _mm_add_ps(sum0, sum1));
+    sum = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+#endif
+
+    for (; i < n; i++)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+}
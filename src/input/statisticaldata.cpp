@@ -154,6 +154,40 @@ long StatisticalData::getNumberOfRows() const
     return numberOfRows;
 }
 
+/**
+ * @brief Reorders blocks of rows of T and MEAN matrices
+ * @param[in] order Original index of block for every new position
+ * @return True on success
+ *
+ * Rows are split to order.size() equal blocks, i.e. 3 rows of vertex for shape data
+ * and all Bernstein coefficients of tetrahedron for density data. Matrices must be
+ * in original order of the mesh file.
+ */
+bool StatisticalData::reorderRows(const QVector<unsigned int> &order)
+{
+    if (order.isEmpty() || numberOfRows % order.size() != 0) {
+        qCritical() << "StatisticalData::reorderRows error: number of rows" << numberOfRows << "is not divisible by order size" << order.size();
+        return false;
+    }
+
+    long rowsPerBlock = numberOfRows / order.size();
+    long tBlockSize = rowsPerBlock * numberOfParameters;
+
+    float *tMatrixReordered = new float[numberOfRows * numberOfParameters];
+    float *meanMatrixReordered = new float[numberOfRows];
+    for (int i = 0; i < order.size(); i++) {
+        std::memcpy(tMatrixReordered + i * tBlockSize, tMatrix + order[i] * tBlockSize, tBlockSize * sizeof(float));
+        std::memcpy(meanMatrixReordered + i * rowsPerBlock, meanMatrix + order[i] * rowsPerBlock, rowsPerBlock * sizeof(float));
+    }
+
+    delete[] tMatrix;
+    delete[] meanMatrix;
+    tMatrix = tMatrixReordered;
+    meanMatrix = meanMatrixReordered;
+
+    return true;
+}
+
 /**
  * @brief Updates PCS matrix with given value on given index
  * @param[in] index Index to PCS matrix
@@ -0,0 +1,197 @@
+/**
+ * @file        vertexcacheoptimizer.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        17 October 2026
+ *
+ * @brief       The implementation file containing the VertexCacheOptimizer class.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "input/vertexcacheoptimizer.h"
+
+#include <vector>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief Creates VertexCacheOptimizer with size of simulated FIFO vertex cache
+ * @param[in] cacheSize Number of vertices in cache
+ */
+VertexCacheOptimizer::VertexCacheOptimizer(int cacheSize)
+{
+    setCacheSize(cacheSize);
+}
+
+/**
+ * @brief Destructor of VertexCacheOptimizer object
+ *
+ * Does nothing.
+ */
+VertexCacheOptimizer::~VertexCacheOptimizer()
+{
+
+}
+
+/**
+ * @brief Sets size of simulated vertex cache
+ * @param[in] value Number of vertices in cache
+ */
+void VertexCacheOptimizer::setCacheSize(int value)
+{
+    cacheSize = qMax(1, value);
+}
+
+/**
+ * @brief Returns size of simulated vertex cache
+ * @return Number of vertices in cache
+ */
+int VertexCacheOptimizer::getCacheSize() const
+{
+    return cacheSize;
+}
+
+/**
+ * @brief Computes order of primitives for vertex cache by Tipsify algorithm
+ * @param[in] indices Indices of primitives
+ * @param[in] numberOfPrimitives Number of primitives
+ * @param[in] primitiveSize Number of indices of one primitive (3 or 6)
+ * @param[in] numberOfVertices Number of vertices
+ * @return Original index of primitive for every new position
+ *
+ * Primitives around fanning vertex are emitted together, next fanning vertex is the
+ * candidate which stays in cache longest after its remaining primitives are emitted.
+ */
+QVector<unsigned int> VertexCacheOptimizer::optimize(const unsigned int *indices, long numberOfPrimitives, int primitiveSize, long numberOfVertices) const
+{
+    QVector<unsigned int> order;
+    if (numberOfPrimitives <= 0 || numberOfVertices <= 0)
+        return order;
+    order.reserve(int(numberOfPrimitives));
+
+    long numberOfIndices = numberOfPrimitives * primitiveSize;
+
+    // Primitives of every vertex and number of not emitted primitives of every vertex
+    std::vector<long> offsets(numberOfVertices + 1, 0);
+    for (long i = 0; i < numberOfIndices; i++)
+        offsets[indices[i] + 1]++;
+    std::vector<int> live(numberOfVertices);
+    for (long i = 0; i < numberOfVertices; i++) {
+        live[i] = int(offsets[i + 1]);
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<unsigned int> primitives(numberOfIndices);
+    std::vector<long> fill(offsets.begin(), offsets.end() - 1);
+    for (long i = 0; i < numberOfIndices; i++)
+        primitives[fill[indices[i]]++] = (unsigned int) (i / primitiveSize);
+
+    std::vector<long> timestamps(numberOfVertices, 0);
+    std::vector<bool> emitted(numberOfPrimitives, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    long time = cacheSize + 1;
+    long cursor = 0;
+    long fanning = indices[0];
+
+    while (fanning >= 0) {
+        candidates.clear();
+
+        // Emit all primitives of fanning vertex
+        for (long i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+            unsigned int primitive = primitives[i];
+            if (emitted[primitive])
+                continue;
+            emitted[primitive] = true;
+            order.append(primitive);
+
+            for (int j = 0; j < primitiveSize; j++) {
+                unsigned int v = indices[long(primitive) * primitiveSize + j];
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - timestamps[v] > cacheSize)
+                    timestamps[v] = time++;
+            }
+        }
+
+        // Candidate with the highest position in cache which stays there after its fan
+        fanning = -1;
+        long bestPriority = -1;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            unsigned int v = candidates[i];
+            if (live[v] <= 0)
+                continue;
+            long priority = 0;
+            if (time - timestamps[v] + (primitiveSize - 1) * live[v] <= cacheSize)
+                priority = time - timestamps[v];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning = v;
+            }
+        }
+
+        // Dead end, recently used vertex or next vertex in input order
+        while (fanning < 0 && !deadEnd.empty()) {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+                fanning = v;
+        }
+        while (fanning < 0 && cursor < numberOfVertices) {
+            if (live[cursor] > 0)
+                fanning = cursor;
+            cursor++;
+        }
+    }
+
+    return order;
+}
+
+/**
+ * @brief Reorders primitives in place
+ * @param[in, out] indices Indices of primitives
+ * @param[in] primitiveSize Number of indices of one primitive
+ * @param[in] order Original index of primitive for every new position
+ */
+void VertexCacheOptimizer::reorder(unsigned int *indices, int primitiveSize, const QVector<unsigned int> &order)
+{
+    std::vector<unsigned int> original(indices, indices + long(order.size()) * primitiveSize);
+    for (int i = 0; i < order.size(); i++) {
+        for (int j = 0; j < primitiveSize; j++)
+            indices[long(i) * primitiveSize + j] = original[long(order[i]) * primitiveSize + j];
+    }
+}
+
+/**
+ * @brief Computes average cache miss ratio with FIFO cache
+ * @param[in] indices Indices of primitives
+ * @param[in] numberOfPrimitives Number of primitives
+ * @param[in] primitiveSize Number of indices of one primitive
+ * @param[in] numberOfVertices Number of vertices
+ * @return Number of transformed vertices per primitive
+ */
+double VertexCacheOptimizer::getACMR(const unsigned int *indices, long numberOfPrimitives, int primitiveSize, long numberOfVertices) const
+{
+    if (numberOfPrimitives <= 0)
+        return 0.0;
+
+    // Vertex is in cache if less than cacheSize misses happened after its insertion
+    std::vector<long> insertions(numberOfVertices, -long(cacheSize) - 1);
+    long misses = 0;
+    for (long i = 0; i < numberOfPrimitives * primitiveSize; i++) {
+        if (misses - insertions[indices[i]] > cacheSize)
+            insertions[indices[i]] = misses++;
+    }
+
+    return double(misses) / double(numberOfPrimitives);
+}
+}
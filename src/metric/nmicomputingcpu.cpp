@@ -66,7 +66,8 @@ NMIComputingCPU::~NMIComputingCPU()
  */
 void NMIComputingCPU::setInputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     inputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -84,7 +85,8 @@ void NMIComputingCPU::setInputImage(const QImage &image)
  */
 void NMIComputingCPU::setRenderingOutputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     renderingOutputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -210,6 +212,8 @@ void NMIComputingCPU::render()
     }
 
     if (hasSharedContext()) {
+        // Output texture of renderer is acquired from pool again after change of crop size
+        toRenderingOutput = ((MainRenderer *) getParentOpenGLWrapper())->getOutputTextureId();
         glBindTexture(GL_TEXTURE_2D, toRenderingOutput);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &imageWidth);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &imageHeight);
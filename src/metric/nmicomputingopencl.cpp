@@ -65,7 +65,8 @@ NMIComputingOpenCL::~NMIComputingOpenCL()
  */
 void NMIComputingOpenCL::setInputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     inputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -83,7 +84,8 @@ void NMIComputingOpenCL::setInputImage(const QImage &image)
  */
 void NMIComputingOpenCL::setRenderingOutputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     renderingOutputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -49,6 +49,9 @@ NMIComputingOpenGL::NMIComputingOpenGL(GLuint binsCount, OpenGLWrapper *parentOp
  */
 NMIComputingOpenGL::~NMIComputingOpenGL()
 {
+    if (!isValid())
+        return;
+
     checkInitAndMakeCurrentContext();
 
     //histogram->program->release();
@@ -86,7 +89,8 @@ NMIComputingOpenGL::~NMIComputingOpenGL()
  */
 void NMIComputingOpenGL::setInputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     QImage inputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -112,7 +116,8 @@ void NMIComputingOpenGL::setInputImage(const QImage &image)
  */
 void NMIComputingOpenGL::setRenderingOutputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     QImage renderingOutputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -140,7 +145,8 @@ void NMIComputingOpenGL::setHistogramBinsCount(int binsCount)
 {
     this->binsCount = binsCount;
 
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     glBindTexture(GL_TEXTURE_2D, toHistogramRenderingOutput);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, this->binsCount, 1, 0, GL_RED, GL_FLOAT, 0);
@@ -169,7 +175,8 @@ void NMIComputingOpenGL::setHistogramBinsCount(int binsCount)
  */
 QImage NMIComputingOpenGL::getJointHistogramImage()
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return QImage();
 
     QImage image = QImage(binsCount, binsCount, QImage::Format_RGB888);
     glBindTexture(GL_TEXTURE_2D, toJointHistogram);
@@ -199,7 +206,8 @@ QImage NMIComputingOpenGL::getJointHistogramImage()
  */
 QImage NMIComputingOpenGL::getInputImageHistogramImage()
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return QImage();
 
     QImage image = QImage(binsCount, 1, QImage::Format_RGB888);
     glBindTexture(GL_TEXTURE_2D, toHistogramInput);
@@ -227,7 +235,8 @@ QImage NMIComputingOpenGL::getInputImageHistogramImage()
  */
 QImage NMIComputingOpenGL::getRenderingOutputImageHistogramImage()
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return QImage();
 
     QImage image = QImage(binsCount, 1, QImage::Format_RGB888);
     glBindTexture(GL_TEXTURE_2D, toHistogramRenderingOutput);
@@ -468,6 +477,10 @@ void NMIComputingOpenGL::render()
         glBindTexture(GL_TEXTURE_2D, 0);
     }*/
 
+    // Output texture of renderer is acquired from pool again after change of crop size
+    if (hasSharedContext())
+        toRenderingOutput = ((MainRenderer *) getParentOpenGLWrapper())->getOutputTextureId();
+
     renderJointHistogramGPU();
     renderHistogramGPU(0, toHistogramInput);
     renderHistogramGPU(1, toHistogramRenderingOutput);
@@ -47,7 +47,8 @@ SSDComputingCPU::~SSDComputingCPU()
  */
 void SSDComputingCPU::setInputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     inputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -63,7 +64,8 @@ void SSDComputingCPU::setInputImage(const QImage &image)
  */
 void SSDComputingCPU::setRenderingOutputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     renderingOutputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -113,6 +115,8 @@ void SSDComputingCPU::render()
     }
 
     if (hasSharedContext()) {
+        // Output texture of renderer is acquired from pool again after change of crop size
+        toRenderingOutput = ((MainRenderer *) getParentOpenGLWrapper())->getOutputTextureId();
         glBindTexture(GL_TEXTURE_2D, toRenderingOutput);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &imageWidth);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &imageHeight);
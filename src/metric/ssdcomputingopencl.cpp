@@ -57,7 +57,8 @@ SSDComputingOpenCL::~SSDComputingOpenCL()
  */
 void SSDComputingOpenCL::setInputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     inputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -86,7 +87,8 @@ void SSDComputingOpenCL::setInputImage(const QImage &image)
  */
 void SSDComputingOpenCL::setRenderingOutputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     renderingOutputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -38,6 +38,9 @@ SSDComputingOpenGL::SSDComputingOpenGL(OpenGLWrapper *parentOpenGLWrapper)
  */
 SSDComputingOpenGL::~SSDComputingOpenGL()
 {
+    if (!isValid())
+        return;
+
     checkInitAndMakeCurrentContext();
 
     //sumOfSquaredDifferences->program->release();
@@ -60,7 +63,8 @@ SSDComputingOpenGL::~SSDComputingOpenGL()
  */
 void SSDComputingOpenGL::setInputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     QImage inputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -84,7 +88,8 @@ void SSDComputingOpenGL::setInputImage(const QImage &image)
  */
 void SSDComputingOpenGL::setRenderingOutputImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     //@todo TODO check dimensions of both images
     QImage renderingOutputImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
@@ -217,6 +222,10 @@ void SSDComputingOpenGL::render()
         return;
     }
 
+    // Output texture of renderer is acquired from pool again after change of crop size
+    if (hasSharedContext())
+        toRenderingOutput = ((MainRenderer *) getParentOpenGLWrapper())->getOutputTextureId();
+
     ssdFloat = renderGPU();
 
     //qDebug() << "SSD:" << ssdFloat;
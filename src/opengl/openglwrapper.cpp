@@ -20,9 +20,17 @@
  */
 
 #include "opengl/openglwrapper.h"
+#include "opengl/programbinarycache.h"
+
+#include <QFile>
+#include <QVariant>
 
 namespace SSIMRenderer
 {
+OpenGLWrapper::ContextBackend OpenGLWrapper::contextBackend = OpenGLWrapper::CONTEXT_BACKEND_QT;
+bool OpenGLWrapper::contextBackendSelected = false;
+QGuiApplication *OpenGLWrapper::headlessApplication = 0;
+
 /**
  * @brief Creates a OpenGLWrapper with surface and optional parental OpenGLWrapper
  * @param[in] surface Surface usually of type QOffscreenSurface or QWindow
@@ -33,24 +41,49 @@ OpenGLWrapper::OpenGLWrapper(QSurface *surface, OpenGLWrapper *parentOpenGLWrapp
     , context(0)
     , logger(0)
     , initialized(false)
+    , valid(true)
     , activeSurface(0)
     , lastRenderTime(0)
+    , lastRenderTimeDouble(0)
+    , frameFence(0)
+    , programBinaryCache(0)
 {
+    frameQueries[0] = 0;
+    frameQueries[1] = 0;
+
     if (parentOpenGLWrapper) {
         this->parentOpenGLWrapper = parentOpenGLWrapper;
         parentOpenGLWrapper->childOpenGLWrappers.append(this);
     }
 
+    // Environment is read by the first object, not during static initialization
+    selectDefaultContextBackend();
+
+    // Without QGuiApplication the object stays invalid, caller checks isValid()
+    if (!checkApplication()) {
+        valid = false;
+        return;
+    }
+
     initSurface(surface);
 }
 
 /**
  * @brief Destructor of OpenGLWrapper object
  *
- * Does nothing.
+ * Deletes fence and timer queries of renderNowAsync() and program binary cache.
  */
 OpenGLWrapper::~OpenGLWrapper()
 {
+    if (context && initialized) {
+        context->makeCurrent(activeSurface);
+        if (frameFence)
+            glDeleteSync(frameFence);
+        if (frameQueries[0])
+            glDeleteQueries(2, frameQueries);
+    }
+
+    delete programBinaryCache;
     //@todo TODO BUG
     //delete context;
     //delete logger;
@@ -64,7 +97,8 @@ OpenGLWrapper::~OpenGLWrapper()
  */
 int OpenGLWrapper::renderNow()
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
 
     if (activeSurface->surfaceClass() == QSurface::Window && (!((QWindow *) activeSurface)->isExposed() || !((QWindow *) activeSurface)->isVisible()) && hasSharedContext())
         return 0;
@@ -92,6 +126,94 @@ int OpenGLWrapper::renderNow()
     return elapsedMs;
 }
 
+/**
+ * @brief Non-blocking render function
+ * @return Fence of submitted frame (owned by OpenGLWrapper), 0 if nothing was rendered
+ *
+ * Calls render() function without glFinish() and returns immediately. Frame is finished
+ * by waitForFrame(), render time is measured on GPU by timestamp queries.
+ */
+GLsync OpenGLWrapper::renderNowAsync()
+{
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
+
+    if (activeSurface->surfaceClass() == QSurface::Window && (!((QWindow *) activeSurface)->isExposed() || !((QWindow *) activeSurface)->isVisible()) && hasSharedContext())
+        return 0;
+
+    // Previous frame was not waited for
+    if (frameFence) {
+        glDeleteSync(frameFence);
+        frameFence = 0;
+    }
+
+    if (!frameQueries[0])
+        glGenQueries(2, frameQueries);
+
+    glQueryCounter(frameQueries[0], GL_TIMESTAMP);
+    render();
+    glQueryCounter(frameQueries[1], GL_TIMESTAMP);
+
+    if ((activeSurface->surfaceClass() == QSurface::Window && ((QWindow *) activeSurface)->isExposed()))
+        context->swapBuffers(activeSurface);
+
+    frameFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    return frameFence;
+}
+
+/**
+ * @brief Is frame submitted by renderNowAsync() finished?
+ * @return True if frame is finished or no frame is pending
+ */
+bool OpenGLWrapper::isFrameReady()
+{
+    if (!frameFence)
+        return true;
+
+    if (!checkInitAndMakeCurrentContext())
+        return false;
+
+    GLenum status = glClientWaitSync(frameFence, 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+/**
+ * @brief Waits for frame submitted by renderNowAsync()
+ * @return GPU render time in milliseconds (integer)
+ */
+int OpenGLWrapper::waitForFrame()
+{
+    if (!frameFence)
+        return lastRenderTime;
+
+    if (!checkInitAndMakeCurrentContext())
+        return lastRenderTime;
+
+    GLenum status;
+    do {
+        status = glClientWaitSync(frameFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(frameFence);
+    frameFence = 0;
+
+    if (status == GL_WAIT_FAILED) {
+        qCritical() << "OpenGLWrapper::waitForFrame error: wait failed";
+        return lastRenderTime;
+    }
+
+    GLuint64 begin = 0, end = 0;
+    glGetQueryObjectui64v(frameQueries[0], GL_QUERY_RESULT, &begin);
+    glGetQueryObjectui64v(frameQueries[1], GL_QUERY_RESULT, &end);
+
+    lastRenderTimeDouble = (double) (end - begin) / 1000000.0;
+    lastRenderTime = lastRenderTimeDouble;
+
+    return lastRenderTime;
+}
+
 /**
  * @brief Is used shared context?
  * @return True if object uses any parenthal shared context
@@ -104,6 +226,18 @@ bool OpenGLWrapper::hasSharedContext()
     return ret;
 }
 
+/**
+ * @brief Can OpenGL context be created?
+ * @return False if object was created without QGuiApplication
+ *
+ * Calls of invalid object are skipped with error message, it can be only deleted. For headless rendering
+ * select CONTEXT_BACKEND_EGL by setContextBackend() before creating application.
+ */
+bool OpenGLWrapper::isValid() const
+{
+    return valid;
+}
+
 /**
  * @brief Is surface class QSurface::Window?
  * @return True if surface class is type of QSurface::Window
@@ -195,9 +329,15 @@ HDC OpenGLWrapper::getHDC() const
 
 /**
  * @brief Checks initialization of OpenGL context and makes context current
+ * @return False if object is not valid (see isValid()), OpenGL must not be called then
  */
-void OpenGLWrapper::checkInitAndMakeCurrentContext()
+bool OpenGLWrapper::checkInitAndMakeCurrentContext()
 {
+    if (!valid) {
+        qCritical() << "OpenGLWrapper::checkInitAndMakeCurrentContext error: object is not valid (see isValid())";
+        return false;
+    }
+
     if (!context)
         createContext();
 
@@ -207,6 +347,8 @@ void OpenGLWrapper::checkInitAndMakeCurrentContext()
         initialized = true;
         initialize();
     }
+
+    return true;
 }
 
 /**
@@ -290,14 +432,60 @@ QString OpenGLWrapper::getGLFramebufferStatusString(GLenum errorCode) const
     return ret;
 }
 
+/**
+ * @brief Sets directory of on-disk program binary cache
+ * @param[in] directory Cache directory (empty string disables cache)
+ *
+ * With cache, shaders are compiled in linkProgram only if binary of the same program
+ * is not cached for this driver. Set it before initialization of context.
+ */
+void OpenGLWrapper::setProgramBinaryCacheDirectory(const QString &directory)
+{
+    programBinaryCacheDirectory = directory;
+    delete programBinaryCache;
+    programBinaryCache = 0;
+}
+
+/**
+ * @brief Returns directory of on-disk program binary cache
+ * @return Cache directory (empty if cache is disabled)
+ */
+QString OpenGLWrapper::getProgramBinaryCacheDirectory() const
+{
+    return programBinaryCacheDirectory;
+}
+
 /**
  * @brief Adds shader from source file to program
  * @param[in, out] program OpenGL shader program
  * @param[in] type Shader type
  * @param[in] filename Path to shader source file
+ * @param[in] defines Optional preprocessor definitions inserted after #version line
  */
-void OpenGLWrapper::addShader(QOpenGLShaderProgram *program, QOpenGLShader::ShaderType type, QString filename)
+void OpenGLWrapper::addShader(QOpenGLShaderProgram *program, QOpenGLShader::ShaderType type, QString filename, QString defines)
 {
+    if (isProgramDeferred(program) || !defines.isEmpty()) {
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qCritical() << "OpenGL shader file open error" << filename;
+            return;
+        }
+        QString source = QString::fromUtf8(file.readAll());
+        if (!defines.isEmpty())
+            source.insert(source.indexOf('\n') + 1, defines);
+
+        if (isProgramDeferred(program)) {
+            addDeferredShaderSource(program, type, source);
+            return;
+        }
+
+        bool status;
+        status = program->addShaderFromSourceCode(type, source);
+        if (!status && !isloggingEnabled())
+            qCritical() << "OpenGL shader compile and add error" << program->log();
+        return;
+    }
+
     bool status;
     status = program->addShaderFromSourceFile(type, filename);
     if (!status && !isloggingEnabled())
@@ -312,6 +500,11 @@ void OpenGLWrapper::addShader(QOpenGLShaderProgram *program, QOpenGLShader::Shad
  */
 void OpenGLWrapper::addShaderFromSource(QOpenGLShaderProgram *program, QOpenGLShader *shader, QString source)
 {
+    if (isProgramDeferred(program)) {
+        addDeferredShaderSource(program, shader->shaderType(), source);
+        return;
+    }
+
     bool status;
     status = shader->compileSourceCode(source);
     if (!status && !isloggingEnabled())
@@ -321,18 +514,215 @@ void OpenGLWrapper::addShaderFromSource(QOpenGLShaderProgram *program, QOpenGLSh
         qCritical() << "OpenGL shader add error" << program->log();
 }
 
+/**
+ * @brief Removes shader from program
+ * @param[in, out] program OpenGL shader program
+ * @param[in] shader OpenGL shader
+ *
+ * Programs with deferred compilation remove source of the same shader type.
+ */
+void OpenGLWrapper::removeShader(QOpenGLShaderProgram *program, QOpenGLShader *shader)
+{
+    if (isProgramDeferred(program)) {
+        QVariantList types = program->property("shaderTypes").toList();
+        QStringList sources = program->property("shaderSources").toStringList();
+        for (int i = types.size() - 1; i >= 0; i--) {
+            if (types.at(i).toInt() == int(shader->shaderType())) {
+                types.removeAt(i);
+                sources.removeAt(i);
+            }
+        }
+        program->setProperty("shaderTypes", types);
+        program->setProperty("shaderSources", sources);
+        return;
+    }
+
+    program->removeShader(shader);
+}
+
 /**
  * @brief Links shader program
  * @param[in, out] program OpenGL shader program
+ * @param[in] degree Degree of Bernstein polynomial of generated shaders (part of cache key)
+ *
+ * Programs with deferred compilation are loaded from program binary cache, or compiled,
+ * linked and stored to cache.
  */
-void OpenGLWrapper::linkProgram(QOpenGLShaderProgram *program)
+void OpenGLWrapper::linkProgram(QOpenGLShaderProgram *program, int degree)
 {
     bool status;
+
+    if (isProgramDeferred(program)) {
+        QVariantList types = program->property("shaderTypes").toList();
+        QStringList sources = program->property("shaderSources").toStringList();
+        QByteArray key = programBinaryCache->key(sources, degree);
+
+        program->removeAllShaders();
+
+        // Program without shaders is marked as linked by link() if binary was loaded
+        if (programBinaryCache->load(program->programId(), key) && program->link())
+            return;
+
+        for (int i = 0; i < sources.size(); i++) {
+            status = program->addShaderFromSourceCode(QOpenGLShader::ShaderType(types.at(i).toInt()), sources.at(i));
+            if (!status && !isloggingEnabled())
+                qCritical() << "OpenGL shader compile and add error" << program->log();
+        }
+
+        programBinaryCache->setRetrievableHint(program->programId());
+        status = program->link();
+        if (!status && !isloggingEnabled())
+            qCritical() << "OpenGL shader link error" << program->log();
+        else if (status)
+            programBinaryCache->save(program->programId(), key);
+        return;
+    }
+
     status = program->link();
     if (!status && !isloggingEnabled())
         qCritical() << "OpenGL shader link error" << program->log();
 }
 
+/**
+ * @brief Is compilation of program deferred to linkProgram because of program binary cache?
+ * @param[in, out] program OpenGL shader program
+ * @return True if shader sources are collected and compiled only on cache miss
+ *
+ * Mode is selected with the first shader of program and is kept by program.
+ */
+bool OpenGLWrapper::isProgramDeferred(QOpenGLShaderProgram *program)
+{
+    QVariant deferred = program->property("deferredCompilation");
+    if (deferred.isValid())
+        return deferred.toBool();
+
+    bool enabled = false;
+    if (!programBinaryCacheDirectory.isEmpty()) {
+        if (!programBinaryCache) {
+            programBinaryCache = new ProgramBinaryCache(programBinaryCacheDirectory);
+            if (!programBinaryCache->initialize(this))
+                qWarning() << "Program binaries are not supported, program binary cache is disabled";
+        }
+        enabled = programBinaryCache->isSupported();
+    }
+
+    program->setProperty("deferredCompilation", enabled);
+    return enabled;
+}
+
+/**
+ * @brief Adds shader source to program with deferred compilation
+ * @param[in, out] program OpenGL shader program
+ * @param[in] type Shader type
+ * @param[in] source Shader string source
+ */
+void OpenGLWrapper::addDeferredShaderSource(QOpenGLShaderProgram *program, QOpenGLShader::ShaderType type, QString source)
+{
+    QVariantList types = program->property("shaderTypes").toList();
+    QStringList sources = program->property("shaderSources").toStringList();
+    types.append(int(type));
+    sources.append(source);
+    program->setProperty("shaderTypes", types);
+    program->setProperty("shaderSources", sources);
+}
+
+/**
+ * @brief Selects OpenGL context backend
+ * @param[in] backend Context backend
+ *
+ * Has to be called before QGuiApplication and the first OpenGLWrapper are created. The EGL
+ * backend selects the eglfs platform plugin without display integration and, for Mesa,
+ * the surfaceless EGL platform, so offscreen surfaces become surfaceless contexts or
+ * pbuffers. Already set environment variables (QT_QPA_PLATFORM, QT_QPA_EGLFS_INTEGRATION,
+ * EGL_PLATFORM) are kept, e.g. EGL_PLATFORM=device for headless NVIDIA drivers.
+ * The backend can be also selected by SSIMR_CONTEXT_BACKEND=egl environment variable, which
+ * is read when the first OpenGLWrapper is created, so it affects only the internal headless
+ * application (application created by user needs setContextBackend()).
+ */
+void OpenGLWrapper::setContextBackend(ContextBackend backend)
+{
+    if (QCoreApplication::instance() && backend != contextBackend) {
+        qWarning() << "OpenGLWrapper::setContextBackend warning: application already exists, platform plugin can not be changed";
+    }
+
+    contextBackend = backend;
+    contextBackendSelected = true;
+
+    if (contextBackend == CONTEXT_BACKEND_EGL)
+        setEGLPlatformEnvironment();
+}
+
+/**
+ * @brief Returns selected OpenGL context backend
+ * @return Context backend
+ */
+OpenGLWrapper::ContextBackend OpenGLWrapper::getContextBackend()
+{
+    selectDefaultContextBackend();
+    return contextBackend;
+}
+
+/**
+ * @brief Selects default context backend by SSIMR_CONTEXT_BACKEND environment variable
+ *
+ * Does nothing if backend was already selected by setContextBackend() or by previous call.
+ */
+void OpenGLWrapper::selectDefaultContextBackend()
+{
+    if (contextBackendSelected)
+        return;
+
+    contextBackendSelected = true;
+    if (qgetenv("SSIMR_CONTEXT_BACKEND").toLower() == "egl") {
+        contextBackend = CONTEXT_BACKEND_EGL;
+        setEGLPlatformEnvironment();
+    }
+}
+
+/**
+ * @brief Sets environment of headless EGL platform plugin, already set variables are kept
+ */
+void OpenGLWrapper::setEGLPlatformEnvironment()
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "eglfs");
+    if (!qEnvironmentVariableIsSet("QT_QPA_EGLFS_INTEGRATION"))
+        qputenv("QT_QPA_EGLFS_INTEGRATION", "none");
+    if (!qEnvironmentVariableIsSet("EGL_PLATFORM"))
+        qputenv("EGL_PLATFORM", "surfaceless");
+}
+
+/**
+ * @brief Checks application needed by Qt OpenGL classes
+ * @return True if QGuiApplication is available
+ *
+ * With the EGL backend and without any application (render server without Qt event loop)
+ * creates internal headless QGuiApplication. QOpenGLContext can not be created in plain
+ * QCoreApplication, the application has to be QGuiApplication created after
+ * setContextBackend(CONTEXT_BACKEND_EGL).
+ */
+bool OpenGLWrapper::checkApplication()
+{
+    if (!QCoreApplication::instance() && contextBackend == CONTEXT_BACKEND_EGL) {
+        static int argc = 1;
+        static char arg0[] = "ssimrenderer";
+        static char *argv[] = { arg0, 0 };
+        // Lives until the end of process, as application created by user would
+        headlessApplication = new QGuiApplication(argc, argv);
+    }
+
+    if (!qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
+        qCritical() << "OpenGLWrapper::checkApplication error: OpenGL context requires QGuiApplication, select CONTEXT_BACKEND_EGL before creating application for headless rendering";
+        return false;
+    }
+
+    if (contextBackend == CONTEXT_BACKEND_EGL && !QGuiApplication::platformName().contains("egl")) {
+        qWarning() << "OpenGLWrapper::checkApplication warning: EGL backend selected, but platform plugin is" << QGuiApplication::platformName();
+    }
+
+    return true;
+}
+
 /**
  * @brief Initializes surface
  * @param[in, out] surface Surface
@@ -345,6 +735,9 @@ void OpenGLWrapper::initSurface(QSurface *surface) {
         ((QWindow *) activeSurface)->setSurfaceType(QWindow::OpenGLSurface);
         surfaceFormat = ((QWindow *) activeSurface)->requestedFormat();
     } else {
+        // Offscreen surface may be constructed before internal headless application
+        if (!((QOffscreenSurface *) activeSurface)->screen())
+            ((QOffscreenSurface *) activeSurface)->setScreen(QGuiApplication::primaryScreen());
         surfaceFormat = ((QOffscreenSurface *) activeSurface)->requestedFormat();
     }
 
@@ -393,10 +786,10 @@ void OpenGLWrapper::createContext()
 
         hGLRC = 0;
         hDC = 0;
-#ifdef USE_OPENCL
+#if defined(USE_OPENCL) && defined(Q_OS_WIN)
         hGLRC = wglGetCurrentContext();
         hDC = wglGetCurrentDC();
-#endif // USE_OPENCL
+#endif // USE_OPENCL && Q_OS_WIN
 
         if (hasDebugExtension()) {
             logger = new QOpenGLDebugLogger();
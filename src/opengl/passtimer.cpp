@@ -0,0 +1,224 @@
+/**
+ * @file        passtimer.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The implementation file containing the PassTimer class.
+ *
+ * GPU times of rendering passes are measured by GL_TIME_ELAPSED queries.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "opengl/passtimer.h"
+
+#include <QtMath>
+
+#include <algorithm>
+
+namespace SSIMRenderer
+{
+/**
+ * @brief Creates PassTimer with size of rolling window
+ * @param[in] windowSize Number of last samples used for statistics
+ */
+PassTimer::PassTimer(int windowSize)
+    : functions(0)
+    , enabled(false)
+    , windowSize(qMax(1, windowSize))
+    , active(false)
+{
+    activeQuery.query = 0;
+}
+
+/**
+ * @brief Destructor of PassTimer object
+ *
+ * Query objects must be deleted by destroy() with current context.
+ */
+PassTimer::~PassTimer()
+{
+
+}
+
+/**
+ * @brief Initializes timer
+ * @param[in] functions OpenGL functions of current context
+ */
+void PassTimer::initialize(OPENGL_FUNCTIONS *functions)
+{
+    this->functions = functions;
+}
+
+/**
+ * @brief Deletes all query objects
+ *
+ * OpenGL context of timer must be current.
+ */
+void PassTimer::destroy()
+{
+    if (functions && !queries.isEmpty())
+        functions->glDeleteQueries(queries.size(), queries.data());
+
+    queries.clear();
+    freeQueries.clear();
+    pendingQueries.clear();
+    active = false;
+}
+
+/**
+ * @brief Enables or disables timers
+ * @param[in] value Boolean flag
+ */
+void PassTimer::setEnabled(bool value)
+{
+    enabled = value;
+}
+
+/**
+ * @brief Are timers enabled?
+ * @return True if timers are enabled
+ */
+bool PassTimer::isEnabled() const
+{
+    return enabled;
+}
+
+/**
+ * @brief Begins measuring of pass
+ * @param[in] pass Name of pass
+ */
+void PassTimer::begin(const QString &pass)
+{
+    if (!enabled || !functions)
+        return;
+
+    if (active) {
+        qWarning() << "PassTimer::begin warning: pass" << pass << "is nested in" << activeQuery.pass;
+        return;
+    }
+
+    if (freeQueries.isEmpty()) {
+        GLuint query;
+        functions->glGenQueries(1, &query);
+        queries.append(query);
+        freeQueries.append(query);
+    }
+
+    activeQuery.pass = pass;
+    activeQuery.query = freeQueries.takeLast();
+    active = true;
+
+    functions->glBeginQuery(GL_TIME_ELAPSED, activeQuery.query);
+}
+
+/**
+ * @brief Ends measuring of current pass
+ */
+void PassTimer::end()
+{
+    if (!active)
+        return;
+
+    functions->glEndQuery(GL_TIME_ELAPSED);
+    pendingQueries.enqueue(activeQuery);
+    active = false;
+}
+
+/**
+ * @brief Reads results of finished queries without waiting
+ *
+ * Queries finish in order, reading stops at first unfinished query.
+ */
+void PassTimer::collect()
+{
+    if (!functions)
+        return;
+
+    while (!pendingQueries.isEmpty()) {
+        const PendingQuery &pendingQuery = pendingQueries.head();
+
+        GLint available = 0;
+        functions->glGetQueryObjectiv(pendingQuery.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 elapsed = 0;
+        functions->glGetQueryObjectui64v(pendingQuery.query, GL_QUERY_RESULT, &elapsed);
+
+        if (!samples.contains(pendingQuery.pass))
+            passes.append(pendingQuery.pass);
+
+        QQueue<double> &window = samples[pendingQuery.pass];
+        window.enqueue(double(elapsed) / 1000000.0);
+        if (window.size() > windowSize)
+            window.dequeue();
+
+        freeQueries.append(pendingQuery.query);
+        pendingQueries.dequeue();
+    }
+}
+
+/**
+ * @brief Returns rolling statistics of pass
+ * @param[in] pass Name of pass
+ * @return Minimal, mean, 95th percentile and last time in milliseconds
+ */
+PassTimer::Stats PassTimer::getStats(const QString &pass) const
+{
+    Stats stats;
+    stats.min = 0;
+    stats.mean = 0;
+    stats.p95 = 0;
+    stats.last = 0;
+    stats.count = 0;
+
+    if (!samples.contains(pass))
+        return stats;
+
+    QVector<double> sorted = samples.value(pass).toVector();
+    if (sorted.isEmpty())
+        return stats;
+
+    stats.last = sorted.last();
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0;
+    for (int i = 0; i < sorted.size(); i++)
+        sum += sorted.at(i);
+
+    stats.count = sorted.size();
+    stats.min = sorted.first();
+    stats.mean = sum / sorted.size();
+    stats.p95 = sorted.at(qMax(0, int(qCeil(0.95 * sorted.size())) - 1));
+
+    return stats;
+}
+
+/**
+ * @brief Returns names of measured passes
+ * @return List of passes in order of the first measurement
+ */
+QStringList PassTimer::getPasses() const
+{
+    return passes;
+}
+
+/**
+ * @brief Clears all samples
+ */
+void PassTimer::reset()
+{
+    passes.clear();
+    samples.clear();
+}
+}
@@ -0,0 +1,247 @@
+/**
+ * @file        programbinarycache.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The implementation file containing the ProgramBinaryCache class.
+ *
+ * Linked programs are stored by glGetProgramBinary and loaded by glProgramBinary,
+ * so short-lived processes do not compile the same shaders again.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "opengl/programbinarycache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace SSIMRenderer
+{
+/// Magic number and version of cache files
+static const quint32 PROGRAM_BINARY_MAGIC = 0x53534231;
+
+/**
+ * @brief Creates ProgramBinaryCache
+ * @param[in] directory Directory of cache files (created if it does not exist)
+ */
+ProgramBinaryCache::ProgramBinaryCache(const QString &directory)
+    : functions(0)
+    , glGetProgramBinary(0)
+    , glProgramBinary(0)
+    , glProgramParameteri(0)
+    , directory(directory)
+    , supported(false)
+{
+
+}
+
+/**
+ * @brief Destructor of ProgramBinaryCache object
+ *
+ * Does nothing.
+ */
+ProgramBinaryCache::~ProgramBinaryCache()
+{
+
+}
+
+/**
+ * @brief Initializes cache with current OpenGL context
+ * @param[in] functions OpenGL functions of current context
+ * @return True if program binaries are supported
+ */
+bool ProgramBinaryCache::initialize(OPENGL_FUNCTIONS *functions)
+{
+    this->functions = functions;
+    supported = false;
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return false;
+
+    QPair<int, int> version = context->format().version();
+    if (version < qMakePair(4, 1) && !context->hasExtension("GL_ARB_get_program_binary"))
+        return false;
+
+    GLint numberOfFormats = 0;
+    functions->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numberOfFormats);
+    if (numberOfFormats <= 0)
+        return false;
+
+    glGetProgramBinary = (GetProgramBinary) context->getProcAddress("glGetProgramBinary");
+    glProgramBinary = (ProgramBinary) context->getProcAddress("glProgramBinary");
+    glProgramParameteri = (ProgramParameteri) context->getProcAddress("glProgramParameteri");
+    if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri)
+        return false;
+
+    if (!QDir().mkpath(directory)) {
+        qWarning() << "Program binary cache directory" << directory << "can not be created";
+        return false;
+    }
+
+    // Binaries are valid only for the same driver
+    driver.clear();
+    driver.append((const char *) functions->glGetString(GL_VENDOR)).append('\n');
+    driver.append((const char *) functions->glGetString(GL_RENDERER)).append('\n');
+    driver.append((const char *) functions->glGetString(GL_VERSION));
+
+    supported = true;
+    return supported;
+}
+
+/**
+ * @brief Are program binaries supported?
+ * @return True if cache can be used
+ */
+bool ProgramBinaryCache::isSupported() const
+{
+    return supported;
+}
+
+/**
+ * @brief Returns directory of cache files
+ * @return Directory
+ */
+QString ProgramBinaryCache::getDirectory() const
+{
+    return directory;
+}
+
+/**
+ * @brief Computes cache key of program
+ * @param[in] sources Sources of all shaders of program
+ * @param[in] degree Degree of Bernstein polynomial (-1 for programs without generated shaders)
+ * @return Hexadecimal key
+ */
+QByteArray ProgramBinaryCache::key(const QStringList &sources, int degree) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(driver);
+    foreach (const QString &source, sources) {
+        hash.addData("\0", 1);
+        hash.addData(source.toUtf8());
+    }
+    QByteArray key = hash.result().toHex();
+    if (degree >= 0)
+        key.append("_d").append(QByteArray::number(degree));
+    return key;
+}
+
+/**
+ * @brief Sets hint for retrieving of binary before linking
+ * @param[in] program Shader program id
+ */
+void ProgramBinaryCache::setRetrievableHint(GLuint program)
+{
+    if (supported)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+/**
+ * @brief Loads binary to program
+ * @param[in] program Shader program id
+ * @param[in] key Cache key
+ * @return True if program is linked from cached binary
+ *
+ * Rejected binaries (e.g. after driver update) are removed from cache.
+ */
+bool ProgramBinaryCache::load(GLuint program, const QByteArray &key)
+{
+    if (!supported)
+        return false;
+
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    quint32 magic = 0, format = 0;
+    QByteArray binary;
+    stream >> magic >> format >> binary;
+    file.close();
+
+    if (stream.status() != QDataStream::Ok || magic != PROGRAM_BINARY_MAGIC || binary.isEmpty()) {
+        QFile::remove(filePath(key));
+        return false;
+    }
+
+    glProgramBinary(program, (GLenum) format, binary.constData(), binary.size());
+
+    GLint status = 0;
+    functions->glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        QFile::remove(filePath(key));
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Stores binary of linked program
+ * @param[in] program Linked shader program id
+ * @param[in] key Cache key
+ * @return True if binary was written
+ */
+bool ProgramBinaryCache::save(GLuint program, const QByteArray &key)
+{
+    if (!supported)
+        return false;
+
+    GLint length = 0;
+    functions->glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+
+    QByteArray binary(length, 0);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    binary.resize(length);
+
+    // Atomic write, concurrent workers can share directory
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Program binary cache file" << file.fileName() << "can not be written";
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << PROGRAM_BINARY_MAGIC << (quint32) format << binary;
+    return file.commit();
+}
+
+/**
+ * @brief Returns path of cache file
+ * @param[in] key Cache key
+ * @return File path
+ */
+QString ProgramBinaryCache::filePath(const QByteArray &key) const
+{
+    return QDir(directory).filePath(QString::fromLatin1(key) + ".bin");
+}
+}
@@ -0,0 +1,298 @@
+/**
+ * @file        rendertargetpool.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The implementation file containing the RenderTargetPool class.
+ *
+ * Released targets are kept and reused for the same (format, width, height),
+ * so switching of render sizes does not reallocate GPU memory.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "opengl/rendertargetpool.h"
+
+namespace SSIMRenderer
+{
+/**
+ * @brief Creates RenderTargetPool
+ * @param[in] maxFreeTargets Max number of unused targets kept in pool
+ */
+RenderTargetPool::RenderTargetPool(int maxFreeTargets)
+    : functions(0)
+    , maxFreeTargets(qMax(0, maxFreeTargets))
+{
+
+}
+
+/**
+ * @brief Destructor of RenderTargetPool object
+ *
+ * Targets must be deleted by destroy() with current context.
+ */
+RenderTargetPool::~RenderTargetPool()
+{
+
+}
+
+/**
+ * @brief Attaches renderer to pool
+ * @param[in] functions OpenGL functions of renderer context
+ *
+ * Pool uses functions of the first attached renderer which is still alive.
+ */
+void RenderTargetPool::attach(OPENGL_FUNCTIONS *functions)
+{
+    if (!functions || attachedFunctions.contains(functions))
+        return;
+
+    attachedFunctions.append(functions);
+    this->functions = attachedFunctions.first();
+}
+
+/**
+ * @brief Detaches renderer from pool
+ * @param[in] functions OpenGL functions of renderer context
+ * @return True if renderer was the last attached, pool should be destroyed and deleted then
+ *
+ * Functions of the last renderer are kept for destroy().
+ */
+bool RenderTargetPool::detach(OPENGL_FUNCTIONS *functions)
+{
+    attachedFunctions.removeAll(functions);
+    if (attachedFunctions.isEmpty())
+        return true;
+
+    this->functions = attachedFunctions.first();
+    return false;
+}
+
+/**
+ * @brief Deletes all targets
+ *
+ * OpenGL context of pool must be current.
+ */
+void RenderTargetPool::destroy()
+{
+    if (functions) {
+        for (int i = 0; i < freeTargets.size(); i++)
+            deleteTarget(freeTargets.at(i));
+        foreach (const Target &target, usedTextures)
+            deleteTarget(target);
+        foreach (const Target &target, usedRenderbuffers)
+            deleteTarget(target);
+    }
+
+    freeTargets.clear();
+    usedTextures.clear();
+    usedRenderbuffers.clear();
+}
+
+/**
+ * @brief Acquires 2D texture
+ * @param[in] internalFormat Texture format (R, RG or RGBA formats with 8, 16F or 32F bits)
+ * @param[in] width Texture width
+ * @param[in] height Texture height
+ * @return Texture id, 0 on error
+ *
+ * Texture content is undefined.
+ */
+GLuint RenderTargetPool::acquireTexture(GLenum internalFormat, GLuint width, GLuint height)
+{
+    if (getBaseFormat(internalFormat) == 0) {
+        qCritical() << "RenderTargetPool::acquireTexture error: unsupported format" << internalFormat;
+        return 0;
+    }
+
+    return acquire(internalFormat, width, height, false);
+}
+
+/**
+ * @brief Returns texture to pool
+ * @param[in] texture Texture id
+ */
+void RenderTargetPool::releaseTexture(GLuint texture)
+{
+    release(usedTextures, texture);
+}
+
+/**
+ * @brief Acquires renderbuffer
+ * @param[in] internalFormat Renderbuffer format
+ * @param[in] width Renderbuffer width
+ * @param[in] height Renderbuffer height
+ * @return Renderbuffer id, 0 on error
+ */
+GLuint RenderTargetPool::acquireRenderbuffer(GLenum internalFormat, GLuint width, GLuint height)
+{
+    return acquire(internalFormat, width, height, true);
+}
+
+/**
+ * @brief Returns renderbuffer to pool
+ * @param[in] renderbuffer Renderbuffer id
+ */
+void RenderTargetPool::releaseRenderbuffer(GLuint renderbuffer)
+{
+    release(usedRenderbuffers, renderbuffer);
+}
+
+/**
+ * @brief Deletes the oldest unused targets over limit
+ * @param[in] maxFreeTargets Max number of kept unused targets
+ */
+void RenderTargetPool::trim(int maxFreeTargets)
+{
+    while (freeTargets.size() > qMax(0, maxFreeTargets)) {
+        deleteTarget(freeTargets.first());
+        freeTargets.removeFirst();
+    }
+}
+
+/**
+ * @brief Returns number of all targets
+ * @return Number of used and unused targets
+ */
+int RenderTargetPool::getNumberOfTargets() const
+{
+    return freeTargets.size() + usedTextures.size() + usedRenderbuffers.size();
+}
+
+/**
+ * @brief Returns number of unused targets
+ * @return Number of unused targets
+ */
+int RenderTargetPool::getNumberOfFreeTargets() const
+{
+    return freeTargets.size();
+}
+
+/**
+ * @brief Returns base format of supported texture format
+ * @param[in] internalFormat Texture format
+ * @return GL_RED, GL_RG or GL_RGBA, 0 for unsupported format
+ */
+GLenum RenderTargetPool::getBaseFormat(GLenum internalFormat)
+{
+    switch (internalFormat) {
+    case GL_R8:
+    case GL_R16F:
+    case GL_R32F:
+        return GL_RED;
+    case GL_RG8:
+    case GL_RG16F:
+    case GL_RG32F:
+        return GL_RG;
+    case GL_RGBA8:
+    case GL_RGBA16F:
+    case GL_RGBA32F:
+        return GL_RGBA;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Finds unused target or creates new one
+ * @param[in] internalFormat Target format
+ * @param[in] width Target width
+ * @param[in] height Target height
+ * @param[in] renderbuffer Is target renderbuffer?
+ * @return Target id, 0 on error
+ */
+GLuint RenderTargetPool::acquire(GLenum internalFormat, GLuint width, GLuint height, bool renderbuffer)
+{
+    if (!functions) {
+        qCritical() << "RenderTargetPool::acquire error: pool is not initialized";
+        return 0;
+    }
+
+    Target target;
+    target.id = 0;
+
+    // The most recently released target first
+    for (int i = freeTargets.size() - 1; i >= 0; i--) {
+        const Target &freeTarget = freeTargets.at(i);
+        if (freeTarget.renderbuffer == renderbuffer && freeTarget.internalFormat == internalFormat
+                && freeTarget.width == width && freeTarget.height == height) {
+            target = freeTarget;
+            freeTargets.remove(i);
+            break;
+        }
+    }
+
+    if (target.id == 0) {
+        target.internalFormat = internalFormat;
+        target.width = width;
+        target.height = height;
+        target.renderbuffer = renderbuffer;
+
+        if (renderbuffer) {
+            functions->glGenRenderbuffers(1, &target.id);
+            functions->glBindRenderbuffer(GL_RENDERBUFFER, target.id);
+            functions->glRenderbufferStorage(GL_RENDERBUFFER, internalFormat, width, height);
+            functions->glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        } else {
+            functions->glGenTextures(1, &target.id);
+            functions->glBindTexture(GL_TEXTURE_2D, target.id);
+            functions->glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, getBaseFormat(internalFormat), GL_FLOAT, 0);
+            functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            functions->glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    }
+
+    if (renderbuffer)
+        usedRenderbuffers.insert(target.id, target);
+    else
+        usedTextures.insert(target.id, target);
+
+    return target.id;
+}
+
+/**
+ * @brief Moves used target to unused targets
+ * @param[in] usedTargets Used textures or renderbuffers
+ * @param[in] id Target id
+ */
+void RenderTargetPool::release(QHash<GLuint, Target> &usedTargets, GLuint id)
+{
+    if (id == 0)
+        return;
+
+    if (!usedTargets.contains(id)) {
+        qWarning() << "RenderTargetPool::release warning: target" << id << "is not from pool";
+        return;
+    }
+
+    freeTargets.append(usedTargets.take(id));
+    trim(maxFreeTargets);
+}
+
+/**
+ * @brief Deletes OpenGL object of target
+ * @param[in] target Target
+ */
+void RenderTargetPool::deleteTarget(const Target &target)
+{
+    if (!functions)
+        return;
+
+    if (target.renderbuffer)
+        functions->glDeleteRenderbuffers(1, &target.id);
+    else
+        functions->glDeleteTextures(1, &target.id);
+}
+}
@@ -0,0 +1,432 @@
+/**
+ * @file        densityraycastercpu.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The implementation file containing the DensityRayCasterCPU class.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "rendering/densityraycastercpu.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define SSIMR_USE_SSE
+#endif
+
+namespace SSIMRenderer
+{
+/**
+ * @brief Creates DensityRayCasterCPU with render width and height and number of threads
+ * @param[in] renderWidth Render width
+ * @param[in] renderHeight Render height
+ * @param[in] numberOfThreads Number of threads (0 = number of CPU cores)
+ */
+DensityRayCasterCPU::DensityRayCasterCPU(unsigned int renderWidth, unsigned int renderHeight, int numberOfThreads)
+    : DensityRendererCPU(renderWidth, renderHeight, numberOfThreads)
+    , roiTilesX(0)
+{
+
+}
+
+/**
+ * @brief Destructor of DensityRayCasterCPU object
+ *
+ * Does nothing.
+ */
+DensityRayCasterCPU::~DensityRayCasterCPU()
+{
+
+}
+
+/**
+ * @brief Sets tetrahedral mesh and generates its adjacency and boundary faces
+ * @param[in] mesh Mesh
+ */
+void DensityRayCasterCPU::setMesh(Mesh *mesh)
+{
+    DensityRendererCPU::setMesh(mesh);
+    if (!mesh)
+        return;
+
+    QVector<int> tetrahedraAdjacency = mesh->getTetrahedraAdjacency();
+    adjacency.assign(tetrahedraAdjacency.constBegin(), tetrahedraAdjacency.constEnd());
+
+    boundaryFaces.clear();
+    for (size_t i = 0; i < adjacency.size(); i++) {
+        if (adjacency[i] < 0)
+            boundaryFaces.push_back((unsigned int) i);
+    }
+}
+
+/**
+ * @brief Sets region of interest
+ * @param[in] rect Rectangle of rendered pixels (rows in OpenGL bottom-up order), null rect = whole image
+ *
+ * Density outside of region of interest is 0.
+ */
+void DensityRayCasterCPU::setRegionOfInterest(const QRect &rect)
+{
+    regionOfInterest = rect;
+}
+
+/**
+ * @brief Returns region of interest
+ * @return Rectangle of rendered pixels, null rect = whole image
+ */
+QRect DensityRayCasterCPU::getRegionOfInterest() const
+{
+    return regionOfInterest;
+}
+
+/**
+ * @brief Main render function
+ * @return Elapsed time in milliseconds (integer)
+ *
+ * Tiles of region of interest are split to contiguous queues of threads, thread with empty
+ * queue steals tiles from queues of other threads.
+ */
+int DensityRayCasterCPU::renderNow()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!prepareData())
+        return 0;
+
+    if (adjacency.size() != size_t(mesh->getNumberOfTetrahedra()) * 4) {
+        qCritical() << "DensityRayCasterCPU::renderNow error: adjacency does not match Mesh";
+        return 0;
+    }
+
+    bool invertible = false;
+    QMatrix4x4 matrixInv = matrix.inverted(&invertible);
+    if (!invertible) {
+        qCritical() << "DensityRayCasterCPU::renderNow error: matrix is not invertible";
+        return 0;
+    }
+
+    density.assign(size_t(renderWidth) * renderHeight, 0.0f);
+
+    QRect roi(0, 0, int(renderWidth), int(renderHeight));
+    if (!regionOfInterest.isNull())
+        roi = roi.intersected(regionOfInterest);
+
+    if (!roi.isEmpty()) {
+        roiTilesX = (roi.width() + TILE_SIZE - 1) / TILE_SIZE;
+        int numberOfTiles = roiTilesX * ((roi.height() + TILE_SIZE - 1) / TILE_SIZE);
+        setupBoundaryFaces(roi);
+
+        int threads = qMin(numberOfThreads, numberOfTiles);
+        std::vector<std::atomic<int> >(threads).swap(queueNext);
+        queueEnd.resize(threads);
+        for (int i = 0; i < threads; i++) {
+            queueNext[i] = int(long(numberOfTiles) * i / threads);
+            queueEnd[i] = int(long(numberOfTiles) * (i + 1) / threads);
+        }
+
+        parallelRun(threads, [&](int thread) {
+            for (int i = 0; i < threads; i++) {
+                int queue = (thread + i) % threads;
+                for (int tile = queueNext[queue]++; tile < queueEnd[queue]; tile = queueNext[queue]++)
+                    castTile(tile, roi, matrixInv);
+            }
+        });
+    }
+
+    qint64 elapsed = timer.nsecsElapsed();
+    lastRenderTimeDouble = (double) elapsed / 1000000.0;
+    lastRenderTime = int(lastRenderTimeDouble);
+
+    return lastRenderTime;
+}
+
+/**
+ * @brief Projects boundary faces to window space and bins them to tiles of region of interest
+ * @param[in] roi Region of interest
+ *
+ * Faces with a vertex behind the eye are skipped.
+ */
+void DensityRayCasterCPU::setupBoundaryFaces(const QRect &roi)
+{
+    const unsigned int *tetrahedra = mesh->getTableOfTetrahedra();
+    const float *m = matrix.constData();
+
+    projectedFaces.clear();
+    bins.resize(roiTilesX * ((roi.height() + TILE_SIZE - 1) / TILE_SIZE));
+    for (size_t i = 0; i < bins.size(); i++)
+        bins[i].clear();
+
+    for (size_t i = 0; i < boundaryFaces.size(); i++) {
+        unsigned int tetrahedron = boundaryFaces[i] / 4;
+        unsigned int face = boundaryFaces[i] % 4;
+
+        BoundaryFace projected;
+        projected.face = boundaryFaces[i];
+        bool visible = true;
+        for (unsigned int v = 0, k = 0; v < 4; v++) {
+            if (v == face)
+                continue;
+            const float *p = positions.data() + tetrahedra[tetrahedron * 4 + v] * 3;
+            float x = xMirroringEnabled ? -p[0] : p[0];
+            float clip[4];
+            for (int r = 0; r < 4; r++)
+                clip[r] = m[r] * x + m[4 + r] * p[1] + m[8 + r] * p[2] + m[12 + r];
+            visible = visible && clip[3] > 0;
+            projected.x[k] = (clip[0] / clip[3] * 0.5f + 0.5f) * renderWidth;
+            projected.y[k] = (clip[1] / clip[3] * 0.5f + 0.5f) * renderHeight;
+            k++;
+        }
+
+        float area = (projected.x[1] - projected.x[0]) * (projected.y[2] - projected.y[0]) - (projected.x[2] - projected.x[0]) * (projected.y[1] - projected.y[0]);
+        if (!visible || area == 0 || !std::isfinite(area))
+            continue;
+        if (area < 0) {
+            std::swap(projected.x[1], projected.x[2]);
+            std::swap(projected.y[1], projected.y[2]);
+        }
+
+        // Pixels with centers in bounding box
+        float x0 = qMax(float(roi.left()), std::ceil(qMin(projected.x[0], qMin(projected.x[1], projected.x[2])) - 0.5f));
+        float x1 = qMin(float(roi.right()), std::floor(qMax(projected.x[0], qMax(projected.x[1], projected.x[2])) - 0.5f));
+        float y0 = qMax(float(roi.top()), std::ceil(qMin(projected.y[0], qMin(projected.y[1], projected.y[2])) - 0.5f));
+        float y1 = qMin(float(roi.bottom()), std::floor(qMax(projected.y[0], qMax(projected.y[1], projected.y[2])) - 0.5f));
+        if (!(x0 <= x1) || !(y0 <= y1))
+            continue;
+
+        projectedFaces.push_back(projected);
+        unsigned int index = (unsigned int) (projectedFaces.size() - 1);
+
+        for (int ty = (int(y0) - roi.top()) / TILE_SIZE; ty <= (int(y1) - roi.top()) / TILE_SIZE; ty++)
+            for (int tx = (int(x0) - roi.left()) / TILE_SIZE; tx <= (int(x1) - roi.left()) / TILE_SIZE; tx++)
+                bins[ty * roiTilesX + tx].push_back(index);
+    }
+}
+
+/**
+ * @brief Casts rays of tile
+ * @param[in] tile Index of tile in region of interest
+ * @param[in] roi Region of interest
+ * @param[in] matrixInv Inverted matrix
+ *
+ * Packets of 4 rays of row are tested against boundary faces by edge functions with top-left
+ * rule, every ray is then traversed from every boundary face it enters.
+ */
+void DensityRayCasterCPU::castTile(int tile, const QRect &roi, const QMatrix4x4 &matrixInv)
+{
+    const std::vector<unsigned int> &bin = bins[tile];
+    if (bin.empty())
+        return;
+
+    int x0 = roi.left() + (tile % roiTilesX) * TILE_SIZE;
+    int y0 = roi.top() + (tile / roiTilesX) * TILE_SIZE;
+    int x1 = qMin(x0 + TILE_SIZE - 1, roi.right());
+    int y1 = qMin(y0 + TILE_SIZE - 1, roi.bottom());
+
+    Ray rays[PACKET_SIZE];
+    float edges[3][PACKET_SIZE];
+
+    for (int y = y0; y <= y1; y++) {
+        float cy = y + 0.5f;
+        float *row = density.data() + size_t(y) * renderWidth;
+
+        for (int x = x0; x <= x1; x += PACKET_SIZE) {
+            int packetSize = qMin(PACKET_SIZE, x1 + 1 - x);
+
+            for (int k = 0; k < packetSize; k++) {
+                float ndcX = (x + k + 0.5f) / renderWidth * 2.0f - 1.0f;
+                float ndcY = cy / renderHeight * 2.0f - 1.0f;
+                QVector4D nearPoint = matrixInv * QVector4D(ndcX, ndcY, -1.0f, 1.0f);
+                QVector4D farPoint = matrixInv * QVector4D(ndcX, ndcY, 1.0f, 1.0f);
+                for (int c = 0; c < 3; c++) {
+                    rays[k].origin[c] = nearPoint[c] / nearPoint.w();
+                    rays[k].direction[c] = farPoint[c] / farPoint.w() - rays[k].origin[c];
+                }
+            }
+
+            for (size_t i = 0; i < bin.size(); i++) {
+                const BoundaryFace &face = projectedFaces[bin[i]];
+                int mask = 0;
+
+                // Edge i is opposite to vertex i, E(x, y) = dx * (y - ay) - dy * (x - ax)
+#ifdef SSIMR_USE_SSE
+                __m128 cx = _mm_add_ps(_mm_set1_ps(x + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+                __m128 inside = _mm_cmpeq_ps(cx, cx);
+#endif
+                for (int e = 0; e < 3; e++) {
+                    int a = (e + 1) % 3;
+                    int b = (e + 2) % 3;
+                    float dx = face.x[b] - face.x[a];
+                    float dy = face.y[b] - face.y[a];
+                    bool topLeft = dy < 0 || (dy == 0 && dx < 0);
+#ifdef SSIMR_USE_SSE
+                    __m128 value = _mm_sub_ps(_mm_set1_ps(dx * (cy - face.y[a])), _mm_mul_ps(_mm_set1_ps(dy), _mm_sub_ps(cx, _mm_set1_ps(face.x[a]))));
+                    _mm_storeu_ps(edges[e], value);
+                    inside = _mm_and_ps(inside, topLeft ? _mm_cmpge_ps(value, _mm_setzero_ps()) : _mm_cmpgt_ps(value, _mm_setzero_ps()));
+#else
+                    for (int k = 0; k < PACKET_SIZE; k++) {
+                        edges[e][k] = dx * (cy - face.y[a]) - dy * (x + k + 0.5f - face.x[a]);
+                        mask |= (topLeft ? edges[e][k] >= 0 : edges[e][k] > 0) ? 0 : (1 << k);
+                    }
+#endif
+                }
+#ifdef SSIMR_USE_SSE
+                mask = _mm_movemask_ps(inside);
+#else
+                mask = ~mask & ((1 << PACKET_SIZE) - 1);
+#endif
+                mask &= (1 << packetSize) - 1;
+
+                for (int k = 0; mask; k++, mask >>= 1) {
+                    if (mask & 1)
+                        row[x + k] += castRay(rays[k], face.face, matrixInv);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Traverses ray from boundary face through tetrahedra and integrates density
+ * @param[in] ray Ray from near to far plane
+ * @param[in] face Boundary face (tetrahedron * 4 + index of opposite vertex)
+ * @param[in] matrixInv Inverted matrix
+ * @return Density along ray up to next boundary face, 0 if ray leaves mesh through face
+ *
+ * Barycentric coords of ray are b(t) = beta + t * delta, ray enters tetrahedron at max
+ * of -beta / delta of increasing coords and exits at min of decreasing ones. Pixel
+ * attributes of fragment shader are evaluated at the point of rasterized face (entry face,
+ * exit face with x mirroring), so density is the same as by DensityRendererCPU.
+ */
+float DensityRayCasterCPU::castRay(const Ray &ray, unsigned int face, const QMatrix4x4 &matrixInv) const
+{
+    const unsigned int *tetrahedra = mesh->getTableOfTetrahedra();
+    const float *m = matrix.constData();
+    const float *mInv = matrixInv.constData();
+    long numberOfTetrahedra = mesh->getNumberOfTetrahedra();
+
+    float sum = 0.0f;
+    int tetrahedron = int(face / 4);
+
+    // Number of steps is limited, rays through vertices or edges may cycle
+    for (long step = 0; step < numberOfTetrahedra; step++) {
+        float p[4][3];
+        for (int i = 0; i < 4; i++) {
+            const float *position = positions.data() + tetrahedra[tetrahedron * 4 + i] * 3;
+            p[i][0] = xMirroringEnabled ? -position[0] : position[0];
+            p[i][1] = position[1];
+            p[i][2] = position[2];
+        }
+
+        // Rows of inverse matrix of edges are cross products of edges
+        float c[3][3], r[3][3];
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                c[i][j] = p[i + 1][j] - p[0][j];
+        for (int i = 0; i < 3; i++) {
+            const float *u = c[(i + 1) % 3];
+            const float *v = c[(i + 2) % 3];
+            r[i][0] = u[1] * v[2] - u[2] * v[1];
+            r[i][1] = u[2] * v[0] - u[0] * v[2];
+            r[i][2] = u[0] * v[1] - u[1] * v[0];
+        }
+        float invDet = 1.0f / (c[0][0] * r[0][0] + c[0][1] * r[0][1] + c[0][2] * r[0][2]);
+        if (!std::isfinite(invDet))
+            break;
+
+        float beta[4], delta[4];
+        beta[0] = 1.0f;
+        delta[0] = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            beta[i + 1] = (r[i][0] * (ray.origin[0] - p[0][0]) + r[i][1] * (ray.origin[1] - p[0][1]) + r[i][2] * (ray.origin[2] - p[0][2])) * invDet;
+            delta[i + 1] = (r[i][0] * ray.direction[0] + r[i][1] * ray.direction[1] + r[i][2] * ray.direction[2]) * invDet;
+            beta[0] -= beta[i + 1];
+            delta[0] -= delta[i + 1];
+        }
+
+        // Ray has to enter mesh through boundary face
+        if (step == 0 && !(delta[face % 4] > 0))
+            return 0.0f;
+
+        float tIn = -INFINITY, tOut = INFINITY;
+        int exitFace = -1;
+        for (int i = 0; i < 4; i++) {
+            float t = -beta[i] / delta[i];
+            if (delta[i] > 0 && t > tIn)
+                tIn = t;
+            if (delta[i] < 0 && t < tOut) {
+                tOut = t;
+                exitFace = i;
+            }
+        }
+
+        if (exitFace < 0 || tIn > 1.0f)
+            break;
+
+        float s = xMirroringEnabled ? tOut : tIn;
+        if (tIn < tOut && s >= 0.0f && s <= 1.0f) {
+            // Barycentric coords of rasterized point, clip coords of vertices
+            float b[4], bSum = 0.0f;
+            for (int i = 0; i < 4; i++) {
+                b[i] = qBound(0.0f, beta[i] + s * delta[i], 1.0f);
+                bSum += b[i];
+            }
+
+            float point[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float eEye[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            for (int i = 0; i < 4; i++) {
+                b[i] /= bSum;
+                float e[4];
+                for (int j = 0; j < 4; j++) {
+                    e[j] = m[j] * p[i][0] + m[4 + j] * p[i][1] + m[8 + j] * p[i][2] + m[12 + j];
+                    point[j] += b[i] * e[j];
+                }
+                eEye[0] += b[i] * e[0] / e[3];
+                eEye[1] += b[i] * e[1] / e[3];
+            }
+
+            // Barycentric coords of eye point (W^-1 * M^-1 * eEye)
+            float world[4];
+            for (int j = 0; j < 4; j++)
+                world[j] = mInv[j] * eEye[0] + mInv[4 + j] * eEye[1] + mInv[8 + j] * eEye[2] + mInv[12 + j] * eEye[3];
+            float bEye[4];
+            bEye[0] = world[3];
+            for (int i = 0; i < 3; i++) {
+                bEye[i + 1] = (r[i][0] * (world[0] - world[3] * p[0][0]) + r[i][1] * (world[1] - world[3] * p[0][1]) + r[i][2] * (world[2] - world[3] * p[0][2])) * invDet;
+                bEye[0] -= bEye[i + 1];
+            }
+
+            float attributes[12];
+            for (int i = 0; i < 4; i++) {
+                attributes[i] = b[i];
+                attributes[4 + i] = xMirroringEnabled ? bEye[i] - b[i] : b[i] - bEye[i];
+                attributes[8 + i] = xMirroringEnabled ? -eEye[i] - point[i] : eEye[i] - point[i];
+            }
+
+            sum += integrate(attributes, coefficients.data() + size_t(tetrahedron) * coeffsCount);
+        }
+
+        tetrahedron = adjacency[tetrahedron * 4 + exitFace];
+        if (tetrahedron < 0)
+            break;
+    }
+
+    return sum;
+}
+}
@@ -0,0 +1,956 @@
+/**
+ * @file        densityrenderercpu.cpp
+ * @author      Petr Kleparnik, VUT FIT Brno, ikleparnik@fit.vutbr.cz
+ * @version     1.0
+ * @date        16 October 2026
+ *
+ * @brief       The implementation file containing the DensityRendererCPU class.
+ *
+ * @copyright   Copyright (C) 2015 Petr Kleparnik, Ondrej Klima. All Rights Reserved.
+ *
+ * @license     This file may be used, distributed and modified under the terms of the LGPL version 3
+ *              open source license. A copy of the LGPL license should have
+ *              been recieved with this file. Otherwise, it can be found at:
+ *              http://www.gnu.org/copyleft/lesser.html
+ *              This file has been created as a part of the Traumatech project:
+ *              http://www.fit.vutbr.cz/research/grants/index.php.en?id=733.
+ *
+ */
+
+#include "rendering/densityrenderercpu.h"
+#include "rendering/densityfsgenerator/densityfsgenerator.h"
+
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define SSIMR_USE_SSE
+#endif
+
+namespace SSIMRenderer
+{
+/**
+ * Density of both paths is accumulated in the same primitive order, differences come from
+ * rounding of fragment shader arithmetic and from pixels lying exactly on projected edges
+ * (OpenGL snaps vertices to 1/256 pixel grid). Snapping of vertices emulated on CPU gave
+ * errors up to 6e-5 (meshes with 10k - 200k tetrahedra, degrees 0 - 3, render sizes
+ * 256 - 1024 pixels), the tolerance keeps margin for rounding of GPU arithmetic.
+ * The value is derived from this CPU emulation only, comparison with OpenGL output is done
+ * by the DensityValidation example, which still has to be run on real GPUs.
+ */
+const float DensityRendererCPU::DENSITY_TOLERANCE = 2e-4f;
+
+/**
+ * @brief Creates DensityRendererCPU with render width and height and number of threads
+ * @param[in] renderWidth Render width
+ * @param[in] renderHeight Render height
+ * @param[in] numberOfThreads Number of threads (0 = number of CPU cores)
+ */
+DensityRendererCPU::DensityRendererCPU(unsigned int renderWidth, unsigned int renderHeight, int numberOfThreads)
+    : mesh(0)
+    , renderWidth(renderWidth)
+    , renderHeight(renderHeight)
+    , coeffsCount(0)
+    , xMirroringEnabled(false)
+    , lastRenderTime(0)
+    , lastRenderTimeDouble(0)
+    , coefficientsStatisticalData(0)
+    , verticesStatisticalData(0)
+    , tilesX(0)
+    , tilesY(0)
+    , degree(0)
+    , integralFactor(1.0f)
+    , recomputeCoefficientsFlag(false)
+    , recomputeVerticesFlag(false)
+{
+    setNumberOfThreads(numberOfThreads);
+}
+
+/**
+ * @brief Destructor of DensityRendererCPU object
+ *
+ * Does nothing.
+ */
+DensityRendererCPU::~DensityRendererCPU()
+{
+
+}
+
+/**
+ * @brief Sets tetrahedral mesh
+ * @param[in] mesh Mesh
+ *
+ * Schedules recomputing of vertices in rendering function.
+ */
+void DensityRendererCPU::setMesh(Mesh *mesh)
+{
+    if (!mesh) {
+        qCritical() << "DensityRendererCPU::setMesh error: null Mesh";
+        return;
+    }
+
+    this->mesh = mesh;
+    recomputeVerticesFlag = true;
+    recomputeCoefficientsFlag = true;
+}
+
+/**
+ * @brief Sets statistical coefficients data
+ * @param[in] statisticalData Statistical coefficients data
+ *
+ * Schedules recomputing in rendering function.
+ */
+void DensityRendererCPU::setCoefficients(StatisticalData *statisticalData)
+{
+    if (!statisticalData) {
+        qCritical() << "DensityRendererCPU::setCoefficients error: null StatisticalData";
+        return;
+    }
+
+    coefficientsStatisticalData = statisticalData;
+    recomputeCoefficientsFlag = true;
+}
+
+/**
+ * @brief Sets statistical vertices data
+ * @param[in] statisticalData Statistical vertices data
+ *
+ * Schedules recomputing in rendering function, vertices of mesh are used without it.
+ */
+void DensityRendererCPU::setVertices(StatisticalData *statisticalData)
+{
+    if (!statisticalData) {
+        qCritical() << "DensityRendererCPU::setVertices error: null StatisticalData";
+        return;
+    }
+
+    verticesStatisticalData = statisticalData;
+    recomputeVerticesFlag = true;
+}
+
+/**
+ * @brief Updates statistical coefficients data (pcs were changed)
+ * @param[in] statisticalData Statistical coefficients data
+ */
+void DensityRendererCPU::updateCoefficients(StatisticalData *statisticalData)
+{
+    setCoefficients(statisticalData);
+}
+
+/**
+ * @brief Updates statistical vertices data (pcs were changed)
+ * @param[in] statisticalData Statistical vertices data
+ */
+void DensityRendererCPU::updateVertices(StatisticalData *statisticalData)
+{
+    setVertices(statisticalData);
+}
+
+/**
+ * @brief Sets final matrix to clip space
+ * @param[in] matrix Matrix (uMatrix of density programs)
+ */
+void DensityRendererCPU::setMatrix(const QMatrix4x4 &matrix)
+{
+    this->matrix = matrix;
+}
+
+/**
+ * @brief Returns final matrix to clip space
+ * @return Matrix
+ */
+QMatrix4x4 DensityRendererCPU::getMatrix() const
+{
+    return matrix;
+}
+
+/**
+ * @brief Sets render width
+ * @param[in] renderWidth Render width
+ */
+void DensityRendererCPU::setRenderWidth(unsigned int renderWidth)
+{
+    this->renderWidth = renderWidth;
+}
+
+/**
+ * @brief Sets render height
+ * @param[in] renderHeight Render height
+ */
+void DensityRendererCPU::setRenderHeight(unsigned int renderHeight)
+{
+    this->renderHeight = renderHeight;
+}
+
+/**
+ * @brief Sets render width and height
+ * @param[in] renderWidth Render width
+ * @param[in] renderHeight Render height
+ */
+void DensityRendererCPU::setRenderSize(unsigned int renderWidth, unsigned int renderHeight)
+{
+    setRenderWidth(renderWidth);
+    setRenderHeight(renderHeight);
+}
+
+/**
+ * @brief Returns render width
+ * @return Render width
+ */
+unsigned int DensityRendererCPU::getRenderWidth() const
+{
+    return renderWidth;
+}
+
+/**
+ * @brief Returns render height
+ * @return Render height
+ */
+unsigned int DensityRendererCPU::getRenderHeight() const
+{
+    return renderHeight;
+}
+
+/**
+ * @brief Enables x mirroring
+ * @param[in] value True/false
+ */
+void DensityRendererCPU::enableXMirroring(bool value)
+{
+    xMirroringEnabled = value;
+}
+
+/**
+ * @brief Is x mirroring enabled?
+ * @return True if x mirroring is enabled
+ */
+bool DensityRendererCPU::isXMirroringEnabled() const
+{
+    return xMirroringEnabled;
+}
+
+/**
+ * @brief Sets number of used threads
+ * @param[in] value Number of threads (0 = number of CPU cores)
+ */
+void DensityRendererCPU::setNumberOfThreads(int value)
+{
+    if (value <= 0)
+        value = int(std::thread::hardware_concurrency());
+    numberOfThreads = qMax(1, value);
+    reconstruction.setNumberOfThreads(numberOfThreads);
+}
+
+/**
+ * @brief Returns number of used threads
+ * @return Number of threads
+ */
+int DensityRendererCPU::getNumberOfThreads() const
+{
+    return numberOfThreads;
+}
+
+/**
+ * @brief Main render function
+ * @return Elapsed time in milliseconds (integer)
+ *
+ * Every thread sets up its own contiguous range of tetrahedra and bins front faces to tiles,
+ * then tiles are rasterized by threads taking them from a shared counter. Tiles are owned
+ * by one thread and every tile accumulates triangles of all ranges in primitive order,
+ * as blending does on GPU.
+ */
+int DensityRendererCPU::renderNow()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!prepareData())
+        return 0;
+
+    tilesX = int((renderWidth + TILE_SIZE - 1) / TILE_SIZE);
+    tilesY = int((renderHeight + TILE_SIZE - 1) / TILE_SIZE);
+    density.assign(size_t(renderWidth) * renderHeight, 0.0f);
+
+    bool invertible = false;
+    QMatrix4x4 matrixInv = matrix.inverted(&invertible);
+    if (!invertible) {
+        qCritical() << "DensityRendererCPU::renderNow error: matrix is not invertible";
+        return 0;
+    }
+
+    long numberOfTetrahedra = mesh->getNumberOfTetrahedra();
+    int threads = int(qMin(long(numberOfThreads), numberOfTetrahedra));
+    long chunk = (numberOfTetrahedra + threads - 1) / threads;
+    setupBuffers.resize(threads);
+
+    parallelRun(threads, [&](int thread) {
+        SetupBuffer &buffer = setupBuffers[thread];
+        buffer.vertices.clear();
+        buffer.triangles.clear();
+        buffer.bins.resize(tilesX * tilesY);
+        for (size_t i = 0; i < buffer.bins.size(); i++)
+            buffer.bins[i].clear();
+
+        long begin = thread * chunk;
+        setupTetrahedra(buffer, begin, qMin(begin + chunk, numberOfTetrahedra), matrixInv);
+    });
+
+    std::atomic<int> nextTile(0);
+    parallelRun(qMin(numberOfThreads, tilesX * tilesY), [&](int) {
+        for (int tile = nextTile++; tile < tilesX * tilesY; tile = nextTile++)
+            rasterizeTile(tile);
+    });
+
+    qint64 elapsed = timer.nsecsElapsed();
+    lastRenderTimeDouble = (double) elapsed / 1000000.0;
+    lastRenderTime = int(lastRenderTimeDouble);
+
+    return lastRenderTime;
+}
+
+/**
+ * @brief Returns last render time
+ * @return Last render time in milliseconds (integer)
+ */
+int DensityRendererCPU::getLastRenderTime() const
+{
+    return lastRenderTime;
+}
+
+/**
+ * @brief Returns last render time
+ * @return Last render time in milliseconds (double)
+ */
+double DensityRendererCPU::getLastRenderTimeDouble() const
+{
+    return lastRenderTimeDouble;
+}
+
+/**
+ * @brief Returns raw density
+ * @param[out] data Float 1D array
+ *
+ * Data output array is allocated in this function.
+ */
+void DensityRendererCPU::getCurrentDensityData(float *&data) const
+{
+    data = new float [renderWidth * renderHeight]();
+    getCurrentDensityData(data, renderWidth * renderHeight);
+}
+
+/**
+ * @brief Returns raw density to caller-owned array
+ * @param[out] data Float 1D array
+ * @param[in] size Size of output array
+ * @param[in] rowStride Number of values between starts of rows (0 means render width)
+ * @return False if output array is too small or nothing was rendered
+ *
+ * Rows are in OpenGL (bottom-up) order as MainRenderer::getCurrentDensityData.
+ */
+bool DensityRendererCPU::getCurrentDensityData(float *data, long size, unsigned int rowStride) const
+{
+    if (rowStride == 0)
+        rowStride = renderWidth;
+
+    if (density.size() != size_t(renderWidth) * renderHeight || renderHeight == 0) {
+        qCritical() << "DensityRendererCPU::getCurrentDensityData error: density is not rendered";
+        return false;
+    }
+
+    if (!data || rowStride < renderWidth || size < long(rowStride) * (renderHeight - 1) + renderWidth) {
+        qCritical() << "DensityRendererCPU::getCurrentDensityData error: output array is too small";
+        return false;
+    }
+
+    for (unsigned int y = 0; y < renderHeight; y++)
+        memcpy(data + long(y) * rowStride, density.data() + size_t(y) * renderWidth, sizeof(float) * renderWidth);
+
+    return true;
+}
+
+/**
+ * @brief Computes RMS difference of density images relative to max of reference
+ * @param[in] reference Reference density (e.g. from MainRenderer::getCurrentDensityData)
+ * @param[in] data Compared density
+ * @param[in] size Number of values
+ * @return Relative error (compare with DENSITY_TOLERANCE), -1 on error
+ */
+float DensityRendererCPU::getDensityError(const float *reference, const float *data, long size)
+{
+    if (!reference || !data || size <= 0) {
+        qCritical() << "DensityRendererCPU::getDensityError error: empty data";
+        return -1;
+    }
+
+    double maxValue = 0, sum = 0;
+    for (long i = 0; i < size; i++) {
+        double diff = double(reference[i]) - double(data[i]);
+        maxValue = qMax(maxValue, std::fabs(double(reference[i])));
+        sum += diff * diff;
+    }
+
+    double rms = std::sqrt(sum / size);
+    return float(maxValue > 0 ? rms / maxValue : rms);
+}
+
+/**
+ * @brief Recomputes coefficients and vertices if needed
+ * @return False if data are missing or wrong
+ */
+bool DensityRendererCPU::prepareData()
+{
+    if (!mesh) {
+        qWarning() << "DensityRendererCPU::renderNow warning: null Mesh";
+        return false;
+    }
+
+    long numberOfTetrahedra = mesh->getNumberOfTetrahedra();
+    if (numberOfTetrahedra == 0) {
+        qWarning() << "DensityRendererCPU::renderNow warning: Tetrahedral mesh is not available";
+        return false;
+    }
+
+    if (!coefficientsStatisticalData) {
+        qWarning() << "DensityRendererCPU::renderNow warning: null coefficients StatisticalData";
+        return false;
+    }
+
+    if (renderWidth == 0 || renderHeight == 0)
+        return false;
+
+    if (recomputeCoefficientsFlag) {
+        long numberOfRows = coefficientsStatisticalData->getNumberOfRows();
+        if (numberOfRows % numberOfTetrahedra != 0) {
+            qCritical() << "DensityRendererCPU::prepareData error: number of coefficients is not divisible by number of tetrahedra";
+            return false;
+        }
+
+        int bernCoeffsCount = int(numberOfRows / numberOfTetrahedra);
+        if (bernCoeffsCount != coeffsCount && !prepareTerms(bernCoeffsCount))
+            return false;
+
+        coefficients.resize(numberOfRows);
+        if (!reconstruction.reconstruct(coefficientsStatisticalData, coefficients.data(), numberOfRows))
+            return false;
+
+        recomputeCoefficientsFlag = false;
+    }
+
+    if (recomputeVerticesFlag) {
+        long numberOfRows = mesh->getNumberOfVertices() * 3;
+        positions.resize(numberOfRows);
+
+        if (verticesStatisticalData) {
+            if (verticesStatisticalData->getNumberOfRows() != numberOfRows) {
+                qCritical() << "DensityRendererCPU::prepareData error: vertices StatisticalData does not match Mesh";
+                return false;
+            }
+            if (!reconstruction.reconstructVertices(verticesStatisticalData, positions.data(), numberOfRows))
+                return false;
+        } else {
+            memcpy(positions.data(), mesh->getTableOfVertices(), sizeof(float) * numberOfRows);
+        }
+
+        recomputeVerticesFlag = false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Prepares terms of density integral
+ * @param[in] coeffsCount Number of coefficients
+ * @return False for unsupported degree
+ *
+ * Terms are the same as terms of loop fragment shader (DensityFSGenerator::generateLoopWeightsData).
+ * Every distinct monomial with its multinomial is evaluated once per pixel, so a term costs
+ * one multiplication instead of products of 8 powers.
+ */
+bool DensityRendererCPU::prepareTerms(int coeffsCount)
+{
+    DensityFSGenerator generator;
+    QVector<unsigned int> data = generator.generateLoopWeightsData(coeffsCount);
+    if (data.isEmpty()) {
+        qCritical() << "DensityRendererCPU::prepareTerms error: unsupported number of coefficients" << coeffsCount;
+        return false;
+    }
+
+    this->coeffsCount = coeffsCount;
+    degree = generator.degreeFromCoeffsCount(coeffsCount);
+    // Same literal as in fragment shader
+    integralFactor = QString::number(1.0f / (degree + 1.0f), 'g').toFloat();
+
+    int termsEndSize = (coeffsCount + 3) / 4 * 4;
+    termsEnd.resize(coeffsCount);
+    for (int c = 0; c < coeffsCount; c++)
+        termsEnd[c] = int(data[c]);
+
+    // Index of monomial by 16 bits of packed exponents
+    std::vector<int> monomialIndices(1 << 16, -1);
+    monomials.clear();
+    terms.resize(termsEnd[coeffsCount - 1]);
+
+    for (size_t t = 0; t < terms.size(); t++) {
+        unsigned int exponents = data[termsEndSize + int(t) * 2];
+        unsigned int multinomials = data[termsEndSize + int(t) * 2 + 1];
+
+        for (int part = 0; part < 2; part++) {
+            unsigned int packed = (exponents >> (16 * part)) & 65535u;
+            if (monomialIndices[packed] < 0) {
+                Monomial monomial;
+                for (int i = 0; i < 4; i++)
+                    monomial.powers[i] = (unsigned short) (i * (degree + 1) + ((packed >> (4 * i)) & 15u));
+                monomial.multinomial = float((multinomials >> (16 * part)) & 65535u);
+                monomialIndices[packed] = int(monomials.size());
+                monomials.push_back(monomial);
+            }
+            if (part == 0)
+                terms[t].in = (unsigned short) monomialIndices[packed];
+            else
+                terms[t].out = (unsigned short) monomialIndices[packed];
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Runs function in threads
+ * @param[in] threads Number of threads
+ * @param[in] function Function called with index of thread
+ *
+ * Thread 0 is the calling thread.
+ */
+void DensityRendererCPU::parallelRun(int threads, const std::function<void(int)> &function) const
+{
+    std::vector<std::thread> workers;
+    workers.reserve(qMax(0, threads - 1));
+    for (int i = 1; i < threads; i++)
+        workers.push_back(std::thread(function, i));
+
+    function(0);
+
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+/**
+ * @brief Sets up tetrahedra [begin, end) as density.geom and bins their front faces
+ * @param[in, out] buffer Setup buffer of thread
+ * @param[in] begin First tetrahedron
+ * @param[in] end Tetrahedron after last tetrahedron
+ * @param[in] matrixInv Inverted matrix
+ *
+ * Faces are culled as back faces (counter-clockwise front faces). Tetrahedra crossing near
+ * or far plane are clipped per face.
+ */
+void DensityRendererCPU::setupTetrahedra(SetupBuffer &buffer, long begin, long end, const QMatrix4x4 &matrixInv) const
+{
+    // Faces in order of emitPrimitive calls
+    static const int faces[4][3] = {{0, 2, 1}, {1, 2, 3}, {3, 2, 0}, {0, 1, 3}};
+
+    const unsigned int *tetrahedra = mesh->getTableOfTetrahedra();
+    const float *p = positions.data();
+
+    for (long t = begin; t < end; t++) {
+        QMatrix4x4 w;
+        for (int i = 0; i < 4; i++) {
+            const float *position = p + tetrahedra[t * 4 + i] * 3;
+            w.setColumn(i, QVector4D(xMirroringEnabled ? -position[0] : position[0], position[1], position[2], 1.0f));
+        }
+
+        bool invertible = false;
+        QMatrix4x4 wInv = w.inverted(&invertible);
+        if (!invertible)
+            continue;
+        QMatrix4x4 a = wInv * matrixInv;
+
+        // Clip coords, barycentric coords, barycentric and eye dirs of vertices
+        float vertices[4][VERTEX_SIZE];
+        bool inside = true;
+        for (int i = 0; i < 4; i++) {
+            QVector4D e = matrix * w.column(i);
+            QVector4D eEye(e.x() / e.w(), e.y() / e.w(), 0.0f, 1.0f);
+            QVector4D b;
+            b[i] = 1.0f;
+            QVector4D bEyedir = b - a * eEye;
+            QVector4D eEyedir = eEye - e;
+            if (xMirroringEnabled) {
+                bEyedir = -bEyedir;
+                eEyedir = -eEye - e;
+            }
+
+            for (int c = 0; c < 4; c++) {
+                vertices[i][c] = e[c];
+                vertices[i][4 + c] = b[c];
+                vertices[i][8 + c] = bEyedir[c];
+                vertices[i][12 + c] = eEyedir[c];
+            }
+
+            if (e.z() < -e.w() || e.z() > e.w())
+                inside = false;
+        }
+
+        if (!inside) {
+            for (int f = 0; f < 4; f++)
+                setupClippedFace(buffer, vertices, faces[f][0], faces[f][1], faces[f][2], (unsigned int) t);
+            continue;
+        }
+
+        float window[4][VERTEX_SIZE];
+        unsigned int indices[4] = {~0u, ~0u, ~0u, ~0u};
+        for (int i = 0; i < 4; i++)
+            toWindow(vertices[i], window[i]);
+
+        for (int f = 0; f < 4; f++) {
+            const int *face = faces[f];
+            if (!(signedArea(window[face[0]], window[face[1]], window[face[2]]) > 0))
+                continue;
+            for (int i = 0; i < 3; i++) {
+                if (indices[face[i]] == ~0u)
+                    indices[face[i]] = addVertex(buffer, window[face[i]]);
+            }
+            addTriangle(buffer, indices[face[0]], indices[face[1]], indices[face[2]], (unsigned int) t);
+        }
+    }
+}
+
+/**
+ * @brief Clips face by near and far planes and bins front triangles of the result
+ * @param[in, out] buffer Setup buffer of thread
+ * @param[in] vertices Clip space vertices of tetrahedron with attributes
+ * @param[in] i First vertex of face
+ * @param[in] j Second vertex of face
+ * @param[in] k Third vertex of face
+ * @param[in] tetrahedron Index of tetrahedron
+ *
+ * Attributes are interpolated linearly in clip space as by OpenGL clipping.
+ */
+void DensityRendererCPU::setupClippedFace(SetupBuffer &buffer, const float (*vertices)[VERTEX_SIZE], int i, int j, int k, unsigned int tetrahedron) const
+{
+    // Triangle clipped by 2 planes has at most 5 vertices
+    float polygons[2][8][VERTEX_SIZE];
+    int count = 3;
+    memcpy(polygons[0][0], vertices[i], sizeof(float) * VERTEX_SIZE);
+    memcpy(polygons[0][1], vertices[j], sizeof(float) * VERTEX_SIZE);
+    memcpy(polygons[0][2], vertices[k], sizeof(float) * VERTEX_SIZE);
+
+    int current = 0;
+    for (int plane = 0; plane < 2; plane++) {
+        float (*in)[VERTEX_SIZE] = polygons[current];
+        float (*out)[VERTEX_SIZE] = polygons[1 - current];
+        int outCount = 0;
+
+        for (int n = 0; n < count; n++) {
+            const float *a = in[n];
+            const float *b = in[(n + 1) % count];
+            // Near plane z >= -w, far plane z <= w
+            float da = plane == 0 ? a[2] + a[3] : a[3] - a[2];
+            float db = plane == 0 ? b[2] + b[3] : b[3] - b[2];
+
+            if (da >= 0)
+                memcpy(out[outCount++], a, sizeof(float) * VERTEX_SIZE);
+            if ((da >= 0) != (db >= 0)) {
+                float s = da / (da - db);
+                for (int c = 0; c < VERTEX_SIZE; c++)
+                    out[outCount][c] = a[c] + (b[c] - a[c]) * s;
+                outCount++;
+            }
+        }
+
+        count = outCount;
+        current = 1 - current;
+        if (count < 3)
+            return;
+    }
+
+    float window[8][VERTEX_SIZE];
+    unsigned int indices[8];
+    for (int n = 0; n < count; n++) {
+        toWindow(polygons[current][n], window[n]);
+        indices[n] = ~0u;
+    }
+
+    // Fan of clipped polygon
+    for (int n = 1; n + 1 < count; n++) {
+        if (!(signedArea(window[0], window[n], window[n + 1]) > 0))
+            continue;
+        int fan[3] = {0, n, n + 1};
+        for (int v = 0; v < 3; v++) {
+            if (indices[fan[v]] == ~0u)
+                indices[fan[v]] = addVertex(buffer, window[fan[v]]);
+        }
+        addTriangle(buffer, indices[0], indices[n], indices[n + 1], tetrahedron);
+    }
+}
+
+/**
+ * @brief Adds triangle to setup buffer and to bins of overlapped tiles
+ * @param[in, out] buffer Setup buffer of thread
+ * @param[in] v0 Index of first vertex
+ * @param[in] v1 Index of second vertex
+ * @param[in] v2 Index of third vertex
+ * @param[in] tetrahedron Index of tetrahedron
+ */
+void DensityRendererCPU::addTriangle(SetupBuffer &buffer, unsigned int v0, unsigned int v1, unsigned int v2, unsigned int tetrahedron) const
+{
+    const float *a = buffer.vertices.data() + size_t(v0) * VERTEX_SIZE;
+    const float *b = buffer.vertices.data() + size_t(v1) * VERTEX_SIZE;
+    const float *c = buffer.vertices.data() + size_t(v2) * VERTEX_SIZE;
+
+    if (!std::isfinite(a[0] + a[1] + b[0] + b[1] + c[0] + c[1]))
+        return;
+
+    // Pixels with centers in bounding box
+    float x0 = qMax(0.0f, std::ceil(qMin(a[0], qMin(b[0], c[0])) - 0.5f));
+    float x1 = qMin(float(renderWidth - 1), std::floor(qMax(a[0], qMax(b[0], c[0])) - 0.5f));
+    float y0 = qMax(0.0f, std::ceil(qMin(a[1], qMin(b[1], c[1])) - 0.5f));
+    float y1 = qMin(float(renderHeight - 1), std::floor(qMax(a[1], qMax(b[1], c[1])) - 0.5f));
+    if (!(x0 <= x1) || !(y0 <= y1))
+        return;
+
+    Triangle triangle;
+    triangle.vertices[0] = v0;
+    triangle.vertices[1] = v1;
+    triangle.vertices[2] = v2;
+    triangle.tetrahedron = tetrahedron;
+    buffer.triangles.push_back(triangle);
+    unsigned int index = (unsigned int) (buffer.triangles.size() - 1);
+
+    for (int ty = int(y0) / TILE_SIZE; ty <= int(y1) / TILE_SIZE; ty++)
+        for (int tx = int(x0) / TILE_SIZE; tx <= int(x1) / TILE_SIZE; tx++)
+            buffer.bins[ty * tilesX + tx].push_back(index);
+}
+
+/**
+ * @brief Adds window space vertex to setup buffer
+ * @param[in, out] buffer Setup buffer of thread
+ * @param[in] vertex Vertex
+ * @return Index of vertex
+ */
+unsigned int DensityRendererCPU::addVertex(SetupBuffer &buffer, const float *vertex) const
+{
+    buffer.vertices.insert(buffer.vertices.end(), vertex, vertex + VERTEX_SIZE);
+    return (unsigned int) (buffer.vertices.size() / VERTEX_SIZE - 1);
+}
+
+/**
+ * @brief Converts clip space vertex to window space vertex for perspective-correct interpolation
+ * @param[in] clip Clip coords and attributes
+ * @param[out] window Window coords, 1 / w and attributes divided by w
+ */
+void DensityRendererCPU::toWindow(const float *clip, float *window) const
+{
+    float invW = 1.0f / clip[3];
+    window[0] = (clip[0] * invW * 0.5f + 0.5f) * renderWidth;
+    window[1] = (clip[1] * invW * 0.5f + 0.5f) * renderHeight;
+    window[2] = invW;
+    window[3] = 0.0f;
+    for (int c = 4; c < VERTEX_SIZE; c++)
+        window[c] = clip[c] * invW;
+}
+
+/**
+ * @brief Computes doubled signed area of triangle in window space
+ * @param[in] v0 First vertex
+ * @param[in] v1 Second vertex
+ * @param[in] v2 Third vertex
+ * @return Positive for counter-clockwise triangle
+ */
+float DensityRendererCPU::signedArea(const float *v0, const float *v1, const float *v2)
+{
+    return (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+}
+
+/**
+ * @brief Rasterizes binned triangles of tile
+ * @param[in] tile Index of tile
+ */
+void DensityRendererCPU::rasterizeTile(int tile)
+{
+    int x0 = (tile % tilesX) * TILE_SIZE;
+    int y0 = (tile / tilesX) * TILE_SIZE;
+    int x1 = qMin(x0 + TILE_SIZE, int(renderWidth)) - 1;
+    int y1 = qMin(y0 + TILE_SIZE, int(renderHeight)) - 1;
+
+    for (size_t b = 0; b < setupBuffers.size(); b++) {
+        const SetupBuffer &buffer = setupBuffers[b];
+        const std::vector<unsigned int> &bin = buffer.bins[tile];
+        for (size_t i = 0; i < bin.size(); i++) {
+            const Triangle &triangle = buffer.triangles[bin[i]];
+            rasterizeTriangle(buffer.vertices.data() + size_t(triangle.vertices[0]) * VERTEX_SIZE,
+                              buffer.vertices.data() + size_t(triangle.vertices[1]) * VERTEX_SIZE,
+                              buffer.vertices.data() + size_t(triangle.vertices[2]) * VERTEX_SIZE,
+                              coefficients.data() + size_t(triangle.tetrahedron) * coeffsCount,
+                              x0, y0, x1, y1);
+        }
+    }
+}
+
+/**
+ * @brief Rasterizes triangle in tile and accumulates density
+ * @param[in] v0 First window space vertex
+ * @param[in] v1 Second window space vertex
+ * @param[in] v2 Third window space vertex
+ * @param[in] coefficients Coefficients of tetrahedron
+ * @param[in] x0 First column of tile
+ * @param[in] y0 First row of tile
+ * @param[in] x1 Last column of tile
+ * @param[in] y1 Last row of tile
+ *
+ * Pixel centers are tested by edge functions with top-left rule, 4 pixels of row at once.
+ */
+void DensityRendererCPU::rasterizeTriangle(const float *v0, const float *v1, const float *v2, const float *coefficients, int x0, int y0, int x1, int y1)
+{
+    float invArea = 1.0f / signedArea(v0, v1, v2);
+
+    // Edge i is opposite to vertex i, E(x, y) = dx * (y - ay) - dy * (x - ax)
+    const float *a[3] = {v1, v2, v0};
+    const float *b[3] = {v2, v0, v1};
+    float dx[3], dy[3];
+    bool topLeft[3];
+    for (int e = 0; e < 3; e++) {
+        dx[e] = b[e][0] - a[e][0];
+        dy[e] = b[e][1] - a[e][1];
+        topLeft[e] = dy[e] < 0 || (dy[e] == 0 && dx[e] < 0);
+    }
+
+    // Bounding box is clamped in floats, coords of vertices may be far outside
+    x0 = int(qMax(float(x0), std::ceil(qMin(v0[0], qMin(v1[0], v2[0])) - 0.5f)));
+    x1 = int(qMin(float(x1), std::floor(qMax(v0[0], qMax(v1[0], v2[0])) - 0.5f)));
+    y0 = int(qMax(float(y0), std::ceil(qMin(v0[1], qMin(v1[1], v2[1])) - 0.5f)));
+    y1 = int(qMin(float(y1), std::floor(qMax(v0[1], qMax(v1[1], v2[1])) - 0.5f)));
+
+    float edges[3][4];
+    float lambda[3];
+
+    for (int y = y0; y <= y1; y++) {
+        float cy = y + 0.5f;
+        float *row = density.data() + size_t(y) * renderWidth;
+
+        for (int x = x0; x <= x1; x += 4) {
+            int mask = 0;
+
+#ifdef SSIMR_USE_SSE
+            __m128 cx = _mm_add_ps(_mm_set1_ps(x + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+            __m128 inside = _mm_cmpeq_ps(cx, cx);
+            for (int e = 0; e < 3; e++) {
+                __m128 value = _mm_sub_ps(_mm_set1_ps(dx[e] * (cy - a[e][1])), _mm_mul_ps(_mm_set1_ps(dy[e]), _mm_sub_ps(cx, _mm_set1_ps(a[e][0]))));
+                _mm_storeu_ps(edges[e], value);
+                inside = _mm_and_ps(inside, topLeft[e] ? _mm_cmpge_ps(value, _mm_setzero_ps()) : _mm_cmpgt_ps(value, _mm_setzero_ps()));
+            }
+            mask = _mm_movemask_ps(inside);
+#else
+            for (int k = 0; k < 4; k++) {
+                float cx = x + k + 0.5f;
+                bool inside = true;
+                for (int e = 0; e < 3; e++) {
+                    edges[e][k] = dx[e] * (cy - a[e][1]) - dy[e] * (cx - a[e][0]);
+                    inside = inside && (topLeft[e] ? edges[e][k] >= 0 : edges[e][k] > 0);
+                }
+                mask |= inside ? (1 << k) : 0;
+            }
+#endif
+
+            // Pixels behind the last column
+            if (x + 4 > x1 + 1)
+                mask &= (1 << (x1 + 1 - x)) - 1;
+
+            for (int k = 0; mask; k++, mask >>= 1) {
+                if (!(mask & 1))
+                    continue;
+                lambda[0] = edges[0][k] * invArea;
+                lambda[1] = edges[1][k] * invArea;
+                lambda[2] = edges[2][k] * invArea;
+                shadePixel(v0, v1, v2, coefficients, lambda, row[x + k]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Interpolates attributes of pixel and accumulates its density
+ * @param[in] v0 First window space vertex
+ * @param[in] v1 Second window space vertex
+ * @param[in] v2 Third window space vertex
+ * @param[in] coefficients Coefficients of tetrahedron
+ * @param[in] lambda Window space barycentric coords of pixel center
+ * @param[in, out] output Accumulated density of pixel
+ */
+void DensityRendererCPU::shadePixel(const float *v0, const float *v1, const float *v2, const float *coefficients, const float *lambda, float &output) const
+{
+    float w = 1.0f / (lambda[0] * v0[2] + lambda[1] * v1[2] + lambda[2] * v2[2]);
+
+    float attributes[12];
+    for (int c = 0; c < 12; c++)
+        attributes[c] = (lambda[0] * v0[4 + c] + lambda[1] * v1[4 + c] + lambda[2] * v2[4 + c]) * w;
+
+    output += integrate(attributes, coefficients);
+}
+
+/**
+ * @brief Evaluates density line integral of fragment shader
+ * @param[in] attributes Barycentric coords, barycentric eye dir and eye dir of pixel
+ * @param[in] coefficients Coefficients of tetrahedron
+ * @return Density of pixel, 0 for discarded pixel
+ */
+float DensityRendererCPU::integrate(const float *attributes, const float *coefficients) const
+{
+    const float *bIn = attributes;
+    const float *bEyedir = attributes + 4;
+    const float *eEyedir = attributes + 8;
+
+    // Clamp wrong values (artefacts)
+    for (int i = 0; i < 4; i++)
+        if (bIn[i] < 0 || bIn[i] > 1)
+            return 0;
+
+    // Select max s, NaN of 0 / 0 is skipped
+    float sIF = -bEyedir[0] / bIn[0];
+    for (int i = 1; i < 4; i++) {
+        float s = -bEyedir[i] / bIn[i];
+        if (s > sIF || sIF != sIF)
+            sIF = s;
+    }
+
+    float wLength = std::sqrt(eEyedir[0] * eEyedir[0] + eEyedir[1] * eEyedir[1] + eEyedir[2] * eEyedir[2] + eEyedir[3] * eEyedir[3]) / sIF;
+
+    // Powers of entry and exit coords, index 0 is 1.0
+    float pIn[4 * (DensityFSGenerator::MAX_LOOP_DEGREE + 1)];
+    float pOut[4 * (DensityFSGenerator::MAX_LOOP_DEGREE + 1)];
+    int degree1 = degree + 1;
+    for (int i = 0; i < 4; i++) {
+        float bOut = bIn[i] + bEyedir[i] / sIF;
+        pIn[i * degree1] = 1.0f;
+        pOut[i * degree1] = 1.0f;
+        for (int e = 1; e <= degree; e++) {
+            pIn[i * degree1 + e] = pIn[i * degree1 + e - 1] * bIn[i];
+            pOut[i * degree1 + e] = pOut[i * degree1 + e - 1] * bOut;
+        }
+    }
+
+    // Monomials with multinomials (Bernstein basis polynomials) of entry and exit coords
+    float mIn[MAX_MONOMIALS], mOut[MAX_MONOMIALS];
+    for (size_t m = 0; m < monomials.size(); m++) {
+        const unsigned short *powers = monomials[m].powers;
+        mIn[m] = pIn[powers[0]] * pIn[powers[1]] * pIn[powers[2]] * pIn[powers[3]] * monomials[m].multinomial;
+        mOut[m] = pOut[powers[0]] * pOut[powers[1]] * pOut[powers[2]] * pOut[powers[3]] * monomials[m].multinomial;
+    }
+
+    float sum = 0.0f;
+    int t = 0;
+    for (int c = 0; c < coeffsCount; c++) {
+        float sum2 = 0.0f;
+        for (; t < termsEnd[c]; t++)
+            sum2 += mIn[terms[t].in] * mOut[terms[t].out];
+        sum += coefficients[c] * sum2;
+    }
+
+    return sum * wLength * integralFactor;
+}
+}
@@ -19,6 +19,8 @@
 
 #include "rendering/mainrenderer.h"
 
+#include <vector>
+
 namespace SSIMRenderer
 {
 /**
@@ -30,6 +32,8 @@ MainRenderer::MainRenderer(QSurface *surface, OpenGLWrapper *parentOpenGLWrapper
     : OpenGLWrapper(surface, parentOpenGLWrapper)
 {
     init();
+    if (!isValid())
+        return;
     checkInitAndMakeCurrentContext();
 }
 
@@ -44,6 +48,8 @@ MainRenderer::MainRenderer(QSurface *surface, GLuint renderWidth, GLuint renderH
     : OpenGLWrapper(surface, parentOpenGLWrapper)
 {
     init();
+    if (!isValid())
+        return;
     checkInitAndMakeCurrentContext();
     setRenderWidth(renderWidth);
     setRenderHeight(renderHeight);
@@ -56,59 +62,108 @@ MainRenderer::MainRenderer(QSurface *surface, GLuint renderWidth, GLuint renderH
  */
 MainRenderer::~MainRenderer()
 {
+    // Nothing was allocated without OpenGL context
+    if (!isValid())
+        return;
+
     checkInitAndMakeCurrentContext();
 
     // Delete programs and others
-    if (!hasSharedContext() && density->program) {
+    if (!hasSharedContext() && density) {
         //density->program->release();
         delete density->program;
         delete density->fragmentShader;
+        delete density->programBounds;
         delete density;
     }
 
-    if (!hasSharedContext() && silhouettes->program) {
+    if (!hasSharedContext() && densityBatch) {
+        delete densityBatch->program;
+        delete densityBatch->fragmentShader;
+        delete densityBatch;
+    }
+
+    if (!hasSharedContext() && densityPulling) {
+        delete densityPulling->program;
+        delete densityPulling->fragmentShader;
+        delete densityPulling->programInverse;
+        delete densityPulling;
+    }
+
+    if (!hasSharedContext() && densityBasis) {
+        delete densityBasis->program;
+        delete densityBasis;
+    }
+
+    if (!hasSharedContext() && silhouettes) {
         //silhouettes->program->release();
         delete silhouettes->program;
         delete silhouettes;
     }
 
-    if (!hasSharedContext() && computing->program) {
+    if (!hasSharedContext() && computing) {
         //computing->program->release();
         delete computing->program;
+        delete computing->programDelta;
         delete computing;
     }
 
-    if (!hasSharedContext() && pyramid->program) {
+    if (!hasSharedContext() && positions) {
+        delete positions->program;
+        delete positions;
+    }
+
+    if (!hasSharedContext() && pyramid) {
         //pyramid->program->release();
         delete pyramid->program;
         delete pyramid;
     }
 
-    if (!hasSharedContext() && polygonal->program) {
+    if (!hasSharedContext() && polygonal) {
         //polygonal->program->release();
         delete polygonal->program;
         delete polygonal;
     }
 
-    if (!hasSharedContext() && postprocessing->program && postprocessing->programSimple) {
+    if (!hasSharedContext() && postprocessing) {
         //postprocessing->program->release();
         delete postprocessing->program;
         delete postprocessing->programSimple;
         delete postprocessing;
     }
 
+    if (!hasSharedContext() && fusedSSD) {
+        delete fusedSSD->program;
+        delete fusedSSD->programReduce;
+        delete fusedSSD;
+    }
+
+    if (!hasSharedContext() && densityVolume) {
+        delete densityVolume->programBake;
+        delete densityVolume->fragmentShader;
+        delete densityVolume->programOccupancy;
+        delete densityVolume->program;
+        glDeleteTextures(1, &densityVolume->toVolume);
+        glDeleteTextures(1, &densityVolume->toOccupancy);
+        delete densityVolume;
+    }
+
     if (!hasSharedContext()) {
         iboElementsTetrahedra.destroy();
         iboElementsTriangles.destroy();
         iboElementsTrianglesAdjacency.destroy();
 
         vboVertices.destroy();
+        vboPositions.destroy();
         vboVerticesColors.destroy();
         //vboComputeIndicesX.destroy();
         //vboComputeIndicesY.destroy();
         vboNormals.destroy();
+        vboTetrahedraInverse.destroy();
+        vboClusterBounds.destroy();
 
         glDeleteBuffers(1, &tboBerncoeffs);
+        glDeleteBuffers(1, &uboBernsteinWeights);
         glDeleteBuffers(1, &tboT);
         glDeleteBuffers(1, &tboPcs);
 
@@ -117,22 +172,55 @@ MainRenderer::~MainRenderer()
         glDeleteTextures(1, &toBerncoeffs);
         glDeleteTextures(1, &toT);
         glDeleteTextures(1, &toPcs);
+        glDeleteTextures(1, &toPositions);
+        glDeleteTextures(1, &toElementsTetrahedra);
+        glDeleteTextures(1, &toTetrahedraInverse);
     }
 
-    glDeleteTextures(1, &toDensity);
-    glDeleteTextures(1, &toSilhouettes);
-    glDeleteTextures(1, &toPyramid);
-    glDeleteTextures(1, &toPolygonal);
-    glDeleteTextures(1, &toOutput);
-    glDeleteTextures(1, &toPyramidImage);
+    // Layer textures and depth buffer are returned to pool, the last renderer deletes the pool
+    if (renderTargetPool) {
+        renderTargetPool->releaseTexture(toDensity);
+        renderTargetPool->releaseTexture(toSilhouettes);
+        renderTargetPool->releaseTexture(toPyramid);
+        renderTargetPool->releaseTexture(toPolygonal);
+        renderTargetPool->releaseRenderbuffer(rbo);
+        renderTargetPool->releaseTexture(toSSDTiles[0]);
+        renderTargetPool->releaseTexture(toSSDTiles[1]);
+        renderTargetPool->releaseTexture(toOutput);
+        renderTargetPool->releaseTexture(toReadback);
+
+        if (renderTargetPool->detach(this)) {
+            renderTargetPool->destroy();
+            delete renderTargetPool;
+        }
+        renderTargetPool = 0;
+    }
 
-    glDeleteRenderbuffers(1, &rbo);
+    glDeleteTextures(1, &toPyramidImage);
+    glDeleteTextures(1, &toBatch);
+    glDeleteTextures(1, &toBatchMatrices);
+    glDeleteTextures(1, &toDensityBasis);
+    glDeleteTextures(1, &toBasisWeights);
+
+    glDeleteBuffers(1, &tboBatchMatrices);
+    glDeleteBuffers(1, &tboBasisWeights);
+
+    glDeleteTextures(1, &toReference);
+    for (int i = 0; i < READBACK_RING_SIZE; i++) {
+        if (readbacks[i].fence)
+            glDeleteSync(readbacks[i].fence);
+        glDeleteBuffers(1, &readbacks[i].pbo);
+    }
 
     glDeleteVertexArrays(1, &vao);
 
     glDeleteFramebuffers(1, &fbo);
     glDeleteFramebuffers(1, &fboOutput);
     glDeleteFramebuffers(1, &fboComputing);
+    glDeleteFramebuffers(1, &fboBatch);
+    glDeleteFramebuffers(1, &fboReadback);
+
+    passTimer.destroy();
 
 }
 
@@ -149,10 +237,13 @@ void MainRenderer::setMesh(Mesh *mesh, GLfloat *colors, GLfloat *normals)
         return;
     }
 
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     this->mesh = mesh;
 
+    invalidateDensityVolume();
+
     // Load vertices and indices data to GPU by main context
     if (!hasSharedContext()) {
 
@@ -171,9 +262,7 @@ void MainRenderer::setMesh(Mesh *mesh, GLfloat *colors, GLfloat *normals)
         iboElementsTetrahedra.allocate(this->mesh->getTableOfTetrahedra(), sizeof(GLuint) * this->mesh->getNumberOfTetrahedra() * 4);
         iboElementsTetrahedra.release();
 
-        iboElementsTriangles.bind();
-        iboElementsTriangles.allocate(this->mesh->getTableOfTriangles(), sizeof(GLuint) * this->mesh->getNumberOfTriangles() * 3);
-        iboElementsTriangles.release();
+        allocateOptimizedElements(iboElementsTriangles, this->mesh->getTableOfTriangles(), this->mesh->getNumberOfTriangles(), 3, this->mesh->getNumberOfVertices());
 
         if (colors) {
             setVerticesColors(colors);
@@ -192,13 +281,13 @@ void MainRenderer::setMesh(Mesh *mesh, GLfloat *colors, GLfloat *normals)
         if (this->mesh->getNumberOfTrianglesAdjacency() == 0)
             qWarning() << "Triangles adjacency are not available (mesh->getNumberOfTrianglesAdjacency() == 0)";
 
-        iboElementsTrianglesAdjacency.bind();
-        iboElementsTrianglesAdjacency.allocate(this->mesh->getTableOfTrianglesAdjacency(), sizeof(GLuint) * this->mesh->getNumberOfTrianglesAdjacency() * 6);
-        iboElementsTrianglesAdjacency.release();
+        allocateOptimizedElements(iboElementsTrianglesAdjacency, this->mesh->getTableOfTrianglesAdjacency(), this->mesh->getNumberOfTrianglesAdjacency(), 6, this->mesh->getNumberOfVertices());
 
         vboVertices.bind();
         vboVertices.allocate(this->mesh->getTableOfVertices(), sizeof(GLfloat) * this->mesh->getNumberOfVertices() * 3);
         vboVertices.release();
+
+        recomputePositionsFlag = true;
     }
 }
 
@@ -213,7 +302,8 @@ void MainRenderer::setVerticesColors(GLfloat *colors)
         return;
     }
 
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     if (!hasSharedContext()) {
         vboVerticesColors.bind();
@@ -236,7 +326,8 @@ void MainRenderer::setNormals(GLfloat *normals)
         return;
     }
 
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
     if (!hasSharedContext()) {
         vboNormals.bind();
@@ -266,7 +357,10 @@ void MainRenderer::setCoefficients(StatisticalData *statisticalData)
         return;
     }
 
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    invalidateDensityVolume();
 
     if (!hasSharedContext()) {
         if (mesh->getNumberOfTetrahedra() == 0) {
@@ -283,27 +377,15 @@ void MainRenderer::setCoefficients(StatisticalData *statisticalData)
         glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboBerncoeffs);
         glBindTexture(GL_TEXTURE_BUFFER, 0);
 
-        if (lastBernCoeffsCount != bernCoeffsCount) {
-            density->program->removeShader(density->fragmentShader);
-            addShaderFromSource(density->program, density->fragmentShader, fsGenerator.generateFragmentShaderSourceCode(bernCoeffsCount/*, true*/));
-            linkProgram(density->program);
-
-            getVariablesLocations();
-            initUniformVariables();
-
-            density->program->bind();
-            density->program->setUniformValue(density->uPositionDiffLengthLog2, positionDiffLengthLog2);
-            density->program->setUniformValue(density->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
-            density->program->release();
-        }
+        if (lastBernCoeffsCount != bernCoeffsCount)
+            updateDensityPrograms(bernCoeffsCount);
 
         lastBernCoeffsCount = bernCoeffsCount;
     }
 
-    if (this->statisticalData != statisticalData) {
-        setStatisticalData(statisticalData);
-        updateCoefficients(statisticalData);
-    }
+    // T matrix is uploaded again, it could be changed (e.g. by StatisticalData::reorderRows())
+    setStatisticalData(statisticalData);
+    updateCoefficients(statisticalData);
 }
 
 /**
@@ -319,7 +401,12 @@ void MainRenderer::setVertices(StatisticalData *statisticalData)
         return;
     }
 
-    checkInitAndMakeCurrentContext();
+    verticesStatisticalData = statisticalData;
+
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    invalidateDensityVolume();
 
     if (!hasSharedContext()) {
         // @todo TODO check size
@@ -328,10 +415,11 @@ void MainRenderer::setVertices(StatisticalData *statisticalData)
         vboVertices.allocate(statisticalData->getMeanMatrix(), sizeof(GLfloat) * statisticalData->getNumberOfRows());
         vboVertices.release();
 
-        if (this->statisticalData != statisticalData) {
-            setStatisticalData(statisticalData);
-            updateVertices(statisticalData);
-        }
+        recomputePositionsFlag = true;
+
+        // T matrix is uploaded again, it could be changed (e.g. by StatisticalData::reorderRows())
+        setStatisticalData(statisticalData);
+        updateVertices(statisticalData);
     }
 }
 
@@ -348,12 +436,13 @@ void MainRenderer::updateCoefficients(StatisticalData *statisticalData)
         return;
     }
 
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-    if (this->statisticalData != statisticalData) {
-        setStatisticalData(statisticalData);
+    invalidateDensityVolume();
+
+    if (this->statisticalData != statisticalData)
         setCoefficients(statisticalData);
-    }
 
     if (!hasSharedContext())
         recomputeCoefficientsDiffFlag = true;
@@ -372,12 +461,15 @@ void MainRenderer::updateVertices(StatisticalData *statisticalData)
         return;
     }
 
-    checkInitAndMakeCurrentContext();
+    verticesStatisticalData = statisticalData;
 
-    if (this->statisticalData != statisticalData) {
-        setStatisticalData(statisticalData);
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    invalidateDensityVolume();
+
+    if (this->statisticalData != statisticalData)
         setVertices(statisticalData);
-    }
 
     if (!hasSharedContext())
         recomputeVerticesDiffFlag = true;
@@ -386,6 +478,8 @@ void MainRenderer::updateVertices(StatisticalData *statisticalData)
 /**
  * @brief Returns recomputed vertices
  * @param[out] vertices Output array with vertices
+ * @param[in] transformed Flag for getting transformed vertices
+ * @return Number of vertices
  *
  * Vertices output array is allocated in this function.
  */
@@ -396,49 +490,83 @@ long MainRenderer::getRecomputedVertices(float *&vertices, bool transformed)
         return 0;
     }
 
-    checkInitAndMakeCurrentContext();
+    long size = mesh->getNumberOfVertices() * 3;
+    vertices = new float[size]();
 
-    float *dataDiff = new float[cWidth * cHeight]();
+    return getRecomputedVertices(vertices, size, transformed);
+}
 
-    glBindTexture(GL_TEXTURE_2D, toCompVertices);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, dataDiff);
-    glBindTexture(GL_TEXTURE_2D, 0);
+/**
+ * @brief Returns recomputed vertices to caller-owned array
+ * @param[out] vertices Output array with vertices
+ * @param[in] size Size of output array (at least number of vertices * 3)
+ * @param[in] transformed Flag for getting transformed vertices
+ * @return Number of vertices, 0 on error
+ *
+ * Final positions are read directly to output array, no memory is allocated. If CPU reconstruction
+ * is enabled, vertices are computed from statistical data without OpenGL context. Vertices
+ * of spatially reordered mesh (Mesh::reorderSpatially) are returned in original order.
+ */
+long MainRenderer::getRecomputedVertices(float *vertices, long size, bool transformed)
+{
+    if (!mesh) {
+        qCritical() << "MainRenderer::getRecomputedVertices error: null Mesh";
+        return 0;
+    }
 
-    float *dataMean;
+    long numberOfVertices = mesh->getNumberOfVertices();
+    if (!checkOutputArray("MainRenderer::getRecomputedVertices", vertices, size, numberOfVertices * 3, 1, 1))
+        return 0;
 
-    vboVertices.bind();
-    dataMean = (float *) glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
+    if (cpuReconstructionEnabled && verticesStatisticalData && verticesStatisticalData->getNumberOfRows() == numberOfVertices * 3) {
+        QMatrix4x4 transformation = translationMatrix * rotationMatrix;
+        long result = shapeReconstructionCPU.reconstructVertices(verticesStatisticalData, vertices, size, xMirroringEnabled, transformed ? &transformation : 0);
+        mesh->restoreVertexOrder(vertices);
+        return result;
+    }
 
-    long size = mesh->getNumberOfVertices();
-    vertices = new float[size * 3]();
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
 
-    // @todo TODO - this is slowly solution
+    // Final positions are updated by main context
+    if (!hasSharedContext())
+        recomputeStatisticalDataIfNeeded();
 
-    for (int i = 0; i < size; i++) {
-        // Invert x coordinate
-        if (xMirroringEnabled)
-            vertices[i * 3] = -(dataMean[i * 3] + dataDiff[i * 3]);
-        else
-            vertices[i * 3] = dataMean[i * 3] + dataDiff[i * 3];
+    long count = numberOfVertices * 3;
 
-        vertices[i * 3 + 1] = dataMean[i * 3 + 1] + dataDiff[i * 3 + 1];
-        vertices[i * 3 + 2] = dataMean[i * 3 + 2] + dataDiff[i * 3 + 2];
+    vboPositions.bind();
+    if (vboPositions.size() < int(sizeof(float) * count)) {
+        qCritical() << "MainRenderer::getRecomputedVertices error: positions are not computed";
+        vboPositions.release();
+        return 0;
+    }
 
-        if (transformed) {
-            QVector3D transformedVertex = (translationMatrix * rotationMatrix * QVector4D(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2], 1)).toVector3DAffine();
-            vertices[i * 3 + 0] = transformedVertex.x();
-            vertices[i * 3 + 1] = transformedVertex.y();
-            vertices[i * 3 + 2] = transformedVertex.z();
-        }
+    const float *positionsData = (const float *) glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
+
+    if (!positionsData) {
+        qCritical() << "MainRenderer::getRecomputedVertices error: positions buffer cannot be mapped";
+        vboPositions.release();
+        return 0;
     }
 
+    memcpy(vertices, positionsData, sizeof(float) * count);
+
     glUnmapBuffer(GL_ARRAY_BUFFER);
-    vboVertices.release();
+    vboPositions.release();
+
+    QMatrix4x4 transformation = translationMatrix * rotationMatrix;
 
-    delete[] dataDiff;
+    if (transformed) {
+        shapeReconstructionCPU.transform(vertices, numberOfVertices, transformation, xMirroringEnabled);
+    } else if (xMirroringEnabled) {
+        // Invert x coordinate
+        for (long i = 0; i < count; i += 3)
+            vertices[i] = -vertices[i];
+    }
 
-    return size;
+    mesh->restoreVertexOrder(vertices);
+
+    return numberOfVertices;
 }
 
 /**
@@ -448,24 +576,18 @@ long MainRenderer::getRecomputedVertices(float *&vertices, bool transformed)
  */
 QVector<QVector3D> MainRenderer::getRecomputedVertices(bool transformed)
 {
-    float *buffer;
+    Q_STATIC_ASSERT(sizeof(QVector3D) == 3 * sizeof(float));
 
     if (!mesh) {
         qCritical() << "MainRenderer::getRecomputedVertices error: null Mesh";
         return QVector<QVector3D>();
     }
 
-    getRecomputedVertices(buffer, transformed);
-
     QVector<QVector3D> result(mesh->getNumberOfVertices());
 
-    for(int i = 0; i < result.size(); i++) {
-        result[i].setX(buffer[i * 3 + 0]);
-        result[i].setY(buffer[i * 3 + 1]);
-        result[i].setZ(buffer[i * 3 + 2]);
-    }
+    // Vertices are written directly to vector data
+    getRecomputedVertices(reinterpret_cast<float *>(result.data()), result.size() * 3, transformed);
 
-    delete[] buffer;
     return result;
 }
 
@@ -537,6 +659,15 @@ void MainRenderer::exportSTL(const QString &filename, bool transformed, QVector<
         QVector<QVector<unsigned int>> triangles = mesh->getTriangles2DVector();
         //QVector<bool> msk = getMask();
 
+        // Vertices are in original order
+        const QVector<unsigned int> &vertexOrder = mesh->getVertexOrder();
+        if (!vertexOrder.isEmpty()) {
+            for (int i = 0; i < triangles.size(); i++) {
+                for (int j = 0; j < 3; j++)
+                    triangles[i][j] = vertexOrder[int(triangles[i][j])];
+            }
+        }
+
 //        if(!xMirroringEnabled)
 //        {
 
@@ -604,7 +735,8 @@ void MainRenderer::saveRenderedImage(const QString &filePath)
  */
 QImage MainRenderer::getRenderedImage()
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return QImage();
 
     //debugTexture(toOutput);
 
@@ -626,13 +758,37 @@ QImage MainRenderer::getRenderedImage()
  */
 void MainRenderer::getRenderedRedChannel(float *&data)
 {
-    checkInitAndMakeCurrentContext();
-
     data = new float [getCropWidth() * getCropHeight()]();
-    glBindTexture(GL_TEXTURE_2D, toOutput);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    getRenderedRedChannel(data, getCropWidth() * getCropHeight());
+}
+
+/**
+ * @brief Returns rendered red channel to caller-owned array
+ * @param[out] data Float 1D array
+ * @param[in] size Size of output array
+ * @param[in] rowStride Number of values between starts of rows (0 means crop width)
+ * @return False if output array is too small
+ *
+ * Only crop window is read, rows are in OpenGL (bottom-up) order. No memory is allocated.
+ */
+bool MainRenderer::getRenderedRedChannel(float *data, long size, GLuint rowStride)
+{
+    if (!checkOutputArray("MainRenderer::getRenderedRedChannel", data, size, getCropWidth(), getCropHeight(), 1, rowStride))
+        return false;
+
+    if (!checkInitAndMakeCurrentContext())
+        return false;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fboOutput);
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toOutput, 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ROW_LENGTH, rowStride);
+    glReadPixels(0, 0, getCropWidth(), getCropHeight(), GL_RED, GL_FLOAT, data);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    return true;
 }
 
 /**
@@ -641,8 +797,9 @@ void MainRenderer::getRenderedRedChannel(float *&data)
  */
 void MainRenderer::saveRedChannelToOpenExr(const QString &filePath)
 {
-    float *data;
-    getRenderedRedChannel(data);
+    QVector<float> buffer(getCropWidth() * getCropHeight());
+    float *data = buffer.data();
+    getRenderedRedChannel(data, buffer.size());
 
     Imf::Header header(getCropWidth(), getCropHeight());
     header.channels().insert ("Z", Imf::Channel (Imf::FLOAT));
@@ -663,2207 +820,4867 @@ void MainRenderer::saveRedChannelToOpenExr(const QString &filePath)
 
 
 /**
- * @brief Returns current silhouettes image
- * @param[out] image Output array with silhouettes image
+ * @brief Starts asynchronous readback of rendered image
+ * @return Handle for waitForRenderedImage()
  *
- * Output array is allocated in this function
+ * Image is flipped on GPU, transfer runs while the next frame is rendered.
  */
-void MainRenderer::getCurrentSilhouettesImage(float *&image)
+long MainRenderer::readRenderedImageAsync()
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
 
-    image = new float [getRenderWidth() * getRenderHeight() * 4]();
-    glBindTexture(GL_TEXTURE_2D, toSilhouettes);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, image);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    return readbackAsync(toOutput, 0, 0, GL_RGB, GL_UNSIGNED_BYTE, 3, true);
 }
 
 /**
- * @brief Returns output texture id
- * @return Output texture id
- *
- * For work with shared contexts
+ * @brief Starts asynchronous readback of rendered red channel
+ * @param[in] flip Flip rows to top-down order on GPU
+ * @return Handle for waitForRenderedRedChannel()
  */
-GLuint MainRenderer::getOutputTextureId() const
+long MainRenderer::readRenderedRedChannelAsync(bool flip)
 {
-    return toOutput;
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
+
+    return readbackAsync(toOutput, 0, 0, GL_RED, GL_FLOAT, sizeof(GLfloat), flip);
 }
 
 /**
- * @brief Sets intensity for density rendering
- * @param[in] value Intesity value from 0.0 to 1.0
+ * @brief Is asynchronous readback finished?
+ * @param[in] handle Readback handle
+ * @return True if data can be taken without waiting
  */
-void MainRenderer::setIntensity(double value)
+bool MainRenderer::isReadbackReady(long handle)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return false;
 
-    intensity = value;
-    if (intensity < 0.0f) intensity = 0.0f;
-    if (intensity > 1.0f) intensity = 1.0f;
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uIntensity, (float) (value / 5000.0f));
-    postprocessing->program->release();
+    if (handle <= 0)
+        return false;
+
+    Readback &readback = readbacks[handle % READBACK_RING_SIZE];
+    if (readback.handle != handle || !readback.fence)
+        return false;
+
+    GLenum status = glClientWaitSync(readback.fence, 0, 0);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
 }
 
 /**
- * @brief Sets line width for silhouettes rendering
- * @param[in] value Line width from 1 to 10
+ * @brief Waits for asynchronous readback of rendered image
+ * @param[in] handle Handle returned by readRenderedImageAsync()
+ * @return Rendered image, null image on error
  */
-void MainRenderer::setLineWidth(double value)
+QImage MainRenderer::waitForRenderedImage(long handle)
 {
-    checkInitAndMakeCurrentContext();
+    if (!checkInitAndMakeCurrentContext())
+        return QImage();
 
-    lineWidth = value;
-    if (lineWidth < 1) lineWidth = 1;
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uLineWidth, (int) lineWidth);
-    postprocessing->program->release();
+    GLuint width, height, size;
+    const GLubyte *data = mapReadback(handle, GL_RGB, GL_UNSIGNED_BYTE, width, height, size);
+    if (!data)
+        return QImage();
+
+    // QImage scan lines are 32-bit aligned
+    QImage image(width, height, QImage::Format_RGB888);
+    for (GLuint y = 0; y < height; y++)
+        memcpy(image.scanLine(y), data + y * width * 3, width * 3);
+
+    unmapReadback();
+
+    return image;
 }
 
 /**
- * @brief Sets special param for density rendering - unused
- * @param[in] value Some value
+ * @brief Waits for asynchronous readback of rendered red channel
+ * @param[in] handle Handle returned by readRenderedRedChannelAsync()
+ * @param[out] data Float 1D array
+ * @return False on error
+ *
+ * Output array is allocated in this function.
  */
-void MainRenderer::setParam(double value)
+bool MainRenderer::waitForRenderedRedChannel(long handle, float *&data)
 {
-    checkInitAndMakeCurrentContext();
+    data = 0;
+    if (!checkInitAndMakeCurrentContext())
+        return false;
+
+    GLuint width, height, size;
+    const GLubyte *mapped = mapReadback(handle, GL_RED, GL_FLOAT, width, height, size);
+    if (!mapped) {
+        data = 0;
+        return false;
+    }
 
-    // @todo TODO - delete in future
-    param = value;
-    density->program->bind();
-    density->program->setUniformValue(density->uParam, (float) param);
-    density->program->release();
+    data = new float [width * height];
+    memcpy(data, mapped, size);
+
+    unmapReadback();
+
+    return true;
 }
 
 /**
- * @brief Returns intenstity for density rendering
- * @return Intenstity value
+ * @brief Waits for asynchronous readback of rendered red channel to caller-owned array
+ * @param[in] handle Handle returned by readRenderedRedChannelAsync()
+ * @param[out] data Float 1D array
+ * @param[in] size Size of output array
+ * @return False on error or if output array is too small
  */
-double MainRenderer::getIntensity() const
+bool MainRenderer::waitForRenderedRedChannel(long handle, float *data, long size)
 {
-    return intensity;
+    if (!checkInitAndMakeCurrentContext())
+        return false;
+
+    GLuint width, height, mappedSize;
+    const GLubyte *mapped = mapReadback(handle, GL_RED, GL_FLOAT, width, height, mappedSize);
+    if (!mapped)
+        return false;
+
+    bool result = checkOutputArray("MainRenderer::waitForRenderedRedChannel", data, size, width, height, 1);
+    if (result)
+        memcpy(data, mapped, mappedSize);
+
+    unmapReadback();
+
+    return result;
 }
 
 /**
- * @brief Returns line width for silhouettes rendering
- * @return Line width
+ * @brief Returns crop window of current silhouettes image
+ * @param[out] image Output array with RGBA silhouettes image
+ *
+ * Output array is allocated in this function.
  */
-double MainRenderer::getLineWidth() const
+void MainRenderer::getCurrentSilhouettesImage(float *&image)
 {
-    return lineWidth;
+    image = new float [getCropWidth() * getCropHeight() * 4]();
+    getCurrentSilhouettesImage(image, getCropWidth() * getCropHeight() * 4);
 }
 
 /**
- * @brief Return special param value
- * @return Value of special param for density rendering
+ * @brief Returns crop window of current silhouettes image to caller-owned array
+ * @param[out] image Output array with RGBA silhouettes image
+ * @param[in] size Size of output array
+ * @param[in] rowStride Number of pixels between starts of rows (0 means crop width)
+ * @return False if output array is too small
+ *
+ * Rows are in OpenGL (bottom-up) order. No memory is allocated.
  */
-double MainRenderer::getParam() const
+bool MainRenderer::getCurrentSilhouettesImage(float *image, long size, GLuint rowStride)
 {
-    return param;
+    return readLayer("MainRenderer::getCurrentSilhouettesImage", toSilhouettes, silhouettesEnabled, GL_RGBA, 4, image, size, rowStride);
 }
 
 /**
- * @brief Sets render width
- * @param[in] renderWidth Render width
+ * @brief Returns raw density of crop window
+ * @param[out] data Float 1D array
  *
- * Sets cropping to same size.
+ * Output array is allocated in this function.
  */
-void MainRenderer::setRenderWidth(GLuint renderWidth)
+void MainRenderer::getCurrentDensityData(float *&data)
 {
-    checkInitAndMakeCurrentContext();
-
-    if (renderWidth < 1 || renderWidth > maxTextureOrRenderSize[0]) {
-        qCritical("Wrong render width");
-        Q_ASSERT_X(false, "OpenGL error", "Wrong render width");
-        exit(1);
-    }
-    this->renderWidth = renderWidth;
-    this->cropX = 0;
-    this->cropWidth = renderWidth;
-    ratio = (float) getRenderWidth() / (float) getRenderHeight();
-    step.setX(1.0f / (float) getRenderWidth());
-    step.setY(1.0f / (float) getRenderHeight());
-    sizeChanged = true;
+    data = new float [getCropWidth() * getCropHeight()]();
+    getCurrentDensityData(data, getCropWidth() * getCropHeight());
 }
 
 /**
- * @brief Sets render height
- * @param[in] renderHeight Render height
+ * @brief Returns raw density of crop window to caller-owned array
+ * @param[out] data Float 1D array
+ * @param[in] size Size of output array
+ * @param[in] rowStride Number of values between starts of rows (0 means crop width)
+ * @return False if output array is too small or density is disabled
  *
- * Sets cropping to same size.
+ * Density layer is read directly, it is independent on postprocessing and other layers.
+ * Rows are in OpenGL (bottom-up) order. No memory is allocated.
  */
-void MainRenderer::setRenderHeight(GLuint renderHeight)
+bool MainRenderer::getCurrentDensityData(float *data, long size, GLuint rowStride)
 {
-    checkInitAndMakeCurrentContext();
-
-    if (renderHeight < 1 || renderHeight > maxTextureOrRenderSize[1]) {
-        qCritical("Wrong render height");
-        Q_ASSERT_X(false, "OpenGL error", "Wrong render height");
-        exit(1);
-    }
-    this->renderHeight = renderHeight;
-    this->cropY = 0;
-    this->cropHeight = renderHeight;
-    ratio = (float) getRenderWidth() / (float) getRenderHeight();
-    step.setX(1.0f / (float) getRenderWidth());
-    step.setY(1.0f / (float) getRenderHeight());
-    sizeChanged = true;
+    return readLayer("MainRenderer::getCurrentDensityData", toDensity, densityEnabled, GL_RED, 1, data, size, rowStride);
 }
 
 /**
- * @brief Sets render size
- * @param[in] renderWidth Render width
- * @param[in] renderHeight Render height
+ * @brief Returns crop window of current polygonal image to caller-owned array
+ * @param[out] image Output array with RGBA polygonal image
+ * @param[in] size Size of output array
+ * @param[in] rowStride Number of pixels between starts of rows (0 means crop width)
+ * @return False if output array is too small or polygonal rendering is disabled
  *
- * Sets cropping to same size.
+ * Rows are in OpenGL (bottom-up) order. No memory is allocated.
  */
-void MainRenderer::setRenderSize(GLuint renderWidth, GLuint renderHeight)
+bool MainRenderer::getCurrentPolygonalImage(float *image, long size, GLuint rowStride)
 {
-    setRenderWidth(renderWidth);
-    setRenderHeight(renderHeight);
+    return readLayer("MainRenderer::getCurrentPolygonalImage", toPolygonal, polygonalEnabled, GL_RGBA, 4, image, size, rowStride);
 }
 
 /**
- * @brief Returns render width
- * @return Render width
+ * @brief Starts asynchronous readback of raw density of crop window
+ * @param[in] flip Flip rows to top-down order on GPU
+ * @return Handle for waitForRenderedRedChannel(), 0 if density is disabled
  */
-GLuint MainRenderer::getRenderWidth() const
+long MainRenderer::readCurrentDensityDataAsync(bool flip)
 {
-    return renderWidth;
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
+
+    if (!densityEnabled) {
+        qCritical() << "MainRenderer::readCurrentDensityDataAsync error: density is disabled";
+        return 0;
+    }
+
+    return readbackAsync(toDensity, getCropX(), getCropY(), GL_RED, GL_FLOAT, sizeof(GLfloat), flip);
 }
 
 /**
- * @brief Returns render height
- * @return Render height
+ * @brief Returns output texture id
+ * @return Output texture id
+ *
+ * For work with shared contexts. Output texture is acquired from render target pool,
+ * its id changes after change of crop size.
  */
-GLuint MainRenderer::getRenderHeight() const
+GLuint MainRenderer::getOutputTextureId() const
 {
-    return renderHeight;
+    return toOutput;
 }
 
 /**
- * @brief Sets cropping window
- * @param[in] cropX X position - top left
- * @param[in] cropY Y position - top left
- * @param[in] cropWidth Cropping width
- * @param[in] cropHeight Cropping height
+ * @brief Renders density of multiple poses in one draw call
+ * @param[in] poses Model matrices (translation * rotation) of rendered poses
+ *
+ * Every pose is rendered to its own layer of 2D array texture with the size of crop window.
+ * Only raw density (red channel) is rendered, camera, perspective and statistical data
+ * are shared by all poses. Results are available by getBatchRedChannel().
  */
-void MainRenderer::setCropWindow(GLuint cropX, GLuint cropY, GLuint cropWidth, GLuint cropHeight)
+void MainRenderer::renderBatch(const QVector<QMatrix4x4> &poses)
 {
-    checkInitAndMakeCurrentContext();
-
-    GLuint newCropY = renderHeight - (cropHeight + cropY);
-
-    if (cropX < 0 || cropX >= renderWidth - 1) {
-        qCritical("Wrong crop x position");
+    if (!mesh) {
+        qCritical() << "MainRenderer::renderBatch error: null Mesh";
         return;
     }
 
-    if (cropWidth < 1 || cropWidth > maxTextureOrRenderSize[0] || cropX + cropWidth > renderWidth) {
-        qCritical("Wrong crop width");
+    if (poses.isEmpty()) {
+        qWarning() << "MainRenderer::renderBatch warning: no poses";
         return;
     }
 
-    if (newCropY < 0 || newCropY >= renderHeight - 1) {
-        qCritical("Wrong crop y position");
+    if (!checkInitAndMakeCurrentContext())
         return;
-    }
 
-    if (cropHeight < 1 || cropHeight > maxTextureOrRenderSize[1] || newCropY + cropHeight > renderHeight) {
-        qCritical("Wrong crop height");
+    if (GLuint(poses.size()) > getMaxBatchSize()) {
+        qCritical() << "MainRenderer::renderBatch error: too many poses" << poses.size() << "(max" << getMaxBatchSize() << ")";
         return;
     }
 
-    this->cropX = cropX;
-    this->cropWidth = cropWidth;
-    this->cropY = newCropY;
-    this->cropHeight = cropHeight;
-    sizeChanged = true;
-}
+    prepareTransformation();
 
-/**
- * @brief Sets cropping window
- * @param[in] rectangle Cropping rectangle
- */
-void MainRenderer::setCropWindow(const QRect &rectangle)
-{
-    setCropWindow(rectangle.x(), rectangle.y(), rectangle.width(), rectangle.height());
+    // Resize for current width and height
+    resizeTexturesAndRenderbuffer();
+
+    recomputeStatisticalDataIfNeeded();
+
+    // Resize layered texture
+    if (batchSize != GLuint(poses.size()) || batchWidth != getCropWidth() || batchHeight != getCropHeight()) {
+        batchSize = poses.size();
+        batchWidth = getCropWidth();
+        batchHeight = getCropHeight();
+        glBindTexture(GL_TEXTURE_2D_ARRAY, toBatch);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, batchWidth, batchHeight, batchSize, 0, GL_RED, GL_FLOAT, 0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    // Final matrices and its inversions (column-major), 32 floats per pose
+    QMatrix4x4 viewMatrix = perspectiveMatrix * cameraMatrix;
+    GLfloat *matrices = new GLfloat[batchSize * 32];
+    for (GLuint i = 0; i < batchSize; i++) {
+        QMatrix4x4 poseMatrix = viewMatrix * poses.at(i);
+        memcpy(matrices + i * 32, poseMatrix.constData(), sizeof(GLfloat) * 16);
+        memcpy(matrices + i * 32 + 16, poseMatrix.inverted().constData(), sizeof(GLfloat) * 16);
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, tboBatchMatrices);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * batchSize * 32, matrices, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, toBatchMatrices);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, tboBatchMatrices);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    delete[] matrices;
+
+    renderDensityBatch();
 }
 
 /**
- * @brief Returns cropping x position
- * @return Cropping x position
+ * @brief Returns rendered red channels of last batch
+ * @param[out] data Float 1D array with all layers
+ * @return Number of layers, 0 if no batch was rendered
+ *
+ * Output array is allocated in this function (null if no batch was rendered).
+ * Layers are stored one after another, every layer has crop width * crop height values
+ * with rows in OpenGL (bottom-up) order.
  */
-GLuint MainRenderer::getCropX() const
+long MainRenderer::getBatchRedChannel(float *&data)
 {
-    return cropX;
+    if (batchSize == 0) {
+        qCritical() << "MainRenderer::getBatchRedChannel error: no batch was rendered";
+        data = 0;
+        return 0;
+    }
+
+    long size = long(batchWidth) * batchHeight * batchSize;
+    data = new float [size]();
+    return getBatchRedChannel(data, size);
 }
 
 /**
- * @brief Returns cropping y position
- * @return Cropping y position
+ * @brief Returns rendered red channels of last batch to caller-owned array
+ * @param[out] data Float 1D array with all layers
+ * @param[in] size Size of output array (at least batch width * batch height * batch size)
+ * @return Number of layers, 0 if no batch was rendered or output array is too small
+ *
+ * Layers are stored as by getBatchRedChannel(float *&). No memory is allocated.
  */
-GLuint MainRenderer::getCropY() const
+long MainRenderer::getBatchRedChannel(float *data, long size)
 {
-    return cropY;
+    if (batchSize == 0) {
+        qCritical() << "MainRenderer::getBatchRedChannel error: no batch was rendered";
+        return 0;
+    }
+
+    if (!checkOutputArray("MainRenderer::getBatchRedChannel", data, size, batchWidth, batchHeight * batchSize, 1))
+        return 0;
+
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, toBatch);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RED, GL_FLOAT, data);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return batchSize;
 }
 
 /**
- * @brief Returns cropping width
- * @return Cropping width
+ * @brief Returns number of layers rendered by last batch
+ * @return Number of layers
  */
-GLuint MainRenderer::getCropWidth() const
+GLuint MainRenderer::getBatchSize() const
 {
-    return cropWidth;
+    return batchSize;
 }
 
 /**
- * @brief Returns cropping height
- * @return Cropping height
+ * @brief Returns maximal number of poses in one batch
+ * @return Maximal number of poses (GL_MAX_ARRAY_TEXTURE_LAYERS)
  */
-GLuint MainRenderer::getCropHeight() const
+GLuint MainRenderer::getMaxBatchSize() const
 {
-    return cropHeight;
+    return maxBatchSize;
 }
 
 /**
- * @brief Returns cropping Rectangle
- * @return Cropping Rectangle
+ * @brief Renders density basis images for current shape, pose and crop window
+ * @param[in] statisticalData Statistical coefficients data (already set by setCoefficients)
+ *
+ * Rendered density is linear in coefficients pcs, so the mean image and one image
+ * for every unit pcs vector are enough to compose density image of any pcs
+ * by renderFromDensityBasis() without the tetrahedral pass. Basis images are
+ * invalidated by change of shape, pose, camera, perspective or crop window.
+ *
+ * Density is rendered to a temporary GL_R32F layer, so the basis is not clamped
+ * or quantized by the storage format of density layer (setDensityFormat()).
  */
-QRect MainRenderer::getCropRectangle() const
+void MainRenderer::renderDensityBasis(StatisticalData *statisticalData)
 {
-    return QRect(cropX, cropY, cropWidth, cropHeight);
+    if (!statisticalData) {
+        qCritical() << "MainRenderer::renderDensityBasis error: null StatisticalData";
+        return;
+    }
+
+    if (!mesh) {
+        qCritical() << "MainRenderer::renderDensityBasis error: null Mesh";
+        return;
+    }
+
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    if (mesh->getNumberOfTetrahedra() == 0) {
+        qWarning() << "MainRenderer::renderDensityBasis warning: Tetrahedral mesh is not available";
+        return;
+    }
+
+    GLuint numberOfParameters = statisticalData->getNumberOfParameters();
+    if (numberOfParameters + 1 > getMaxBatchSize()) {
+        qCritical() << "MainRenderer::renderDensityBasis error: too many parameters" << numberOfParameters;
+        return;
+    }
+
+    // Final matrix
+    prepareTransformation();
+    matrix = cropMatrix * perspectiveMatrix * cameraMatrix * translationMatrix * rotationMatrix;
+
+    // Resize for current width and height
+    resizeTexturesAndRenderbuffer();
+
+    // Shape must be recomputed before switching of statistical data
+    recomputeStatisticalDataIfNeeded();
+
+    if (this->statisticalData != statisticalData)
+        setStatisticalData(statisticalData);
+
+    basisSize = numberOfParameters + 1;
+    basisWidth = getCropWidth();
+    basisHeight = getCropHeight();
+    basisMatrix = matrix;
+    basisShapeGeneration = positions->generation;
+    basisXMirroring = xMirroringEnabled;
+
+    // Full precision density layer replaces density layer during basis rendering
+    GLuint densityTexture = toDensity;
+    toDensity = renderTargetPool->acquireTexture(GL_R32F, getRenderWidth(), getRenderHeight());
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, toDensityBasis);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, basisWidth, basisHeight, basisSize, 0, GL_RED, GL_FLOAT, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // Zero pcs for mean, unit pcs vectors for modes
+    GLfloat *pcs = new GLfloat[numberOfParameters]();
+    for (GLuint i = 0; i < basisSize; i++) {
+        if (i > 1)
+            pcs[i - 2] = 0.0f;
+        if (i > 0)
+            pcs[i - 1] = 1.0f;
+
+        recomputeCoefficientsDiff(pcs);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        clearViewport();
+        clearTexture(toDensity);
+
+        renderDensity();
+
+        // Copy crop window to basis layer
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toDensity, 0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, toDensityBasis);
+        glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, getCropX(), getCropY(), basisWidth, basisHeight);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+    delete[] pcs;
+
+    renderTargetPool->releaseTexture(toDensity);
+    toDensity = densityTexture;
+
+    // Restore diff of current pcs
+    recomputeCoefficientsDiff();
 }
 
 /**
- * @brief Enables or disables density rendering
- * @param[in] value Boolean flag
+ * @brief Composes density image from density basis images
+ * @param[in] statisticalData Statistical coefficients data with current pcs
+ *
+ * Output texture contains the same values as rendering of density with disabled
+ * postprocessing, so it can be read by getRenderedRedChannel() or used by metrics.
  */
-void MainRenderer::enableDensity(bool value)
+void MainRenderer::renderFromDensityBasis(StatisticalData *statisticalData)
 {
-    checkInitAndMakeCurrentContext();
+    if (!statisticalData) {
+        qCritical() << "MainRenderer::renderFromDensityBasis error: null StatisticalData";
+        return;
+    }
 
-    densityEnabled = value;
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uDensityEnabled, densityEnabled);
-    postprocessing->program->release();
+    if (!hasDensityBasis() || basisSize != GLuint(statisticalData->getNumberOfParameters()) + 1) {
+        qCritical() << "MainRenderer::renderFromDensityBasis error: density basis is not rendered for current shape, pose, crop window or statistical data";
+        return;
+    }
+
+    requirePrograms(PROGRAMS_DENSITY_BASIS);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, tboBasisWeights);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * statisticalData->getNumberOfParameters(), statisticalData->getPcsMatrix(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, toBasisWeights);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboBasisWeights);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fboOutput);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toOutput, 0);
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glViewport(0, 0, basisWidth, basisHeight);
+
+    densityBasis->program->bind();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, toDensityBasis);
+    densityBasis->program->setUniformValue(densityBasis->uBasisTexture, 0);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, toBasisWeights);
+    densityBasis->program->setUniformValue(densityBasis->uWeights, 1);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    densityBasis->program->release();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 /**
- * @brief Enables or disables postprocessing
- * @param[in] value Boolean flag
+ * @brief Returns density basis images
+ * @param[out] data Float 1D array with all basis images
+ * @return Number of basis images
+ *
+ * Output array is allocated in this function. First image is the mean density image,
+ * image i + 1 is density image of i-th unit pcs vector. Every image has crop width * crop height
+ * values with rows in OpenGL (bottom-up) order. Density of any pcs can be composed on CPU as
+ * mean + sum(pcs[i] * (image[i + 1] - mean)).
  */
-void MainRenderer::enablePostprocessing(bool value)
+long MainRenderer::getDensityBasis(float *&data)
 {
-    checkInitAndMakeCurrentContext();
+    data = 0;
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
 
-    postprocessingEnabled = value;
+    data = new float [basisWidth * basisHeight * basisSize]();
+    if (basisSize == 0)
+        return 0;
 
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uPostprocessingEnabled, postprocessingEnabled);
-    postprocessing->program->release();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, toDensityBasis);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RED, GL_FLOAT, data);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return basisSize;
 }
 
 /**
- * @brief Enables or disables density rendering
- * @param[in] value Boolean flag
+ * @brief Are density basis images rendered for current shape, pose and crop window?
+ * @return True if density basis images are available
+ *
+ * Final matrix and shape generation are compared with the ones used by renderDensityBasis(),
+ * pending shape changes (not recomputed yet) invalidate the basis too.
  */
-void MainRenderer::enableSilhouettes(bool value)
+bool MainRenderer::hasDensityBasis()
 {
-    checkInitAndMakeCurrentContext();
+    if (basisSize == 0 || basisWidth != getCropWidth() || basisHeight != getCropHeight())
+        return false;
 
-    silhouettesEnabled = value;
+    if (recomputeVerticesDiffFlag || recomputePositionsFlag || basisShapeGeneration != positions->generation)
+        return false;
 
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uSilhouettesEnabled, silhouettesEnabled);
-    postprocessing->program->release();
+    prepareTransformation();
+    return basisXMirroring == xMirroringEnabled && basisMatrix == cropMatrix * perspectiveMatrix * cameraMatrix * translationMatrix * rotationMatrix;
 }
 
 /**
- * @brief Enables or disables pyramid rendering
- * @param[in] value Boolean flag
+ * @brief Invalidates density basis images
+ *
+ * Should be called after change of coefficients model (mean or pcs), changes of shape,
+ * pose, camera and crop window are detected by hasDensityBasis().
  */
-void MainRenderer::enablePyramid(bool value)
+void MainRenderer::invalidateDensityBasis()
 {
-    checkInitAndMakeCurrentContext();
-
-    pyramidEnabled = value;
-
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uPyramidEnabled, pyramidEnabled);
-    postprocessing->program->release();
+    basisSize = 0;
 }
 
 /**
- * @brief Enables or disables polygonal rendering
- * @param[in] value Boolean flag
+ * @brief Sets reference image for fused SSD
+ * @param[in] data Float 1D array with reference density
+ * @param[in] width Image width (must be same as crop width)
+ * @param[in] height Image height (must be same as crop height)
+ *
+ * Rows are in OpenGL (bottom-up) order, same as getCurrentDensityData().
  */
-void MainRenderer::enablePolygonal(bool value)
+void MainRenderer::setReferenceImage(const float *data, GLuint width, GLuint height)
 {
-    checkInitAndMakeCurrentContext();
+    if (!data || width == 0 || height == 0) {
+        qCritical() << "MainRenderer::setReferenceImage error: empty reference image";
+        return;
+    }
 
-    polygonalEnabled = value;
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uPolygonalEnabled, polygonalEnabled);
-    postprocessing->program->release();
+    referenceWidth = width;
+    referenceHeight = height;
+    fusedSSDWarningLogged = false;
+
+    glBindTexture(GL_TEXTURE_2D, toReference);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, data);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 /**
- * @brief Enables or disables x-axis mirroring
- * @param[in] value Boolean flag
+ * @brief Sets reference image for fused SSD
+ * @param[in] image Reference image (red channel is used, values are normalized to 0.0 - 1.0)
  */
-void MainRenderer::enableXMirroring(bool value)
+void MainRenderer::setReferenceImage(const QImage &image)
 {
-    checkInitAndMakeCurrentContext();
-
-    xMirroringEnabled = value;
-
-    density->program->bind();
-    density->program->setUniformValue(density->uXMirror, xMirroringEnabled);
-    density->program->release();
+    QImage referenceImage = image.mirrored().convertToFormat(QImage::Format_RGBA8888);
 
-    silhouettes->program->bind();
-    silhouettes->program->setUniformValue(silhouettes->uXMirror, xMirroringEnabled);
-    silhouettes->program->release();
+    QVector<float> data(referenceImage.width() * referenceImage.height());
+    for (int y = 0; y < referenceImage.height(); y++) {
+        const uchar *line = referenceImage.constScanLine(y);
+        for (int x = 0; x < referenceImage.width(); x++)
+            data[y * referenceImage.width() + x] = line[x * 4] / 255.0f;
+    }
 
-    polygonal->program->bind();
-    polygonal->program->setUniformValue(polygonal->uXMirror, xMirroringEnabled);
-    polygonal->program->release();
+    setReferenceImage(data.constData(), referenceImage.width(), referenceImage.height());
 }
 
 /**
- * @brief Enables or disables polygonal lighting
+ * @brief Enables or disables fused SSD
  * @param[in] value Boolean flag
+ *
+ * Every frame the density layer of crop window is compared with reference image.
+ * Only partial sums of tiles are stored on GPU, result is available by getFusedSSD().
+ * Together with enableOutput(false), no image leaves the GPU.
  */
-void MainRenderer::enablePolygonalLighting(bool value)
+void MainRenderer::enableFusedSSD(bool value)
 {
-    checkInitAndMakeCurrentContext();
-
-    polygonalLightingEnabled = value;
+    fusedSSDEnabled = value;
+    toSSDResult = 0;
+    fusedSSDWarningLogged = false;
 
-    polygonal->program->bind();
-    polygonal->program->setUniformValue(polygonal->uLightingEnabled, polygonalLightingEnabled);
-    polygonal->program->release();
+    if (fusedSSDEnabled && !densityEnabled) {
+        qWarning() << "MainRenderer::enableFusedSSD warning: density is disabled";
+        fusedSSDWarningLogged = true;
+    }
 }
 
 /**
- * @brief Is density rendering enabled?
- * @return True if density rendering is enabled
+ * @brief Is fused SSD enabled?
+ * @return True if fused SSD is enabled
  */
-bool MainRenderer::isDensityEnabled() const
+bool MainRenderer::isFusedSSDEnabled() const
 {
-    return densityEnabled;
+    return fusedSSDEnabled;
 }
 
 /**
- * @brief Is density rendering enabled?
- * @return True if density rendering is enabled
+ * @brief Returns fused SSD of last rendered frame
+ * @return SSD value, 0 on error
+ *
+ * Only one float is read from GPU.
  */
-bool MainRenderer::isPostprocessingEnabled() const
+float MainRenderer::getFusedSSD()
 {
-    return postprocessingEnabled;
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
+
+    if (toSSDResult == 0) {
+        qCritical() << "MainRenderer::getFusedSSD error: fused SSD is not rendered";
+        return 0;
+    }
+
+    float ssd = 0;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fboOutput);
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toSSDResult, 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, 1, 1, GL_RED, GL_FLOAT, &ssd);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    return ssd;
 }
 
 /**
- * @brief Is silhouettes rendering enabled?
- * @return True if silhouettes rendering is enabled
+ * @brief Enables or disables rendering of density from density volume
+ * @param[in] value Boolean flag
+ *
+ * Current deformed density is baked to 3D texture on first render and every pose
+ * is rendered by ray marching of the volume instead of the tetrahedral pass. Volume is
+ * baked again after change of shape (setMesh, setCoefficients, setVertices, updateCoefficients
+ * or updateVertices), so it pays off when only pose changes.
  */
-bool MainRenderer::isSilhouettesEnabled() const
+void MainRenderer::enableDensityVolume(bool value)
 {
-    return silhouettesEnabled;
+    densityVolumeEnabled = value;
 }
 
 /**
- * @brief Is pyramid rendering enabled?
- * @return True if density pyramid is enabled
+ * @brief Is rendering of density from density volume enabled?
+ * @return True if density volume is enabled
  */
-bool MainRenderer::isPyramidEnabled() const
+bool MainRenderer::isDensityVolumeEnabled() const
 {
-    return pyramidEnabled;
+    return densityVolumeEnabled;
 }
 
 /**
- * @brief Is polygonal rendering enabled?
- * @return True if density polygonal is enabled
+ * @brief Sets voxel size of density volume
+ * @param[in] value Voxel size in model units (0 = longest side of mesh / DENSITY_VOLUME_DEFAULT_RESOLUTION)
  */
-bool MainRenderer::isPolygonalEnabled() const
+void MainRenderer::setDensityVolumeVoxelSize(float value)
 {
-    return polygonalEnabled;
+    densityVolumeVoxelSize = qMax(value, 0.0f);
+    invalidateDensityVolume();
 }
 
 /**
- * @brief Is x-axis mirroring enabled?
- * @return True if x-axis mirroring is enabled
+ * @brief Returns voxel size of density volume
+ * @return Voxel size in model units (0 = default)
  */
-bool MainRenderer::isXMirroringEnabled() const
+float MainRenderer::getDensityVolumeVoxelSize() const
 {
-    return xMirroringEnabled;
+    return densityVolumeVoxelSize;
 }
 
 /**
- * @brief Is polygonal lighting enabled?
- * @return True if polygonal lighting is enabled
+ * @brief Bakes current deformed density to density volume
+ *
+ * Density of voxel centers is evaluated slice by slice, every tetrahedron is cut by slice plane
+ * in geometry shader. Max absolute density of blocks of DENSITY_VOLUME_BLOCK_SIZE voxels is stored
+ * to occupancy grid for skipping of empty space. Volume is shared by renderers with shared context.
  */
-bool MainRenderer::isLightingEnabled() const
+void MainRenderer::bakeDensityVolume()
 {
-    return polygonalLightingEnabled;
+    if (!mesh) {
+        qCritical() << "MainRenderer::bakeDensityVolume error: null Mesh";
+        return;
+    }
+
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    if (mesh->getNumberOfTetrahedra() == 0) {
+        qWarning() << "MainRenderer::bakeDensityVolume warning: Tetrahedral mesh is not available";
+        return;
+    }
+
+    requirePrograms(PROGRAMS_DENSITY_VOLUME);
+
+    // Final positions are updated by main context
+    if (!hasSharedContext())
+        recomputeStatisticalDataIfNeeded();
+
+    // Bounding box of deformed vertices
+    long numberOfVertices = mesh->getNumberOfVertices();
+
+    vboPositions.bind();
+    if (vboPositions.size() < int(sizeof(GLfloat) * numberOfVertices * 3)) {
+        qCritical() << "MainRenderer::bakeDensityVolume error: positions are not computed";
+        vboPositions.release();
+        return;
+    }
+
+    const GLfloat *positionsData = (const GLfloat *) glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
+
+    if (!positionsData) {
+        qCritical() << "MainRenderer::bakeDensityVolume error: positions buffer cannot be mapped";
+        vboPositions.release();
+        return;
+    }
+
+    QVector3D minVertex(positionsData[0], positionsData[1], positionsData[2]);
+    QVector3D maxVertex = minVertex;
+    for (long i = 1; i < numberOfVertices; i++) {
+        for (int j = 0; j < 3; j++) {
+            minVertex[j] = qMin(minVertex[j], positionsData[i * 3 + j]);
+            maxVertex[j] = qMax(maxVertex[j], positionsData[i * 3 + j]);
+        }
+    }
+
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    vboPositions.release();
+
+    // Voxel centers cover bounding box with one empty voxel on every side
+    QVector3D extent = maxVertex - minVertex;
+    GLfloat voxelSize = densityVolumeVoxelSize;
+    if (voxelSize <= 0.0f)
+        voxelSize = qMax(extent.x(), qMax(extent.y(), extent.z())) / DENSITY_VOLUME_DEFAULT_RESOLUTION;
+
+    if (voxelSize <= 0.0f) {
+        qCritical() << "MainRenderer::bakeDensityVolume error: empty bounding box of mesh";
+        return;
+    }
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+
+    GLuint size[3], blocks[3];
+    for (int i = 0; i < 3; i++) {
+        size[i] = GLuint(qCeil(extent[i] / voxelSize)) + 3;
+        blocks[i] = (size[i] + DENSITY_VOLUME_BLOCK_SIZE - 1) / DENSITY_VOLUME_BLOCK_SIZE;
+        if (size[i] > GLuint(maxSize)) {
+            qCritical() << "MainRenderer::bakeDensityVolume error: volume size" << size[i] << "exceeds GL_MAX_3D_TEXTURE_SIZE" << maxSize;
+            return;
+        }
+    }
+
+    QVector3D origin = minVertex - QVector3D(voxelSize, voxelSize, voxelSize);
+    densityVolume->origin = origin;
+    densityVolume->voxelSize = voxelSize;
+
+    glBindTexture(GL_TEXTURE_3D, densityVolume->toVolume);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R32F, size[0], size[1], size[2], 0, GL_RED, GL_FLOAT, 0);
+    glBindTexture(GL_TEXTURE_3D, densityVolume->toOccupancy);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R32F, blocks[0], blocks[1], blocks[2], 0, GL_RED, GL_FLOAT, 0);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    // Model space to slice viewport, voxel centers are pixel centers
+    QMatrix4x4 sliceMatrix;
+    sliceMatrix.translate(-1.0f, -1.0f, 0.0f);
+    sliceMatrix.scale(2.0f / (voxelSize * size[0]), 2.0f / (voxelSize * size[1]), 0.0f);
+    sliceMatrix.translate(0.5f * voxelSize - origin.x(), 0.5f * voxelSize - origin.y(), 0.0f);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fboComputing);
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glViewport(0, 0, size[0], size[1]);
+
+    // Slices of density
+    densityVolume->programBake->bind();
+    densityVolume->programBake->setUniformValue(densityVolume->uSliceMatrix, sliceMatrix);
+    densityVolume->programBake->setUniformValue(densityVolume->uBakeXMirror, false);
+
+    glBindVertexArray(vao);
+
+    iboElementsTetrahedra.bind();
+
+    vboPositions.bind();
+    glEnableVertexAttribArray(densityVolume->aPosition);
+    glVertexAttribPointer(densityVolume->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, toBerncoeffs);
+    densityVolume->programBake->setUniformValue(densityVolume->uBernCoeffs, 0);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
+    densityVolume->programBake->setUniformValue(densityVolume->uBernCoeffsDiff, 1);
+
+    for (GLuint z = 0; z < size[2]; z++) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, densityVolume->toVolume, 0, z);
+        glClear(GL_COLOR_BUFFER_BIT);
+        densityVolume->programBake->setUniformValue(densityVolume->uSliceZ, origin.z() + z * voxelSize);
+        glDrawElements(GL_LINES_ADJACENCY, mesh->getNumberOfTetrahedra() * 4, GL_UNSIGNED_INT, 0);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glDisableVertexAttribArray(densityVolume->aPosition);
+
+    vboPositions.release();
+    iboElementsTetrahedra.release();
+
+    densityVolume->programBake->release();
+
+    // Occupancy grid, one fragment per block
+    glViewport(0, 0, blocks[0], blocks[1]);
+
+    densityVolume->programOccupancy->bind();
+
+    glBindTexture(GL_TEXTURE_3D, densityVolume->toVolume);
+    densityVolume->programOccupancy->setUniformValue(densityVolume->uOccupancyVolumeTexture, 0);
+
+    for (GLuint z = 0; z < blocks[2]; z++) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, densityVolume->toOccupancy, 0, z);
+        densityVolume->programOccupancy->setUniformValue(densityVolume->uOccupancyLayer, GLint(z));
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    glBindVertexArray(0);
+
+    densityVolume->programOccupancy->release();
+
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    densityVolume->valid = true;
 }
 
 /**
- * @brief Sets flag for sharing transformations between shared contexts
- * @param[in] value Boolean flag
+ * @brief Is density volume baked for current shape?
+ * @return True if density volume is available
  */
-void MainRenderer::setFlagShareTransformations(bool value)
+bool MainRenderer::hasDensityVolume() const
 {
-    flagShareTransformations = value;
+    return densityVolume->valid;
 }
 
 /**
- * @brief Sets translation of model in scene
- * @param[in] x X position
- * @param[in] y Y position
- * @param[in] z Z position
+ * @brief Invalidates density volume
+ *
+ * Called automatically after change of shape or voxel size.
  */
-void MainRenderer::setTranslation(float x, float y, float z)
+void MainRenderer::invalidateDensityVolume()
 {
-    setTranslation(QVector3D(x, y, z));
+    densityVolume->valid = false;
 }
 
 /**
- * @brief Sets translation of model in scene
- * @param[in] position 3D vector with position
+ * @brief Enables or disables culling of density rendering
+ * @param[in] value Boolean flag
+ *
+ * Tetrahedra are split to clusters of DENSITY_CLUSTER_SIZE consecutive tetrahedra. Bounding
+ * boxes of clusters are computed and read back after every change of shape, clusters outside
+ * of frustum of crop window are not drawn by geometry shader nor vertex pulling path. Visible
+ * ranges are recomputed only after change of view or shape. Clusters are compact if the mesh
+ * is spatially reordered (Mesh::reorderSpatially).
  */
-void MainRenderer::setTranslation(QVector3D position)
+void MainRenderer::enableDensityCulling(bool value)
 {
-    translationMatrix.setToIdentity();
-    translationMatrix.translate(position.x(), position.y(), position.z());
-
-    if (flagShareTransformations) {
-        if (!hasSharedContext()) {
-            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
-            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
-                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
-                if (dynamic_cast<MainRenderer *>(renderSurface)) {
-                    ((MainRenderer *) renderSurface)->translationMatrix = translationMatrix;
-                }
-            }
-        } else {
-            ((MainRenderer *) getParentOpenGLWrapper())->setTranslation(position);
-        }
-    }
+    densityCullingEnabled = value;
 }
 
 /**
- * @brief Returns translation
- * @param[out] x X position
- * @param[out] y Y position
- * @param[out] z Z position
+ * @brief Is culling of density rendering enabled?
+ * @return True if density culling is enabled
  */
-void MainRenderer::getTranslation(float &x, float &y, float &z)
+bool MainRenderer::isDensityCullingEnabled() const
 {
-    QVector3D translation = getTranslation();
-    x = translation.x();
-    y = translation.y();
-    z = translation.z();
+    return densityCullingEnabled;
 }
 
 /**
- * @brief Returns translation
- * @return 3D vector with position
+ * @brief Returns number of tetrahedra drawn by last density rendering
+ * @return Number of drawn tetrahedra
  */
-QVector3D MainRenderer::getTranslation()
+long MainRenderer::getNumberOfDrawnTetrahedra() const
 {
-    return QVector3D(translationMatrix.column(3).x(), translationMatrix.column(3).y(), translationMatrix.column(3).z());
+    return drawnTetrahedra;
 }
 
 /**
- * @brief Translates model in scene
- * @param[in] x X position
- * @param[in] y Y position
- * @param[in] z Z position
+ * @brief Returns average cache miss ratio of triangles (transformed vertices per triangle)
+ * @param[in] adjacency Triangles adjacency instead of triangles?
+ * @param[in] optimized Order uploaded to index buffer instead of order of mesh?
+ * @return ACMR with simulated FIFO vertex cache, 0 without triangles
+ *
+ * Computed only on request, uploaded order is read back from index buffer.
  */
-void MainRenderer::translate(float x, float y, float z)
+double MainRenderer::getTrianglesACMR(bool adjacency, bool optimized)
 {
-    translate(QVector3D(x, y, z));
+    if (!mesh) {
+        qCritical() << "MainRenderer::getTrianglesACMR error: null Mesh";
+        return 0;
+    }
+
+    long numberOfPrimitives = adjacency ? mesh->getNumberOfTrianglesAdjacency() : mesh->getNumberOfTriangles();
+    int primitiveSize = adjacency ? 6 : 3;
+    if (numberOfPrimitives == 0)
+        return 0;
+
+    if (!optimized)
+        return vertexCacheOptimizer.getACMR(adjacency ? mesh->getTableOfTrianglesAdjacency() : mesh->getTableOfTriangles(), numberOfPrimitives, primitiveSize, mesh->getNumberOfVertices());
+
+    if (!checkInitAndMakeCurrentContext())
+        return 0;
+
+    std::vector<GLuint> elements(numberOfPrimitives * primitiveSize);
+    QOpenGLBuffer &buffer = adjacency ? iboElementsTrianglesAdjacency : iboElementsTriangles;
+    buffer.bind();
+    buffer.read(0, elements.data(), int(sizeof(GLuint) * elements.size()));
+    buffer.release();
+
+    return vertexCacheOptimizer.getACMR(elements.data(), numberOfPrimitives, primitiveSize, mesh->getNumberOfVertices());
 }
 
 /**
- * @brief Translates model in scene
- * @param[in] position 3D vector with position
+ * @brief Sets intensity for density rendering
+ * @param[in] value Intesity value from 0.0 to 1.0
  */
-void MainRenderer::translate(QVector3D position)
+void MainRenderer::setIntensity(double value)
 {
-    translationMatrix.translate(position.x(), position.y(), position.z());
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-    if (flagShareTransformations) {
-        if (!hasSharedContext()) {
-            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
-            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
-                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
-                if (dynamic_cast<MainRenderer *>(renderSurface)) {
-                    ((MainRenderer *) renderSurface)->translationMatrix = translationMatrix;
-                }
-            }
-        } else {
-            ((MainRenderer *) getParentOpenGLWrapper())->translate(position);
-        }
+    intensity = value;
+    if (intensity < 0.0f) intensity = 0.0f;
+    if (intensity > 1.0f) intensity = 1.0f;
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uIntensity, (float) (value / 5000.0f));
+        postprocessing->program->release();
     }
 }
 
 /**
- * @brief Sets rotation of model in scene
- * @param[in] xAngle X angle
- * @param[in] yAngle Y angle
- * @param[in] zAngle Z angle
+ * @brief Sets line width for silhouettes rendering
+ * @param[in] value Line width from 1 to 10
  */
-void MainRenderer::setRotation(float xAngle, float yAngle, float zAngle)
+void MainRenderer::setLineWidth(double value)
 {
-    setRotation(QVector3D(xAngle, yAngle, zAngle));
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    lineWidth = value;
+    if (lineWidth < 1) lineWidth = 1;
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uLineWidth, (int) lineWidth);
+        postprocessing->program->release();
+    }
 }
 
 /**
- * @brief Sets rotation of model in scene
- * @param[in] rotation 3D vector with rotation
+ * @brief Sets special param for density rendering - unused
+ * @param[in] value Some value
  */
-void MainRenderer::setRotation(QVector3D rotation)
+void MainRenderer::setParam(double value)
 {
-    rotationMatrix.setToIdentity();
-    angles = rotation;
-    if (angles.x() < 0)
-        angles.setX(360 + angles.x());
-    if (angles.y() < 0)
-        angles.setY(360 + angles.y());
-    if (angles.z() < 0)
-        angles.setZ(360 + angles.z());
-    angles.setX(fmod(angles.x(), 360));
-    angles.setY(fmod(angles.y(), 360));
-    angles.setZ(fmod(angles.z(), 360));
-
-    /*float sX = qSin(qDegreesToRadians(angles.x()));
-    float sY = qSin(qDegreesToRadians(angles.y()));
-    float sZ = qSin(qDegreesToRadians(angles.z()));
-    float cX = qCos(qDegreesToRadians(angles.x()));
-    float cY = qCos(qDegreesToRadians(angles.y()));
-    float cZ = qCos(qDegreesToRadians(angles.z()));
-
-    rotationMatrix(0, 0) = cY * cZ;
-    rotationMatrix(0, 1) = -cY * sZ;
-    rotationMatrix(0, 2) = sY;
-
-    rotationMatrix(1, 0) = cZ * sX * sY + cX * sZ;
-    rotationMatrix(1, 1) = cX * cZ-sX * sY * sZ;
-    rotationMatrix(1, 2) = -cY * sX;
-
-    rotationMatrix(2, 0) = -cX * cZ * sY + sX * sZ;
-    rotationMatrix(2, 1) = cZ * sX + cX * sY * sZ;
-    rotationMatrix(2, 2) = cX * cY;*/
-
-    rotationMatrix.rotate(angles.z(), 0, 0, 1);
-    rotationMatrix.rotate(angles.y(), 0, 1, 0);
-    rotationMatrix.rotate(angles.x(), 1, 0, 0);
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-    if (flagShareTransformations) {
-        if (!hasSharedContext()) {
-            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
-            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
-                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
-                if (dynamic_cast<MainRenderer *>(renderSurface)) {
-                    ((MainRenderer *) renderSurface)->rotationMatrix = rotationMatrix;
-                    ((MainRenderer *) renderSurface)->angles = angles;
-                }
-            }
-        } else {
-            ((MainRenderer *) getParentOpenGLWrapper())->setRotation(angles);
-        }
+    // @todo TODO - delete in future
+    param = value;
+    if (hasPrograms(PROGRAMS_DENSITY)) {
+        density->program->bind();
+        density->program->setUniformValue(density->uParam, (float) param);
+        density->program->release();
     }
 }
 
 /**
- * @brief Sets rotation matrix
- * @param[in] rotationMatrix Rotation matrix
+ * @brief Returns intenstity for density rendering
+ * @return Intenstity value
  */
-void MainRenderer::setRotationMatrix(QMatrix4x4 rotationMatrix)
+double MainRenderer::getIntensity() const
 {
-    this->rotationMatrix = rotationMatrix;
-    //QVector3D angles = getAngles(rotationMatrix);
-    //setRotation(angles);
-
-    if (flagShareTransformations) {
-        if (!hasSharedContext()) {
-            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
-            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
-                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
-                if (dynamic_cast<MainRenderer *>(renderSurface)) {
-                    ((MainRenderer *) renderSurface)->rotationMatrix = rotationMatrix;
-                }
-            }
-        } else {
-            ((MainRenderer *) getParentOpenGLWrapper())->setRotationMatrix(rotationMatrix);
-        }
-    }
-}
+    return intensity;
+}
 
 /**
- * @brief Returns rotation
- * @param[out] xAngle X angle
- * @param[out] yAngle Y angle
- * @param[out] zAngle Z angle
+ * @brief Returns line width for silhouettes rendering
+ * @return Line width
  */
-void MainRenderer::getRotation(float &xAngle, float &yAngle, float &zAngle)
+double MainRenderer::getLineWidth() const
 {
-    xAngle = angles.x();
-    yAngle = angles.y();
-    zAngle = angles.z();
+    return lineWidth;
 }
 
 /**
- * @brief Returns rotation
- * @return 3D vector with rotation
+ * @brief Return special param value
+ * @return Value of special param for density rendering
  */
-QVector3D MainRenderer::getRotation()
+double MainRenderer::getParam() const
 {
-    return angles;
+    return param;
 }
 
 /**
- * @brief Returns rotation matrix
- * @return Rotation matrix
+ * @brief Sets render width
+ * @param[in] renderWidth Render width
+ *
+ * Sets cropping to same size.
  */
-QMatrix4x4 MainRenderer::getRotationMatrix()
+void MainRenderer::setRenderWidth(GLuint renderWidth)
 {
-    return rotationMatrix;
-}
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-/**
- * @brief Rotates model in scene
- * @param[in] xAngle X angle
- * @param[in] yAngle Y angle
- * @param[in] zAngle Z angle
- */
-void MainRenderer::rotate(float xAngle, float yAngle, float zAngle)
-{
-    rotate(QVector3D(xAngle, yAngle, zAngle));
+    if (renderWidth < 1 || renderWidth > maxTextureOrRenderSize[0]) {
+        qCritical("Wrong render width");
+        Q_ASSERT_X(false, "OpenGL error", "Wrong render width");
+        exit(1);
+    }
+    this->renderWidth = renderWidth;
+    this->cropX = 0;
+    this->cropWidth = renderWidth;
+    ratio = (float) getRenderWidth() / (float) getRenderHeight();
+    step.setX(1.0f / (float) getRenderWidth());
+    step.setY(1.0f / (float) getRenderHeight());
+    sizeChanged = true;
+    cropSizeChanged = true;
 }
 
 /**
- * @brief Rotates model in scene
- * @param[in] rotation 3D vector with rotation
+ * @brief Sets render height
+ * @param[in] renderHeight Render height
+ *
+ * Sets cropping to same size.
  */
-void MainRenderer::rotate(QVector3D rotation)
+void MainRenderer::setRenderHeight(GLuint renderHeight)
 {
-    setRotation(angles + rotation);
-}
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-/**
- * @brief Sets camera by corners ane eye positions
- * @param[in] leftTop Left top corner of pyramid base
- * @param[in] leftBottom Left bottom corner of pyramid base
- * @param[in] rightTop Right top corner of pyramid base
- * @param[in] rightBottom Right bottom corner of pyramid base
- * @param[in] eye Position of eye - the top of the pyramid
- */
-void MainRenderer::setCamera(QVector3D leftTop, QVector3D leftBottom, QVector3D rightTop, QVector3D rightBottom, QVector3D eye)
-{
-    setCamera(SSIMRenderer::Pyramid(leftTop, leftBottom, rightTop, rightBottom, eye));
+    if (renderHeight < 1 || renderHeight > maxTextureOrRenderSize[1]) {
+        qCritical("Wrong render height");
+        Q_ASSERT_X(false, "OpenGL error", "Wrong render height");
+        exit(1);
+    }
+    this->renderHeight = renderHeight;
+    this->cropY = 0;
+    this->cropHeight = renderHeight;
+    ratio = (float) getRenderWidth() / (float) getRenderHeight();
+    step.setX(1.0f / (float) getRenderWidth());
+    step.setY(1.0f / (float) getRenderHeight());
+    sizeChanged = true;
+    cropSizeChanged = true;
 }
 
 /**
- * @brief Sets camera by pyramid object
- * @param[in] camera Pyramid to set
+ * @brief Sets render size
+ * @param[in] renderWidth Render width
+ * @param[in] renderHeight Render height
+ *
+ * Sets cropping to same size.
  */
-void MainRenderer::setCamera(SSIMRenderer::Pyramid camera)
+void MainRenderer::setRenderSize(GLuint renderWidth, GLuint renderHeight)
 {
-    setCamera(camera.getEye(), camera.getCenter());
+    setRenderWidth(renderWidth);
+    setRenderHeight(renderHeight);
 }
 
 /**
- * @brief Sets camera by eye and center position
- * @param[in] eye Eye position
- * @param[in] center Center position
+ * @brief Returns render width
+ * @return Render width
  */
-void MainRenderer::setCamera(QVector3D eye, QVector3D center)
+GLuint MainRenderer::getRenderWidth() const
 {
-    this->center = center;
-    this->eye = eye;
-    if (this->eye == this->center)
-        setCamera(this->eye + (perspective.getViewDir() * perspective.getDistance()), this->center);
-    cameraMatrix.setToIdentity();
-    cameraMatrix.lookAt(getEye(), getCenter(), perspective.getUpDir());
+    return renderWidth;
 }
 
 /**
- * @brief Move camera with given distance and center position
- * @param[in] distance Distance form center
- * @param[in] center Center position
+ * @brief Returns render height
+ * @return Render height
  */
-void MainRenderer::moveCamera(float distance, QVector3D center)
+GLuint MainRenderer::getRenderHeight() const
 {
-    QVector3D eyeTranslated;
-    QVector3D centerTranslated;
-    QVector3D centerDir = (getEye() - center).normalized();
-    eyeTranslated = getEye() + centerDir * distance;
-    centerTranslated = getCenter() + centerDir * distance;
-    setCamera(eyeTranslated, centerTranslated);
+    return renderHeight;
 }
 
 /**
- * @brief Rotates camera arround center with x and y angles
- * @param[in] xAngle X angle
- * @param[in] yAngle Y angle
- * @param[in] center Center position
+ * @brief Sets cropping window
+ * @param[in] cropX X position - top left
+ * @param[in] cropY Y position - top left
+ * @param[in] cropWidth Cropping width
+ * @param[in] cropHeight Cropping height
  */
-void MainRenderer::rotateCamera(float xAngle, float yAngle, QVector3D center)
+void MainRenderer::setCropWindow(GLuint cropX, GLuint cropY, GLuint cropWidth, GLuint cropHeight)
 {
-    QVector3D eyeRotated;
-    QVector3D centerRotated;
-    QMatrix4x4 rotation;
-    rotation.rotate(xAngle, QVector3D::crossProduct(perspective.getUpDir(), getViewDir()));
-    rotation.rotate(yAngle, perspective.getUpDir());
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-    if (qAbs(QVector3D::dotProduct(rotation * getViewDir(), perspective.getUpDir())) > 0.99f) {
-        rotation.setToIdentity();
-        rotation.rotate(yAngle, perspective.getUpDir());
+    GLuint newCropY = renderHeight - (cropHeight + cropY);
+
+    if (cropX < 0 || cropX >= renderWidth - 1) {
+        qCritical("Wrong crop x position");
+        return;
     }
 
-    QVector3D eyeVector = (getEye() - center);
-    QVector3D centerVector = (getCenter() - center);
-    eyeRotated = rotation * eyeVector;
-    centerRotated = rotation * centerVector;
-    eyeRotated += center;
-    centerRotated += center;
-    setCamera(eyeRotated, centerRotated);
+    if (cropWidth < 1 || cropWidth > maxTextureOrRenderSize[0] || cropX + cropWidth > renderWidth) {
+        qCritical("Wrong crop width");
+        return;
+    }
+
+    if (newCropY < 0 || newCropY >= renderHeight - 1) {
+        qCritical("Wrong crop y position");
+        return;
+    }
+
+    if (cropHeight < 1 || cropHeight > maxTextureOrRenderSize[1] || newCropY + cropHeight > renderHeight) {
+        qCritical("Wrong crop height");
+        return;
+    }
+
+    // Only output texture depends on crop size, crop position is just a viewport
+    if (this->cropWidth != cropWidth || this->cropHeight != cropHeight)
+        cropSizeChanged = true;
+
+    this->cropX = cropX;
+    this->cropWidth = cropWidth;
+    this->cropY = newCropY;
+    this->cropHeight = cropHeight;
 }
 
 /**
- * @brief Returns eye position
- * @return Eye position
+ * @brief Sets cropping window
+ * @param[in] rectangle Cropping rectangle
  */
-QVector3D MainRenderer::getEye()
+void MainRenderer::setCropWindow(const QRect &rectangle)
 {
-    if (eye == center)
-        setCamera(eye + (perspective.getViewDir() * perspective.getDistance()), center);
-    return eye;
+    setCropWindow(rectangle.x(), rectangle.y(), rectangle.width(), rectangle.height());
 }
 
 /**
- * @brief Returns center position
- * @return Center position
+ * @brief Returns cropping x position
+ * @return Cropping x position
  */
-QVector3D MainRenderer::getCenter()
+GLuint MainRenderer::getCropX() const
 {
-    if (eye == center)
-        setCamera(eye + (perspective.getViewDir() * perspective.getDistance()), center);
-    return center;
+    return cropX;
 }
 
 /**
- * @brief Returns middle position
- * @return Middle position
+ * @brief Returns cropping y position
+ * @return Cropping y position
  */
-QVector3D MainRenderer::getMiddle()
+GLuint MainRenderer::getCropY() const
 {
-    return perspective.getMiddle();
+    return cropY;
 }
 
 /**
- * @brief Returns view dir
- * @return View dir
+ * @brief Returns cropping width
+ * @return Cropping width
  */
-QVector3D MainRenderer::getViewDir()
+GLuint MainRenderer::getCropWidth() const
 {
-    return (getEye() - getCenter()).normalized();
+    return cropWidth;
 }
 
 /**
- * @brief Sets eye position
- * @param[in] Eye position
+ * @brief Returns cropping height
+ * @return Cropping height
  */
-void MainRenderer::setEye(const QVector3D &value)
+GLuint MainRenderer::getCropHeight() const
 {
-    setCamera(value, getCenter());
+    return cropHeight;
 }
 
 /**
- * @brief Sets center position
- * @param[in] value Center position
+ * @brief Returns cropping Rectangle
+ * @return Cropping Rectangle
  */
-void MainRenderer::setCenter(const QVector3D &value)
+QRect MainRenderer::getCropRectangle() const
 {
-    setCamera(getEye(), value);
+    return QRect(cropX, cropY, cropWidth, cropHeight);
 }
 
 /**
- * @brief Sets perspective by corners ane eye positions
- * @param[in] leftTop Left top corner of pyramid base
- * @param[in] leftBottom Left bottom corner of pyramid base
- * @param[in] rightTop Right top corner of pyramid base
- * @param[in] rightBottom Right bottom corner of pyramid base
- * @param[in] eye Position of eye - the top of the pyramid
+ * @brief Enables or disables density rendering
+ * @param[in] value Boolean flag
  */
-void MainRenderer::setPerspective(QVector3D leftTop, QVector3D leftBottom, QVector3D rightTop, QVector3D rightBottom, QVector3D eye)
+void MainRenderer::enableDensity(bool value)
 {
-    perspective = SSIMRenderer::Pyramid(leftTop, leftBottom, rightTop, rightBottom, eye);
-    prepareTransformation();
-    setCamera(perspective);
-}
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-/**
- * @brief Sets perspective camera by pyramid object
- * @param[in] camera Pyramid to set
- */
-void MainRenderer::setPerspective(SSIMRenderer::Pyramid perspective)
-{
-    this->perspective = perspective;
-    points.append(perspective.getCenter());
-    prepareTransformation();
-    setCamera(perspective);
+    // Layer texture is allocated only for enabled layer
+    if (densityEnabled != value)
+        sizeChanged = true;
+
+    densityEnabled = value;
+
+    // Programs are built on first use
+    if (value)
+        requirePrograms(densityVertexPullingEnabled ? PROGRAMS_DENSITY_PULLING : PROGRAMS_DENSITY);
+
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uDensityEnabled, densityEnabled);
+        postprocessing->program->release();
+    }
 }
 
 /**
- * @brief Returns perspective
- * @return Setted perspective
+ * @brief Enables or disables postprocessing
+ * @param[in] value Boolean flag
  */
-SSIMRenderer::Pyramid MainRenderer::getPerspective()
+void MainRenderer::enablePostprocessing(bool value)
 {
-    return perspective;
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    postprocessingEnabled = value;
+
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uPostprocessingEnabled, postprocessingEnabled);
+        postprocessing->program->release();
+    }
 }
 
 /**
- * @brief Adds control point for distances measuring
- * @param[in] value Point position
+ * @brief Enables or disables compositing of layers to output texture
+ * @param[in] value Boolean flag
+ *
+ * If only raw layers are read (getCurrentDensityData() etc.), the compositing pass
+ * can be skipped. Rendered image, red channel and metrics need enabled output.
  */
-void MainRenderer::addPoint(const QVector3D &value)
+void MainRenderer::enableOutput(bool value)
 {
-    points.append(value);
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    outputEnabled = value;
+
+    // Programs are built on first use
+    if (value)
+        requirePrograms(PROGRAMS_POSTPROCESSING);
 }
 
 /**
- * @brief Adds control points for distances measuring
- * @param[in] points 2D vector of control points
+ * @brief Enables or disables density rendering
+ * @param[in] value Boolean flag
  */
-void MainRenderer::setPoints(QVector<QVector3D> points)
+void MainRenderer::enableSilhouettes(bool value)
 {
-    this->points = points;
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    // Layer texture is allocated only for enabled layer
+    if (silhouettesEnabled != value)
+        sizeChanged = true;
+
+    silhouettesEnabled = value;
+
+    // Programs are built on first use
+    if (value)
+        requirePrograms(PROGRAMS_SILHOUETTES);
+
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uSilhouettesEnabled, silhouettesEnabled);
+        postprocessing->program->release();
+    }
 }
 
 /**
- * @brief Returns controls points
- * @return 2D vector with control points
+ * @brief Enables or disables pyramid rendering
+ * @param[in] value Boolean flag
  */
-QVector<QVector3D> MainRenderer::getPoints()
+void MainRenderer::enablePyramid(bool value)
 {
-    return points;
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    // Layer texture is allocated only for enabled layer
+    if (pyramidEnabled != value)
+        sizeChanged = true;
+
+    pyramidEnabled = value;
+
+    // Programs are built on first use
+    if (value)
+        requirePrograms(PROGRAMS_PYRAMID);
+
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uPyramidEnabled, pyramidEnabled);
+        postprocessing->program->release();
+    }
 }
 
-/*
 /**
- * @brief MainRenderer::getMinimalDistancesToPoints
- * @return
- *
- * @todo TODO nepouzito, predelat, upravit, zprehlednit
+ * @brief Enables or disables polygonal rendering
+ * @param[in] value Boolean flag
  */
-/*QVector<float> MainRenderer::getMinimalDistancesToPoints(void (*f)(float *d, unsigned char *u, int  w, int h))
+void MainRenderer::enablePolygonal(bool value)
 {
-    // @todo TODO comments!
-    QVector<float> distances(points.size(), -1);
-
-    if (distances.size() > 0) {
-        //QMatrix4x4 r = getRotationMatrix().inverted();
-        //float tx, ty, tz;
-        //getTranslation(tx, ty, tz);
-        //QVector3D t(tx, ty, tz);
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-        float *silhouettesImage;
-        getCurrentSilhouettesImage(silhouettesImage);
-        unsigned char *mask = NULL;
-        if (f != NULL) {
-            mask = new unsigned char[getRenderWidth() * getRenderHeight()]();
-            f(silhouettesImage, mask, getRenderWidth(), getRenderHeight());
-        }
+    // Layer texture is allocated only for enabled layer
+    if (polygonalEnabled != value)
+        sizeChanged = true;
 
-        QVector<QVector3D> lines;
+    polygonalEnabled = value;
 
-        for (int i = 0; i < points.size(); i++) {
-            lines.append((points.at(i) - perspective.getEye()).normalized());
-        }
+    // Programs are built on first use
+    if (value)
+        requirePrograms(PROGRAMS_POLYGONAL);
 
-        for (unsigned int i = 0; i < getRenderWidth() * getRenderHeight(); i++) {
-            if (silhouettesImage[4 * i + 3] != 0 && (mask == NULL || mask[i] != 0)) {
-                for (int p = 0; p < points.size(); p++) {
-                    QVector3D silhouettePoint = QVector3D(silhouettesImage[4 * i + 0], silhouettesImage[4 * i + 1], silhouettesImage[4 * i + 2]);
-                    silhouettePoint = translationMatrix * rotationMatrix * silhouettePoint;
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uPolygonalEnabled, polygonalEnabled);
+        postprocessing->program->release();
+    }
+}
 
-                    float distance = silhouettePoint.distanceToLine(points.at(p), lines.at(p));
-                    if (distances[p] != -1) {
-                        if (distances[p] > distance) {
-                            distances[p] = distance;
-                        }
-                    } else {
-                        distances[p] = distance;
-                    }
-                }
-            }
+/**
+ * @brief Enables or disables x-axis mirroring
+ * @param[in] value Boolean flag
+ */
+void MainRenderer::enableXMirroring(bool value)
+{
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-        }
-        //qDebug() << points;
-        //qDebug() << distances;
+    xMirroringEnabled = value;
 
-        delete[] silhouettesImage;
-        if (f != NULL)
-            delete[] mask;
+    if (hasPrograms(PROGRAMS_DENSITY)) {
+        density->program->bind();
+        density->program->setUniformValue(density->uXMirror, xMirroringEnabled);
+        density->program->release();
     }
 
-    return distances;
-}
-/*
-QVector<float> MainRenderer::getMinimalDistancesToPoints()
-{
-    QVector<float> distances(points.size(), -1);
+    if (hasPrograms(PROGRAMS_DENSITY_BATCH)) {
+        densityBatch->program->bind();
+        densityBatch->program->setUniformValue(densityBatch->uXMirror, xMirroringEnabled);
+        densityBatch->program->release();
+    }
 
-    if (distances.size() > 0) {
+    if (hasPrograms(PROGRAMS_SILHOUETTES)) {
+        silhouettes->program->bind();
+        silhouettes->program->setUniformValue(silhouettes->uXMirror, xMirroringEnabled);
+        silhouettes->program->release();
+    }
 
-        //QMatrix4x4 r = getRotationMatrix().inverted();
-        //float tx, ty, tz;
-        //getTranslation(tx, ty, tz);
-        //QVector3D t(tx, ty, tz);
+    if (hasPrograms(PROGRAMS_POLYGONAL)) {
+        polygonal->program->bind();
+        polygonal->program->setUniformValue(polygonal->uXMirror, xMirroringEnabled);
+        polygonal->program->release();
+    }
+}
 
-        float *silhouettesImage;
-        getCurrentSilhouettesImage(silhouettesImage);
+/**
+ * @brief Enables or disables polygonal lighting
+ * @param[in] value Boolean flag
+ */
+void MainRenderer::enablePolygonalLighting(bool value)
+{
+    if (!checkInitAndMakeCurrentContext())
+        return;
 
-        QVector<QVector3D> lines;
+    polygonalLightingEnabled = value;
 
-        for (int i = 0; i < points.size(); i++) {
-            lines.append((points.at(i) - perspective.getEye()).normalized());
-        }
+    if (hasPrograms(PROGRAMS_POLYGONAL)) {
+        polygonal->program->bind();
+        polygonal->program->setUniformValue(polygonal->uLightingEnabled, polygonalLightingEnabled);
+        polygonal->program->release();
+    }
+}
 
-        for (unsigned int i = 0; i < getRenderWidth() * getRenderHeight(); i++) {
-            if (silhouettesImage[4 * i + 3] != 0) {
-                for (int p = 0; p < points.size(); p++) {
-                    QVector3D silhouettePoint = QVector3D(silhouettesImage[4 * i + 0], silhouettesImage[4 * i + 1], silhouettesImage[4 * i + 2]);
-                    silhouettePoint = translationMatrix * rotationMatrix * silhouettePoint;
+/**
+ * @brief Selects vertex pulling or geometry shader path of density rendering
+ * @param[in] value Boolean flag
+ *
+ * Vertex pulling draws 12 vertices per tetrahedron instanced, inverse matrices of tetrahedra
+ * are precomputed after every change of shape. Geometry shader path is the default fallback.
+ */
+void MainRenderer::enableDensityVertexPulling(bool value)
+{
+    densityVertexPullingEnabled = value;
+}
 
-                    float distance = silhouettePoint.distanceToLine(points.at(p), lines.at(p));
-                    if (distances[p] != -1) {
-                        if (distances[p] > distance) {
-                            distances[p] = distance;
-                        }
-                    } else {
-                        distances[p] = distance;
-                    }
-                }
-            }
+/**
+ * @brief Forces compact loop fragment shaders of density for all degrees
+ * @param[in] value Boolean flag
+ *
+ * Loop shaders read exponents and multinomials of terms from uniform buffer, so their
+ * source code does not grow with degree. They are always used from DENSITY_LOOP_MIN_DEGREE,
+ * lower degrees use unrolled code by default. Programs are shared, setting of main context
+ * is applied.
+ */
+void MainRenderer::enableDensityLoopGenerator(bool value)
+{
+    if (densityLoopGeneratorEnabled == value)
+        return;
 
-        }
-        //qDebug() << points;
-        //qDebug() << distances;
+    densityLoopGeneratorEnabled = value;
 
-        delete[] silhouettesImage;
+    if (!hasSharedContext() && lastBernCoeffsCount > 0) {
+        if (!checkInitAndMakeCurrentContext())
+            return;
+        updateDensityPrograms(lastBernCoeffsCount);
     }
+}
 
-    return distances;
-}      */
+/**
+ * @brief Is density rendering enabled?
+ * @return True if density rendering is enabled
+ */
+bool MainRenderer::isDensityEnabled() const
+{
+    return densityEnabled;
+}
 
 /**
- * @brief Clear control points
+ * @brief Is density rendering enabled?
+ * @return True if density rendering is enabled
  */
-void MainRenderer::clearPoints()
+bool MainRenderer::isPostprocessingEnabled() const
 {
-    points.clear();
+    return postprocessingEnabled;
 }
 
 /**
- * @brief Returns pointer to statistical data object
- * @return The pointer to statistical data object
+ * @brief Is compositing to output texture enabled?
+ * @return True if output texture is rendered
  */
-StatisticalData *MainRenderer::getStatisticalData() const
+bool MainRenderer::isOutputEnabled() const
 {
-    if (!statisticalData) {
-        qCritical() << "MainRenderer::getStatisticalData error: null StatisticalData";
-        return 0;
-    }
+    return outputEnabled;
+}
 
-    return statisticalData;
+/**
+ * @brief Is silhouettes rendering enabled?
+ * @return True if silhouettes rendering is enabled
+ */
+bool MainRenderer::isSilhouettesEnabled() const
+{
+    return silhouettesEnabled;
 }
 
 /**
- * @brief Returns pointer to mesh object
- * @return The pointer to mesh object
+ * @brief Is pyramid rendering enabled?
+ * @return True if density pyramid is enabled
  */
-Mesh *MainRenderer::getMesh() const
+bool MainRenderer::isPyramidEnabled() const
 {
-    if (!mesh) {
-        qCritical() << "MainRenderer::getMesh error: null Mesh";
-        return 0;
-    }
+    return pyramidEnabled;
+}
 
-    return mesh;
+/**
+ * @brief Is polygonal rendering enabled?
+ * @return True if density polygonal is enabled
+ */
+bool MainRenderer::isPolygonalEnabled() const
+{
+    return polygonalEnabled;
 }
 
 /**
- * @brief Main initialze function
- *
- * Initializes OpenGL (shared) resources and others.
+ * @brief Is x-axis mirroring enabled?
+ * @return True if x-axis mirroring is enabled
  */
-void MainRenderer::initialize()
+bool MainRenderer::isXMirroringEnabled() const
 {
-    // Important for resources in library
-    Q_INIT_RESOURCE(shaders);
+    return xMirroringEnabled;
+}
 
-    // Get max texture and viewport dims
-    GLint dimsV[2], dimT;
+/**
+ * @brief Is polygonal lighting enabled?
+ * @return True if polygonal lighting is enabled
+ */
+bool MainRenderer::isLightingEnabled() const
+{
+    return polygonalLightingEnabled;
+}
+
+/**
+ * @brief Is vertex pulling path of density rendering enabled?
+ * @return True if density is rendered without geometry shader
+ */
+bool MainRenderer::isDensityVertexPullingEnabled() const
+{
+    return densityVertexPullingEnabled;
+}
+
+/**
+ * @brief Are loop fragment shaders of density forced for all degrees?
+ * @return True if loop generator is forced
+ */
+bool MainRenderer::isDensityLoopGeneratorEnabled() const
+{
+    return densityLoopGeneratorEnabled;
+}
+
+/**
+ * @brief Sets storage format of density layer
+ * @param[in] internalFormat GL_R8, GL_R16F, GL_R32F, GL_RG8, GL_RG16F, GL_RG32F, GL_RGBA8, GL_RGBA16F or GL_RGBA32F
+ *
+ * Density is stored in red channel, formats without alpha channel save memory and bandwidth.
+ */
+void MainRenderer::setDensityFormat(GLenum internalFormat)
+{
+    if (!checkLayerFormat("MainRenderer::setDensityFormat", internalFormat, false))
+        return;
+
+    if (densityFormat != internalFormat)
+        sizeChanged = true;
+    densityFormat = internalFormat;
+}
+
+/**
+ * @brief Sets storage format of silhouettes layer
+ * @param[in] internalFormat GL_R8, GL_R16F, GL_R32F, GL_RG8, GL_RG16F, GL_RG32F, GL_RGBA8, GL_RGBA16F or GL_RGBA32F
+ *
+ * Formats without alpha channel store only coverage of silhouettes (no positions).
+ */
+void MainRenderer::setSilhouettesFormat(GLenum internalFormat)
+{
+    if (!checkLayerFormat("MainRenderer::setSilhouettesFormat", internalFormat, false))
+        return;
+
+    if (silhouettesFormat != internalFormat)
+        sizeChanged = true;
+    silhouettesFormat = internalFormat;
+}
+
+/**
+ * @brief Sets storage format of polygonal layer
+ * @param[in] internalFormat GL_RGBA8, GL_RGBA16F or GL_RGBA32F
+ */
+void MainRenderer::setPolygonalFormat(GLenum internalFormat)
+{
+    if (!checkLayerFormat("MainRenderer::setPolygonalFormat", internalFormat, true))
+        return;
+
+    if (polygonalFormat != internalFormat)
+        sizeChanged = true;
+    polygonalFormat = internalFormat;
+}
+
+/**
+ * @brief Sets storage format of pyramid layer
+ * @param[in] internalFormat GL_RGBA8, GL_RGBA16F or GL_RGBA32F
+ */
+void MainRenderer::setPyramidFormat(GLenum internalFormat)
+{
+    if (!checkLayerFormat("MainRenderer::setPyramidFormat", internalFormat, true))
+        return;
+
+    if (pyramidFormat != internalFormat)
+        sizeChanged = true;
+    pyramidFormat = internalFormat;
+}
+
+/**
+ * @brief Returns storage format of density layer
+ * @return Storage format
+ */
+GLenum MainRenderer::getDensityFormat() const
+{
+    return densityFormat;
+}
+
+/**
+ * @brief Returns storage format of silhouettes layer
+ * @return Storage format
+ */
+GLenum MainRenderer::getSilhouettesFormat() const
+{
+    return silhouettesFormat;
+}
+
+/**
+ * @brief Returns storage format of polygonal layer
+ * @return Storage format
+ */
+GLenum MainRenderer::getPolygonalFormat() const
+{
+    return polygonalFormat;
+}
+
+/**
+ * @brief Returns storage format of pyramid layer
+ * @return Storage format
+ */
+GLenum MainRenderer::getPyramidFormat() const
+{
+    return pyramidFormat;
+}
+
+/**
+ * @brief Enables or disables GPU timers of rendering passes
+ * @param[in] value Boolean flag
+ *
+ * Passes are measured by GL_TIME_ELAPSED queries, results are collected
+ * asynchronously in following frames.
+ */
+void MainRenderer::enablePassTimers(bool value)
+{
+    passTimer.setEnabled(value);
+}
+
+/**
+ * @brief Are GPU timers of rendering passes enabled?
+ * @return True if timers are enabled
+ */
+bool MainRenderer::isPassTimersEnabled() const
+{
+    return passTimer.isEnabled();
+}
+
+/**
+ * @brief Returns rolling statistics of rendering pass
+ * @param[in] pass Name of pass (recomputeDiff, recomputePositions, recomputeClusterBounds, renderPyramid, renderDensity, bakeDensityVolume,
+ * renderDensityVolume, renderPolygonal, renderSilhouettes or renderPostprocessing)
+ * @return Minimal, mean, 95th percentile and last GPU time in milliseconds
+ */
+PassTimer::Stats MainRenderer::getPassTimerStats(const QString &pass)
+{
+    if (!checkInitAndMakeCurrentContext())
+        return PassTimer::Stats();
+
+    passTimer.collect();
+    return passTimer.getStats(pass);
+}
+
+/**
+ * @brief Returns names of measured rendering passes
+ * @return List of passes
+ */
+QStringList MainRenderer::getTimedPasses()
+{
+    if (!checkInitAndMakeCurrentContext())
+        return QStringList();
+
+    passTimer.collect();
+    return passTimer.getPasses();
+}
+
+/**
+ * @brief Clears statistics of GPU timers
+ */
+void MainRenderer::resetPassTimers()
+{
+    passTimer.reset();
+}
+
+/**
+ * @brief Deletes unused render targets of pool shared by renderers
+ *
+ * Released targets are otherwise kept for next size or layer changes.
+ */
+void MainRenderer::releaseUnusedRenderTargets()
+{
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    if (renderTargetPool)
+        renderTargetPool->trim();
+}
+
+/**
+ * @brief Builds all shader programs upfront
+ *
+ * Programs are otherwise compiled on first use (enabling of layer or first render
+ * which needs them), so unused programs (e.g. pyramid or polygonal) are never built.
+ */
+void MainRenderer::warmUp()
+{
+    if (!checkInitAndMakeCurrentContext())
+        return;
+    requirePrograms(PROGRAMS_ALL);
+}
+
+/**
+ * @brief Enables or disables CPU reconstruction of vertices
+ * @param[in] value Boolean flag
+ * @param[in] numberOfThreads Number of threads (0 = number of CPU cores)
+ *
+ * Recomputed vertices (getRecomputedVertices, getVerticesMask, exportSTL) are computed
+ * on CPU from current pcs of vertices statistical data, GPU diff texture is not read.
+ */
+void MainRenderer::enableCPUReconstruction(bool value, int numberOfThreads)
+{
+    cpuReconstructionEnabled = value;
+    shapeReconstructionCPU.setNumberOfThreads(numberOfThreads);
+}
+
+/**
+ * @brief Is CPU reconstruction of vertices enabled?
+ * @return True if CPU reconstruction is enabled
+ */
+bool MainRenderer::isCPUReconstructionEnabled() const
+{
+    return cpuReconstructionEnabled;
+}
+
+/**
+ * @brief Sets flag for sharing transformations between shared contexts
+ * @param[in] value Boolean flag
+ */
+void MainRenderer::setFlagShareTransformations(bool value)
+{
+    flagShareTransformations = value;
+}
+
+/**
+ * @brief Sets translation of model in scene
+ * @param[in] x X position
+ * @param[in] y Y position
+ * @param[in] z Z position
+ */
+void MainRenderer::setTranslation(float x, float y, float z)
+{
+    setTranslation(QVector3D(x, y, z));
+}
+
+/**
+ * @brief Sets translation of model in scene
+ * @param[in] position 3D vector with position
+ */
+void MainRenderer::setTranslation(QVector3D position)
+{
+    translationMatrix.setToIdentity();
+    translationMatrix.translate(position.x(), position.y(), position.z());
+
+    if (flagShareTransformations) {
+        if (!hasSharedContext()) {
+            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
+            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
+                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
+                if (dynamic_cast<MainRenderer *>(renderSurface)) {
+                    ((MainRenderer *) renderSurface)->translationMatrix = translationMatrix;
+                }
+            }
+        } else {
+            ((MainRenderer *) getParentOpenGLWrapper())->setTranslation(position);
+        }
+    }
+}
+
+/**
+ * @brief Returns translation
+ * @param[out] x X position
+ * @param[out] y Y position
+ * @param[out] z Z position
+ */
+void MainRenderer::getTranslation(float &x, float &y, float &z)
+{
+    QVector3D translation = getTranslation();
+    x = translation.x();
+    y = translation.y();
+    z = translation.z();
+}
+
+/**
+ * @brief Returns translation
+ * @return 3D vector with position
+ */
+QVector3D MainRenderer::getTranslation()
+{
+    return QVector3D(translationMatrix.column(3).x(), translationMatrix.column(3).y(), translationMatrix.column(3).z());
+}
+
+/**
+ * @brief Translates model in scene
+ * @param[in] x X position
+ * @param[in] y Y position
+ * @param[in] z Z position
+ */
+void MainRenderer::translate(float x, float y, float z)
+{
+    translate(QVector3D(x, y, z));
+}
+
+/**
+ * @brief Translates model in scene
+ * @param[in] position 3D vector with position
+ */
+void MainRenderer::translate(QVector3D position)
+{
+    translationMatrix.translate(position.x(), position.y(), position.z());
+
+    if (flagShareTransformations) {
+        if (!hasSharedContext()) {
+            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
+            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
+                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
+                if (dynamic_cast<MainRenderer *>(renderSurface)) {
+                    ((MainRenderer *) renderSurface)->translationMatrix = translationMatrix;
+                }
+            }
+        } else {
+            ((MainRenderer *) getParentOpenGLWrapper())->translate(position);
+        }
+    }
+}
+
+/**
+ * @brief Sets rotation of model in scene
+ * @param[in] xAngle X angle
+ * @param[in] yAngle Y angle
+ * @param[in] zAngle Z angle
+ */
+void MainRenderer::setRotation(float xAngle, float yAngle, float zAngle)
+{
+    setRotation(QVector3D(xAngle, yAngle, zAngle));
+}
+
+/**
+ * @brief Sets rotation of model in scene
+ * @param[in] rotation 3D vector with rotation
+ */
+void MainRenderer::setRotation(QVector3D rotation)
+{
+    rotationMatrix.setToIdentity();
+    angles = rotation;
+    if (angles.x() < 0)
+        angles.setX(360 + angles.x());
+    if (angles.y() < 0)
+        angles.setY(360 + angles.y());
+    if (angles.z() < 0)
+        angles.setZ(360 + angles.z());
+    angles.setX(fmod(angles.x(), 360));
+    angles.setY(fmod(angles.y(), 360));
+    angles.setZ(fmod(angles.z(), 360));
+
+    /*float sX = qSin(qDegreesToRadians(angles.x()));
+    float sY = qSin(qDegreesToRadians(angles.y()));
+    float sZ = qSin(qDegreesToRadians(angles.z()));
+    float cX = qCos(qDegreesToRadians(angles.x()));
+    float cY = qCos(qDegreesToRadians(angles.y()));
+    float cZ = qCos(qDegreesToRadians(angles.z()));
+
+    rotationMatrix(0, 0) = cY * cZ;
+    rotationMatrix(0, 1) = -cY * sZ;
+    rotationMatrix(0, 2) = sY;
+
+    rotationMatrix(1, 0) = cZ * sX * sY + cX * sZ;
+    rotationMatrix(1, 1) = cX * cZ-sX * sY * sZ;
+    rotationMatrix(1, 2) = -cY * sX;
+
+    rotationMatrix(2, 0) = -cX * cZ * sY + sX * sZ;
+    rotationMatrix(2, 1) = cZ * sX + cX * sY * sZ;
+    rotationMatrix(2, 2) = cX * cY;*/
+
+    rotationMatrix.rotate(angles.z(), 0, 0, 1);
+    rotationMatrix.rotate(angles.y(), 0, 1, 0);
+    rotationMatrix.rotate(angles.x(), 1, 0, 0);
+
+    if (flagShareTransformations) {
+        if (!hasSharedContext()) {
+            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
+            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
+                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
+                if (dynamic_cast<MainRenderer *>(renderSurface)) {
+                    ((MainRenderer *) renderSurface)->rotationMatrix = rotationMatrix;
+                    ((MainRenderer *) renderSurface)->angles = angles;
+                }
+            }
+        } else {
+            ((MainRenderer *) getParentOpenGLWrapper())->setRotation(angles);
+        }
+    }
+}
+
+/**
+ * @brief Sets rotation matrix
+ * @param[in] rotationMatrix Rotation matrix
+ */
+void MainRenderer::setRotationMatrix(QMatrix4x4 rotationMatrix)
+{
+    this->rotationMatrix = rotationMatrix;
+    //QVector3D angles = getAngles(rotationMatrix);
+    //setRotation(angles);
+
+    if (flagShareTransformations) {
+        if (!hasSharedContext()) {
+            QList<OpenGLWrapper *> childOpenGLWrappers = getChildOpenGLWrappers();
+            for (int i = 0; i < childOpenGLWrappers.size(); i++) {
+                OpenGLWrapper *renderSurface = childOpenGLWrappers.at(i);
+                if (dynamic_cast<MainRenderer *>(renderSurface)) {
+                    ((MainRenderer *) renderSurface)->rotationMatrix = rotationMatrix;
+                }
+            }
+        } else {
+            ((MainRenderer *) getParentOpenGLWrapper())->setRotationMatrix(rotationMatrix);
+        }
+    }
+}
+
+/**
+ * @brief Returns rotation
+ * @param[out] xAngle X angle
+ * @param[out] yAngle Y angle
+ * @param[out] zAngle Z angle
+ */
+void MainRenderer::getRotation(float &xAngle, float &yAngle, float &zAngle)
+{
+    xAngle = angles.x();
+    yAngle = angles.y();
+    zAngle = angles.z();
+}
+
+/**
+ * @brief Returns rotation
+ * @return 3D vector with rotation
+ */
+QVector3D MainRenderer::getRotation()
+{
+    return angles;
+}
+
+/**
+ * @brief Returns rotation matrix
+ * @return Rotation matrix
+ */
+QMatrix4x4 MainRenderer::getRotationMatrix()
+{
+    return rotationMatrix;
+}
+
+/**
+ * @brief Rotates model in scene
+ * @param[in] xAngle X angle
+ * @param[in] yAngle Y angle
+ * @param[in] zAngle Z angle
+ */
+void MainRenderer::rotate(float xAngle, float yAngle, float zAngle)
+{
+    rotate(QVector3D(xAngle, yAngle, zAngle));
+}
+
+/**
+ * @brief Rotates model in scene
+ * @param[in] rotation 3D vector with rotation
+ */
+void MainRenderer::rotate(QVector3D rotation)
+{
+    setRotation(angles + rotation);
+}
+
+/**
+ * @brief Sets camera by corners ane eye positions
+ * @param[in] leftTop Left top corner of pyramid base
+ * @param[in] leftBottom Left bottom corner of pyramid base
+ * @param[in] rightTop Right top corner of pyramid base
+ * @param[in] rightBottom Right bottom corner of pyramid base
+ * @param[in] eye Position of eye - the top of the pyramid
+ */
+void MainRenderer::setCamera(QVector3D leftTop, QVector3D leftBottom, QVector3D rightTop, QVector3D rightBottom, QVector3D eye)
+{
+    setCamera(SSIMRenderer::Pyramid(leftTop, leftBottom, rightTop, rightBottom, eye));
+}
+
+/**
+ * @brief Sets camera by pyramid object
+ * @param[in] camera Pyramid to set
+ */
+void MainRenderer::setCamera(SSIMRenderer::Pyramid camera)
+{
+    setCamera(camera.getEye(), camera.getCenter());
+}
+
+/**
+ * @brief Sets camera by eye and center position
+ * @param[in] eye Eye position
+ * @param[in] center Center position
+ */
+void MainRenderer::setCamera(QVector3D eye, QVector3D center)
+{
+    this->center = center;
+    this->eye = eye;
+    if (this->eye == this->center)
+        setCamera(this->eye + (perspective.getViewDir() * perspective.getDistance()), this->center);
+    cameraMatrix.setToIdentity();
+    cameraMatrix.lookAt(getEye(), getCenter(), perspective.getUpDir());
+}
+
+/**
+ * @brief Move camera with given distance and center position
+ * @param[in] distance Distance form center
+ * @param[in] center Center position
+ */
+void MainRenderer::moveCamera(float distance, QVector3D center)
+{
+    QVector3D eyeTranslated;
+    QVector3D centerTranslated;
+    QVector3D centerDir = (getEye() - center).normalized();
+    eyeTranslated = getEye() + centerDir * distance;
+    centerTranslated = getCenter() + centerDir * distance;
+    setCamera(eyeTranslated, centerTranslated);
+}
+
+/**
+ * @brief Rotates camera arround center with x and y angles
+ * @param[in] xAngle X angle
+ * @param[in] yAngle Y angle
+ * @param[in] center Center position
+ */
+void MainRenderer::rotateCamera(float xAngle, float yAngle, QVector3D center)
+{
+    QVector3D eyeRotated;
+    QVector3D centerRotated;
+    QMatrix4x4 rotation;
+    rotation.rotate(xAngle, QVector3D::crossProduct(perspective.getUpDir(), getViewDir()));
+    rotation.rotate(yAngle, perspective.getUpDir());
+
+    if (qAbs(QVector3D::dotProduct(rotation * getViewDir(), perspective.getUpDir())) > 0.99f) {
+        rotation.setToIdentity();
+        rotation.rotate(yAngle, perspective.getUpDir());
+    }
+
+    QVector3D eyeVector = (getEye() - center);
+    QVector3D centerVector = (getCenter() - center);
+    eyeRotated = rotation * eyeVector;
+    centerRotated = rotation * centerVector;
+    eyeRotated += center;
+    centerRotated += center;
+    setCamera(eyeRotated, centerRotated);
+}
+
+/**
+ * @brief Returns eye position
+ * @return Eye position
+ */
+QVector3D MainRenderer::getEye()
+{
+    if (eye == center)
+        setCamera(eye + (perspective.getViewDir() * perspective.getDistance()), center);
+    return eye;
+}
+
+/**
+ * @brief Returns center position
+ * @return Center position
+ */
+QVector3D MainRenderer::getCenter()
+{
+    if (eye == center)
+        setCamera(eye + (perspective.getViewDir() * perspective.getDistance()), center);
+    return center;
+}
+
+/**
+ * @brief Returns middle position
+ * @return Middle position
+ */
+QVector3D MainRenderer::getMiddle()
+{
+    return perspective.getMiddle();
+}
+
+/**
+ * @brief Returns view dir
+ * @return View dir
+ */
+QVector3D MainRenderer::getViewDir()
+{
+    return (getEye() - getCenter()).normalized();
+}
+
+/**
+ * @brief Sets eye position
+ * @param[in] Eye position
+ */
+void MainRenderer::setEye(const QVector3D &value)
+{
+    setCamera(value, getCenter());
+}
+
+/**
+ * @brief Sets center position
+ * @param[in] value Center position
+ */
+void MainRenderer::setCenter(const QVector3D &value)
+{
+    setCamera(getEye(), value);
+}
+
+/**
+ * @brief Sets perspective by corners ane eye positions
+ * @param[in] leftTop Left top corner of pyramid base
+ * @param[in] leftBottom Left bottom corner of pyramid base
+ * @param[in] rightTop Right top corner of pyramid base
+ * @param[in] rightBottom Right bottom corner of pyramid base
+ * @param[in] eye Position of eye - the top of the pyramid
+ */
+void MainRenderer::setPerspective(QVector3D leftTop, QVector3D leftBottom, QVector3D rightTop, QVector3D rightBottom, QVector3D eye)
+{
+    perspective = SSIMRenderer::Pyramid(leftTop, leftBottom, rightTop, rightBottom, eye);
+    prepareTransformation();
+    setCamera(perspective);
+}
+
+/**
+ * @brief Sets perspective camera by pyramid object
+ * @param[in] camera Pyramid to set
+ */
+void MainRenderer::setPerspective(SSIMRenderer::Pyramid perspective)
+{
+    this->perspective = perspective;
+    points.append(perspective.getCenter());
+    prepareTransformation();
+    setCamera(perspective);
+}
+
+/**
+ * @brief Returns perspective
+ * @return Setted perspective
+ */
+SSIMRenderer::Pyramid MainRenderer::getPerspective()
+{
+    return perspective;
+}
+
+/**
+ * @brief Returns final matrix of density rendering
+ * @return Matrix with crop sub-frustum, perspective, camera, translation and rotation
+ *
+ * DensityRendererCPU with this matrix and with size of crop window renders the same
+ * image as getCurrentDensityData returns.
+ */
+QMatrix4x4 MainRenderer::getDensityMatrix()
+{
+    prepareTransformation();
+    return cropMatrix * perspectiveMatrix * cameraMatrix * translationMatrix * rotationMatrix;
+}
+
+/**
+ * @brief Adds control point for distances measuring
+ * @param[in] value Point position
+ */
+void MainRenderer::addPoint(const QVector3D &value)
+{
+    points.append(value);
+}
+
+/**
+ * @brief Adds control points for distances measuring
+ * @param[in] points 2D vector of control points
+ */
+void MainRenderer::setPoints(QVector<QVector3D> points)
+{
+    this->points = points;
+}
+
+/**
+ * @brief Returns controls points
+ * @return 2D vector with control points
+ */
+QVector<QVector3D> MainRenderer::getPoints()
+{
+    return points;
+}
+
+/*
+/**
+ * @brief MainRenderer::getMinimalDistancesToPoints
+ * @return
+ *
+ * @todo TODO nepouzito, predelat, upravit, zprehlednit
+ */
+/*QVector<float> MainRenderer::getMinimalDistancesToPoints(void (*f)(float *d, unsigned char *u, int  w, int h))
+{
+    // @todo TODO comments!
+    QVector<float> distances(points.size(), -1);
+
+    if (distances.size() > 0) {
+        //QMatrix4x4 r = getRotationMatrix().inverted();
+        //float tx, ty, tz;
+        //getTranslation(tx, ty, tz);
+        //QVector3D t(tx, ty, tz);
+
+        float *silhouettesImage;
+        getCurrentSilhouettesImage(silhouettesImage);
+        unsigned char *mask = NULL;
+        if (f != NULL) {
+            mask = new unsigned char[getRenderWidth() * getRenderHeight()]();
+            f(silhouettesImage, mask, getRenderWidth(), getRenderHeight());
+        }
+
+        QVector<QVector3D> lines;
+
+        for (int i = 0; i < points.size(); i++) {
+            lines.append((points.at(i) - perspective.getEye()).normalized());
+        }
+
+        for (unsigned int i = 0; i < getRenderWidth() * getRenderHeight(); i++) {
+            if (silhouettesImage[4 * i + 3] != 0 && (mask == NULL || mask[i] != 0)) {
+                for (int p = 0; p < points.size(); p++) {
+                    QVector3D silhouettePoint = QVector3D(silhouettesImage[4 * i + 0], silhouettesImage[4 * i + 1], silhouettesImage[4 * i + 2]);
+                    silhouettePoint = translationMatrix * rotationMatrix * silhouettePoint;
+
+                    float distance = silhouettePoint.distanceToLine(points.at(p), lines.at(p));
+                    if (distances[p] != -1) {
+                        if (distances[p] > distance) {
+                            distances[p] = distance;
+                        }
+                    } else {
+                        distances[p] = distance;
+                    }
+                }
+            }
+
+        }
+        //qDebug() << points;
+        //qDebug() << distances;
+
+        delete[] silhouettesImage;
+        if (f != NULL)
+            delete[] mask;
+    }
+
+    return distances;
+}
+/*
+QVector<float> MainRenderer::getMinimalDistancesToPoints()
+{
+    QVector<float> distances(points.size(), -1);
+
+    if (distances.size() > 0) {
+
+        //QMatrix4x4 r = getRotationMatrix().inverted();
+        //float tx, ty, tz;
+        //getTranslation(tx, ty, tz);
+        //QVector3D t(tx, ty, tz);
+
+        float *silhouettesImage;
+        getCurrentSilhouettesImage(silhouettesImage);
+
+        QVector<QVector3D> lines;
+
+        for (int i = 0; i < points.size(); i++) {
+            lines.append((points.at(i) - perspective.getEye()).normalized());
+        }
+
+        for (unsigned int i = 0; i < getRenderWidth() * getRenderHeight(); i++) {
+            if (silhouettesImage[4 * i + 3] != 0) {
+                for (int p = 0; p < points.size(); p++) {
+                    QVector3D silhouettePoint = QVector3D(silhouettesImage[4 * i + 0], silhouettesImage[4 * i + 1], silhouettesImage[4 * i + 2]);
+                    silhouettePoint = translationMatrix * rotationMatrix * silhouettePoint;
+
+                    float distance = silhouettePoint.distanceToLine(points.at(p), lines.at(p));
+                    if (distances[p] != -1) {
+                        if (distances[p] > distance) {
+                            distances[p] = distance;
+                        }
+                    } else {
+                        distances[p] = distance;
+                    }
+                }
+            }
+
+        }
+        //qDebug() << points;
+        //qDebug() << distances;
+
+        delete[] silhouettesImage;
+    }
+
+    return distances;
+}      */
+
+/**
+ * @brief Clear control points
+ */
+void MainRenderer::clearPoints()
+{
+    points.clear();
+}
+
+/**
+ * @brief Returns pointer to statistical data object
+ * @return The pointer to statistical data object
+ */
+StatisticalData *MainRenderer::getStatisticalData() const
+{
+    if (!statisticalData) {
+        qCritical() << "MainRenderer::getStatisticalData error: null StatisticalData";
+        return 0;
+    }
+
+    return statisticalData;
+}
+
+/**
+ * @brief Returns pointer to mesh object
+ * @return The pointer to mesh object
+ */
+Mesh *MainRenderer::getMesh() const
+{
+    if (!mesh) {
+        qCritical() << "MainRenderer::getMesh error: null Mesh";
+        return 0;
+    }
+
+    return mesh;
+}
+
+/**
+ * @brief Main initialze function
+ *
+ * Initializes OpenGL (shared) resources and others.
+ */
+void MainRenderer::initialize()
+{
+    // Important for resources in library
+    Q_INIT_RESOURCE(shaders);
+
+    // Query objects are not shared
+    passTimer.initialize(this);
+
+    // Render targets are shared with parent surface
+    if (hasSharedContext()) {
+        renderTargetPool = ((MainRenderer *) getParentOpenGLWrapper())->renderTargetPool;
+    } else {
+        renderTargetPool = new RenderTargetPool();
+    }
+    renderTargetPool->attach(this);
+
+    // Get max texture and viewport dims
+    GLint dimsV[2], dimT;
     glGetIntegerv(GL_MAX_VIEWPORT_DIMS, &dimsV[0]);
     glGetIntegerv(GL_MAX_TEXTURE_SIZE, &dimT);
     maxTextureOrRenderSize[0] = (GLuint) qMin(dimsV[0], dimT);
     maxTextureOrRenderSize[1] = (GLuint) qMin(dimsV[1], dimT);
     cWidth = maxTextureOrRenderSize[0];
 
-    // Set helper variables
-    positionDiffLengthLog2 = (GLuint(double(qLn(maxTextureOrRenderSize[0]) / qLn(2))));
-    positionDiffLengthMinus1 = maxTextureOrRenderSize[0] - 1;
+    // Set helper variables
+    positionDiffLengthLog2 = (GLuint(double(qLn(maxTextureOrRenderSize[0]) / qLn(2))));
+    positionDiffLengthMinus1 = maxTextureOrRenderSize[0] - 1;
+
+    // Init first render size
+    setRenderHeight(renderHeight);
+    setRenderWidth(renderWidth);
+
+    // If current surface uses other main context
+    if (hasSharedContext()) {
+
+        // Get structures from parent surface
+        MainRenderer* parentOpenGLWrapper = (MainRenderer *) getParentOpenGLWrapper();
+
+        density = parentOpenGLWrapper->density;
+        densityBatch = parentOpenGLWrapper->densityBatch;
+        densityBasis = parentOpenGLWrapper->densityBasis;
+        densityPulling = parentOpenGLWrapper->densityPulling;
+        silhouettes = parentOpenGLWrapper->silhouettes;
+        computing = parentOpenGLWrapper->computing;
+        positions = parentOpenGLWrapper->positions;
+        pyramid = parentOpenGLWrapper->pyramid;
+        polygonal = parentOpenGLWrapper->polygonal;
+        postprocessing = parentOpenGLWrapper->postprocessing;
+        fusedSSD = parentOpenGLWrapper->fusedSSD;
+        densityVolume = parentOpenGLWrapper->densityVolume;
+
+        // Texture Objects
+        toCompCoeffs = parentOpenGLWrapper->toCompCoeffs;
+        toCompVertices = parentOpenGLWrapper->toCompVertices;
+        toBerncoeffs = parentOpenGLWrapper->toBerncoeffs;
+        toT = parentOpenGLWrapper->toT;
+        toPcs = parentOpenGLWrapper->toPcs;
+        toPositions = parentOpenGLWrapper->toPositions;
+        toElementsTetrahedra = parentOpenGLWrapper->toElementsTetrahedra;
+        toTetrahedraInverse = parentOpenGLWrapper->toTetrahedraInverse;
+
+        // Vertex Buffer Objects
+        vboVertices = parentOpenGLWrapper->vboVertices;
+        vboPositions = parentOpenGLWrapper->vboPositions;
+
+        vboNormals = parentOpenGLWrapper->vboNormals;
+        vboTetrahedraInverse = parentOpenGLWrapper->vboTetrahedraInverse;
+        vboClusterBounds = parentOpenGLWrapper->vboClusterBounds;
+        //vboComputeIndicesX = parentOpenGLWrapper->vboComputeIndicesX;
+        //vboComputeIndicesY = parentOpenGLWrapper->vboComputeIndicesY;
+
+        // Element Buffer Objects
+        iboElementsTetrahedra = parentOpenGLWrapper->iboElementsTetrahedra;
+        iboElementsTriangles = parentOpenGLWrapper->iboElementsTriangles;
+        vboVerticesColors = parentOpenGLWrapper->vboVerticesColors;
+        iboElementsTrianglesAdjacency = parentOpenGLWrapper->iboElementsTrianglesAdjacency;
+
+        // Texture Buffer Objects
+        tboBerncoeffs = parentOpenGLWrapper->tboBerncoeffs;
+        tboT = parentOpenGLWrapper->tboT;
+        tboPcs = parentOpenGLWrapper->tboPcs;
+
+        // Uniform Buffer Objects
+        uboBernsteinWeights = parentOpenGLWrapper->uboBernsteinWeights;
+
+        // Other shared data
+        if (parentOpenGLWrapper->mesh && mesh == 0)
+            mesh = parentOpenGLWrapper->mesh;
+
+    } else { // Main context
+
+        density = new Density();
+        density->program = 0;
+        density->fragmentShader = 0;
+        density->programBounds = 0;
+        density->clusterBoundsGeneration = -1;
+
+        densityBatch = new DensityBatch();
+        densityBatch->program = 0;
+        densityBatch->fragmentShader = 0;
+
+        densityBasis = new DensityBasis();
+        densityBasis->program = 0;
+
+        densityPulling = new DensityPulling();
+        densityPulling->program = 0;
+        densityPulling->fragmentShader = 0;
+        densityPulling->programInverse = 0;
+        densityPulling->inverseGeneration = -1;
+
+        silhouettes = new Silhouettes();
+        silhouettes->program = 0;
+
+        computing = new Computing();
+        computing->program = 0;
+        computing->programDelta = 0;
+        computing->coefficientsState.statisticalData = 0;
+        computing->coefficientsState.width = 0;
+        computing->coefficientsState.height = 0;
+        computing->coefficientsState.deltaUpdates = 0;
+        computing->verticesState = computing->coefficientsState;
+
+        positions = new Positions();
+        positions->program = 0;
+        positions->generation = 0;
+
+        pyramid = new Pyramid();
+        pyramid->program = 0;
+
+        polygonal = new Polygonal();
+        polygonal->program = 0;
+
+        postprocessing = new Postprocessing();
+        postprocessing->program = 0;
+        postprocessing->programSimple = 0;
+
+        fusedSSD = new FusedSSD();
+        fusedSSD->program = 0;
+        fusedSSD->programReduce = 0;
+
+        densityVolume = new DensityVolume();
+        densityVolume->programBake = 0;
+        densityVolume->fragmentShader = 0;
+        densityVolume->programOccupancy = 0;
+        densityVolume->program = 0;
+        densityVolume->voxelSize = 0;
+        densityVolume->valid = false;
+
+        // Density volume is filtered linearly with zero outside, occupancy grid is fetched
+        glGenTextures(1, &densityVolume->toVolume);
+        glBindTexture(GL_TEXTURE_3D, densityVolume->toVolume);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
+        glGenTextures(1, &densityVolume->toOccupancy);
+        glBindTexture(GL_TEXTURE_3D, densityVolume->toOccupancy);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_3D, 0);
+
+        // Programs are built on first use by requirePrograms (or by warmUp)
+
+        // Generate buffers
+        // Element buffer for tetrahedra
+        iboElementsTetrahedra = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+        iboElementsTetrahedra.create();
+
+        // Element buffer for triangles
+        iboElementsTriangles = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+        iboElementsTriangles.create();
+
+        // Color buffer for triangles
+        vboVerticesColors = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        vboVerticesColors.create();
+
+        // Element buffer for adjacent triangles
+        iboElementsTrianglesAdjacency = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+        iboElementsTrianglesAdjacency.create();
+
+        // Vertex buffer
+        vboVertices = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        vboVertices.create();
+
+        // Buffer for final vertex positions
+        vboPositions = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        vboPositions.create();
+
+        vboNormals = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        vboNormals.create();
+
+        // Buffer for inverse matrices of tetrahedra
+        vboTetrahedraInverse = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        vboTetrahedraInverse.create();
+
+        // Buffer for bounding boxes of clusters of tetrahedra
+        vboClusterBounds = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        vboClusterBounds.create();
+
+        // Textures for vertex pulling, buffers are attached in recomputeTetrahedraInverse
+        glGenTextures(1, &toPositions);
+        glGenTextures(1, &toElementsTetrahedra);
+        glGenTextures(1, &toTetrahedraInverse);
+
+        //vboComputeIndicesX = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        //vboComputeIndicesX.create();
+
+        //vboComputeIndicesY = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        //vboComputeIndicesY.create();
+
+        // Coefficients texture buffer
+        glGenBuffers(1, &tboBerncoeffs);
+        glBindBuffer(GL_TEXTURE_BUFFER, tboBerncoeffs);
+        glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        // Texture for coefficients
+        glGenTextures(1, &toBerncoeffs);
+        glBindTexture(GL_TEXTURE_BUFFER, toBerncoeffs);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboBerncoeffs);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        // Uniform buffer with weights of loop density fragment shaders, filled in updateDensityPrograms
+        glGenBuffers(1, &uboBernsteinWeights);
+        glBindBuffer(GL_UNIFORM_BUFFER, uboBernsteinWeights);
+        glBufferData(GL_UNIFORM_BUFFER, 0, 0, GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        // Textures for computing - input
+        glGenTextures(1, &toCompCoeffs);
+        glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenTextures(1, &toCompVertices);
+        glBindTexture(GL_TEXTURE_2D, toCompVertices);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // T matrix texture buffer
+        glGenBuffers(1, &tboT);
+        glBindBuffer(GL_TEXTURE_BUFFER, tboT);
+        glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        // Texture for T matrix
+        glGenTextures(1, &toT);
+        glBindTexture(GL_TEXTURE_BUFFER, toT);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboT);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        // Pcs matrix texture buffer
+        glGenBuffers(1, &tboPcs);
+        glBindBuffer(GL_TEXTURE_BUFFER, tboPcs);
+        glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        // Texture for Pcs matrix
+        glGenTextures(1, &toPcs);
+        glBindTexture(GL_TEXTURE_BUFFER, toPcs);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboPcs);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    }
+
+    // Textures for rendering are acquired from pool in resizeTexturesAndRenderbuffer
+
+    // Binding point of weights for loop density fragment shaders
+    glBindBufferBase(GL_UNIFORM_BUFFER, BERNSTEIN_WEIGHTS_BINDING, uboBernsteinWeights);
+
+    // Final texture, it is acquired from pool again after change of crop size
+    allocateCropTexture(toOutput);
+
+    // Texture for pyramid image
+    glGenTextures(1, &toPyramidImage);
+    glBindTexture(GL_TEXTURE_2D, toPyramidImage);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, getRenderWidth(), getRenderHeight(), 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Layered texture for batch rendering
+    GLint maxLayers;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    maxBatchSize = (GLuint) maxLayers;
+
+    glGenTextures(1, &toBatch);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, toBatch);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // Matrices of batch poses
+    glGenBuffers(1, &tboBatchMatrices);
+    glBindBuffer(GL_TEXTURE_BUFFER, tboBatchMatrices);
+    glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &toBatchMatrices);
+    glBindTexture(GL_TEXTURE_BUFFER, toBatchMatrices);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, tboBatchMatrices);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    // Layered texture for density basis images
+    glGenTextures(1, &toDensityBasis);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, toDensityBasis);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // Weights of density basis images
+    glGenBuffers(1, &tboBasisWeights);
+    glBindBuffer(GL_TEXTURE_BUFFER, tboBasisWeights);
+    glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &toBasisWeights);
+    glBindTexture(GL_TEXTURE_BUFFER, toBasisWeights);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboBasisWeights);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    // Reference image for fused SSD, tiles are acquired from pool
+    glGenTextures(1, &toReference);
+    glBindTexture(GL_TEXTURE_2D, toReference);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Pixel buffers and texture for asynchronous readback
+    for (int i = 0; i < READBACK_RING_SIZE; i++) {
+        glGenBuffers(1, &readbacks[i].pbo);
+        readbacks[i].fence = 0;
+        readbacks[i].handle = 0;
+        readbacks[i].format = 0;
+        readbacks[i].type = 0;
+        readbacks[i].width = 0;
+        readbacks[i].height = 0;
+        readbacks[i].size = 0;
+    }
+
+    // Vertex Array Object
+    glGenVertexArrays(1, &vao);
+
+    // Helper framebuffers
+    glGenFramebuffers(1, &fbo);
+    glGenFramebuffers(1, &fboOutput);
+
+    // Render depth buffer is acquired from pool in resizeTexturesAndRenderbuffer
+
+    // Framebuffer for computing
+    glGenFramebuffers(1, &fboComputing);
+
+    // Framebuffer for layered batch rendering (without depth buffer)
+    glGenFramebuffers(1, &fboBatch);
+
+    // Framebuffer for flipping of output
+    glGenFramebuffers(1, &fboReadback);
+
+    // Settings
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    // Blending
+    //glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+    //glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+    //glEnable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    if (!hasSharedContext())
+        initUniformVariables();
+}
+
+/**
+ * @brief Main render function
+ */
+void MainRenderer::render()
+{
+    // Results of previous frames
+    passTimer.collect();
+
+    prepareRendering();
+
+    // Must be first!!! - depth culling
+    if (pyramidEnabled) {
+        passTimer.begin("renderPyramid");
+        renderPyramid(getPerspective());
+        passTimer.end();
+    }
+    if (densityEnabled && densityVolumeEnabled && !hasDensityVolume()) {
+        passTimer.begin("bakeDensityVolume");
+        bakeDensityVolume();
+        passTimer.end();
+
+        if (!hasDensityVolume()) {
+            qWarning() << "MainRenderer::render warning: density volume cannot be baked, density volume is disabled";
+            densityVolumeEnabled = false;
+        }
+    }
+    if (densityEnabled && densityVolumeEnabled) {
+        passTimer.begin("renderDensityVolume");
+        renderDensityVolume();
+        passTimer.end();
+    } else if (densityEnabled) {
+        passTimer.begin("renderDensity");
+        renderDensity();
+        passTimer.end();
+    }
+    if (polygonalEnabled) {
+        passTimer.begin("renderPolygonal");
+        renderPolygonal();
+        passTimer.end();
+    }
+    if (silhouettesEnabled) {
+        passTimer.begin("renderSilhouettes");
+        renderSilhouettes();
+        passTimer.end();
+    }
+
+    if (fusedSSDEnabled) {
+        passTimer.begin("renderFusedSSD");
+        renderFusedSSD();
+        passTimer.end();
+    }
+
+    if (outputEnabled) {
+        passTimer.begin("renderPostprocessing");
+        renderPostprocessing();
+        passTimer.end();
+    }
+}
+
+/**
+ * @brief Renders density
+ */
+void MainRenderer::renderDensity()
+{
+    if (densityVertexPullingEnabled) {
+        renderDensityPulling();
+        return;
+    }
+
+    requirePrograms(PROGRAMS_DENSITY);
+
+    if (!mesh) {
+        qWarning() << "MainRenderer::renderDensity warning: null Mesh";
+        return;
+    }
+
+    if (mesh->getNumberOfTetrahedra() == 0) {
+        qWarning() << "MainRenderer::renderDensity warning: Tetrahedral mesh is not available";
+        return;
+    }
+
+    updateDensityRanges();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toDensity, 0);
+    setCropViewport();
+
+    //glDisable(GL_MULTISAMPLE);
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+    glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+    glDepthMask(GL_FALSE);
+
+    // Drawing
+    density->program->bind();
+    // Set matrix to shader
+    density->program->setUniformValue(density->uMatrix, matrix);
+    density->program->setUniformValue(density->uMatrixInv, matrix.inverted());
+
+    glBindVertexArray(vao);
+
+    iboElementsTetrahedra.bind();
+
+    vboPositions.bind();
+    glEnableVertexAttribArray(density->aPosition);
+    glVertexAttribPointer(density->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    /*vboComputeIndicesX.bind();
+    glEnableVertexAttribArray(density->aIndicesX);
+    glVertexAttribIPointer(density->aIndicesX, 3, GL_UNSIGNED_INT, 0, 0);
+    vboComputeIndicesY.bind();
+    glEnableVertexAttribArray(density->aIndicesY);
+    glVertexAttribIPointer(density->aIndicesY, 3, GL_UNSIGNED_INT, 0, 0);*/
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, toBerncoeffs);
+    density->program->setUniformValue(density->uBernCoeffs, 0);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
+    density->program->setUniformValue(density->uBernCoeffsDiff, 1);
+
+    // Every range is drawn separately, gl_PrimitiveID is offset to index of tetrahedron
+    drawnTetrahedra = 0;
+    for (int i = 0; i < densityRanges.size(); i += 2) {
+        density->program->setUniformValue(density->uPrimitiveOffset, densityRanges[i]);
+        glDrawElements(GL_LINES_ADJACENCY, densityRanges[i + 1] * 4, GL_UNSIGNED_INT, (const GLvoid *) (sizeof(GLuint) * densityRanges[i] * 4));
+        drawnTetrahedra += densityRanges[i + 1];
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    //glDisableVertexAttribArray(density->aIndicesY);
+    //glDisableVertexAttribArray(density->aIndicesX);
+    glDisableVertexAttribArray(density->aPosition);
+
+    //vboComputeIndicesY.release();
+    //vboComputeIndicesX.release();
+    vboPositions.release();
+    iboElementsTetrahedra.release();
+
+    glBindVertexArray(0);
+
+    density->program->release();
+
+    //debugTexture("renderDensity");
+
+    //glEnable(GL_MULTISAMPLE);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/**
+ * @brief Updates ranges of consecutive visible tetrahedra for density rendering
+ *
+ * Culled ranges are recomputed only if the final matrix, mirroring, shape or culling state
+ * was changed, without culling there is one range of all tetrahedra.
+ */
+void MainRenderer::updateDensityRanges()
+{
+    if (!densityCullingEnabled) {
+        densityRanges.resize(0);
+        densityRanges << 0 << GLint(mesh->getNumberOfTetrahedra());
+        densityRangesCulling = false;
+        return;
+    }
+
+    // Shape was changed by any renderer with shared context
+    if (density->clusterBoundsGeneration != positions->generation)
+        recomputeClusterBounds();
+
+    if (densityRangesCulling && densityRangesGeneration == positions->generation
+            && densityRangesXMirroring == xMirroringEnabled && densityRangesMatrix == matrix)
+        return;
+
+    densityRangesCulling = true;
+    densityRangesGeneration = positions->generation;
+    densityRangesXMirroring = xMirroringEnabled;
+    densityRangesMatrix = matrix;
+
+    // Keeps capacity of previous ranges
+    densityRanges.resize(0);
+
+    // Cluster is culled if all corners of its bounding box are outside of one side plane of crop frustum
+    GLint numberOfTetrahedra = GLint(mesh->getNumberOfTetrahedra());
+    for (int i = 0; i * 6 < density->clusterBounds.size(); i++) {
+        const GLfloat *bounds = density->clusterBounds.constData() + i * 6;
+        int outside[4] = {0, 0, 0, 0};
+        for (int j = 0; j < 8; j++) {
+            QVector4D corner(bounds[(j & 1) ? 3 : 0], bounds[(j & 2) ? 4 : 1], bounds[(j & 4) ? 5 : 2], 1.0f);
+            if (xMirroringEnabled)
+                corner.setX(-corner.x());
+            corner = matrix * corner;
+            outside[0] += corner.x() < -corner.w();
+            outside[1] += corner.x() > corner.w();
+            outside[2] += corner.y() < -corner.w();
+            outside[3] += corner.y() > corner.w();
+        }
+        if (outside[0] == 8 || outside[1] == 8 || outside[2] == 8 || outside[3] == 8)
+            continue;
+
+        GLint first = i * DENSITY_CLUSTER_SIZE;
+        GLint count = qMin(GLint(DENSITY_CLUSTER_SIZE), numberOfTetrahedra - first);
+        if (!densityRanges.isEmpty() && densityRanges[densityRanges.size() - 2] + densityRanges[densityRanges.size() - 1] == first)
+            densityRanges[densityRanges.size() - 1] += count;
+        else
+            densityRanges << first << count;
+    }
+}
+
+/**
+ * @brief Renders density by vertex pulling
+ *
+ * Every instance is one tetrahedron with 4 triangles (12 vertices), positions and inverse
+ * matrices are fetched from texture buffers. Output is same as renderDensity() with geometry shader,
+ * culled ranges are drawn as separate instanced draws offset by uInstanceOffset.
+ */
+void MainRenderer::renderDensityPulling()
+{
+    if (!mesh) {
+        qWarning() << "MainRenderer::renderDensityPulling warning: null Mesh";
+        return;
+    }
+
+    if (mesh->getNumberOfTetrahedra() == 0) {
+        qWarning() << "MainRenderer::renderDensityPulling warning: Tetrahedral mesh is not available";
+        return;
+    }
+
+    requirePrograms(PROGRAMS_DENSITY_PULLING);
+
+    // Shape was changed by any renderer with shared context
+    if (densityPulling->inverseGeneration != positions->generation)
+        recomputeTetrahedraInverse();
+
+    updateDensityRanges();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toDensity, 0);
+    setCropViewport();
+
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+    glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+    glDepthMask(GL_FALSE);
+
+    densityPulling->program->bind();
+    densityPulling->program->setUniformValue(densityPulling->uMatrix, matrix);
+    densityPulling->program->setUniformValue(densityPulling->uMatrixInv, matrix.inverted());
+    densityPulling->program->setUniformValue(densityPulling->uXMirror, xMirroringEnabled);
+    densityPulling->program->setUniformValue(densityPulling->uParam, (float) param);
+
+    glBindVertexArray(vao);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, toBerncoeffs);
+    densityPulling->program->setUniformValue(densityPulling->uBernCoeffs, 0);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
+    densityPulling->program->setUniformValue(densityPulling->uBernCoeffsDiff, 1);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, toPositions);
+    densityPulling->program->setUniformValue(densityPulling->uPositions, 2);
+
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, toElementsTetrahedra);
+    densityPulling->program->setUniformValue(densityPulling->uElements, 3);
+
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_BUFFER, toTetrahedraInverse);
+    densityPulling->program->setUniformValue(densityPulling->uTetrahedraInverse, 4);
+
+    // Every range is drawn separately, gl_InstanceID is offset to index of tetrahedron
+    drawnTetrahedra = 0;
+    for (int i = 0; i < densityRanges.size(); i += 2) {
+        densityPulling->program->setUniformValue(densityPulling->uInstanceOffset, densityRanges[i]);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 12, densityRanges[i + 1]);
+        drawnTetrahedra += densityRanges[i + 1];
+    }
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glBindVertexArray(0);
+
+    densityPulling->program->release();
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/**
+ * @brief Renders silhouettes
+ */
+void MainRenderer::renderSilhouettes()
+{
+    if (!mesh) {
+        qWarning() << "MainRenderer::renderSilhouettes warning: null Mesh";
+        return;
+    }
+
+    if (mesh->getNumberOfTrianglesAdjacency() == 0) {
+        qWarning() << "MainRenderer::renderSilhouettes warning: Triangles adjacency are not available";
+        return;
+    }
+
+    requirePrograms(PROGRAMS_SILHOUETTES);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toSilhouettes, 0);
+    setCropViewport();
+
+    //glDisable(GL_BLEND);
+    //glEnable(GL_MULTISAMPLE);
+    //glDepthMask(GL_FALSE);
+
+    silhouettes->program->bind();
+    // Set matrix to shader
+    silhouettes->program->setUniformValue(silhouettes->uMatrix, matrix);
+    silhouettes->program->setUniformValue(silhouettes->uCoverageOnly, !hasAlphaChannel(silhouettesFormat));
+    silhouettes->program->setUniformValue(silhouettes->uAreaScale, (float) (getCropWidth() * getCropHeight()) / (float) (getRenderWidth() * getRenderHeight()));
+
+    glBindVertexArray(vao);
+
+    iboElementsTrianglesAdjacency.bind();
+
+    vboPositions.bind();
+    glEnableVertexAttribArray(silhouettes->aPosition);
+    glVertexAttribPointer(silhouettes->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    /*vboComputeIndicesX.bind();
+    glEnableVertexAttribArray(silhouettes->aIndicesX);
+    glVertexAttribIPointer(silhouettes->aIndicesX, 3, GL_UNSIGNED_INT, 0, 0);
+    vboComputeIndicesY.bind();
+    glEnableVertexAttribArray(silhouettes->aIndicesY);
+    glVertexAttribIPointer(silhouettes->aIndicesY, 3, GL_UNSIGNED_INT, 0, 0);*/
+
+    glDrawElements(GL_TRIANGLES_ADJACENCY, mesh->getNumberOfTrianglesAdjacency() * 6, GL_UNSIGNED_INT, 0);
 
-    // Init first render size
-    setRenderHeight(renderHeight);
-    setRenderWidth(renderWidth);
+    //glDisableVertexAttribArray(silhouettes->aIndicesY);
+    //glDisableVertexAttribArray(silhouettes->aIndicesX);
+    glDisableVertexAttribArray(silhouettes->aPosition);
 
-    // If current surface uses other main context
-    if (hasSharedContext()) {
+    //vboComputeIndicesY.release();
+    //vboComputeIndicesX.release();
+    vboPositions.release();
+    iboElementsTrianglesAdjacency.release();
 
-        // Get structures from parent surface
-        MainRenderer* parentOpenGLWrapper = (MainRenderer *) getParentOpenGLWrapper();
+    glBindVertexArray(0);
 
-        density = parentOpenGLWrapper->density;
-        silhouettes = parentOpenGLWrapper->silhouettes;
-        computing = parentOpenGLWrapper->computing;
-        pyramid = parentOpenGLWrapper->pyramid;
-        polygonal = parentOpenGLWrapper->polygonal;
-        postprocessing = parentOpenGLWrapper->postprocessing;
+    silhouettes->program->release();
 
-        // Texture Objects
-        toCompCoeffs = parentOpenGLWrapper->toCompCoeffs;
-        toCompVertices = parentOpenGLWrapper->toCompVertices;
-        toBerncoeffs = parentOpenGLWrapper->toBerncoeffs;
-        toT = parentOpenGLWrapper->toT;
-        toPcs = parentOpenGLWrapper->toPcs;
+    //glDepthMask(GL_TRUE);
+    //glDisable(GL_MULTISAMPLE);
+    //glEnable(GL_BLEND);
 
-        // Vertex Buffer Objects
-        vboVertices = parentOpenGLWrapper->vboVertices;
+    //debugTexture("renderSilhouettes");
 
-        vboNormals = parentOpenGLWrapper->vboNormals;
-        //vboComputeIndicesX = parentOpenGLWrapper->vboComputeIndicesX;
-        //vboComputeIndicesY = parentOpenGLWrapper->vboComputeIndicesY;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
 
-        // Element Buffer Objects
-        iboElementsTetrahedra = parentOpenGLWrapper->iboElementsTetrahedra;
-        iboElementsTriangles = parentOpenGLWrapper->iboElementsTriangles;
-        vboVerticesColors = parentOpenGLWrapper->vboVerticesColors;
-        iboElementsTrianglesAdjacency = parentOpenGLWrapper->iboElementsTrianglesAdjacency;
+/**
+ * @brief Renders polygonal
+ */
+void MainRenderer::renderPolygonal()
+{
+    if (!mesh) {
+        qWarning() << "MainRenderer::renderPolygonal warning: null Mesh";
+        return;
+    }
 
-        // Texture Buffer Objects
-        tboBerncoeffs = parentOpenGLWrapper->tboBerncoeffs;
-        tboT = parentOpenGLWrapper->tboT;
-        tboPcs = parentOpenGLWrapper->tboPcs;
+    requirePrograms(PROGRAMS_POLYGONAL);
 
-        // Other shared data
-        if (parentOpenGLWrapper->mesh && mesh == 0)
-            mesh = parentOpenGLWrapper->mesh;
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toPolygonal, 0);
+    setCropViewport();
 
-    } else { // Main context
+    //glEnable(GL_BLEND);
+    //glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+    //glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+    //glBlendColor(0, 0, 0, 1);
+    //glEnable(GL_MULTISAMPLE);
+    //glDisable(GL_DEPTH_TEST);
+    //glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
 
-        density = new Density();
-        density->program = 0;
-        density->fragmentShader = 0;
+    polygonal->program->bind();
+    // Set matrix to shader
+    polygonal->program->setUniformValue(polygonal->uMatrix, matrix);
+    polygonal->program->setUniformValue(polygonal->uNormalMatrix, (cameraMatrix * translationMatrix * rotationMatrix).normalMatrix());
 
-        silhouettes = new Silhouettes();
-        silhouettes->program = 0;
+    glBindVertexArray(vao);
 
-        computing = new Computing();
-        computing->program = 0;
+    iboElementsTriangles.bind();
 
-        pyramid = new Pyramid();
-        pyramid->program = 0;
+    vboPositions.bind();
+    glEnableVertexAttribArray(polygonal->aPosition);
+    glVertexAttribPointer(polygonal->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    /*vboComputeIndicesX.bind();
+    glEnableVertexAttribArray(polygonal->aIndicesX);
+    glVertexAttribIPointer(polygonal->aIndicesX, 3, GL_UNSIGNED_INT, 0, 0);
+    vboComputeIndicesY.bind();
+    glEnableVertexAttribArray(polygonal->aIndicesY);
+    glVertexAttribIPointer(polygonal->aIndicesY, 3, GL_UNSIGNED_INT, 0, 0);*/
+    vboVerticesColors.bind();
+    glEnableVertexAttribArray(polygonal->aColor);
+    glVertexAttribPointer(polygonal->aColor, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-        polygonal = new Polygonal();
-        polygonal->program = 0;
+    if (polygonalLightingEnabled) {
+        vboNormals.bind();
+        glEnableVertexAttribArray(polygonal->aNormal);
+        glVertexAttribPointer(polygonal->aNormal, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    }
 
-        postprocessing = new Postprocessing();
-        postprocessing->program = 0;
+    glDrawElements(GL_TRIANGLES, mesh->getNumberOfTriangles() * 3, GL_UNSIGNED_INT, 0);
 
-        // Load, create and link shaders
-        // Main program for render geometry with density to texture
-        density->program = new QOpenGLShaderProgram();
-        addShader(density->program, QOpenGLShader::Vertex, ":/vsDensity");
-        addShader(density->program, QOpenGLShader::Geometry, ":/gsDensity");
-        density->fragmentShader = new QOpenGLShader(QOpenGLShader::Fragment);
-        addShaderFromSource(density->program, density->fragmentShader, fsGenerator.generateFragmentShaderSourceCode(0));
-        linkProgram(density->program);
+    glDisableVertexAttribArray(polygonal->aColor);
+    if (polygonalLightingEnabled) {
+        glDisableVertexAttribArray(polygonal->aNormal);
+        vboNormals.release();
+    }
+    //glDisableVertexAttribArray(polygonal->aIndicesY);
+    //glDisableVertexAttribArray(polygonal->aIndicesX);
+    glDisableVertexAttribArray(polygonal->aPosition);
 
-        // Program for render silhouettes
-        silhouettes->program = new QOpenGLShaderProgram();
-        addShader(silhouettes->program, QOpenGLShader::Vertex, ":/vsSilhouettes");
-        addShader(silhouettes->program, QOpenGLShader::Geometry, ":/gsSilhouettes");
-        addShader(silhouettes->program, QOpenGLShader::Fragment, ":/fsSilhouettes");
-        linkProgram(silhouettes->program);
+    //vboComputeIndicesY.release();
+    //vboComputeIndicesX.release();
+    vboVerticesColors.release();
+    vboPositions.release();
 
-        // Program for computing coefficients and vertices
-        computing->program = new QOpenGLShaderProgram();
-        addShader(computing->program, QOpenGLShader::Vertex, ":/vsComputing");
-        addShader(computing->program, QOpenGLShader::Fragment, ":/fsComputing");
-        linkProgram(computing->program);
+    iboElementsTriangles.release();
 
-        // Program for rendering pyramid
-        pyramid->program = new QOpenGLShaderProgram();
-        addShader(pyramid->program, QOpenGLShader::Vertex, ":/vsPyramid");
-        addShader(pyramid->program, QOpenGLShader::Fragment, ":/fsPyramid");
-        linkProgram(pyramid->program);
+    glBindVertexArray(0);
 
-        // Program for render polygonal model
-        polygonal->program = new QOpenGLShaderProgram();
-        addShader(polygonal->program, QOpenGLShader::Vertex, ":/vsPolygonal");
-        //addShader(polygonal->program, QOpenGLShader::Geometry, ":/gsPolygonal");
-        addShader(polygonal->program, QOpenGLShader::Fragment, ":/fsPolygonal");
-        linkProgram(polygonal->program);
+    polygonal->program->release();
 
-        // Program for render final texture with textures
-        postprocessing->program = new QOpenGLShaderProgram();
-        addShader(postprocessing->program, QOpenGLShader::Vertex, ":/vsPostprocessing");
-        addShader(postprocessing->program, QOpenGLShader::Fragment, ":/fsPostprocessing");
-        linkProgram(postprocessing->program);
+    glEnable(GL_CULL_FACE);
+    //glDepthMask(GL_TRUE);
+    //glEnable(GL_DEPTH_TEST);
+    //glDisable(GL_MULTISAMPLE);
+    //glDisable(GL_BLEND);
 
-        // Program for render final quad with output texture
-        postprocessing->programSimple = new QOpenGLShaderProgram();
-        addShader(postprocessing->programSimple, QOpenGLShader::Vertex, ":/vsPostprocessingSimple");
-        addShader(postprocessing->programSimple, QOpenGLShader::Fragment, ":/fsPostprocessingSimple");
-        linkProgram(postprocessing->programSimple);
+    //debugTexture("renderPolygonal");
+    //QPixmap::fromImage(getCurrentImage()).save("test.png", "png", 100);
 
-        // Generate buffers
-        // Element buffer for tetrahedra
-        iboElementsTetrahedra = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
-        iboElementsTetrahedra.create();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
 
-        // Element buffer for triangles
-        iboElementsTriangles = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
-        iboElementsTriangles.create();
+/**
+ * @brief Renders given pyramid
+ * @param[in] pyramidObject Given pyramid object
+ */
+void MainRenderer::renderPyramid(SSIMRenderer::Pyramid pyramidObject)
+{
+    requirePrograms(PROGRAMS_PYRAMID);
 
-        // Color buffer for triangles
-        vboVerticesColors = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-        vboVerticesColors.create();
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toPyramid, 0);
+    setCropViewport();
 
-        // Element buffer for adjacent triangles
-        iboElementsTrianglesAdjacency = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
-        iboElementsTrianglesAdjacency.create();
+    //glEnable(GL_BLEND);
+    //glDisable(GL_BLEND);
+    //glDepthMask(GL_FALSE);
+    //glEnable(GL_MULTISAMPLE);
+    glDisable(GL_CULL_FACE);
 
-        // Vertex buffer
-        vboVertices = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-        vboVertices.create();
+    pyramid->program->bind();
+    pyramid->program->setUniformValue(pyramid->uMatrix, cropMatrix * perspectiveMatrix * cameraMatrix);
+    pyramid->program->setUniformValue(pyramid->uCorners, pyramidObject.getCorners());
+    pyramid->program->setUniformValue(pyramid->uEye, pyramidObject.getEye());
+    pyramid->program->setUniformValue(pyramid->uColor, pyramidObject.getColor());
 
-        vboNormals = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-        vboNormals.create();
+    //glDrawArrays(GL_LINE_LOOP, 0, 12);
 
-        //vboComputeIndicesX = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-        //vboComputeIndicesX.create();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, toPyramidImage);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, pyramidObject.getImage().width(), pyramidObject.getImage().height(), 0, GL_RGB, GL_UNSIGNED_BYTE, pyramidObject.getImage().bits());
+    pyramid->program->setUniformValue(pyramid->uTexture, 0);
+    pyramid->program->setUniformValue(pyramid->uColor, pyramidObject.getColor());
 
-        //vboComputeIndicesY = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-        //vboComputeIndicesY.create();
+    glBindVertexArray(vao);
+    //glDrawArrays(GL_LINE_STRIP, 0, 12);
+    glDrawArrays(GL_TRIANGLES, 12, 6);
+    glBindVertexArray(0);
 
-        // Coefficients texture buffer
-        glGenBuffers(1, &tboBerncoeffs);
-        glBindBuffer(GL_TEXTURE_BUFFER, tboBerncoeffs);
-        glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STATIC_DRAW);
-        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    pyramid->program->release();
 
-        // Texture for coefficients
-        glGenTextures(1, &toBerncoeffs);
-        glBindTexture(GL_TEXTURE_BUFFER, toBerncoeffs);
-        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboBerncoeffs);
-        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glEnable(GL_CULL_FACE);
+    //glDisable(GL_MULTISAMPLE);
+    //glDepthMask(GL_TRUE);
+    //glEnable(GL_BLEND);
+    //glDisable(GL_BLEND);
 
-        // Textures for computing - input
-        glGenTextures(1, &toCompCoeffs);
-        glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glBindTexture(GL_TEXTURE_2D, 0);
+    //debugTexture("renderPyramid");
 
-        glGenTextures(1, &toCompVertices);
-        glBindTexture(GL_TEXTURE_2D, toCompVertices);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
 
-        // T matrix texture buffer
-        glGenBuffers(1, &tboT);
-        glBindBuffer(GL_TEXTURE_BUFFER, tboT);
-        glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STATIC_DRAW);
-        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+/**
+ * @brief Renders postprocessing
+ */
+void MainRenderer::renderPostprocessing()
+{
+    requirePrograms(PROGRAMS_POSTPROCESSING);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fboOutput);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toOutput, 0);
 
-        // Texture for T matrix
-        glGenTextures(1, &toT);
-        glBindTexture(GL_TEXTURE_BUFFER, toT);
-        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboT);
-        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glViewport(0, 0, getCropWidth(), getCropHeight());
+    glScissor(0, 0, getCropWidth(), getCropHeight());
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-        // Pcs matrix texture buffer
-        glGenBuffers(1, &tboPcs);
-        glBindBuffer(GL_TEXTURE_BUFFER, tboPcs);
-        glBufferData(GL_TEXTURE_BUFFER, 0, 0, GL_STATIC_DRAW);
-        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBlendEquation(GL_FUNC_ADD);
 
-        // Texture for Pcs matrix
-        glGenTextures(1, &toPcs);
-        glBindTexture(GL_TEXTURE_BUFFER, toPcs);
-        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboPcs);
-        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    // Draw textures on quad
+    postprocessing->program->bind();
 
-        // Init attribute and uniform variables
-        getVariablesLocations();
-    }
+    float cropWidthR = (float) (getCropX() + getCropWidth()) / (float) getRenderWidth();
+    float cropHeightR = (float) (getCropY() + getCropHeight()) / (float) getRenderHeight();
+    float cropXR = (float) getCropX() / (float) getRenderWidth();
+    float cropYR = (float) getCropY() / (float) getRenderHeight();
 
-    // Textures for rendering
-    generateScreenTexture(&toDensity);
-    generateScreenTexture(&toSilhouettes);
-    generateScreenTexture(&toPyramid);
-    generateScreenTexture(&toPolygonal);
+    //qDebug() << cropWidthR << cropHeightR << cropXR << cropYR;
 
-    // Final textures
-    glGenTextures(1, &toOutput);
-    glBindTexture(GL_TEXTURE_2D, toOutput);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, getCropWidth(), getCropHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    QVector2D leftBottomCorner(cropXR, cropYR);
+    QVector2D rightTopCorner(cropWidthR, cropHeightR);
 
-    // Texture for pyramid image
-    glGenTextures(1, &toPyramidImage);
-    glBindTexture(GL_TEXTURE_2D, toPyramidImage);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, getRenderWidth(), getRenderHeight(), 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    postprocessing->program->setUniformValue(postprocessing->uLeftBottomCorner, leftBottomCorner);
+    postprocessing->program->setUniformValue(postprocessing->uRightTopCorner, rightTopCorner);
 
-    // Vertex Array Object
-    glGenVertexArrays(1, &vao);
+    //postprocessing->program->setUniformValue(postprocessing->uLeftBottomCorner, QVector2D(0.0f, 0.0f));
+    //postprocessing->program->setUniformValue(postprocessing->uRightTopCorner, QVector2D(1.0f, 1.0f));
 
-    // Helper framebuffers
-    glGenFramebuffers(1, &fbo);
-    glGenFramebuffers(1, &fboOutput);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    postprocessing->program->setUniformValue(postprocessing->uPostprocessingEnabled, postprocessingEnabled);
 
-    // Render depth buffer
-    glGenRenderbuffers(1, &rbo);
+    // Layer formats are per renderer, program is shared
+    postprocessing->program->setUniformValue(postprocessing->uDensityHasAlpha, hasAlphaChannel(densityFormat));
+    postprocessing->program->setUniformValue(postprocessing->uSilhouettesHasAlpha, hasAlphaChannel(silhouettesFormat));
 
-    // Render depth buffer
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, getRenderWidth(), getRenderHeight());
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    postprocessing->program->setUniformValue(postprocessing->uPyramidEnabled, pyramidEnabled);
+    if (pyramidEnabled) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, toPyramid);
+        postprocessing->program->setUniformValue(postprocessing->uPyramidTexture, 0);
+    }
 
-    // Check framebuffer
-    if (GLenum err = glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        qCritical() << "OpenGL framebuffer error" << QString::number(err);
+    postprocessing->program->setUniformValue(postprocessing->uDensityEnabled, densityEnabled);
+    if (densityEnabled) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, toDensity);
+        postprocessing->program->setUniformValue(postprocessing->uDensityTexture, 1);
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    postprocessing->program->setUniformValue(postprocessing->uPolygonalEnabled, polygonalEnabled);
+    if (polygonalEnabled) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, toPolygonal);
+        postprocessing->program->setUniformValue(postprocessing->uPolygonalTexture, 2);
+    }
 
-    // Framebuffer for computing
-    glGenFramebuffers(1, &fboComputing);
+    postprocessing->program->setUniformValue(postprocessing->uSilhouettesEnabled, silhouettesEnabled);
+    if (silhouettesEnabled) {
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, toSilhouettes);
+        postprocessing->program->setUniformValue(postprocessing->uSilhouettesTexture, 3);
+    }
 
-    // Settings
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glFrontFace(GL_CCW);
-    glClearColor(0, 0, 0, 0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
 
-    // Blending
-    //glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
-    //glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-    //glEnable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    postprocessing->program->release();
 
-    if (!hasSharedContext())
-        initUniformVariables();
-}
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
 
-/**
- * @brief Main render function
- */
-void MainRenderer::render()
-{
-    prepareRendering();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // Must be first!!! - depth culling
-    if (pyramidEnabled) renderPyramid(getPerspective());
-    if (densityEnabled) renderDensity();
-    if (polygonalEnabled) renderPolygonal();
-    if (silhouettesEnabled) renderSilhouettes();
+    if (isWindow()) {
+        glViewport(0, 0, getRenderWidth(), getRenderHeight());
+        glScissor(0, 0, getRenderWidth(), getRenderHeight());
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        // Draw output texture on screen
+        postprocessing->programSimple->bind();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, toOutput);
+        postprocessing->programSimple->setUniformValue(postprocessing->uOutputTexture, 0);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        postprocessing->programSimple->release();
+    }
 
-    renderPostprocessing();
+    //debugTexture(toOutput);
 }
 
 /**
- * @brief Renders density
+ * @brief Renders fused SSD of density layer and reference image
+ *
+ * The first pass stores squared differences summed over tiles of crop window,
+ * following passes reduce tiles until one value remains.
  */
-void MainRenderer::renderDensity()
+void MainRenderer::renderFusedSSD()
 {
-    if (!mesh) {
-        qWarning() << "MainRenderer::renderDensity warning: null Mesh";
+    toSSDResult = 0;
+
+    // Invalid state is logged only once, until it changes
+    if (!densityEnabled) {
+        if (!fusedSSDWarningLogged)
+            qWarning() << "MainRenderer::renderFusedSSD warning: density is disabled";
+        fusedSSDWarningLogged = true;
         return;
     }
 
-    if (mesh->getNumberOfTetrahedra() == 0) {
-        qWarning() << "MainRenderer::renderDensity warning: Tetrahedral mesh is not available";
+    if (referenceWidth != getCropWidth() || referenceHeight != getCropHeight()) {
+        if (!fusedSSDWarningLogged)
+            qCritical() << "MainRenderer::renderFusedSSD error: size of reference image is not same as crop window";
+        fusedSSDWarningLogged = true;
         return;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toDensity, 0);
+    fusedSSDWarningLogged = false;
 
-    //glDisable(GL_MULTISAMPLE);
-    glEnable(GL_BLEND);
-    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
-    glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
-    glDepthMask(GL_FALSE);
+    requirePrograms(PROGRAMS_FUSED_SSD);
 
-    // Drawing
-    density->program->bind();
-    // Set matrix to shader
-    density->program->setUniformValue(density->uMatrix, matrix);
-    density->program->setUniformValue(density->uMatrixInv, matrix.inverted());
+    GLuint width = (getCropWidth() + SSD_TILE_SIZE - 1) / SSD_TILE_SIZE;
+    GLuint height = (getCropHeight() + SSD_TILE_SIZE - 1) / SSD_TILE_SIZE;
 
-    glBindVertexArray(vao);
+    // Both tile textures have size of the first level
+    if (ssdTilesWidth != width || ssdTilesHeight != height) {
+        for (int i = 0; i < 2; i++) {
+            renderTargetPool->releaseTexture(toSSDTiles[i]);
+            toSSDTiles[i] = renderTargetPool->acquireTexture(GL_R32F, width, height);
+        }
+        ssdTilesWidth = width;
+        ssdTilesHeight = height;
+    }
 
-    iboElementsTetrahedra.bind();
+    glBindFramebuffer(GL_FRAMEBUFFER, fboOutput);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toSSDTiles[0], 0);
 
-    vboVertices.bind();
-    glEnableVertexAttribArray(density->aPosition);
-    glVertexAttribPointer(density->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    /*vboComputeIndicesX.bind();
-    glEnableVertexAttribArray(density->aIndicesX);
-    glVertexAttribIPointer(density->aIndicesX, 3, GL_UNSIGNED_INT, 0, 0);
-    vboComputeIndicesY.bind();
-    glEnableVertexAttribArray(density->aIndicesY);
-    glVertexAttribIPointer(density->aIndicesY, 3, GL_UNSIGNED_INT, 0, 0);*/
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glViewport(0, 0, width, height);
+
+    fusedSSD->program->bind();
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_BUFFER, toBerncoeffs);
-    density->program->setUniformValue(density->uBernCoeffs, 0);
+    glBindTexture(GL_TEXTURE_2D, toDensity);
+    fusedSSD->program->setUniformValue(fusedSSD->uDensityTexture, 0);
 
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
-    density->program->setUniformValue(density->uBernCoeffsDiff, 1);
+    glBindTexture(GL_TEXTURE_2D, toReference);
+    fusedSSD->program->setUniformValue(fusedSSD->uReferenceTexture, 1);
 
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, toCompVertices);
-    density->program->setUniformValue(density->uPositionDiff, 2);
+    glUniform2i(fusedSSD->uOffset, getCropX(), getCropY());
+    glUniform2i(fusedSSD->uSize, getCropWidth(), getCropHeight());
 
-    glDrawElements(GL_LINES_ADJACENCY, mesh->getNumberOfTetrahedra() * 4, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
 
     glBindTexture(GL_TEXTURE_2D, 0);
-    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    //glDisableVertexAttribArray(density->aIndicesY);
-    //glDisableVertexAttribArray(density->aIndicesX);
-    glDisableVertexAttribArray(density->aPosition);
+    fusedSSD->program->release();
 
-    //vboComputeIndicesY.release();
-    //vboComputeIndicesX.release();
-    vboVertices.release();
-    iboElementsTetrahedra.release();
+    // Reduction of partial sums (ping-pong)
+    int source = 0;
+    fusedSSD->programReduce->bind();
+    fusedSSD->programReduce->setUniformValue(fusedSSD->uInputTexture, 0);
+
+    while (width > 1 || height > 1) {
+        GLuint reducedWidth = (width + SSD_TILE_SIZE - 1) / SSD_TILE_SIZE;
+        GLuint reducedHeight = (height + SSD_TILE_SIZE - 1) / SSD_TILE_SIZE;
+
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toSSDTiles[1 - source], 0);
+        glViewport(0, 0, reducedWidth, reducedHeight);
+
+        glBindTexture(GL_TEXTURE_2D, toSSDTiles[source]);
+        glUniform2i(fusedSSD->uInputSize, width, height);
+
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        source = 1 - source;
+        width = reducedWidth;
+        height = reducedHeight;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+
+    fusedSSD->programReduce->release();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    toSSDResult = toSSDTiles[source];
+}
+
+/**
+ * @brief Renders density by ray marching of density volume
+ *
+ * Output has the same channels as renderDensity(), alpha is depth of first non-empty sample.
+ * Depth of pyramid is not tested.
+ */
+void MainRenderer::renderDensityVolume()
+{
+    requirePrograms(PROGRAMS_DENSITY_VOLUME);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toDensity, 0);
+    setCropViewport();
+
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+
+    densityVolume->program->bind();
+    densityVolume->program->setUniformValue(densityVolume->uMatrix, matrix);
+    densityVolume->program->setUniformValue(densityVolume->uMatrixInv, matrix.inverted());
+    densityVolume->program->setUniformValue(densityVolume->uViewport, QVector4D(getCropX(), getCropY(), getCropWidth(), getCropHeight()));
+    densityVolume->program->setUniformValue(densityVolume->uOrigin, densityVolume->origin);
+    densityVolume->program->setUniformValue(densityVolume->uVoxelSize, densityVolume->voxelSize);
+    densityVolume->program->setUniformValue(densityVolume->uXMirror, xMirroringEnabled);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, densityVolume->toVolume);
+    densityVolume->program->setUniformValue(densityVolume->uVolumeTexture, 0);
 
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_3D, densityVolume->toOccupancy);
+    densityVolume->program->setUniformValue(densityVolume->uOccupancyTexture, 1);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
 
-    density->program->release();
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_3D, 0);
 
-    //debugTexture("renderDensity");
+    densityVolume->program->release();
 
-    //glEnable(GL_MULTISAMPLE);
     glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 /**
- * @brief Renders silhouettes
+ * @brief Renders density of all batch poses to layers of batch texture
+ *
+ * Poses are drawn as instances, geometry shader selects matrices and output layer by instance id.
  */
-void MainRenderer::renderSilhouettes()
+void MainRenderer::renderDensityBatch()
 {
-    if (!mesh) {
-        qWarning() << "MainRenderer::renderSilhouettes warning: null Mesh";
-        return;
-    }
-
-    if (mesh->getNumberOfTrianglesAdjacency() == 0) {
-        qWarning() << "MainRenderer::renderSilhouettes warning: Triangles adjacency are not available";
+    if (mesh->getNumberOfTetrahedra() == 0) {
+        qWarning() << "MainRenderer::renderDensityBatch warning: Tetrahedral mesh is not available";
         return;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toSilhouettes, 0);
-
-    //glDisable(GL_BLEND);
-    //glEnable(GL_MULTISAMPLE);
-    //glDepthMask(GL_FALSE);
+    requirePrograms(PROGRAMS_DENSITY_BATCH);
 
-    silhouettes->program->bind();
-    // Set matrix to shader
-    silhouettes->program->setUniformValue(silhouettes->uMatrix, matrix);
+    glBindFramebuffer(GL_FRAMEBUFFER, fboBatch);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toBatch, 0);
 
-    glBindVertexArray(vao);
+    // Clear all layers
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, batchWidth, batchHeight);
+    glClear(GL_COLOR_BUFFER_BIT);
 
-    iboElementsTrianglesAdjacency.bind();
+    // Crop window is moved to the origin of every layer
+    glViewport(-GLint(getCropX()), -GLint(getCropY()), getRenderWidth(), getRenderHeight());
 
-    vboVertices.bind();
-    glEnableVertexAttribArray(silhouettes->aPosition);
-    glVertexAttribPointer(silhouettes->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    /*vboComputeIndicesX.bind();
-    glEnableVertexAttribArray(silhouettes->aIndicesX);
-    glVertexAttribIPointer(silhouettes->aIndicesX, 3, GL_UNSIGNED_INT, 0, 0);
-    vboComputeIndicesY.bind();
-    glEnableVertexAttribArray(silhouettes->aIndicesY);
-    glVertexAttribIPointer(silhouettes->aIndicesY, 3, GL_UNSIGNED_INT, 0, 0);*/
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+    glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+
+    densityBatch->program->bind();
+
+    glBindVertexArray(vao);
+
+    iboElementsTetrahedra.bind();
+
+    vboPositions.bind();
+    glEnableVertexAttribArray(densityBatch->aPosition);
+    glVertexAttribPointer(densityBatch->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, toCompVertices);
-    silhouettes->program->setUniformValue(silhouettes->uPositionDiff, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, toBerncoeffs);
+    densityBatch->program->setUniformValue(densityBatch->uBernCoeffs, 0);
 
-    glDrawElements(GL_TRIANGLES_ADJACENCY, mesh->getNumberOfTrianglesAdjacency() * 6, GL_UNSIGNED_INT, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
+    densityBatch->program->setUniformValue(densityBatch->uBernCoeffsDiff, 1);
+
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_BUFFER, toBatchMatrices);
+    densityBatch->program->setUniformValue(densityBatch->uMatrices, 3);
 
+    glDrawElementsInstanced(GL_LINES_ADJACENCY, mesh->getNumberOfTetrahedra() * 4, GL_UNSIGNED_INT, 0, batchSize);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
 
-    //glDisableVertexAttribArray(silhouettes->aIndicesY);
-    //glDisableVertexAttribArray(silhouettes->aIndicesX);
-    glDisableVertexAttribArray(silhouettes->aPosition);
+    glDisableVertexAttribArray(densityBatch->aPosition);
 
-    //vboComputeIndicesY.release();
-    //vboComputeIndicesX.release();
-    vboVertices.release();
-    iboElementsTrianglesAdjacency.release();
+    vboPositions.release();
+    iboElementsTetrahedra.release();
 
     glBindVertexArray(0);
 
-    silhouettes->program->release();
-
-    //glDepthMask(GL_TRUE);
-    //glDisable(GL_MULTISAMPLE);
-    //glEnable(GL_BLEND);
+    densityBatch->program->release();
 
-    //debugTexture("renderSilhouettes");
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 /**
- * @brief Renders polygonal
+ * @brief Prepares rendering
  */
-void MainRenderer::renderPolygonal()
+void MainRenderer::prepareRendering()
 {
-    if (!mesh) {
-        qWarning() << "MainRenderer::renderPolygonal warning: null Mesh";
-        return;
-    }
+    // Final matrix
+    prepareTransformation();
+    matrix = cropMatrix * perspectiveMatrix * cameraMatrix * translationMatrix * rotationMatrix;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toPolygonal, 0);
+    // Resize for current width and height
+    resizeTexturesAndRenderbuffer();
 
-    //glEnable(GL_BLEND);
-    //glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
-    //glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
-    //glBlendColor(0, 0, 0, 1);
-    //glEnable(GL_MULTISAMPLE);
-    //glDisable(GL_DEPTH_TEST);
-    //glDepthMask(GL_FALSE);
-    glDisable(GL_CULL_FACE);
+    recomputeStatisticalDataIfNeeded();
 
-    polygonal->program->bind();
-    // Set matrix to shader
-    polygonal->program->setUniformValue(polygonal->uMatrix, matrix);
-    polygonal->program->setUniformValue(polygonal->uNormalMatrix, (cameraMatrix * translationMatrix * rotationMatrix).normalMatrix());
+    // For every window the step can be different
+    setRelativeTextureStep();
 
-    glBindVertexArray(vao);
+    // Initialize framebuffer for rendering to texture
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    clearViewport();
 
-    iboElementsTriangles.bind();
+    if (pyramidEnabled) clearTexture(toPyramid);
+    if (densityEnabled) clearTexture(toDensity);
+    if (polygonalEnabled) clearTexture(toPolygonal);
+    if (silhouettesEnabled) clearTexture(toSilhouettes);
 
-    vboVertices.bind();
-    glEnableVertexAttribArray(polygonal->aPosition);
-    glVertexAttribPointer(polygonal->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    /*vboComputeIndicesX.bind();
-    glEnableVertexAttribArray(polygonal->aIndicesX);
-    glVertexAttribIPointer(polygonal->aIndicesX, 3, GL_UNSIGNED_INT, 0, 0);
-    vboComputeIndicesY.bind();
-    glEnableVertexAttribArray(polygonal->aIndicesY);
-    glVertexAttribIPointer(polygonal->aIndicesY, 3, GL_UNSIGNED_INT, 0, 0);*/
-    vboVerticesColors.bind();
-    glEnableVertexAttribArray(polygonal->aColor);
-    glVertexAttribPointer(polygonal->aColor, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    // Clear output texture
+    if (outputEnabled) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fboOutput);
+        clearTexture(toOutput);
+    }
 
-    if (polygonalLightingEnabled) {
-        vboNormals.bind();
-        glEnableVertexAttribArray(polygonal->aNormal);
-        glVertexAttribPointer(polygonal->aNormal, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    // Clear default viewport
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (isWindow()) {
+        clearViewport();
     }
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, toCompVertices);
-    polygonal->program->setUniformValue(polygonal->uPositionDiff, 0);
+/**
+ * @brief Clears viewport
+ */
+void MainRenderer::clearViewport()
+{
+    glEnable(GL_SCISSOR_TEST);
+    glViewport(0, 0, getRenderWidth(), getRenderHeight());
+    glScissor(getCropX(), getCropY(), getCropWidth(), getCropHeight());
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
 
-    glDrawElements(GL_TRIANGLES, mesh->getNumberOfTriangles() * 3, GL_UNSIGNED_INT, 0);
+/**
+ * @brief Sets viewport and scissor to crop window
+ *
+ * Together with crop sub-frustum (cropMatrix) only crop window is rasterized,
+ * pixels stay on the same positions as in whole frame.
+ */
+void MainRenderer::setCropViewport()
+{
+    glEnable(GL_SCISSOR_TEST);
+    glViewport(getCropX(), getCropY(), getCropWidth(), getCropHeight());
+    glScissor(getCropX(), getCropY(), getCropWidth(), getCropHeight());
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+/**
+ * @brief Clears texture
+ * @param[in] id Texture id
+ */
+void MainRenderer::clearTexture(GLuint id)
+{
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, id, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
 
-    glDisableVertexAttribArray(polygonal->aColor);
-    if (polygonalLightingEnabled) {
-        glDisableVertexAttribArray(polygonal->aNormal);
-        vboNormals.release();
-    }
-    //glDisableVertexAttribArray(polygonal->aIndicesY);
-    //glDisableVertexAttribArray(polygonal->aIndicesX);
-    glDisableVertexAttribArray(polygonal->aPosition);
+/**
+ * @brief Returns camera matrix
+ * @return Camera matrix
+ */
+QMatrix4x4 MainRenderer::getCameraMatrix()
+{
+    return cameraMatrix;
+}
 
-    //vboComputeIndicesY.release();
-    //vboComputeIndicesX.release();
-    vboVerticesColors.release();
-    vboVertices.release();
+/**
+ * @brief Returns perspective matrix
+ * @return Perspective matrix
+ */
+QMatrix4x4 MainRenderer::getPerspetiveMatrix()
+{
+    prepareTransformation();
+    return perspectiveMatrix;
+}
 
-    iboElementsTriangles.release();
+/**
+ * @brief Convert point to OpenGL relative position
+ * @param[in] point Point to convert
+ * @return Converted point
+ */
+QPointF MainRenderer::convertPointToOpenGLRelative(QPointF point)
+{
+    QPointF pointOutput;
+    pointOutput.setX((point.x() / (float) getRenderWidth() - 0.5f) * 2.0f);
+    pointOutput.setY((point.y() / (float) getRenderHeight() - 0.5f) * 2.0f);
+    return pointOutput;
+}
 
-    glBindVertexArray(0);
+/**
+ * @brief Creates bounding box vertex array
+ * @param[in] minVertex Min vertex
+ * @param[in] maxVertex Max vertex
+ * @param[out] verticesArray Output vertices array
+ *
+ * Unused.
+ */
+void MainRenderer::createBoundingBoxVertexArray(QVector3D minVertex, QVector3D maxVertex, GLfloat *verticesArray)
+{
+    verticesArray[0] = minVertex.x();
+    verticesArray[1] = minVertex.y();
+    verticesArray[2] = maxVertex.z();
 
-    polygonal->program->release();
+    verticesArray[3] = maxVertex.x();
+    verticesArray[4] = minVertex.y();
+    verticesArray[5] = maxVertex.z();
 
-    glEnable(GL_CULL_FACE);
-    //glDepthMask(GL_TRUE);
-    //glEnable(GL_DEPTH_TEST);
-    //glDisable(GL_MULTISAMPLE);
-    //glDisable(GL_BLEND);
+    verticesArray[6] = maxVertex.x();
+    verticesArray[7] = maxVertex.y();
+    verticesArray[8] = maxVertex.z();
 
-    //debugTexture("renderPolygonal");
-    //QPixmap::fromImage(getCurrentImage()).save("test.png", "png", 100);
+    verticesArray[9] = minVertex.x();
+    verticesArray[10] = maxVertex.y();
+    verticesArray[11] = maxVertex.z();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    verticesArray[12] = minVertex.x();
+    verticesArray[13] = minVertex.y();
+    verticesArray[14] = minVertex.z();
+
+    verticesArray[15] = maxVertex.x();
+    verticesArray[16] = minVertex.y();
+    verticesArray[17] = minVertex.z();
+
+    verticesArray[18] = maxVertex.x();
+    verticesArray[19] = maxVertex.y();
+    verticesArray[20] = minVertex.z();
+
+    verticesArray[21] = minVertex.x();
+    verticesArray[22] = maxVertex.y();
+    verticesArray[23] = minVertex.z();
 }
 
 /**
- * @brief Renders given pyramid
- * @param[in] pyramidObject Given pyramid object
+ * @brief Catches event and sets render width and height
+ * @param[in] event QEvent object
+ * @return True
  */
-void MainRenderer::renderPyramid(SSIMRenderer::Pyramid pyramidObject)
+bool MainRenderer::event(QEvent *event)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toPyramid, 0);
-
-    //glEnable(GL_BLEND);
-    //glDisable(GL_BLEND);
-    //glDepthMask(GL_FALSE);
-    //glEnable(GL_MULTISAMPLE);
-    glDisable(GL_CULL_FACE);
-
-    pyramid->program->bind();
-    pyramid->program->setUniformValue(pyramid->uMatrix, perspectiveMatrix * cameraMatrix);
-    pyramid->program->setUniformValue(pyramid->uCorners, pyramidObject.getCorners());
-    pyramid->program->setUniformValue(pyramid->uEye, pyramidObject.getEye());
-    pyramid->program->setUniformValue(pyramid->uColor, pyramidObject.getColor());
+    if (event->type() == QEvent::Resize) {
+        setRenderWidth(((QResizeEvent *) event)->size().width());
+        setRenderHeight(((QResizeEvent *) event)->size().height());
+    }
+    return true;
+}
 
-    //glDrawArrays(GL_LINE_LOOP, 0, 12);
+// Private stuff - make comments
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, toPyramidImage);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, pyramidObject.getImage().width(), pyramidObject.getImage().height(), 0, GL_RGB, GL_UNSIGNED_BYTE, pyramidObject.getImage().bits());
-    pyramid->program->setUniformValue(pyramid->uTexture, 0);
-    pyramid->program->setUniformValue(pyramid->uColor, pyramidObject.getColor());
+/**
+ * @brief MainRenderer::init
+ */
+void MainRenderer::init()
+{
+    densityEnabled = true;
+    postprocessingEnabled = true;
+    outputEnabled = true;
+    silhouettesEnabled = true;
+    pyramidEnabled = true;
+    polygonalEnabled = false;
+    xMirroringEnabled = false;
+    polygonalLightingEnabled = true;
+    densityVertexPullingEnabled = false;
+    densityLoopGeneratorEnabled = false;
 
-    glBindVertexArray(vao);
-    //glDrawArrays(GL_LINE_STRIP, 0, 12);
-    glDrawArrays(GL_TRIANGLES, 12, 6);
-    glBindVertexArray(0);
+    densityFormat = GL_RGBA32F;
+    silhouettesFormat = GL_RGBA32F;
+    polygonalFormat = GL_RGBA32F;
+    pyramidFormat = GL_RGBA32F;
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    pyramid->program->release();
+    mesh = 0;
+    lastBernCoeffsCount = 0;
 
-    glEnable(GL_CULL_FACE);
-    //glDisable(GL_MULTISAMPLE);
-    //glDepthMask(GL_TRUE);
-    //glEnable(GL_BLEND);
-    //glDisable(GL_BLEND);
+    builtPrograms = 0;
+    densityShadersCoeffsCount = 0;
+    densityShadersLoop = false;
 
-    //debugTexture("renderPyramid");
+    verticesStatisticalData = 0;
+    cpuReconstructionEnabled = false;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-}
+    cWidth = 0;
+    cHeight = 0;
 
-/**
- * @brief Renders postprocessing
- */
-void MainRenderer::renderPostprocessing()
-{
-    glBindFramebuffer(GL_FRAMEBUFFER, fboOutput);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toOutput, 0);
+    maxBatchSize = 0;
+    batchSize = 0;
+    batchWidth = 0;
+    batchHeight = 0;
+
+    basisSize = 0;
+    basisWidth = 0;
+    basisHeight = 0;
+    basisShapeGeneration = -1;
+    basisXMirroring = false;
+    referenceWidth = 0;
+    referenceHeight = 0;
+    ssdTilesWidth = 0;
+    ssdTilesHeight = 0;
+    fusedSSDEnabled = false;
+    fusedSSDWarningLogged = false;
+    toSSDTiles[0] = 0;
+    toSSDTiles[1] = 0;
+    toSSDResult = 0;
+    basisHeight = 0;
+
+    densityVolumeVoxelSize = 0.0f;
+    densityVolumeEnabled = false;
+
+    drawnTetrahedra = 0;
+    densityCullingEnabled = false;
+    densityRangesGeneration = -1;
+    densityRangesXMirroring = false;
+    densityRangesCulling = false;
+
+    lastReadbackHandle = 0;
+    readbackWidth = 0;
+    readbackHeight = 0;
 
-    glViewport(0, 0, getCropWidth(), getCropHeight());
-    glScissor(0, 0, getCropWidth(), getCropHeight());
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    renderWidth = 1;
+    renderHeight = 1;
+    cropX = 0;
+    cropY = 0;
+    cropWidth = 1;
+    cropHeight = 1;
+    ratio = 1;
+    step.setX(1);
+    step.setY(1);
+    sizeChanged = true;
+    cropSizeChanged = true;
+    renderTargetPool = 0;
+    rbo = 0;
+    toDensity = 0;
+    toSilhouettes = 0;
+    toPyramid = 0;
+    toPolygonal = 0;
+    toOutput = 0;
+    toReadback = 0;
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glBlendEquation(GL_FUNC_ADD);
+    intensity = 0.5f;
+    lineWidth = 0.005f;
+    param = 1.0f;
 
-    // Draw textures on quad
-    postprocessing->program->bind();
+    flagShareTransformations = true;
+    //flagShareRenderSettings = true;
 
-    float cropWidthR = (float) (getCropX() + getCropWidth()) / (float) getRenderWidth();
-    float cropHeightR = (float) (getCropY() + getCropHeight()) / (float) getRenderHeight();
-    float cropXR = (float) getCropX() / (float) getRenderWidth();
-    float cropYR = (float) getCropY() / (float) getRenderHeight();
+    recomputeCoefficientsDiffFlag = false;
+    recomputeVerticesDiffFlag = false;
+    recomputePositionsFlag = false;
 
-    //qDebug() << cropWidthR << cropHeightR << cropXR << cropYR;
+    matrix.setToIdentity();
+    perspectiveMatrix.setToIdentity();
+    cropMatrix.setToIdentity();
+    cameraMatrix.setToIdentity();
+    translationMatrix.setToIdentity();
+    rotationMatrix.setToIdentity();
 
-    QVector2D leftBottomCorner(cropXR, cropYR);
-    QVector2D rightTopCorner(cropWidthR, cropHeightR);
+    setCamera(perspective);
 
-    postprocessing->program->setUniformValue(postprocessing->uLeftBottomCorner, leftBottomCorner);
-    postprocessing->program->setUniformValue(postprocessing->uRightTopCorner, rightTopCorner);
+    maxTextureOrRenderSize[0] = 0;
+    maxTextureOrRenderSize[1] = 0;
+}
 
-    //postprocessing->program->setUniformValue(postprocessing->uLeftBottomCorner, QVector2D(0.0f, 0.0f));
-    //postprocessing->program->setUniformValue(postprocessing->uRightTopCorner, QVector2D(1.0f, 1.0f));
+/**
+ * @brief MainRenderer::getVariablesLocations
+ */
+void MainRenderer::getVariablesLocations()
+{
+    // Density
+    if (builtPrograms & PROGRAMS_DENSITY) {
+        density->aPosition = density->program->attributeLocation("aPosition");
+        //density->aIndicesX = density->program->attributeLocation("aIndicesX");
+        //density->aIndicesY = density->program->attributeLocation("aIndicesY");
+        density->uParam = density->program->uniformLocation("uParam");
+        density->uMatrix = density->program->uniformLocation("uMatrix");
+        density->uMatrixInv = density->program->uniformLocation("uMatrixInv");
+        density->uBernCoeffs = density->program->uniformLocation("uBernCoeffs");
+        density->uBernCoeffsDiff = density->program->uniformLocation("uBernCoeffsDiff");
+        density->uPositionDiffLengthMinus1 = density->program->uniformLocation("uPositionDiffLengthMinus1");
+        density->uPositionDiffLengthLog2 = density->program->uniformLocation("uPositionDiffLengthLog2");
+        density->uXMirror = density->program->uniformLocation("uXMirror");
+        density->uPrimitiveOffset = density->program->uniformLocation("uPrimitiveOffset");
+        density->uBoundsPositions = density->programBounds->uniformLocation("uPositions");
+        density->uBoundsElements = density->programBounds->uniformLocation("uElements");
+        density->uBoundsClusterSize = density->programBounds->uniformLocation("uClusterSize");
+        density->uBoundsNumberOfTetrahedra = density->programBounds->uniformLocation("uNumberOfTetrahedra");
+    }
 
-    postprocessing->program->setUniformValue(postprocessing->uPostprocessingEnabled, postprocessingEnabled);
+    // Density batch
+    if (builtPrograms & PROGRAMS_DENSITY_BATCH) {
+        densityBatch->aPosition = densityBatch->program->attributeLocation("aPosition");
+        densityBatch->uMatrices = densityBatch->program->uniformLocation("uMatrices");
+        densityBatch->uBernCoeffs = densityBatch->program->uniformLocation("uBernCoeffs");
+        densityBatch->uBernCoeffsDiff = densityBatch->program->uniformLocation("uBernCoeffsDiff");
+        densityBatch->uPositionDiffLengthMinus1 = densityBatch->program->uniformLocation("uPositionDiffLengthMinus1");
+        densityBatch->uPositionDiffLengthLog2 = densityBatch->program->uniformLocation("uPositionDiffLengthLog2");
+        densityBatch->uXMirror = densityBatch->program->uniformLocation("uXMirror");
+    }
 
-    postprocessing->program->setUniformValue(postprocessing->uPyramidEnabled, pyramidEnabled);
-    if (pyramidEnabled) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, toPyramid);
-        postprocessing->program->setUniformValue(postprocessing->uPyramidTexture, 0);
+    // Fused SSD
+    if (builtPrograms & PROGRAMS_FUSED_SSD) {
+        fusedSSD->uDensityTexture = fusedSSD->program->uniformLocation("uDensityTexture");
+        fusedSSD->uReferenceTexture = fusedSSD->program->uniformLocation("uReferenceTexture");
+        fusedSSD->uOffset = fusedSSD->program->uniformLocation("uOffset");
+        fusedSSD->uSize = fusedSSD->program->uniformLocation("uSize");
+        fusedSSD->uInputTexture = fusedSSD->programReduce->uniformLocation("uInputTexture");
+        fusedSSD->uInputSize = fusedSSD->programReduce->uniformLocation("uInputSize");
     }
 
-    postprocessing->program->setUniformValue(postprocessing->uDensityEnabled, densityEnabled);
-    if (densityEnabled) {
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, toDensity);
-        postprocessing->program->setUniformValue(postprocessing->uDensityTexture, 1);
+    // Density by vertex pulling
+    if (builtPrograms & PROGRAMS_DENSITY_PULLING) {
+        densityPulling->uMatrix = densityPulling->program->uniformLocation("uMatrix");
+        densityPulling->uMatrixInv = densityPulling->program->uniformLocation("uMatrixInv");
+        densityPulling->uPositions = densityPulling->program->uniformLocation("uPositions");
+        densityPulling->uElements = densityPulling->program->uniformLocation("uElements");
+        densityPulling->uTetrahedraInverse = densityPulling->program->uniformLocation("uTetrahedraInverse");
+        densityPulling->uBernCoeffs = densityPulling->program->uniformLocation("uBernCoeffs");
+        densityPulling->uBernCoeffsDiff = densityPulling->program->uniformLocation("uBernCoeffsDiff");
+        densityPulling->uPositionDiffLengthMinus1 = densityPulling->program->uniformLocation("uPositionDiffLengthMinus1");
+        densityPulling->uPositionDiffLengthLog2 = densityPulling->program->uniformLocation("uPositionDiffLengthLog2");
+        densityPulling->uParam = densityPulling->program->uniformLocation("uParam");
+        densityPulling->uXMirror = densityPulling->program->uniformLocation("uXMirror");
+        densityPulling->uInstanceOffset = densityPulling->program->uniformLocation("uInstanceOffset");
+        densityPulling->uInversePositions = densityPulling->programInverse->uniformLocation("uPositions");
+        densityPulling->uInverseElements = densityPulling->programInverse->uniformLocation("uElements");
     }
 
-    postprocessing->program->setUniformValue(postprocessing->uPolygonalEnabled, polygonalEnabled);
-    if (polygonalEnabled) {
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, toPolygonal);
-        postprocessing->program->setUniformValue(postprocessing->uPolygonalTexture, 2);
+    // Density volume
+    if (builtPrograms & PROGRAMS_DENSITY_VOLUME) {
+        densityVolume->aPosition = densityVolume->programBake->attributeLocation("aPosition");
+        densityVolume->uSliceMatrix = densityVolume->programBake->uniformLocation("uSliceMatrix");
+        densityVolume->uSliceZ = densityVolume->programBake->uniformLocation("uSliceZ");
+        densityVolume->uBernCoeffs = densityVolume->programBake->uniformLocation("uBernCoeffs");
+        densityVolume->uBernCoeffsDiff = densityVolume->programBake->uniformLocation("uBernCoeffsDiff");
+        densityVolume->uPositionDiffLengthMinus1 = densityVolume->programBake->uniformLocation("uPositionDiffLengthMinus1");
+        densityVolume->uPositionDiffLengthLog2 = densityVolume->programBake->uniformLocation("uPositionDiffLengthLog2");
+        densityVolume->uBakeXMirror = densityVolume->programBake->uniformLocation("uXMirror");
+        densityVolume->uOccupancyVolumeTexture = densityVolume->programOccupancy->uniformLocation("uVolumeTexture");
+        densityVolume->uOccupancyLayer = densityVolume->programOccupancy->uniformLocation("uLayer");
+        densityVolume->uVolumeTexture = densityVolume->program->uniformLocation("uVolumeTexture");
+        densityVolume->uOccupancyTexture = densityVolume->program->uniformLocation("uOccupancyTexture");
+        densityVolume->uMatrix = densityVolume->program->uniformLocation("uMatrix");
+        densityVolume->uMatrixInv = densityVolume->program->uniformLocation("uMatrixInv");
+        densityVolume->uViewport = densityVolume->program->uniformLocation("uViewport");
+        densityVolume->uOrigin = densityVolume->program->uniformLocation("uOrigin");
+        densityVolume->uVoxelSize = densityVolume->program->uniformLocation("uVoxelSize");
+        densityVolume->uXMirror = densityVolume->program->uniformLocation("uXMirror");
     }
 
-    postprocessing->program->setUniformValue(postprocessing->uSilhouettesEnabled, silhouettesEnabled);
-    if (silhouettesEnabled) {
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, toSilhouettes);
-        postprocessing->program->setUniformValue(postprocessing->uSilhouettesTexture, 3);
+    // Density basis
+    if (builtPrograms & PROGRAMS_DENSITY_BASIS) {
+        densityBasis->uBasisTexture = densityBasis->program->uniformLocation("uBasisTexture");
+        densityBasis->uWeights = densityBasis->program->uniformLocation("uWeights");
     }
 
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    // Silhouettes
+    if (builtPrograms & PROGRAMS_SILHOUETTES) {
+        silhouettes->aPosition = silhouettes->program->attributeLocation("aPosition");
+        //silhouettes->aIndicesX = silhouettes->program->attributeLocation("aIndicesX");
+        //silhouettes->aIndicesY = silhouettes->program->attributeLocation("aIndicesY");
+        silhouettes->uMatrix = silhouettes->program->uniformLocation("uMatrix");
+        silhouettes->uAreaScale = silhouettes->program->uniformLocation("uAreaScale");
+        silhouettes->uCoverageOnly = silhouettes->program->uniformLocation("uCoverageOnly");
+        silhouettes->uXMirror = silhouettes->program->uniformLocation("uXMirror");
+    }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    postprocessing->program->release();
+    // Computing
+    if (builtPrograms & PROGRAMS_COMPUTING) {
+        computing->uT = computing->program->uniformLocation("uT");
+        computing->uPcs = computing->program->uniformLocation("uPcs");
+        computing->uWidth = computing->program->uniformLocation("uWidth");
+        computing->uHeight = computing->program->uniformLocation("uHeight");
+        computing->uDeltaT = computing->programDelta->uniformLocation("uT");
+        computing->uDeltaModes = computing->programDelta->uniformLocation("uModes");
+        computing->uDeltaValues = computing->programDelta->uniformLocation("uDeltas");
+        computing->uDeltaCount = computing->programDelta->uniformLocation("uCount");
+        computing->uDeltaNumberOfParameters = computing->programDelta->uniformLocation("uNumberOfParameters");
+        computing->uDeltaWidth = computing->programDelta->uniformLocation("uWidth");
+        computing->uDeltaHeight = computing->programDelta->uniformLocation("uHeight");
+    }
 
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
+    // Positions
+    if (builtPrograms & PROGRAMS_COMPUTING) {
+        positions->aPosition = positions->program->attributeLocation("aPosition");
+        positions->uPositionDiff = positions->program->uniformLocation("uPositionDiff");
+        positions->uPositionDiffLengthMinus1 = positions->program->uniformLocation("uPositionDiffLengthMinus1");
+        positions->uPositionDiffLengthLog2 = positions->program->uniformLocation("uPositionDiffLengthLog2");
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Pyramid
+    if (builtPrograms & PROGRAMS_PYRAMID) {
+        pyramid->uMatrix = pyramid->program->uniformLocation("uMatrix");
+        pyramid->uCorners = pyramid->program->uniformLocation("uCorners");
+        pyramid->uEye = pyramid->program->uniformLocation("uEye");
+        pyramid->uColor = pyramid->program->uniformLocation("uColor");
+        pyramid->uTexture = pyramid->program->uniformLocation("uTexture");
+    }
 
-    if (isWindow()) {
-        glViewport(0, 0, getRenderWidth(), getRenderHeight());
-        glScissor(0, 0, getRenderWidth(), getRenderHeight());
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-        // Draw output texture on screen
-        postprocessing->programSimple->bind();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, toOutput);
-        postprocessing->programSimple->setUniformValue(postprocessing->uOutputTexture, 0);
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        postprocessing->programSimple->release();
+    // Polygonal
+    if (builtPrograms & PROGRAMS_POLYGONAL) {
+        polygonal->aPosition = polygonal->program->attributeLocation("aPosition");
+        //polygonal->aIndicesX = polygonal->program->attributeLocation("aIndicesX");
+        //polygonal->aIndicesY = polygonal->program->attributeLocation("aIndicesY");
+        polygonal->aColor = polygonal->program->attributeLocation("aColor");
+        polygonal->aNormal = polygonal->program->attributeLocation("aNormal");
+        polygonal->uMatrix = polygonal->program->uniformLocation("uMatrix");
+        polygonal->uNormalMatrix = polygonal->program->uniformLocation("uNormalMatrix");
+        polygonal->uXMirror = polygonal->program->uniformLocation("uXMirror");
+        polygonal->uLightingEnabled = polygonal->program->uniformLocation("uLightingEnabled");
     }
 
-    //debugTexture(toOutput);
+    // Post-processing
+    if (builtPrograms & PROGRAMS_POSTPROCESSING) {
+        postprocessing->uDensityTexture = postprocessing->program->uniformLocation("uDensityTexture");
+        postprocessing->uSilhouettesTexture = postprocessing->program->uniformLocation("uSilhouettesTexture");
+        postprocessing->uPolygonalTexture = postprocessing->program->uniformLocation("uPolygonalTexture");
+        postprocessing->uPyramidTexture = postprocessing->program->uniformLocation("uPyramidTexture");
+        postprocessing->uIntensity = postprocessing->program->uniformLocation("uIntensity");
+        postprocessing->uLineWidth = postprocessing->program->uniformLocation("uLineWidth");
+        postprocessing->uTextureStep = postprocessing->program->uniformLocation("uTextureStep");
+
+        postprocessing->uDensityEnabled = postprocessing->program->uniformLocation("uDensityEnabled");
+        postprocessing->uDensityHasAlpha = postprocessing->program->uniformLocation("uDensityHasAlpha");
+        postprocessing->uSilhouettesHasAlpha = postprocessing->program->uniformLocation("uSilhouettesHasAlpha");
+        postprocessing->uSilhouettesEnabled = postprocessing->program->uniformLocation("uSilhouettesEnabled");
+        postprocessing->uPolygonalEnabled = postprocessing->program->uniformLocation("uPolygonalEnabled");
+        postprocessing->uPyramidEnabled = postprocessing->program->uniformLocation("uPyramidEnabled");
+        postprocessing->uPostprocessingEnabled = postprocessing->program->uniformLocation("uPostprocessingEnabled");
+
+        postprocessing->uLeftBottomCorner = postprocessing->program->uniformLocation("uLeftBottomCorner");
+        postprocessing->uRightTopCorner = postprocessing->program->uniformLocation("uRightTopCorner");
+
+        postprocessing->uOutputTexture = postprocessing->programSimple->uniformLocation("uOutputTexture");
+    }
 }
 
 /**
- * @brief Prepares rendering
+ * @brief Regenerates fragment shaders of density programs for number of coefficients
+ * @param[in] bernCoeffsCount Number of Bernstein coefficients per tetrahedron
+ *
+ * From DENSITY_LOOP_MIN_DEGREE (or always if loop generator is enabled) compact loop
+ * shaders are generated and their weights are uploaded to uniform buffer. Unrolled
+ * shaders are used if the uniform block does not fit to GL_MAX_UNIFORM_BLOCK_SIZE.
  */
-void MainRenderer::prepareRendering()
+void MainRenderer::updateDensityPrograms(int bernCoeffsCount)
 {
-    // Final matrix
-    prepareTransformation();
-    matrix = perspectiveMatrix * cameraMatrix * translationMatrix * rotationMatrix;
+    int degree = fsGenerator.degreeFromCoeffsCount(bernCoeffsCount);
+    bool loop = densityLoopGeneratorEnabled || degree >= DENSITY_LOOP_MIN_DEGREE;
+
+    if (loop) {
+        QVector<unsigned int> weights = fsGenerator.generateLoopWeightsData(bernCoeffsCount);
+        GLint maxUniformBlockSize = 0;
+        glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxUniformBlockSize);
+        if (weights.isEmpty() || GLint(sizeof(GLuint) * weights.size()) > maxUniformBlockSize) {
+            qWarning() << "Loop density fragment shader is not available for degree" << degree << "- unrolled shader is used";
+            loop = false;
+        } else {
+            glBindBuffer(GL_UNIFORM_BUFFER, uboBernsteinWeights);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(GLuint) * weights.size(), weights.constData(), GL_STATIC_DRAW);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+    }
 
-    // Resize for current width and height
-    if (sizeChanged)
-        resizeTexturesAndRenderbuffer();
-    sizeChanged = false;
+    densityShadersCoeffsCount = bernCoeffsCount;
+    densityShadersLoop = loop;
 
-    recomputeStatisticalDataIfNeeded();
+    // Programs not built yet get new fragment shader on first use
+    if (builtPrograms & PROGRAMS_DENSITY) {
+        removeShader(density->program, density->fragmentShader);
+        linkDensityProgram(density->program, density->fragmentShader, false);
+    }
 
-    // For every window the step can be different
-    setRelativeTextureStep();
+    if (builtPrograms & PROGRAMS_DENSITY_BATCH) {
+        removeShader(densityBatch->program, densityBatch->fragmentShader);
+        linkDensityProgram(densityBatch->program, densityBatch->fragmentShader, false);
+    }
 
-    // Initialize framebuffer for rendering to texture
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    clearViewport();
+    if (builtPrograms & PROGRAMS_DENSITY_PULLING) {
+        removeShader(densityPulling->program, densityPulling->fragmentShader);
+        linkDensityProgram(densityPulling->program, densityPulling->fragmentShader, true);
+    }
 
-    if (pyramidEnabled) clearTexture(toPyramid);
-    if (densityEnabled) clearTexture(toDensity);
-    if (polygonalEnabled) clearTexture(toPolygonal);
-    if (silhouettesEnabled) clearTexture(toSilhouettes);
+    if (builtPrograms & PROGRAMS_DENSITY_VOLUME) {
+        removeShader(densityVolume->programBake, densityVolume->fragmentShader);
+        linkDensityVolumeProgram();
+    }
 
-    // Clear output texture
-    glBindFramebuffer(GL_FRAMEBUFFER, fboOutput);
-    clearTexture(toOutput);
+    getVariablesLocations();
+    initUniformVariables();
+}
 
-    // Clear default viewport
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    if (isWindow()) {
-        clearViewport();
-    }
+/**
+ * @brief Adds generated fragment shader of density for current coefficients and links program
+ * @param[in, out] program Density shader program
+ * @param[in, out] fragmentShader Fragment shader of program
+ * @param[in] vertexPulling Is program for vertex pulling path?
+ */
+void MainRenderer::linkDensityProgram(QOpenGLShaderProgram *program, QOpenGLShader *fragmentShader, bool vertexPulling)
+{
+    int coeffsCount = densityShadersCoeffsCount;
+    QString source;
+    if (vertexPulling)
+        source = fsGenerator.generateVertexPullingFragmentShaderSourceCode(coeffsCount, densityShadersLoop);
+    else if (densityShadersLoop)
+        source = fsGenerator.generateLoopFragmentShaderSourceCode(coeffsCount);
+    else
+        source = fsGenerator.generateFragmentShaderSourceCode(coeffsCount);
+
+    addShaderFromSource(program, fragmentShader, source);
+    linkProgram(program, coeffsCount > 0 ? fsGenerator.degreeFromCoeffsCount(coeffsCount) : -1);
 }
 
 /**
- * @brief Clears viewport
+ * @brief Adds generated fragment shader of density volume baking for current coefficients and links program
+ *
+ * Point density is always unrolled, it has only one term per coefficient.
  */
-void MainRenderer::clearViewport()
+void MainRenderer::linkDensityVolumeProgram()
 {
-    glEnable(GL_SCISSOR_TEST);
-    glViewport(0, 0, getRenderWidth(), getRenderHeight());
-    glScissor(getCropX(), getCropY(), getCropWidth(), getCropHeight());
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    int coeffsCount = densityShadersCoeffsCount;
+    addShaderFromSource(densityVolume->programBake, densityVolume->fragmentShader, fsGenerator.generateVolumeFragmentShaderSourceCode(coeffsCount));
+    linkProgram(densityVolume->programBake, coeffsCount > 0 ? fsGenerator.degreeFromCoeffsCount(coeffsCount) : -1);
 }
 
 /**
- * @brief Clears texture
- * @param[in] id Texture id
+ * @brief Builds groups of shader programs which are not built yet
+ * @param[in] programs Groups of programs (Programs flags)
+ *
+ * Programs are shared, renderers with shared context let main context build them.
  */
-void MainRenderer::clearTexture(GLuint id)
+void MainRenderer::requirePrograms(int programs)
 {
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, id, 0);
-    glClear(GL_COLOR_BUFFER_BIT);
+    MainRenderer *mainRenderer = hasSharedContext() ? (MainRenderer *) getParentOpenGLWrapper() : this;
+
+    if ((mainRenderer->builtPrograms & programs) == programs)
+        return;
+
+    mainRenderer->buildPrograms(programs);
+
+    // Building switched current context to main context
+    if (mainRenderer != this)
+        if (!checkInitAndMakeCurrentContext())
+            return;
 }
 
 /**
- * @brief Returns camera matrix
- * @return Camera matrix
+ * @brief Are groups of shader programs built?
+ * @param[in] programs Groups of programs (Programs flags)
+ * @return True if all groups are built
  */
-QMatrix4x4 MainRenderer::getCameraMatrix()
+bool MainRenderer::hasPrograms(int programs)
 {
-    return cameraMatrix;
+    MainRenderer *mainRenderer = hasSharedContext() ? (MainRenderer *) getParentOpenGLWrapper() : this;
+    return (mainRenderer->builtPrograms & programs) == programs;
+}
+
+/**
+ * @brief Loads, compiles and links groups of shader programs
+ * @param[in] programs Groups of programs (Programs flags)
+ *
+ * Called in main context only. Locations and uniform values of all built programs
+ * are set again.
+ */
+void MainRenderer::buildPrograms(int programs)
+{
+    if (!checkInitAndMakeCurrentContext())
+        return;
+
+    programs &= PROGRAMS_ALL & ~builtPrograms;
+    if (!programs)
+        return;
+
+    // Main program for render geometry with density to texture
+    if (programs & PROGRAMS_DENSITY) {
+        density->program = new QOpenGLShaderProgram();
+        addShader(density->program, QOpenGLShader::Vertex, ":/vsDensity");
+        addShader(density->program, QOpenGLShader::Geometry, ":/gsDensity");
+        density->fragmentShader = new QOpenGLShader(QOpenGLShader::Fragment);
+        linkDensityProgram(density->program, density->fragmentShader, false);
+
+        // Program for bounding boxes of clusters of tetrahedra, output is captured by transform feedback
+        density->programBounds = new QOpenGLShaderProgram();
+        addShader(density->programBounds, QOpenGLShader::Vertex, ":/vsDensityClusterBounds");
+        const GLchar *boundsVaryings[] = {"vBoundsMin", "vBoundsMax"};
+        glTransformFeedbackVaryings(density->programBounds->programId(), 2, boundsVaryings, GL_INTERLEAVED_ATTRIBS);
+        linkProgram(density->programBounds);
+    }
+
+    // Program for render density of multiple poses to layers
+    if (programs & PROGRAMS_DENSITY_BATCH) {
+        densityBatch->program = new QOpenGLShaderProgram();
+        addShader(densityBatch->program, QOpenGLShader::Vertex, ":/vsDensityBatch");
+        addShader(densityBatch->program, QOpenGLShader::Geometry, ":/gsDensityBatch");
+        densityBatch->fragmentShader = new QOpenGLShader(QOpenGLShader::Fragment);
+        linkDensityProgram(densityBatch->program, densityBatch->fragmentShader, false);
+    }
+
+    if (programs & PROGRAMS_DENSITY_PULLING) {
+        // Program for render density by vertex pulling
+        densityPulling->program = new QOpenGLShaderProgram();
+        addShader(densityPulling->program, QOpenGLShader::Vertex, ":/vsDensityPulling");
+        densityPulling->fragmentShader = new QOpenGLShader(QOpenGLShader::Fragment);
+        linkDensityProgram(densityPulling->program, densityPulling->fragmentShader, true);
+
+        // Program for inverse matrices of tetrahedra, output is captured by transform feedback
+        densityPulling->programInverse = new QOpenGLShaderProgram();
+        addShader(densityPulling->programInverse, QOpenGLShader::Vertex, ":/vsTetrahedraInverse");
+        const GLchar *inverseVaryings[] = {"vInverse0", "vInverse1", "vInverse2", "vInverse3"};
+        glTransformFeedbackVaryings(densityPulling->programInverse->programId(), 4, inverseVaryings, GL_INTERLEAVED_ATTRIBS);
+        linkProgram(densityPulling->programInverse);
+    }
+
+    // Program for composing density from basis images
+    if (programs & PROGRAMS_DENSITY_BASIS) {
+        densityBasis->program = new QOpenGLShaderProgram();
+        addShader(densityBasis->program, QOpenGLShader::Vertex, ":/vsPostprocessingSimple");
+        addShader(densityBasis->program, QOpenGLShader::Fragment, ":/fsDensityBasis");
+        linkProgram(densityBasis->program);
+    }
+
+    // Program for render silhouettes
+    if (programs & PROGRAMS_SILHOUETTES) {
+        silhouettes->program = new QOpenGLShaderProgram();
+        addShader(silhouettes->program, QOpenGLShader::Vertex, ":/vsSilhouettes");
+        addShader(silhouettes->program, QOpenGLShader::Geometry, ":/gsSilhouettes");
+        addShader(silhouettes->program, QOpenGLShader::Fragment, ":/fsSilhouettes");
+        linkProgram(silhouettes->program);
+    }
+
+    if (programs & PROGRAMS_COMPUTING) {
+        // Program for computing coefficients and vertices
+        computing->program = new QOpenGLShaderProgram();
+        addShader(computing->program, QOpenGLShader::Vertex, ":/vsComputing");
+        addShader(computing->program, QOpenGLShader::Fragment, ":/fsComputing");
+        linkProgram(computing->program);
+
+        // Program for incremental update of coefficients and vertices
+        computing->programDelta = new QOpenGLShaderProgram();
+        addShader(computing->programDelta, QOpenGLShader::Vertex, ":/vsComputing");
+        addShader(computing->programDelta, QOpenGLShader::Fragment, ":/fsComputingDelta", QString("#define MAX_DELTA_MODES %1\n").arg(MAX_DELTA_MODES));
+        linkProgram(computing->programDelta);
+
+        // Program for final vertex positions, output is captured by transform feedback
+        positions->program = new QOpenGLShaderProgram();
+        addShader(positions->program, QOpenGLShader::Vertex, ":/vsPositions");
+        const GLchar *positionsVaryings[] = {"vPosition"};
+        glTransformFeedbackVaryings(positions->program->programId(), 1, positionsVaryings, GL_INTERLEAVED_ATTRIBS);
+        linkProgram(positions->program);
+    }
+
+    // Program for rendering pyramid
+    if (programs & PROGRAMS_PYRAMID) {
+        pyramid->program = new QOpenGLShaderProgram();
+        addShader(pyramid->program, QOpenGLShader::Vertex, ":/vsPyramid");
+        addShader(pyramid->program, QOpenGLShader::Fragment, ":/fsPyramid");
+        linkProgram(pyramid->program);
+    }
+
+    // Program for render polygonal model
+    if (programs & PROGRAMS_POLYGONAL) {
+        polygonal->program = new QOpenGLShaderProgram();
+        addShader(polygonal->program, QOpenGLShader::Vertex, ":/vsPolygonal");
+        //addShader(polygonal->program, QOpenGLShader::Geometry, ":/gsPolygonal");
+        addShader(polygonal->program, QOpenGLShader::Fragment, ":/fsPolygonal");
+        linkProgram(polygonal->program);
+    }
+
+    if (programs & PROGRAMS_POSTPROCESSING) {
+        // Program for render final texture with textures
+        postprocessing->program = new QOpenGLShaderProgram();
+        addShader(postprocessing->program, QOpenGLShader::Vertex, ":/vsPostprocessing");
+        addShader(postprocessing->program, QOpenGLShader::Fragment, ":/fsPostprocessing");
+        linkProgram(postprocessing->program);
+
+        // Program for render final quad with output texture
+        postprocessing->programSimple = new QOpenGLShaderProgram();
+        addShader(postprocessing->programSimple, QOpenGLShader::Vertex, ":/vsPostprocessingSimple");
+        addShader(postprocessing->programSimple, QOpenGLShader::Fragment, ":/fsPostprocessingSimple");
+        linkProgram(postprocessing->programSimple);
+    }
+
+    // Programs for fused SSD - tile partial sums and their reduction
+    if (programs & PROGRAMS_FUSED_SSD) {
+        QString tileSizeDefine = QString("#define SSD_TILE_SIZE %1\n").arg(SSD_TILE_SIZE);
+
+        fusedSSD->program = new QOpenGLShaderProgram();
+        addShader(fusedSSD->program, QOpenGLShader::Vertex, ":/vsPostprocessingSimple");
+        addShader(fusedSSD->program, QOpenGLShader::Fragment, ":/fsSSDTiles", tileSizeDefine);
+        linkProgram(fusedSSD->program);
+
+        fusedSSD->programReduce = new QOpenGLShaderProgram();
+        addShader(fusedSSD->programReduce, QOpenGLShader::Vertex, ":/vsPostprocessingSimple");
+        addShader(fusedSSD->programReduce, QOpenGLShader::Fragment, ":/fsReduceTiles", tileSizeDefine);
+        linkProgram(fusedSSD->programReduce);
+    }
+
+    // Programs for density volume - baking of slices, occupancy grid and ray marching
+    if (programs & PROGRAMS_DENSITY_VOLUME) {
+        densityVolume->programBake = new QOpenGLShaderProgram();
+        addShader(densityVolume->programBake, QOpenGLShader::Vertex, ":/vsDensity");
+        addShader(densityVolume->programBake, QOpenGLShader::Geometry, ":/gsDensityVolume");
+        densityVolume->fragmentShader = new QOpenGLShader(QOpenGLShader::Fragment);
+        linkDensityVolumeProgram();
+
+        densityVolume->programOccupancy = new QOpenGLShaderProgram();
+        addShader(densityVolume->programOccupancy, QOpenGLShader::Vertex, ":/vsPostprocessingSimple");
+        addShader(densityVolume->programOccupancy, QOpenGLShader::Fragment, ":/fsDensityVolumeOccupancy");
+        linkProgram(densityVolume->programOccupancy);
+
+        densityVolume->program = new QOpenGLShaderProgram();
+        addShader(densityVolume->program, QOpenGLShader::Vertex, ":/vsPostprocessingSimple");
+        addShader(densityVolume->program, QOpenGLShader::Fragment, ":/fsDensityVolume");
+        linkProgram(densityVolume->program);
+    }
+
+    builtPrograms |= programs;
+
+    // Init attribute and uniform variables
+    getVariablesLocations();
+    initUniformVariables();
 }
 
 /**
- * @brief Returns perspective matrix
- * @return Perspective matrix
+ * @brief Binds BernsteinWeights uniform block of program to its binding point
+ * @param[in] program Shader program
+ *
+ * Unrolled fragment shaders have no uniform block and are skipped.
  */
-QMatrix4x4 MainRenderer::getPerspetiveMatrix()
+void MainRenderer::bindBernsteinWeightsBlock(QOpenGLShaderProgram *program)
 {
-    prepareTransformation();
-    return perspectiveMatrix;
+    GLuint blockIndex = glGetUniformBlockIndex(program->programId(), "BernsteinWeights");
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(program->programId(), blockIndex, BERNSTEIN_WEIGHTS_BINDING);
 }
 
 /**
- * @brief Convert point to OpenGL relative position
- * @param[in] point Point to convert
- * @return Converted point
+ * @brief MainRenderer::initUniformVariables
  */
-QPointF MainRenderer::convertPointToOpenGLRelative(QPointF point)
+void MainRenderer::initUniformVariables()
 {
-    QPointF pointOutput;
-    pointOutput.setX((point.x() / (float) getRenderWidth() - 0.5f) * 2.0f);
-    pointOutput.setY((point.y() / (float) getRenderHeight() - 0.5f) * 2.0f);
-    return pointOutput;
+    // Set uniform values
+    setIntensity(intensity);
+    setLineWidth(lineWidth);
+    setParam(param);
+    setRelativeTextureStep();
+
+    if (builtPrograms & PROGRAMS_POSTPROCESSING) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uDensityEnabled, densityEnabled);
+        postprocessing->program->setUniformValue(postprocessing->uSilhouettesEnabled, silhouettesEnabled);
+        postprocessing->program->setUniformValue(postprocessing->uPolygonalEnabled, polygonalEnabled);
+        postprocessing->program->setUniformValue(postprocessing->uPyramidEnabled, pyramidEnabled);
+        postprocessing->program->setUniformValue(postprocessing->uPostprocessingEnabled, postprocessingEnabled);
+        postprocessing->program->setUniformValue(postprocessing->uLeftBottomCorner, QVector2D(0.0f, 0.0f));
+        postprocessing->program->setUniformValue(postprocessing->uRightTopCorner, QVector2D(1.0f, 1.0f));
+        postprocessing->program->release();
+    }
+
+    if (builtPrograms & PROGRAMS_COMPUTING) {
+        positions->program->bind();
+        positions->program->setUniformValue(positions->uPositionDiffLengthLog2, positionDiffLengthLog2);
+        positions->program->setUniformValue(positions->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
+        positions->program->release();
+
+        computing->program->bind();
+        computing->program->setUniformValue(computing->uWidth, cWidth);
+        computing->program->setUniformValue(computing->uHeight, cHeight);
+        computing->program->release();
+
+        computing->programDelta->bind();
+        computing->programDelta->setUniformValue(computing->uDeltaWidth, cWidth);
+        computing->programDelta->setUniformValue(computing->uDeltaHeight, cHeight);
+        computing->programDelta->release();
+    }
+
+    // Fragment shaders of density read coefficient diffs from 2D texture,
+    // loop fragment shaders read weights from uniform block
+    if (builtPrograms & PROGRAMS_DENSITY) {
+        bindBernsteinWeightsBlock(density->program);
+        density->program->bind();
+        density->program->setUniformValue(density->uPositionDiffLengthLog2, positionDiffLengthLog2);
+        density->program->setUniformValue(density->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
+        density->program->setUniformValue(density->uPrimitiveOffset, 0);
+        density->program->release();
+    }
+
+    if (builtPrograms & PROGRAMS_DENSITY_BATCH) {
+        bindBernsteinWeightsBlock(densityBatch->program);
+        densityBatch->program->bind();
+        densityBatch->program->setUniformValue(densityBatch->uPositionDiffLengthLog2, positionDiffLengthLog2);
+        densityBatch->program->setUniformValue(densityBatch->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
+        densityBatch->program->release();
+    }
+
+    if (builtPrograms & PROGRAMS_DENSITY_PULLING) {
+        bindBernsteinWeightsBlock(densityPulling->program);
+        densityPulling->program->bind();
+        densityPulling->program->setUniformValue(densityPulling->uPositionDiffLengthLog2, positionDiffLengthLog2);
+        densityPulling->program->setUniformValue(densityPulling->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
+        densityPulling->program->release();
+    }
+
+    if (builtPrograms & PROGRAMS_DENSITY_VOLUME) {
+        densityVolume->programBake->bind();
+        densityVolume->programBake->setUniformValue(densityVolume->uPositionDiffLengthLog2, positionDiffLengthLog2);
+        densityVolume->programBake->setUniformValue(densityVolume->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
+        densityVolume->programBake->release();
+    }
+
+    enableXMirroring(xMirroringEnabled);
+
+    enablePolygonalLighting(polygonalLightingEnabled);
 }
 
 /**
- * @brief Creates bounding box vertex array
- * @param[in] minVertex Min vertex
- * @param[in] maxVertex Max vertex
- * @param[out] verticesArray Output vertices array
+ * @brief MainRenderer::setStatisticalData
+ * @param statisticalData
  *
- * Unused.
+ * T matrix is uploaded to tboT, so applied pcs of both diffs are forgotten
+ * and the next recomputeDiff() is full.
  */
-void MainRenderer::createBoundingBoxVertexArray(QVector3D minVertex, QVector3D maxVertex, GLfloat *verticesArray)
+void MainRenderer::setStatisticalData(StatisticalData *statisticalData)
 {
-    verticesArray[0] = minVertex.x();
-    verticesArray[1] = minVertex.y();
-    verticesArray[2] = maxVertex.z();
+    if (!statisticalData) {
+        qCritical() << "MainRenderer::setStatisticalData error: null StatisticalData";
+        return;
+    }
 
-    verticesArray[3] = maxVertex.x();
-    verticesArray[4] = minVertex.y();
-    verticesArray[5] = maxVertex.z();
+    // Compute texture height padding
+    cHeight = statisticalData->getNumberOfRows() / cWidth + 1;
 
-    verticesArray[6] = maxVertex.x();
-    verticesArray[7] = maxVertex.y();
-    verticesArray[8] = maxVertex.z();
+    this->statisticalData = statisticalData;
 
-    verticesArray[9] = minVertex.x();
-    verticesArray[10] = maxVertex.y();
-    verticesArray[11] = maxVertex.z();
+    if (!hasSharedContext()) {
 
-    verticesArray[12] = minVertex.x();
-    verticesArray[13] = minVertex.y();
-    verticesArray[14] = minVertex.z();
+        /*// Create indices for accesing of texture coords in shaders
+        GLuint *indicesX = new GLuint[widthComp * heightComp * 3]();
+        GLuint *indicesY = new GLuint[widthComp * heightComp * 3]();
+        // Crazy magic code...
+        int positionDiffLengthLog2 = (int(double(qLn(maxTextureOrRenderSize[0]) / qLn(2))));
+        int positionDiffLengthMinus1 = maxTextureOrRenderSize[0] - 1;
+        for (unsigned int i = 0; i < heightComp * widthComp; i++) {
+            indicesX[i * 3] = (i * 3) & positionDiffLengthMinus1;
+            indicesX[i * 3 + 1] = (i * 3 + 1) & positionDiffLengthMinus1;
+            indicesX[i * 3 + 2] = (i * 3 + 2) & positionDiffLengthMinus1;
 
-    verticesArray[15] = maxVertex.x();
-    verticesArray[16] = minVertex.y();
-    verticesArray[17] = minVertex.z();
+            indicesY[i * 3] = (i * 3) >> positionDiffLengthLog2;
+            indicesY[i * 3 + 1] = (i * 3 + 1) >> positionDiffLengthLog2;
+            indicesY[i * 3 + 2] = (i * 3 + 2) >> positionDiffLengthLog2;
+        }
+        vboComputeIndicesX.bind();
+        vboComputeIndicesX.allocate(indicesX, sizeof(GLuint) * widthComp * heightComp * 3);
+        vboComputeIndicesX.release();
+        vboComputeIndicesY.bind();
+        vboComputeIndicesY.allocate(indicesY, sizeof(GLuint) * widthComp * heightComp * 3);
+        vboComputeIndicesY.release();
+        delete[] indicesX;
+        delete[] indicesY;*/
 
-    verticesArray[18] = maxVertex.x();
-    verticesArray[19] = maxVertex.y();
-    verticesArray[20] = minVertex.z();
+        glBindBuffer(GL_TEXTURE_BUFFER, tboT);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * statisticalData->getNumberOfRows() * statisticalData->getNumberOfParameters(), statisticalData->getTMatrix(), GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
-    verticesArray[21] = minVertex.x();
-    verticesArray[22] = maxVertex.y();
-    verticesArray[23] = minVertex.z();
+        glBindTexture(GL_TEXTURE_BUFFER, toT);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboT);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        // Incremental updates would apply deltas to diffs of previous T
+        computing->coefficientsState.statisticalData = 0;
+        computing->verticesState.statisticalData = 0;
+
+        // Built programs get sizes in initUniformVariables
+        if (hasPrograms(PROGRAMS_COMPUTING)) {
+            computing->program->bind();
+            computing->program->setUniformValue(computing->uWidth, cWidth);
+            computing->program->setUniformValue(computing->uHeight, cHeight);
+            computing->program->release();
+
+            computing->programDelta->bind();
+            computing->programDelta->setUniformValue(computing->uDeltaWidth, cWidth);
+            computing->programDelta->setUniformValue(computing->uDeltaHeight, cHeight);
+            computing->programDelta->release();
+        }
+    }
 }
 
 /**
- * @brief Catches event and sets render width and height
- * @param[in] event QEvent object
- * @return True
+ * @brief MainRenderer::recomputeDiff
+ * @param[in] texture Diff texture (coefficients or vertices)
+ * @param[in,out] state Pcs applied to diff texture
+ * @param[in] pcs Optional pcs vector, pcs of current statistical data are used by default
+ *
+ * If only few pcs changed since the last recompute, the diff is updated incrementally
+ * (diff += T[:, i] * delta pcs[i]) instead of full T * pcs product. Full recompute
+ * is forced after MAX_DELTA_UPDATES incremental updates to limit rounding errors.
  */
-bool MainRenderer::event(QEvent *event)
+void MainRenderer::recomputeDiff(GLuint texture, DiffState &state, const GLfloat *pcs)
 {
-    if (event->type() == QEvent::Resize) {
-        setRenderWidth(((QResizeEvent *) event)->size().width());
-        setRenderHeight(((QResizeEvent *) event)->size().height());
+    if (!statisticalData) {
+        qCritical() << "MainRenderer::recomputeDiff error: null StatisticalData";
+        return;
     }
-    return true;
-}
 
-// Private stuff - make comments
+    if (!pcs)
+        pcs = statisticalData->getPcsMatrix();
 
-/**
- * @brief MainRenderer::init
- */
-void MainRenderer::init()
-{
-    densityEnabled = true;
-    postprocessingEnabled = true;
-    silhouettesEnabled = true;
-    pyramidEnabled = true;
-    polygonalEnabled = false;
-    xMirroringEnabled = false;
-    polygonalLightingEnabled = true;
+    requirePrograms(PROGRAMS_COMPUTING);
 
-    mesh = 0;
-    lastBernCoeffsCount = 0;
+    int numberOfParameters = statisticalData->getNumberOfParameters();
 
-    cWidth = 0;
-    cHeight = 0;
+    // Find changed modes
+    QVector<GLint> changedModes;
+    QVector<GLfloat> deltas;
+    bool diffSizeChanged = state.width != cWidth || state.height != cHeight;
+    bool fullRecompute = diffSizeChanged || state.statisticalData != statisticalData
+            || state.pcs.size() != numberOfParameters || state.deltaUpdates >= MAX_DELTA_UPDATES;
 
-    renderWidth = 1;
-    renderHeight = 1;
-    cropX = 0;
-    cropY = 0;
-    cropWidth = 1;
-    cropHeight = 1;
-    ratio = 1;
-    step.setX(1);
-    step.setY(1);
-    sizeChanged = true;
+    if (!fullRecompute) {
+        for (int i = 0; i < numberOfParameters; i++) {
+            if (pcs[i] != state.pcs.at(i)) {
+                changedModes.append(i);
+                deltas.append(pcs[i] - state.pcs.at(i));
+            }
+        }
 
-    intensity = 0.5f;
-    lineWidth = 0.005f;
-    param = 1.0f;
+        // Diff is up to date
+        if (changedModes.isEmpty())
+            return;
 
-    flagShareTransformations = true;
-    //flagShareRenderSettings = true;
+        fullRecompute = changedModes.size() > MAX_DELTA_MODES;
+    }
 
-    recomputeCoefficientsDiffFlag = false;
-    recomputeVerticesDiffFlag = false;
+    passTimer.begin("recomputeDiff");
 
-    matrix.setToIdentity();
-    perspectiveMatrix.setToIdentity();
-    cameraMatrix.setToIdentity();
-    translationMatrix.setToIdentity();
-    rotationMatrix.setToIdentity();
+    if (diffSizeChanged) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, cWidth, cHeight, 0, GL_RED, GL_FLOAT, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
 
-    setCamera(perspective);
+    if (fullRecompute) {
+        glBindBuffer(GL_TEXTURE_BUFFER, tboPcs);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * numberOfParameters * 1, pcs, GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
-    maxTextureOrRenderSize[0] = 0;
-    maxTextureOrRenderSize[1] = 0;
-}
+        glBindTexture(GL_TEXTURE_BUFFER, toPcs);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboPcs);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
 
-/**
- * @brief MainRenderer::getVariablesLocations
- */
-void MainRenderer::getVariablesLocations()
-{
-    // Density
-    density->aPosition = density->program->attributeLocation("aPosition");
-    //density->aIndicesX = density->program->attributeLocation("aIndicesX");
-    //density->aIndicesY = density->program->attributeLocation("aIndicesY");
-    density->uPositionDiff = density->program->uniformLocation("uPositionDiff");
-    density->uPositionDiffLengthMinus1 = density->program->uniformLocation("uPositionDiffLengthMinus1");
-    density->uPositionDiffLengthLog2 = density->program->uniformLocation("uPositionDiffLengthLog2");
-    density->uParam = density->program->uniformLocation("uParam");
-    density->uMatrix = density->program->uniformLocation("uMatrix");
-    density->uMatrixInv = density->program->uniformLocation("uMatrixInv");
-    density->uBernCoeffs = density->program->uniformLocation("uBernCoeffs");
-    density->uBernCoeffsDiff = density->program->uniformLocation("uBernCoeffsDiff");
-    density->uXMirror = density->program->uniformLocation("uXMirror");
+    glBindFramebuffer(GL_FRAMEBUFFER, fboComputing);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0);
 
-    // Silhouettes
-    silhouettes->aPosition = silhouettes->program->attributeLocation("aPosition");
-    //silhouettes->aIndicesX = silhouettes->program->attributeLocation("aIndicesX");
-    //silhouettes->aIndicesY = silhouettes->program->attributeLocation("aIndicesY");
-    silhouettes->uPositionDiff = silhouettes->program->uniformLocation("uPositionDiff");
-    silhouettes->uPositionDiffLengthMinus1 = silhouettes->program->uniformLocation("uPositionDiffLengthMinus1");
-    silhouettes->uPositionDiffLengthLog2 = silhouettes->program->uniformLocation("uPositionDiffLengthLog2");
-    silhouettes->uMatrix = silhouettes->program->uniformLocation("uMatrix");
-    silhouettes->uXMirror = silhouettes->program->uniformLocation("uXMirror");
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, cWidth, cHeight);
+    //glScissor(0, 0, cWidth, cHeight);
 
-    // Computing
-    computing->uT = computing->program->uniformLocation("uT");
-    computing->uPcs = computing->program->uniformLocation("uPcs");
-    computing->uWidth = computing->program->uniformLocation("uWidth");
-    computing->uHeight = computing->program->uniformLocation("uHeight");
+    glBindVertexArray(vao);
 
-    // Pyramid
-    pyramid->uMatrix = pyramid->program->uniformLocation("uMatrix");
-    pyramid->uCorners = pyramid->program->uniformLocation("uCorners");
-    pyramid->uEye = pyramid->program->uniformLocation("uEye");
-    pyramid->uColor = pyramid->program->uniformLocation("uColor");
-    pyramid->uTexture = pyramid->program->uniformLocation("uTexture");
+    if (fullRecompute) {
+        glDisable(GL_BLEND);
+        glClear(GL_COLOR_BUFFER_BIT);
 
-    // Polygonal
-    polygonal->aPosition = polygonal->program->attributeLocation("aPosition");
-    //polygonal->aIndicesX = polygonal->program->attributeLocation("aIndicesX");
-    //polygonal->aIndicesY = polygonal->program->attributeLocation("aIndicesY");
-    polygonal->aColor = polygonal->program->attributeLocation("aColor");
-    polygonal->aNormal = polygonal->program->attributeLocation("aNormal");
-    polygonal->uPositionDiff = polygonal->program->uniformLocation("uPositionDiff");
-    polygonal->uPositionDiffLengthMinus1 = polygonal->program->uniformLocation("uPositionDiffLengthMinus1");
-    polygonal->uPositionDiffLengthLog2 = polygonal->program->uniformLocation("uPositionDiffLengthLog2");
-    polygonal->uMatrix = polygonal->program->uniformLocation("uMatrix");
-    polygonal->uNormalMatrix = polygonal->program->uniformLocation("uNormalMatrix");
-    polygonal->uXMirror = polygonal->program->uniformLocation("uXMirror");
-    polygonal->uLightingEnabled = polygonal->program->uniformLocation("uLightingEnabled");
+        computing->program->bind();
 
-    // Post-processing
-    postprocessing->uDensityTexture = postprocessing->program->uniformLocation("uDensityTexture");
-    postprocessing->uSilhouettesTexture = postprocessing->program->uniformLocation("uSilhouettesTexture");
-    postprocessing->uPolygonalTexture = postprocessing->program->uniformLocation("uPolygonalTexture");
-    postprocessing->uPyramidTexture = postprocessing->program->uniformLocation("uPyramidTexture");
-    postprocessing->uIntensity = postprocessing->program->uniformLocation("uIntensity");
-    postprocessing->uLineWidth = postprocessing->program->uniformLocation("uLineWidth");
-    postprocessing->uTextureStep = postprocessing->program->uniformLocation("uTextureStep");
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, toT);
+        computing->program->setUniformValue(computing->uT, 0);
 
-    postprocessing->uDensityEnabled = postprocessing->program->uniformLocation("uDensityEnabled");
-    postprocessing->uSilhouettesEnabled = postprocessing->program->uniformLocation("uSilhouettesEnabled");
-    postprocessing->uPolygonalEnabled = postprocessing->program->uniformLocation("uPolygonalEnabled");
-    postprocessing->uPyramidEnabled = postprocessing->program->uniformLocation("uPyramidEnabled");
-    postprocessing->uPostprocessingEnabled = postprocessing->program->uniformLocation("uPostprocessingEnabled");
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, toPcs);
+        computing->program->setUniformValue(computing->uPcs, 1);
 
-    postprocessing->uLeftBottomCorner = postprocessing->program->uniformLocation("uLeftBottomCorner");
-    postprocessing->uRightTopCorner = postprocessing->program->uniformLocation("uRightTopCorner");
+        glDrawArrays(GL_TRIANGLES, 0, 6);
 
-    postprocessing->uOutputTexture = postprocessing->programSimple->uniformLocation("uOutputTexture");
-}
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
 
-/**
- * @brief MainRenderer::initUniformVariables
- */
-void MainRenderer::initUniformVariables()
-{
-    // Set uniform values
-    setIntensity(intensity);
-    setLineWidth(lineWidth);
-    setParam(param);
-    setRelativeTextureStep();
+        computing->program->release();
 
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uDensityEnabled, densityEnabled);
-    postprocessing->program->setUniformValue(postprocessing->uSilhouettesEnabled, silhouettesEnabled);
-    postprocessing->program->setUniformValue(postprocessing->uPolygonalEnabled, polygonalEnabled);
-    postprocessing->program->setUniformValue(postprocessing->uPyramidEnabled, pyramidEnabled);
-    postprocessing->program->setUniformValue(postprocessing->uPostprocessingEnabled, postprocessingEnabled);
-    postprocessing->program->setUniformValue(postprocessing->uLeftBottomCorner, QVector2D(0.0f, 0.0f));
-    postprocessing->program->setUniformValue(postprocessing->uRightTopCorner, QVector2D(1.0f, 1.0f));
-    postprocessing->program->release();
+        state.deltaUpdates = 0;
+    } else {
+        // Rank-k update is added to current diff
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glBlendEquation(GL_FUNC_ADD);
 
-    silhouettes->program->bind();
-    silhouettes->program->setUniformValue(silhouettes->uPositionDiffLengthLog2, positionDiffLengthLog2);
-    silhouettes->program->setUniformValue(silhouettes->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
-    silhouettes->program->release();
+        computing->programDelta->bind();
 
-    polygonal->program->bind();
-    polygonal->program->setUniformValue(polygonal->uPositionDiffLengthLog2, positionDiffLengthLog2);
-    polygonal->program->setUniformValue(polygonal->uPositionDiffLengthMinus1, positionDiffLengthMinus1);
-    polygonal->program->release();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, toT);
+        computing->programDelta->setUniformValue(computing->uDeltaT, 0);
 
-    enableXMirroring(xMirroringEnabled);
+        computing->programDelta->setUniformValueArray(computing->uDeltaModes, changedModes.constData(), changedModes.size());
+        computing->programDelta->setUniformValueArray(computing->uDeltaValues, deltas.constData(), deltas.size(), 1);
+        computing->programDelta->setUniformValue(computing->uDeltaCount, changedModes.size());
+        computing->programDelta->setUniformValue(computing->uDeltaNumberOfParameters, numberOfParameters);
+
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        computing->programDelta->release();
+
+        glDisable(GL_BLEND);
+
+        state.deltaUpdates++;
+    }
+
+    glBindVertexArray(0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Remember applied pcs
+    state.statisticalData = statisticalData;
+    state.pcs.resize(numberOfParameters);
+    memcpy(state.pcs.data(), pcs, sizeof(GLfloat) * numberOfParameters);
+    state.width = cWidth;
+    state.height = cHeight;
+
+    passTimer.end();
+}
 
-    enablePolygonalLighting(polygonalLightingEnabled);
+/**
+ * @brief MainRenderer::recomputeCoefficientsDiff
+ * @param[in] pcs Optional pcs vector, pcs of current statistical data are used by default
+ */
+void MainRenderer::recomputeCoefficientsDiff(const GLfloat *pcs)
+{
+    recomputeCoefficientsDiffFlag = false;
+    recomputeDiff(toCompCoeffs, computing->coefficientsState, pcs);
 }
 
 /**
- * @brief MainRenderer::generateScreenTexture
- * @param id
+ * @brief MainRenderer::recomputeVerticesDiff
  */
-void MainRenderer::generateScreenTexture(GLuint *id)
+void MainRenderer::recomputeVerticesDiff()
 {
-    glGenTextures(1, id);
-    glBindTexture(GL_TEXTURE_2D, *id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, getRenderWidth(), getRenderHeight(), 0, GL_RGBA, GL_FLOAT, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    recomputeVerticesDiffFlag = false;
+    recomputeDiff(toCompVertices, computing->verticesState);
+    recomputePositionsFlag = true;
 }
 
 /**
- * @brief MainRenderer::setStatisticalData
- * @param statisticalData
+ * @brief MainRenderer::recomputePositions
+ *
+ * Final vertex positions (mean + diff) are written to vboPositions by transform feedback
+ * once per shape update, all rendering passes read them as vertex attribute.
  */
-void MainRenderer::setStatisticalData(StatisticalData *statisticalData)
+void MainRenderer::recomputePositions()
 {
-    if (!statisticalData) {
-        qCritical() << "MainRenderer::setStatisticalData error: null StatisticalData";
+    recomputePositionsFlag = false;
+
+    if (!mesh)
         return;
-    }
 
-    // Compute texture height padding
-    cHeight = statisticalData->getNumberOfRows() / cWidth + 1;
+    requirePrograms(PROGRAMS_COMPUTING);
 
-    this->statisticalData = statisticalData;
+    passTimer.begin("recomputePositions");
 
-    if (!hasSharedContext()) {
+    GLint numberOfVertices = GLint(mesh->getNumberOfVertices());
 
-        /*// Create indices for accesing of texture coords in shaders
-        GLuint *indicesX = new GLuint[widthComp * heightComp * 3]();
-        GLuint *indicesY = new GLuint[widthComp * heightComp * 3]();
-        // Crazy magic code...
-        int positionDiffLengthLog2 = (int(double(qLn(maxTextureOrRenderSize[0]) / qLn(2))));
-        int positionDiffLengthMinus1 = maxTextureOrRenderSize[0] - 1;
-        for (unsigned int i = 0; i < heightComp * widthComp; i++) {
-            indicesX[i * 3] = (i * 3) & positionDiffLengthMinus1;
-            indicesX[i * 3 + 1] = (i * 3 + 1) & positionDiffLengthMinus1;
-            indicesX[i * 3 + 2] = (i * 3 + 2) & positionDiffLengthMinus1;
+    vboPositions.bind();
+    if (vboPositions.size() != int(sizeof(GLfloat) * numberOfVertices * 3))
+        vboPositions.allocate(sizeof(GLfloat) * numberOfVertices * 3);
+    vboPositions.release();
 
-            indicesY[i * 3] = (i * 3) >> positionDiffLengthLog2;
-            indicesY[i * 3 + 1] = (i * 3 + 1) >> positionDiffLengthLog2;
-            indicesY[i * 3 + 2] = (i * 3 + 2) >> positionDiffLengthLog2;
-        }
-        vboComputeIndicesX.bind();
-        vboComputeIndicesX.allocate(indicesX, sizeof(GLuint) * widthComp * heightComp * 3);
-        vboComputeIndicesX.release();
-        vboComputeIndicesY.bind();
-        vboComputeIndicesY.allocate(indicesY, sizeof(GLuint) * widthComp * heightComp * 3);
-        vboComputeIndicesY.release();
-        delete[] indicesX;
-        delete[] indicesY;*/
+    glEnable(GL_RASTERIZER_DISCARD);
 
-        glBindBuffer(GL_TEXTURE_BUFFER, tboT);
-        glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * statisticalData->getNumberOfRows() * statisticalData->getNumberOfParameters(), statisticalData->getTMatrix(), GL_STATIC_DRAW);
-        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    positions->program->bind();
 
-        glBindTexture(GL_TEXTURE_BUFFER, toT);
-        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboT);
-        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindVertexArray(vao);
 
-        computing->program->bind();
-        computing->program->setUniformValue(computing->uWidth, cWidth);
-        computing->program->setUniformValue(computing->uHeight, cHeight);
-        computing->program->release();
-    }
+    vboVertices.bind();
+    glEnableVertexAttribArray(positions->aPosition);
+    glVertexAttribPointer(positions->aPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, toCompVertices);
+    positions->program->setUniformValue(positions->uPositionDiff, 0);
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vboPositions.bufferId());
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, numberOfVertices);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glDisableVertexAttribArray(positions->aPosition);
+    vboVertices.release();
+
+    glBindVertexArray(0);
+
+    positions->program->release();
+
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    // Inverse matrices and bounds of clusters of all renderers depend on positions
+    positions->generation++;
+
+    passTimer.end();
 }
 
 /**
- * @brief MainRenderer::recomputeDiff
+ * @brief Recomputes inverse matrices of tetrahedra for vertex pulling
+ *
+ * Inverse matrix of vertices of every tetrahedron (4 columns RGBA32F) is captured
+ * by transform feedback, it is computed once per shape instead of once per frame in geometry shader.
  */
-void MainRenderer::recomputeDiff()
+void MainRenderer::recomputeTetrahedraInverse()
 {
-    if (!statisticalData) {
-        qCritical() << "MainRenderer::recomputeDiff error: null StatisticalData";
+    densityPulling->inverseGeneration = positions->generation;
+
+    if (!mesh || mesh->getNumberOfTetrahedra() == 0)
         return;
-    }
 
-    glBindBuffer(GL_TEXTURE_BUFFER, tboPcs);
-    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLfloat) * statisticalData->getNumberOfParameters() * 1, statisticalData->getPcsMatrix(), GL_STATIC_DRAW);
-    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    requirePrograms(PROGRAMS_DENSITY_PULLING);
+
+    passTimer.begin("recomputeTetrahedraInverse");
 
-    glBindTexture(GL_TEXTURE_BUFFER, toPcs);
-    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, tboPcs);
+    GLint numberOfTetrahedra = GLint(mesh->getNumberOfTetrahedra());
+
+    vboTetrahedraInverse.bind();
+    if (vboTetrahedraInverse.size() != int(sizeof(GLfloat) * numberOfTetrahedra * 16))
+        vboTetrahedraInverse.allocate(sizeof(GLfloat) * numberOfTetrahedra * 16);
+    vboTetrahedraInverse.release();
+
+    // Buffers can be reallocated by new mesh or shape
+    glBindTexture(GL_TEXTURE_BUFFER, toPositions);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, vboPositions.bufferId());
+    glBindTexture(GL_TEXTURE_BUFFER, toElementsTetrahedra);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, iboElementsTetrahedra.bufferId());
+    glBindTexture(GL_TEXTURE_BUFFER, toTetrahedraInverse);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, vboTetrahedraInverse.bufferId());
     glBindTexture(GL_TEXTURE_BUFFER, 0);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fboComputing);
+    glEnable(GL_RASTERIZER_DISCARD);
 
-    glDisable(GL_SCISSOR_TEST);
-    glViewport(0, 0, cWidth, cHeight);
-    //glScissor(0, 0, cWidth, cHeight);
-    glDisable(GL_BLEND);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    densityPulling->programInverse->bind();
 
-    computing->program->bind();
+    glBindVertexArray(vao);
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_BUFFER, toT);
-    computing->program->setUniformValue(computing->uT, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, toPositions);
+    densityPulling->programInverse->setUniformValue(densityPulling->uInversePositions, 0);
 
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_BUFFER, toPcs);
-    computing->program->setUniformValue(computing->uPcs, 1);
+    glBindTexture(GL_TEXTURE_BUFFER, toElementsTetrahedra);
+    densityPulling->programInverse->setUniformValue(densityPulling->uInverseElements, 1);
 
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vboTetrahedraInverse.bufferId());
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, numberOfTetrahedra);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
 
     glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glBindVertexArray(0);
 
-    computing->program->release();
+    densityPulling->programInverse->release();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    passTimer.end();
 }
 
 /**
- * @brief MainRenderer::recomputeCoefficientsDiff
+ * @brief Recomputes bounding boxes of clusters of tetrahedra for density culling
+ *
+ * Bounding box of every cluster (min xyz, max xyz) is captured by transform feedback
+ * and read back, it is done once per shape.
  */
-void MainRenderer::recomputeCoefficientsDiff()
+void MainRenderer::recomputeClusterBounds()
 {
-    recomputeCoefficientsDiffFlag = false;
-    glBindTexture(GL_TEXTURE_2D, toCompCoeffs);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, cWidth, cHeight, 0, GL_RED, GL_FLOAT, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    density->clusterBoundsGeneration = positions->generation;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fboComputing);
+    density->clusterBounds.clear();
 
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toCompCoeffs, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!mesh || mesh->getNumberOfTetrahedra() == 0)
+        return;
 
-    recomputeDiff();
-}
+    requirePrograms(PROGRAMS_DENSITY);
 
-/**
- * @brief MainRenderer::recomputeVerticesDiff
- */
-void MainRenderer::recomputeVerticesDiff()
-{
-    recomputeVerticesDiffFlag = false;
-    glBindTexture(GL_TEXTURE_2D, toCompVertices);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, cWidth, cHeight, 0, GL_RED, GL_FLOAT, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    passTimer.begin("recomputeClusterBounds");
 
-    glBindFramebuffer(GL_FRAMEBUFFER, fboComputing);
+    GLint numberOfTetrahedra = GLint(mesh->getNumberOfTetrahedra());
+    GLint numberOfClusters = (numberOfTetrahedra + DENSITY_CLUSTER_SIZE - 1) / DENSITY_CLUSTER_SIZE;
 
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toCompVertices, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    vboClusterBounds.bind();
+    if (vboClusterBounds.size() != int(sizeof(GLfloat) * numberOfClusters * 6))
+        vboClusterBounds.allocate(sizeof(GLfloat) * numberOfClusters * 6);
+    vboClusterBounds.release();
+
+    // Buffers can be reallocated by new mesh or shape
+    glBindTexture(GL_TEXTURE_BUFFER, toPositions);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, vboPositions.bufferId());
+    glBindTexture(GL_TEXTURE_BUFFER, toElementsTetrahedra);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, iboElementsTetrahedra.bufferId());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    density->programBounds->bind();
+    density->programBounds->setUniformValue(density->uBoundsClusterSize, GLint(DENSITY_CLUSTER_SIZE));
+    density->programBounds->setUniformValue(density->uBoundsNumberOfTetrahedra, numberOfTetrahedra);
+
+    glBindVertexArray(vao);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, toPositions);
+    density->programBounds->setUniformValue(density->uBoundsPositions, 0);
 
-    recomputeDiff();
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, toElementsTetrahedra);
+    density->programBounds->setUniformValue(density->uBoundsElements, 1);
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vboClusterBounds.bufferId());
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, numberOfClusters);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glBindVertexArray(0);
+
+    density->programBounds->release();
+
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    // Culling is done on CPU
+    density->clusterBounds.resize(numberOfClusters * 6);
+    vboClusterBounds.bind();
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GLfloat) * density->clusterBounds.size(), density->clusterBounds.data());
+    vboClusterBounds.release();
+
+    passTimer.end();
 }
 
 /**
@@ -2877,6 +5694,9 @@ void MainRenderer::recomputeStatisticalDataIfNeeded()
 
     if (recomputeVerticesDiffFlag)
         recomputeVerticesDiff();
+
+    if (recomputePositionsFlag)
+        recomputePositions();
 }
 
 /**
@@ -2884,30 +5704,83 @@ void MainRenderer::recomputeStatisticalDataIfNeeded()
  */
 void MainRenderer::resizeTexturesAndRenderbuffer()
 {
-    // Update width and height on window resize
-    glBindTexture(GL_TEXTURE_2D, toDensity);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, getRenderWidth(), getRenderHeight(), 0, GL_RGBA, GL_FLOAT, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Update width and height on window resize, only enabled layers are acquired
+    if (sizeChanged) {
+        allocateLayerTexture(toDensity, densityFormat, densityEnabled);
+        allocateLayerTexture(toSilhouettes, silhouettesFormat, silhouettesEnabled);
+        allocateLayerTexture(toPolygonal, polygonalFormat, polygonalEnabled);
+        allocateLayerTexture(toPyramid, pyramidFormat, pyramidEnabled);
+
+        renderTargetPool->releaseRenderbuffer(rbo);
+        rbo = renderTargetPool->acquireRenderbuffer(GL_DEPTH_COMPONENT, getRenderWidth(), getRenderHeight());
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 
-    glBindTexture(GL_TEXTURE_2D, toSilhouettes);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, getRenderWidth(), getRenderHeight(), 0, GL_RGBA, GL_FLOAT, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Switching between crop windows reuses output textures kept in pool
+    if (cropSizeChanged)
+        allocateCropTexture(toOutput);
 
-    glBindTexture(GL_TEXTURE_2D, toPolygonal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, getRenderWidth(), getRenderHeight(), 0, GL_RGBA, GL_FLOAT, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    sizeChanged = false;
+    cropSizeChanged = false;
+}
 
-    glBindTexture(GL_TEXTURE_2D, toPyramid);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, getRenderWidth(), getRenderHeight(), 0, GL_RGBA, GL_FLOAT, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+/**
+ * @brief Acquires or releases layer texture in render target pool
+ * @param[in, out] texture Layer texture
+ * @param[in] internalFormat Storage format
+ * @param[in] enabled Is layer enabled? Texture of disabled layer is released
+ */
+void MainRenderer::allocateLayerTexture(GLuint &texture, GLenum internalFormat, bool enabled)
+{
+    renderTargetPool->releaseTexture(texture);
+    texture = enabled ? renderTargetPool->acquireTexture(internalFormat, getRenderWidth(), getRenderHeight()) : 0;
+}
 
-    glBindTexture(GL_TEXTURE_2D, toOutput);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, getCropWidth(), getCropHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+/**
+ * @brief Acquires crop-sized texture in render target pool
+ * @param[in, out] texture RGBA32F texture, previous texture is released
+ *
+ * Texture released for the same crop size is acquired again.
+ */
+void MainRenderer::allocateCropTexture(GLuint &texture)
+{
+    renderTargetPool->releaseTexture(texture);
+    texture = renderTargetPool->acquireTexture(GL_RGBA32F, getCropWidth(), getCropHeight());
+}
 
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, getRenderWidth(), getRenderHeight());
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+/**
+ * @brief Checks supported storage format of layer
+ * @param[in] function Name of calling function for error message
+ * @param[in] internalFormat Storage format
+ * @param[in] alphaRequired Must format have alpha channel?
+ * @return True if format is supported
+ */
+bool MainRenderer::checkLayerFormat(const char *function, GLenum internalFormat, bool alphaRequired) const
+{
+    if (RenderTargetPool::getBaseFormat(internalFormat) == 0) {
+        qCritical() << function << "error: unsupported format" << internalFormat;
+        return false;
+    }
+
+    if (alphaRequired && !hasAlphaChannel(internalFormat)) {
+        qCritical() << function << "error: format without alpha channel" << internalFormat;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Has storage format alpha channel?
+ * @param[in] internalFormat Storage format
+ * @return True for RGBA formats
+ */
+bool MainRenderer::hasAlphaChannel(GLenum internalFormat)
+{
+    return RenderTargetPool::getBaseFormat(internalFormat) == GL_RGBA;
 }
 
 /**
@@ -2915,9 +5788,11 @@ void MainRenderer::resizeTexturesAndRenderbuffer()
  */
 void MainRenderer::setRelativeTextureStep()
 {
-    postprocessing->program->bind();
-    postprocessing->program->setUniformValue(postprocessing->uTextureStep, step);
-    postprocessing->program->release();
+    if (hasPrograms(PROGRAMS_POSTPROCESSING)) {
+        postprocessing->program->bind();
+        postprocessing->program->setUniformValue(postprocessing->uTextureStep, step);
+        postprocessing->program->release();
+    }
 }
 
 /**
@@ -2928,6 +5803,19 @@ void MainRenderer::prepareTransformation()
     perspectiveMatrix.setToIdentity();
     perspectiveMatrix.perspective(perspective.getFovy(), ratio, 1.0f, 1000.0f);
     perspectiveMatrix.scale(0.1f);
+
+    // Sub-frustum of crop window - maps crop window to whole clip space
+    cropMatrix.setToIdentity();
+    if (getCropWidth() == 0 || getCropHeight() == 0)
+        return;
+
+    float cropScaleX = (float) getRenderWidth() / (float) getCropWidth();
+    float cropScaleY = (float) getRenderHeight() / (float) getCropHeight();
+    float cropCenterX = (float) (2 * getCropX() + getCropWidth()) / (float) getRenderWidth() - 1.0f;
+    float cropCenterY = (float) (2 * getCropY() + getCropHeight()) / (float) getRenderHeight() - 1.0f;
+
+    cropMatrix.scale(cropScaleX, cropScaleY, 1.0f);
+    cropMatrix.translate(-cropCenterX, -cropCenterY, 0.0f);
 }
 
 /**
@@ -2982,6 +5870,236 @@ QImage MainRenderer::getCurrentImage()
     return image.mirrored();
 }
 
+/**
+ * @brief MainRenderer::readbackAsync
+ * @param[in] texture Read texture
+ * @param[in] x X position of crop window in texture
+ * @param[in] y Y position of crop window in texture
+ * @param[in] format Pixel format
+ * @param[in] type Pixel type
+ * @param[in] bytesPerPixel Bytes per pixel
+ * @param[in] flip Flip rows on GPU
+ * @return Readback handle
+ *
+ * Copies crop window of texture to the next pixel buffer of the ring and inserts fence.
+ * If the ring is full, the oldest unfinished readback is dropped.
+ */
+long MainRenderer::readbackAsync(GLuint texture, GLuint x, GLuint y, GLenum format, GLenum type, GLuint bytesPerPixel, bool flip)
+{
+    long handle = ++lastReadbackHandle;
+    Readback &readback = readbacks[handle % READBACK_RING_SIZE];
+
+    if (readback.fence)
+        glDeleteSync(readback.fence);
+
+    readback.handle = handle;
+    readback.format = format;
+    readback.type = type;
+    readback.width = getCropWidth();
+    readback.height = getCropHeight();
+    readback.size = readback.width * readback.height * bytesPerPixel;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fboOutput);
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0);
+
+    if (flip) {
+        if (readbackWidth != readback.width || readbackHeight != readback.height) {
+            readbackWidth = readback.width;
+            readbackHeight = readback.height;
+            allocateCropTexture(toReadback);
+        }
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fboReadback);
+        glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, toReadback, 0);
+
+        glDisable(GL_SCISSOR_TEST);
+        glBlitFramebuffer(x, y, x + readback.width, y + readback.height, 0, readback.height, readback.width, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fboReadback);
+        x = 0;
+        y = 0;
+    }
+
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, readback.size, 0, GL_STREAM_READ);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, readback.width, readback.height, format, type, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    return handle;
+}
+
+/**
+ * @brief MainRenderer::mapReadback
+ * @param[in] handle Readback handle
+ * @param[in] format Expected pixel format
+ * @param[in] type Expected pixel type
+ * @param[out] width Width of image
+ * @param[out] height Height of image
+ * @param[out] size Size of mapped pixel buffer in bytes
+ * @return Mapped pixel buffer, 0 if readback with handle is not available or has different format
+ *
+ * Waits for the fence of readback, pixel buffer stays mapped until unmapReadback().
+ * Readback with different format is kept, it can be taken by the matching function.
+ */
+const GLubyte *MainRenderer::mapReadback(long handle, GLenum format, GLenum type, GLuint &width, GLuint &height, GLuint &size)
+{
+    if (handle <= 0) {
+        qCritical() << "MainRenderer::mapReadback error: readback" << handle << "is not available";
+        return 0;
+    }
+
+    Readback &readback = readbacks[handle % READBACK_RING_SIZE];
+    if (readback.handle != handle || !readback.fence) {
+        qCritical() << "MainRenderer::mapReadback error: readback" << handle << "is not available";
+        return 0;
+    }
+
+    if (readback.format != format || readback.type != type) {
+        qCritical() << "MainRenderer::mapReadback error: readback" << handle << "has different pixel format";
+        return 0;
+    }
+
+    GLenum status;
+    do {
+        status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(readback.fence);
+    readback.fence = 0;
+    readback.handle = 0;
+
+    if (status == GL_WAIT_FAILED) {
+        qCritical() << "MainRenderer::mapReadback error: wait failed";
+        return 0;
+    }
+
+    width = readback.width;
+    height = readback.height;
+    size = readback.size;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    const GLubyte *mapped = (const GLubyte *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.size, GL_MAP_READ_BIT);
+    if (!mapped) {
+        qCritical() << "MainRenderer::mapReadback error: pixel buffer cannot be mapped";
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    return mapped;
+}
+
+/**
+ * @brief MainRenderer::unmapReadback
+ */
+void MainRenderer::unmapReadback()
+{
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/**
+ * @brief Uploads primitives ordered for post-transform vertex cache to index buffer
+ * @param[in] buffer Index buffer
+ * @param[in] elements Indices of primitives
+ * @param[in] numberOfPrimitives Number of primitives
+ * @param[in] primitiveSize Number of indices of one primitive (3 or 6)
+ * @param[in] numberOfVertices Number of vertices
+ *
+ * Primitives are reordered as whole, layout of triangles adjacency is kept. Mesh data are not changed.
+ * Effect of reordering is reported by getTrianglesACMR().
+ */
+void MainRenderer::allocateOptimizedElements(QOpenGLBuffer &buffer, const GLuint *elements, long numberOfPrimitives, int primitiveSize, long numberOfVertices)
+{
+    std::vector<GLuint> optimizedElements(elements, elements + numberOfPrimitives * primitiveSize);
+
+    if (numberOfPrimitives > 0)
+        VertexCacheOptimizer::reorder(optimizedElements.data(), primitiveSize, vertexCacheOptimizer.optimize(elements, numberOfPrimitives, primitiveSize, numberOfVertices));
+
+    buffer.bind();
+    buffer.allocate(optimizedElements.data(), int(sizeof(GLuint) * optimizedElements.size()));
+    buffer.release();
+}
+
+/**
+ * @brief MainRenderer::readLayer
+ * @param[in] function Name of calling function for error messages
+ * @param[in] texture Layer texture
+ * @param[in] enabled Is layer enabled?
+ * @param[in] format Pixel format
+ * @param[in] channels Number of values per pixel
+ * @param[out] data Output array
+ * @param[in] size Size of output array
+ * @param[in] rowStride Number of pixels between starts of rows (0 means crop width)
+ * @return False if layer is disabled or output array is too small
+ *
+ * Reads crop window of layer texture.
+ */
+bool MainRenderer::readLayer(const char *function, GLuint texture, bool enabled, GLenum format, GLuint channels, float *data, long size, GLuint rowStride)
+{
+    if (!checkOutputArray(function, data, size, getCropWidth(), getCropHeight(), channels, rowStride))
+        return false;
+
+    if (!enabled) {
+        qCritical() << function << "error: layer is disabled";
+        return false;
+    }
+
+    if (!checkInitAndMakeCurrentContext())
+        return false;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glFramebufferTexture(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ROW_LENGTH, rowStride);
+    glReadPixels(getCropX(), getCropY(), getCropWidth(), getCropHeight(), format, GL_FLOAT, data);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    return true;
+}
+
+/**
+ * @brief MainRenderer::checkOutputArray
+ * @param[in] function Name of calling function for error messages
+ * @param[in] data Output array
+ * @param[in] size Size of output array
+ * @param[in] width Width of copied image
+ * @param[in] height Height of copied image
+ * @param[in] channels Number of values per pixel
+ * @param[in] rowStride Number of pixels between starts of rows (0 means width)
+ * @return True if output array is big enough
+ */
+bool MainRenderer::checkOutputArray(const char *function, const float *data, long size, GLuint width, GLuint height, GLuint channels, GLuint rowStride) const
+{
+    if (!data) {
+        qCritical() << function << "error: null output array";
+        return false;
+    }
+
+    if (rowStride != 0 && rowStride < width) {
+        qCritical() << function << "error: row stride" << rowStride << "is smaller than width" << width;
+        return false;
+    }
+
+    GLuint stride = rowStride ? rowStride : width;
+    long required = height > 0 ? (long(height) - 1) * stride * channels + long(width) * channels : 0;
+    if (size < required) {
+        qCritical() << function << "error: output array is too small" << size << "<" << required;
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * @brief MainRenderer::getAngles
  * @param matrix
@@ -0,0 +1,27 @@
+#version 330
+
+uniform samplerBuffer uT;
+
+// Changed modes and differences of its pcs, MAX_DELTA_MODES is defined by MainRenderer
+uniform int uModes[MAX_DELTA_MODES];
+uniform float uDeltas[MAX_DELTA_MODES];
+uniform int uCount;
+uniform int uNumberOfParameters;
+
+uniform int uWidth;
+uniform int uHeight;
+
+out float outColor;
+
+noperspective in vec2 vPosition;
+
+void main()
+{
+    int index = int(floor(vPosition.y) * uWidth + floor(vPosition.x));
+
+    float sum = 0;
+    for (int i = 0; i < uCount; i++)
+        sum += texelFetch(uT, index * uNumberOfParameters + uModes[i]).r * uDeltas[i];
+
+    outColor = sum;
+}
@@ -0,0 +1,21 @@
+#version 330
+
+// Layer 0 is mean density image, layer i + 1 is density image of i-th unit pcs vector
+uniform sampler2DArray uBasisTexture;
+uniform samplerBuffer uWeights;
+
+out vec4 outColor;
+
+void main()
+{
+    ivec2 position = ivec2(gl_FragCoord.xy);
+    int numberOfParameters = textureSize(uWeights);
+
+    float mean = texelFetch(uBasisTexture, ivec3(position, 0), 0).r;
+    float value = mean;
+
+    for (int i = 0; i < numberOfParameters; i++)
+        value += texelFetch(uWeights, i).r * (texelFetch(uBasisTexture, ivec3(position, i + 1), 0).r - mean);
+
+    outColor = vec4(value, value, value, 1);
+}
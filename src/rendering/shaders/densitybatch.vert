@@ -0,0 +1,20 @@
+#version 330
+
+uniform bool uXMirror;
+
+// Final position (mean + diff) from positions pre-pass
+in vec3 aPosition;
+flat out int vInstance;
+
+void main()
+{
+    vec3 position = aPosition;
+
+    if (uXMirror)
+        position.x = -position.x;
+
+    // Instance selects pose and output layer
+    vInstance = gl_InstanceID;
+
+    gl_Position = vec4(position, 1.0f);
+}
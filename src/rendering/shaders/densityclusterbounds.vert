@@ -0,0 +1,30 @@
+#version 330
+
+// Final positions (x, y, z per vertex) and indices of tetrahedra
+uniform samplerBuffer uPositions;
+uniform usamplerBuffer uElements;
+
+uniform int uClusterSize;
+uniform int uNumberOfTetrahedra;
+
+// Bounding box of cluster of tetrahedra, captured by transform feedback
+out vec3 vBoundsMin;
+out vec3 vBoundsMax;
+
+void main()
+{
+    // One vertex per cluster of consecutive tetrahedra
+    int begin = gl_VertexID * uClusterSize * 4;
+    int end = min(begin + uClusterSize * 4, uNumberOfTetrahedra * 4);
+
+    vBoundsMin = vec3(3.402823e38f);
+    vBoundsMax = vec3(-3.402823e38f);
+    for (int i = begin; i < end; i++) {
+        int index = int(texelFetch(uElements, i).r) * 3;
+        vec3 position = vec3(texelFetch(uPositions, index).r, texelFetch(uPositions, index + 1).r, texelFetch(uPositions, index + 2).r);
+        vBoundsMin = min(vBoundsMin, position);
+        vBoundsMax = max(vBoundsMax, position);
+    }
+
+    gl_Position = vec4(0, 0, 0, 1);
+}
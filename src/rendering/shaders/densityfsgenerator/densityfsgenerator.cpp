@@ -89,61 +89,10 @@ const QString DensityFSGenerator::generateFragmentShaderSourceCode(int coeffsCou
     lastSourceCode.clear();
 
     // Header
-    lastSourceCode.append(QString(
-                              "#version 330\n"
-                              "\n"
-                              //// Texture with Bernstein coefficients
-                              "uniform samplerBuffer uBernCoeffs;\n"
-                              "uniform sampler2D uBernCoeffsDiff;\n"
-                              "\n"
-                              "uniform int uPositionDiffLengthMinus1;\n"
-                              "uniform int uPositionDiffLengthLog2;\n"
-                              "uniform float uParam;\n"
-                              "\n"
-                              //// Output color
-                              "out vec4 outColor;\n"
-                              "\n"
-                              //// Barycentric coords for fragment
-                              "in vec4 b;\n"
-                              //// Barycentric eye dir
-                              "in vec4 bEyedir;\n"
-                              //// Eye dir in normalized eye coordinates
-                              "in vec4 eEyedir;\n"
-                              "\n"
-                            ));
+    lastSourceCode.append(headerSourceCode());
 
-    lastSourceCode.append(QString(
-                              "void main()\n"
-                              "{\n"
-                              "    outColor.a = gl_FragCoord.z;\n"
-                              "\n"
-                              //// Inverted factor s
-                              "    vec4 sIV;\n"
-                              //// Final factor s and traversal length
-                              "    float sIF, wLength;\n"
-                              //// Barycentric exit coords from tetrahedron
-                              "    vec4 bOut;\n"
-                              //// Barycentric input coords to tetrahedron
-                              "    vec4 bIn = b;\n"
-                              //// Clamp wrong values (artefacts)
-                              "    if (bIn[0] < 0 || bIn[1] < 0 || bIn[2] < 0 || bIn[3] < 0) discard;\n"
-                              "    if (bIn[0] > 1 || bIn[1] > 1 || bIn[2] > 1 || bIn[3] > 1) discard;\n"
-                              "\n"
-                              //// Compute factor s
-                              "    sIV = -bEyedir / bIn;\n"
-                              "\n"
-                              //// Select max s
-                              "    sIF = max(max(sIV[0], sIV[1]), max(sIV[2], sIV[3]));\n"
-                              //// Compute length of traversal
-                              "    wLength = length(eEyedir) / sIF;\n"
-                              //// Compute bOut and clamp
-                              "    bOut = bIn + bEyedir / sIF;\n"
-                              "    //if (bOut[0] < -1 || bOut[1] < -1 || bOut[2] < -1 || bOut[3] < -1) discard;\n"
-                              "    //if (bOut[0] > 1 || bOut[1] > 1 || bOut[2] > 1 || bOut[3] > 1) discard;\n"
-                              "\n"
-                              "    outColor.g = wLength;\n"
-                              "\n"
-                            ));
+    // Computation of exit coords and traversal length
+    lastSourceCode.append(traversalSourceCode());
 
     // For coefficients generate integration code
     if (coeffsCount > 0) {
@@ -169,7 +118,7 @@ const QString DensityFSGenerator::generateFragmentShaderSourceCode(int coeffsCou
                                   "\n"
                                   "    float cijkl, bq, bkq;\n"
                                   "    int index;\n"
-                                  "    int indexPart = gl_PrimitiveID * " +  QString::number(coeffsCount) + ";\n"
+                                  "    int indexPart = TETRAHEDRON_ID * " +  QString::number(coeffsCount) + ";\n"
                                   "\n"
                                 ));
 
@@ -205,25 +154,21 @@ const QString DensityFSGenerator::generateFragmentShaderSourceCode(int coeffsCou
                 float bPartq = ((float) factorial(dq)) / (factorial(qArray[0]) * factorial(qArray[1]) * factorial(qArray[2]) * factorial(qArray[3]));
                 float bPartkq = ((float) factorial(dkq)) / (factorial(kqArray[0]) * factorial(kqArray[1]) * factorial(kqArray[2]) * factorial(kqArray[3]));
 
-                QString bPartqString = (bPartq != 1) ? QString::number(bPartq, 'g').prepend(" * ") : QString("");
-                QString bPartkqString = (bPartkq != 1) ? QString::number(bPartkq, 'g').prepend(" * ") : QString("");
-
-                // Pows strings
-                QString powBxq = powStringVariable(qArray[0], "bIn", "x");
-                QString powByq = powStringVariable(qArray[1], "bIn", "y").prepend(" * ");
-                QString powBzq = powStringVariable(qArray[2], "bIn", "z").prepend(" * ");
-                QString powBwq = powStringVariable(qArray[3], "bIn", "w").prepend(" * ");
-                QString powBxkq = powStringVariable(kqArray[0], "bOut", "x");
-                QString powBykq = powStringVariable(kqArray[1], "bOut", "y").prepend(" * ");
-                QString powBzkq = powStringVariable(kqArray[2], "bOut", "z").prepend(" * ");
-                QString powBwkq = powStringVariable(kqArray[3], "bOut", "w").prepend(" * ");
-
-                QString bqbkq = QString(QString(powBxq + powByq + powBzq + powBwq + bPartqString).remove("1 * ").remove(" * 1") + " * " + QString(powBxkq + powBykq + powBzkq + powBwkq + bPartkqString)).remove("1 * ").remove(" * 1");
-
-                /*lastSourceCode.append(QString(
-                                          "    bq = " + QString(powBxq + powByq + powBzq + powBwq + bPartqString).remove(" * 1").remove("1 * ") + ";\n"
-                                          "    bkq = " + QString(powBxkq + powBykq + powBzkq + powBwkq + bPartkqString).remove(" * 1").remove("1 * ") + ";\n"
-                                        ));*/
+                // Factors of product, ones are skipped (multinomials like 12 must not be stripped as "1 * ")
+                QStringList factors;
+                const char *coords[4] = {"x", "y", "z", "w"};
+                for (int i = 0; i < 4; i++)
+                    if (qArray[i] != 0)
+                        factors.append(powStringVariable(qArray[i], "bIn", coords[i]));
+                if (bPartq != 1)
+                    factors.append(QString::number(bPartq, 'g'));
+                for (int i = 0; i < 4; i++)
+                    if (kqArray[i] != 0)
+                        factors.append(powStringVariable(kqArray[i], "bOut", coords[i]));
+                if (bPartkq != 1)
+                    factors.append(QString::number(bPartkq, 'g'));
+
+                QString bqbkq = factors.isEmpty() ? QString("1") : factors.join(" * ");
 
                 lastSourceCode.append(QString(
                                           "    sum2 += " + bqbkq + ";\n"
@@ -259,6 +204,84 @@ const QString DensityFSGenerator::generateFragmentShaderSourceCode(int coeffsCou
     return lastSourceCode;
 }
 
+/**
+ * @brief Generates common header of density fragment shaders
+ * @return Source code of header with uniforms and inputs
+ */
+QString DensityFSGenerator::headerSourceCode() const
+{
+    return QString(
+           "#version 330\n"
+           "\n"
+           //// Texture with Bernstein coefficients
+           "uniform samplerBuffer uBernCoeffs;\n"
+           "uniform sampler2D uBernCoeffsDiff;\n"
+           "\n"
+           "uniform int uPositionDiffLengthMinus1;\n"
+           "uniform int uPositionDiffLengthLog2;\n"
+           "uniform float uParam;\n"
+           "\n"
+           //// Output color
+           "out vec4 outColor;\n"
+           "\n"
+           //// Barycentric coords for fragment
+           "in vec4 b;\n"
+           //// Barycentric eye dir
+           "in vec4 bEyedir;\n"
+           //// Eye dir in normalized eye coordinates
+           "in vec4 eEyedir;\n"
+           "\n"
+           //// Index of tetrahedron from geometry shader or from vertex pulling
+           "#ifdef VERTEX_PULLING\n"
+           "flat in int vTetrahedron;\n"
+           "#define TETRAHEDRON_ID vTetrahedron\n"
+           "#else\n"
+           "#define TETRAHEDRON_ID gl_PrimitiveID\n"
+           "#endif\n"
+           "\n"
+           );
+}
+
+/**
+ * @brief Generates beginning of main function computing exit coords and traversal length
+ * @return Source code of unfinished main function
+ */
+QString DensityFSGenerator::traversalSourceCode() const
+{
+    return QString(
+           "void main()\n"
+           "{\n"
+           "    outColor.a = gl_FragCoord.z;\n"
+           "\n"
+           //// Inverted factor s
+           "    vec4 sIV;\n"
+           //// Final factor s and traversal length
+           "    float sIF, wLength;\n"
+           //// Barycentric exit coords from tetrahedron
+           "    vec4 bOut;\n"
+           //// Barycentric input coords to tetrahedron
+           "    vec4 bIn = b;\n"
+           //// Clamp wrong values (artefacts)
+           "    if (bIn[0] < 0 || bIn[1] < 0 || bIn[2] < 0 || bIn[3] < 0) discard;\n"
+           "    if (bIn[0] > 1 || bIn[1] > 1 || bIn[2] > 1 || bIn[3] > 1) discard;\n"
+           "\n"
+           //// Compute factor s
+           "    sIV = -bEyedir / bIn;\n"
+           "\n"
+           //// Select max s
+           "    sIF = max(max(sIV[0], sIV[1]), max(sIV[2], sIV[3]));\n"
+           //// Compute length of traversal
+           "    wLength = length(eEyedir) / sIF;\n"
+           //// Compute bOut and clamp
+           "    bOut = bIn + bEyedir / sIF;\n"
+           "    //if (bOut[0] < -1 || bOut[1] < -1 || bOut[2] < -1 || bOut[3] < -1) discard;\n"
+           "    //if (bOut[0] > 1 || bOut[1] > 1 || bOut[2] > 1 || bOut[3] > 1) discard;\n"
+           "\n"
+           "    outColor.g = wLength;\n"
+           "\n"
+           );
+}
+
 /**
  * @brief Computes number of coefficients from degree
  * @param[in]   degree      Degree of Berstein polynomial
@@ -394,6 +417,288 @@ void DensityFSGenerator::getLessOrEqualIjklArray(const int index, const int *inA
         qDebug() << outArray[newIndex * 4] << outArray[newIndex * 4 + 1] << outArray[newIndex * 4 + 2] << outArray[newIndex * 4 + 3];
 }
 
+/**
+ * @brief Generates fragment shader source code for density rendering with vertex pulling
+ * @param[in]   coeffsCount Number of coefficients
+ * @param[in]   loop        Generate compact loop version?
+ * @return Source code of fragment shader
+ *
+ * Index of tetrahedron is read from vertex shader output instead of gl_PrimitiveID.
+ */
+const QString DensityFSGenerator::generateVertexPullingFragmentShaderSourceCode(int coeffsCount, bool loop)
+{
+    QString sourceCode = loop ? generateLoopFragmentShaderSourceCode(coeffsCount) : generateFragmentShaderSourceCode(coeffsCount);
+    return sourceCode.replace("#version 330\n", "#version 330\n#define VERTEX_PULLING\n");
+}
+
+/**
+ * @brief Generates compact fragment shader source code looping over table of weights
+ * @param[in]   coeffsCount Number of coefficients
+ * @return Source code of fragment shader
+ *
+ * The segment integral is evaluated by the same terms as the unrolled version, but the
+ * exponents and multinomials of terms are read from BernsteinWeights uniform block
+ * (see generateLoopWeightsData). Powers are precomputed to arrays where index 0 is 1.0,
+ * so the products are multiplied in the same order as in the unrolled code. Size of the
+ * source code does not grow with the degree and driver compiles it quickly.
+ */
+const QString DensityFSGenerator::generateLoopFragmentShaderSourceCode(int coeffsCount)
+{
+    if (coeffsCount <= 0)
+        return generateFragmentShaderSourceCode(coeffsCount);
+
+    int degree = degreeFromCoeffsCount(coeffsCount);
+    if (degree < 0 || degree > MAX_LOOP_DEGREE) {
+        qWarning() << "Loop fragment shader is not available for degree" << degree;
+        return generateFragmentShaderSourceCode(coeffsCount);
+    }
+
+    QVector<unsigned int> termsEnd, terms;
+    generateLoopTerms(coeffsCount, termsEnd, terms);
+    // 1 / (degree + 1)
+    float d1Inv = 1.0f / (degree + 1.0f);
+
+    QString sourceCode;
+
+    // Header
+    sourceCode.append(headerSourceCode());
+
+    // Uniform block with packed terms
+    sourceCode.append(QString(
+                          "#define DEGREE " + QString::number(degree) + "\n"
+                          "#define COEFFS_COUNT " + QString::number(coeffsCount) + "\n"
+                          "\n"
+                          "layout(std140) uniform BernsteinWeights\n"
+                          "{\n"
+                          //// End indices of terms of coefficients, 4 per item
+                          "    uvec4 uTermsEnd[" + QString::number(termsEnd.size() / 4) + "];\n"
+                          //// Terms, 2 per item: exponents of q and k - q by 4 bits, multinomials of q and k - q by 16 bits
+                          "    uvec4 uTerms[" + QString::number(terms.size() / 4) + "];\n"
+                          "};\n"
+                          "\n"
+                        ));
+
+    // Computation of exit coords and traversal length
+    sourceCode.append(traversalSourceCode());
+
+    // Powers of coords, pIn[i * (DEGREE + 1) + e] = bIn[i]^e
+    sourceCode.append(QString(
+                          "    float pIn[4 * (DEGREE + 1)], pOut[4 * (DEGREE + 1)];\n"
+                          "    for (int i = 0; i < 4; i++) {\n"
+                          "        pIn[i * (DEGREE + 1)] = 1.0f;\n"
+                          "        pOut[i * (DEGREE + 1)] = 1.0f;\n"
+                          "        for (int e = 1; e <= DEGREE; e++) {\n"
+                          "            pIn[i * (DEGREE + 1) + e] = pIn[i * (DEGREE + 1) + e - 1] * bIn[i];\n"
+                          "            pOut[i * (DEGREE + 1) + e] = pOut[i * (DEGREE + 1) + e - 1] * bOut[i];\n"
+                          "        }\n"
+                          "    }\n"
+                          "\n"
+                        ));
+
+    // Integration loop
+    sourceCode.append(QString(
+                          "    float sum = 0.0f, sum2 = 0.0f;\n"
+                          "\n"
+                          "    float cijkl;\n"
+                          "    int index;\n"
+                          "    int indexPart = TETRAHEDRON_ID * COEFFS_COUNT;\n"
+                          "    uint t = 0u, tEnd, exponents, multinomials;\n"
+                          "    uvec4 item;\n"
+                          "\n"
+                          "    for (int c = 0; c < COEFFS_COUNT; c++) {\n"
+                          "        index = indexPart + c;\n"
+                          "        cijkl = texelFetch(uBernCoeffs, index).r;\n"
+                          "        cijkl += texelFetch(uBernCoeffsDiff, ivec2(index & uPositionDiffLengthMinus1, index >> uPositionDiffLengthLog2), 0).r;\n"
+                          "\n"
+                          "        sum2 = 0.0f;\n"
+                          "        tEnd = uTermsEnd[c >> 2][c & 3];\n"
+                          "        for (; t < tEnd; t++) {\n"
+                          "            item = uTerms[int(t >> 1u)];\n"
+                          "            exponents = ((t & 1u) == 0u) ? item.x : item.z;\n"
+                          "            multinomials = ((t & 1u) == 0u) ? item.y : item.w;\n"
+                          "            sum2 += pIn[int(exponents & 15u)]\n"
+                          "                  * pIn[(DEGREE + 1) + int((exponents >> 4u) & 15u)]\n"
+                          "                  * pIn[2 * (DEGREE + 1) + int((exponents >> 8u) & 15u)]\n"
+                          "                  * pIn[3 * (DEGREE + 1) + int((exponents >> 12u) & 15u)]\n"
+                          "                  * float(multinomials & 65535u)\n"
+                          "                  * pOut[int((exponents >> 16u) & 15u)]\n"
+                          "                  * pOut[(DEGREE + 1) + int((exponents >> 20u) & 15u)]\n"
+                          "                  * pOut[2 * (DEGREE + 1) + int((exponents >> 24u) & 15u)]\n"
+                          "                  * pOut[3 * (DEGREE + 1) + int(exponents >> 28u)]\n"
+                          "                  * float(multinomials >> 16u);\n"
+                          "        }\n"
+                          "        sum += cijkl * sum2;\n"
+                          "    }\n"
+                          "\n"
+                          "    outColor.r = sum * wLength * " + QString::number(d1Inv, 'g') + ";\n"
+                          "\n"
+                          "}\n"
+                        ));
+
+    return sourceCode;
+}
+
+/**
+ * @brief Generates std140 data of BernsteinWeights uniform block for loop fragment shader
+ * @param[in]   coeffsCount Number of coefficients
+ * @return Data for uniform buffer (empty for unsupported degree)
+ */
+QVector<unsigned int> DensityFSGenerator::generateLoopWeightsData(int coeffsCount)
+{
+    QVector<unsigned int> termsEnd, terms;
+    if (coeffsCount <= 0)
+        return termsEnd;
+
+    int degree = degreeFromCoeffsCount(coeffsCount);
+    if (degree < 0 || degree > MAX_LOOP_DEGREE)
+        return termsEnd;
+
+    generateLoopTerms(coeffsCount, termsEnd, terms);
+    return termsEnd + terms;
+}
+
+/**
+ * @brief Generates fragment shader source code evaluating density at barycentric coords (volume baking)
+ * @param[in]   coeffsCount Number of coefficients
+ * @return Source code of fragment shader
+ *
+ * Output is the density of point sum(cijkl * degree! / (i! j! k! l!) * b^ijkl) instead of
+ * the line integral, its integral along the ray is the same as the output of the density
+ * fragment shader.
+ */
+const QString DensityFSGenerator::generateVolumeFragmentShaderSourceCode(int coeffsCount)
+{
+    QString sourceCode = QString(
+                             "#version 330\n"
+                             "\n"
+                             "uniform samplerBuffer uBernCoeffs;\n"
+                             "uniform sampler2D uBernCoeffsDiff;\n"
+                             "\n"
+                             "uniform int uPositionDiffLengthMinus1;\n"
+                             "uniform int uPositionDiffLengthLog2;\n"
+                             "\n"
+                             "out vec4 outColor;\n"
+                             "\n"
+                             "in vec4 b;\n"
+                             "\n"
+                             "void main()\n"
+                             "{\n"
+                             "    outColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);\n"
+                         );
+
+    if (coeffsCount > 0) {
+        int degree = degreeFromCoeffsCount(coeffsCount);
+        int *array = new int[coeffsCount * 4]();
+        generateIjklArray(degree, array);
+
+        // Generate some pow numbers
+        sourceCode.append("\n");
+        sourceCode.append(powVariables(degree, "b", "x"));
+        sourceCode.append(powVariables(degree, "b", "y"));
+        sourceCode.append(powVariables(degree, "b", "z"));
+        sourceCode.append(powVariables(degree, "b", "w"));
+        sourceCode.append(QString(
+                              "\n"
+                              "    float sum = 0.0f;\n"
+                              "\n"
+                              "    float cijkl;\n"
+                              "    int index;\n"
+                              "    int indexPart = gl_PrimitiveID * " + QString::number(coeffsCount) + ";\n"
+                              "\n"
+                            ));
+
+        const char *coords[4] = {"x", "y", "z", "w"};
+        for (int c = 0; c < coeffsCount; c++) {
+            sourceCode.append(QString(
+                                  "    index = indexPart + " + QString::number(c) + ";\n"
+                                  "    cijkl = texelFetch(uBernCoeffs, index).r;\n"
+                                  "    cijkl += texelFetch(uBernCoeffsDiff, ivec2(index & uPositionDiffLengthMinus1, index >> uPositionDiffLengthLog2), 0).r;\n"
+                                ));
+
+            // Bernstein basis polynomial, ones are skipped
+            float multinomial = ((float) factorial(degree)) / (factorial(array[c * 4]) * factorial(array[c * 4 + 1]) * factorial(array[c * 4 + 2]) * factorial(array[c * 4 + 3]));
+            QStringList factors;
+            factors.append("cijkl");
+            for (int i = 0; i < 4; i++)
+                if (array[c * 4 + i] != 0)
+                    factors.append(powStringVariable(array[c * 4 + i], "b", coords[i]));
+            if (multinomial != 1)
+                factors.append(QString::number(multinomial, 'g'));
+
+            sourceCode.append(QString(
+                                  "    sum += " + factors.join(" * ") + ";\n"
+                                  "\n"
+                                ));
+        }
+
+        delete[] array;
+
+        sourceCode.append(QString(
+                              "    outColor.r = sum;\n"
+                              "\n"
+                            ));
+    }
+
+    sourceCode.append(QString(
+                          "}\n"
+                        ));
+
+    return sourceCode;
+}
+
+/**
+ * @brief Generates packed terms of loop fragment shader
+ * @param[in]   coeffsCount Number of coefficients
+ * @param[out]  termsEnd    End indices of terms for every coefficient (padded to 4 items)
+ * @param[out]  terms       Pairs of packed exponents and multinomials (padded to 4 items)
+ *
+ * Terms are in the same order as sums of the unrolled fragment shader.
+ */
+void DensityFSGenerator::generateLoopTerms(const int coeffsCount, QVector<unsigned int> &termsEnd, QVector<unsigned int> &terms)
+{
+    int degree = degreeFromCoeffsCount(coeffsCount);
+    int *array = new int[coeffsCount * 4]();
+    int *outArray = new int[coeffsCount * 4]();
+    generateIjklArray(degree, array);
+
+    termsEnd.clear();
+    terms.clear();
+
+    for (int c = 0; c < coeffsCount; c++) {
+        int k = 0;
+        getLessOrEqualIjklArray(c, array, k, outArray);
+        k--;
+
+        for (int q = 0; q <= k; q++) {
+            unsigned int exponents = 0, multinomials = 0;
+            int dq = 0, dkq = 0, fq = 1, fkq = 1;
+            for (int i = 0; i < 4; i++) {
+                int qi = outArray[q * 4 + i];
+                int kqi = outArray[k * 4 + i] - qi;
+                exponents |= (unsigned int) qi << (4 * i);
+                exponents |= (unsigned int) kqi << (16 + 4 * i);
+                dq += qi;
+                dkq += kqi;
+                fq *= factorial(qi);
+                fkq *= factorial(kqi);
+            }
+            multinomials = (unsigned int) (factorial(dq) / fq) | ((unsigned int) (factorial(dkq) / fkq) << 16);
+            terms.append(exponents);
+            terms.append(multinomials);
+        }
+
+        termsEnd.append(terms.size() / 2);
+    }
+
+    delete[] outArray;
+    delete[] array;
+
+    while (termsEnd.size() % 4)
+        termsEnd.append(0);
+    while (terms.size() % 4)
+        terms.append(0);
+}
+
 /**
  * @brief Generates QString for pow operation (x^y)
  * @param[in] x Base
@@ -0,0 +1,66 @@
+#version 330
+
+uniform mat4 uMatrix;
+uniform mat4 uMatrixInv;
+
+uniform bool uXMirror;
+
+// Final positions (x, y, z per vertex), indices and inverse matrices of tetrahedra
+uniform samplerBuffer uPositions;
+uniform usamplerBuffer uElements;
+uniform samplerBuffer uTetrahedraInverse;
+
+// Index of first tetrahedron of drawn range (culled drawing)
+uniform int uInstanceOffset;
+
+out vec4 b;
+out vec4 bEyedir;
+out vec4 eEyedir;
+flat out int vTetrahedron;
+
+// Vertices of 4 faces, same order as density.geom
+const int corners[12] = int[12](0, 2, 1, 1, 2, 3, 3, 2, 0, 0, 1, 3);
+
+void main()
+{
+    // Instance is tetrahedron, vertex is corner of its face
+    int i = corners[gl_VertexID];
+    int tetrahedron = gl_InstanceID + uInstanceOffset;
+    vTetrahedron = tetrahedron;
+
+    int index = int(texelFetch(uElements, tetrahedron * 4 + i).r) * 3;
+    vec4 position = vec4(texelFetch(uPositions, index).r, texelFetch(uPositions, index + 1).r, texelFetch(uPositions, index + 2).r, 1.0f);
+
+    mat4 inverseW = mat4(
+            texelFetch(uTetrahedraInverse, tetrahedron * 4),
+            texelFetch(uTetrahedraInverse, tetrahedron * 4 + 1),
+            texelFetch(uTetrahedraInverse, tetrahedron * 4 + 2),
+            texelFetch(uTetrahedraInverse, tetrahedron * 4 + 3)
+        );
+
+    if (uXMirror)
+        position.x = -position.x;
+
+    vec4 e = uMatrix * position;
+    vec4 eEye = e / e.w;
+    eEye.z = 0;
+
+    // Inverse of mirrored vertices is inverse(w) * mirror
+    vec4 w = uMatrixInv * eEye;
+    if (uXMirror)
+        w.x = -w.x;
+
+    vec4 bSelf = vec4(0);
+    bSelf[i] = 1;
+
+    b = bSelf;
+    if (uXMirror) {
+        bEyedir = -(bSelf - inverseW * w);
+        eEyedir = -eEye - e;
+    } else {
+        bEyedir = bSelf - inverseW * w;
+        eEyedir = eEye - e;
+    }
+
+    gl_Position = e;
+}
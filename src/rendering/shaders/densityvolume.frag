@@ -0,0 +1,104 @@
+#version 330
+
+// Must be same as MainRenderer::DENSITY_VOLUME_BLOCK_SIZE
+const int BLOCK_SIZE = 8;
+
+// Step of ray marching in voxels and max number of steps
+const float STEP = 0.5f;
+const int MAX_STEPS = 4096;
+
+uniform sampler3D uVolumeTexture;
+uniform sampler3D uOccupancyTexture;
+
+uniform mat4 uMatrix;
+uniform mat4 uMatrixInv;
+
+// Crop viewport in window coords (x, y, width, height)
+uniform vec4 uViewport;
+
+// Model position of first voxel center and voxel size
+uniform vec3 uOrigin;
+uniform float uVoxelSize;
+
+uniform bool uXMirror;
+
+out vec4 outColor;
+
+void main()
+{
+    outColor = vec4(0.0f);
+
+    // Ray from near to far plane
+    vec2 ndc = (gl_FragCoord.xy - uViewport.xy) / uViewport.zw * 2.0f - 1.0f;
+    vec4 nearPoint = uMatrixInv * vec4(ndc, -1.0f, 1.0f);
+    vec4 farPoint = uMatrixInv * vec4(ndc, 1.0f, 1.0f);
+    vec3 rayStart = nearPoint.xyz / nearPoint.w;
+    vec3 rayEnd = farPoint.xyz / farPoint.w;
+
+    // Clip coords of ray are linear in t
+    vec4 clipStart = uMatrix * vec4(rayStart, 1.0f);
+    vec4 clipDirection = uMatrix * vec4(rayEnd - rayStart, 0.0f);
+
+    // Volume is baked without mirroring
+    vec3 start = rayStart;
+    vec3 end = rayEnd;
+    if (uXMirror) {
+        start.x = -start.x;
+        end.x = -end.x;
+    }
+
+    // Ray in voxel coords, voxel centers are at i + 0.5
+    vec3 size = vec3(textureSize(uVolumeTexture, 0));
+    vec3 origin = (start - uOrigin) / uVoxelSize + 0.5f;
+    vec3 direction = (end - start) / uVoxelSize;
+    vec3 directionInv = 1.0f / direction;
+
+    // Intersection with volume box
+    vec3 t0 = -origin * directionInv;
+    vec3 t1 = (size - origin) * directionInv;
+    float tEnter = max(max(max(min(t0.x, t1.x), min(t0.y, t1.y)), min(t0.z, t1.z)), 0.0f);
+    float tExit = min(min(min(max(t0.x, t1.x), max(t0.y, t1.y)), max(t0.z, t1.z)), 1.0f);
+    if (!(tEnter < tExit))
+        return;
+
+    // Midpoint rule, empty blocks of occupancy grid are skipped
+    ivec3 blocks = textureSize(uOccupancyTexture, 0);
+    float dt = STEP / length(direction);
+    float t = tEnter, tFirst = -1.0f;
+    float sum = 0.0f, occupied = 0.0f;
+    for (int i = 0; i < MAX_STEPS && t < tExit; i++) {
+        float segment = min(dt, tExit - t);
+        vec3 position = origin + (t + 0.5f * segment) * direction;
+        ivec3 block = clamp(ivec3(position) / BLOCK_SIZE, ivec3(0), blocks - 1);
+
+        if (texelFetch(uOccupancyTexture, block, 0).r == 0.0f) {
+            // Jump to exit of block
+            vec3 b0 = (vec3(block * BLOCK_SIZE) - origin) * directionInv;
+            vec3 b1 = (vec3((block + 1) * BLOCK_SIZE) - origin) * directionInv;
+            vec3 bExit = max(b0, b1);
+            t = max(min(min(bExit.x, bExit.y), bExit.z), t + 0.5f * segment);
+            continue;
+        }
+
+        if (tFirst < 0.0f)
+            tFirst = t;
+
+        // Traversal length of density fragment shader per unit of t (eEyedir of density.geom
+        // and its step to the exit from tetrahedron), so the result matches rasterized density
+        vec4 clip = clipStart + (t + 0.5f * segment) * clipDirection;
+        vec4 eEye = vec4(clip.xy / clip.w, 0.0f, 1.0f);
+        float traversal = length(uXMirror ? clip + eEye : clip - eEye) * abs(clipDirection.z * clip.w - clipDirection.w * clip.z) / abs(clip.z);
+
+        sum += texture(uVolumeTexture, position / size).r * segment * traversal;
+        occupied += segment * traversal;
+        t += segment;
+    }
+
+    if (tFirst < 0.0f)
+        return;
+
+    // Depth of first occupied sample instead of max depth of front faces
+    vec4 first = clipStart + tFirst * clipDirection;
+
+    outColor = vec4(sum, occupied, 0.0f, first.z / first.w * 0.5f + 0.5f);
+}
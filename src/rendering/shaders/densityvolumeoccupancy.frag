@@ -0,0 +1,28 @@
+#version 330
+
+// Must be same as MainRenderer::DENSITY_VOLUME_BLOCK_SIZE
+const int BLOCK_SIZE = 8;
+
+uniform sampler3D uVolumeTexture;
+uniform int uLayer;
+
+out vec4 outColor;
+
+void main()
+{
+    // Every fragment is max of absolute density of one block, extended by one voxel
+    // to cover linear filtering of neighbouring blocks
+    ivec3 block = ivec3(ivec2(gl_FragCoord.xy), uLayer);
+    ivec3 begin = max(block * BLOCK_SIZE - 1, 0);
+    ivec3 end = min(block * BLOCK_SIZE + BLOCK_SIZE + 1, textureSize(uVolumeTexture, 0));
+
+    float value = 0;
+    for (int z = begin.z; z < end.z; z++) {
+        for (int y = begin.y; y < end.y; y++) {
+            for (int x = begin.x; x < end.x; x++)
+                value = max(value, abs(texelFetch(uVolumeTexture, ivec3(x, y, z), 0).r));
+        }
+    }
+
+    outColor = vec4(value, 0, 0, 1);
+}
@@ -0,0 +1,21 @@
+#version 330
+
+uniform sampler2D uPositionDiff;
+
+in vec3 aPosition;
+out vec3 vPosition;
+
+uniform int uPositionDiffLengthMinus1;
+uniform int uPositionDiffLengthLog2;
+
+void main()
+{
+    vec3 positionDiff;
+
+    positionDiff.x = texelFetch(uPositionDiff, ivec2((gl_VertexID * 3) & uPositionDiffLengthMinus1, (gl_VertexID * 3) >> uPositionDiffLengthLog2), 0).r;
+    positionDiff.y = texelFetch(uPositionDiff, ivec2((gl_VertexID * 3 + 1) & uPositionDiffLengthMinus1, (gl_VertexID * 3 + 1) >> uPositionDiffLengthLog2), 0).r;
+    positionDiff.z = texelFetch(uPositionDiff, ivec2((gl_VertexID * 3 + 2) & uPositionDiffLengthMinus1, (gl_VertexID * 3 + 2) >> uPositionDiffLengthLog2), 0).r;
+
+    // Captured by transform feedback
+    vPosition = aPosition + positionDiff;
+}
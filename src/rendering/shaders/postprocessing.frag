@@ -12,6 +12,8 @@ uniform bool uPostprocessingEnabled;
 uniform bool uSilhouettesEnabled;
 uniform bool uPolygonalEnabled;
 uniform bool uPyramidEnabled;
+uniform bool uDensityHasAlpha;
+uniform bool uSilhouettesHasAlpha;
 uniform float uIntensity;
 
 noperspective in vec2 vTextureCoord;
@@ -24,8 +26,12 @@ void main()
     vec4 polygonal = vec4(0, 0, 0, 0);
     vec4 pyramid = vec4(0, 0, 0, 0);
 
-    if (uDensityEnabled)
+    if (uDensityEnabled) {
         density = texture(uDensityTexture, vTextureCoord);
+        // Coverage from density for formats without alpha
+        if (!uDensityHasAlpha)
+            density.a = density.r;
+    }
 
     if (uPolygonalEnabled)
         polygonal = texture(uPolygonalTexture, vTextureCoord);
@@ -42,7 +48,7 @@ void main()
         for (int x = -halfStepDown; x < halfStepTop; x++) {
             for (int y = -halfStepDown; y < halfStepTop; y++) {
                 vec4 value = texture(uSilhouettesTexture, vec2(vTextureCoord.x + x * uTextureStep[0], vTextureCoord.y + y * uTextureStep[1]));
-                silhouetteMaxValue = max(silhouetteMaxValue, value.a);
+                silhouetteMaxValue = max(silhouetteMaxValue, uSilhouettesHasAlpha ? value.a : value.r);
             }
         }
     }
@@ -0,0 +1,25 @@
+#version 330
+
+// SSD_TILE_SIZE is defined by MainRenderer
+const int TILE_SIZE = SSD_TILE_SIZE;
+
+uniform sampler2D uInputTexture;
+uniform ivec2 uInputSize;
+
+layout(location = 0) out float outSum;
+
+void main()
+{
+    // Every fragment sums one tile of partial sums
+    ivec2 begin = ivec2(gl_FragCoord.xy) * TILE_SIZE;
+    ivec2 end = min(begin + TILE_SIZE, uInputSize);
+
+    float sum = 0;
+    for (int y = begin.y; y < end.y; y++) {
+        for (int x = begin.x; x < end.x; x++) {
+            sum += texelFetch(uInputTexture, ivec2(x, y), 0).r;
+        }
+    }
+
+    outSum = sum;
+}
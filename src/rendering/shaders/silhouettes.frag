@@ -2,6 +2,9 @@
 
 //uniform float uLineWidth;
 
+// Only coverage is stored (layer format without alpha channel)
+uniform bool uCoverageOnly;
+
 //flat in vec4 vCenter;
 //flat in int vConnections;
 in vec3 vvPosition;
@@ -28,5 +31,8 @@ void main()
         //outColor.r = 0.8f;
     }*/
 
-    outColor = vec4(vvPosition, gl_FragCoord.z);
+    if (uCoverageOnly)
+        outColor = vec4(1.0f);
+    else
+        outColor = vec4(vvPosition, gl_FragCoord.z);
 }
@@ -0,0 +1,28 @@
+#version 330
+
+// SSD_TILE_SIZE is defined by MainRenderer
+const int TILE_SIZE = SSD_TILE_SIZE;
+
+uniform sampler2D uDensityTexture;
+uniform sampler2D uReferenceTexture;
+uniform ivec2 uOffset;
+uniform ivec2 uSize;
+
+layout(location = 0) out float outSum;
+
+void main()
+{
+    // Every fragment sums squared differences of one tile of crop window
+    ivec2 begin = ivec2(gl_FragCoord.xy) * TILE_SIZE;
+    ivec2 end = min(begin + TILE_SIZE, uSize);
+
+    float sum = 0;
+    for (int y = begin.y; y < end.y; y++) {
+        for (int x = begin.x; x < end.x; x++) {
+            float diff = texelFetch(uDensityTexture, uOffset + ivec2(x, y), 0).r - texelFetch(uReferenceTexture, ivec2(x, y), 0).r;
+            sum += diff * diff;
+        }
+    }
+
+    outSum = sum;
+}
@@ -0,0 +1,30 @@
+#version 330
+
+// Final positions (x, y, z per vertex) and indices of tetrahedra
+uniform samplerBuffer uPositions;
+uniform usamplerBuffer uElements;
+
+// Columns of inverse matrix of tetrahedron vertices, captured by transform feedback
+out vec4 vInverse0;
+out vec4 vInverse1;
+out vec4 vInverse2;
+out vec4 vInverse3;
+
+vec4 fetchPosition(int i)
+{
+    int index = int(texelFetch(uElements, gl_VertexID * 4 + i).r) * 3;
+    return vec4(texelFetch(uPositions, index).r, texelFetch(uPositions, index + 1).r, texelFetch(uPositions, index + 2).r, 1.0f);
+}
+
+void main()
+{
+    // One vertex per tetrahedron
+    mat4 inverseW = inverse(mat4(fetchPosition(0), fetchPosition(1), fetchPosition(2), fetchPosition(3)));
+
+    vInverse0 = inverseW[0];
+    vInverse1 = inverseW[1];
+    vInverse2 = inverseW[2];
+    vInverse3 = inverseW[3];
+
+    gl_Position = vec4(0, 0, 0, 1);
+}
@@ -51,6 +51,8 @@ SOURCES += \
     src/input/pyramid.cpp \
     src/input/mesh.cpp \
     src/input/statisticaldata.cpp \
+    src/input/shapereconstructioncpu.cpp \
+    src/input/vertexcacheoptimizer.cpp \
     src/input/csvcoeffsfile.cpp \
     src/input/csvpyramidfile.cpp \
     src/input/csvgeneralfile.cpp \
@@ -62,11 +64,16 @@ SOURCES += \
     src/input/xmlcalibsfile.cpp \
     \# OpenGL
     src/opengl/openglwrapper.cpp \
+    src/opengl/passtimer.cpp \
+    src/opengl/rendertargetpool.cpp \
+    src/opengl/programbinarycache.cpp \
     \# Rendering
     src/rendering/mainrenderer.cpp \
     src/rendering/offscreenrenderer.cpp \
     src/rendering/sharedwindow.cpp \
     src/rendering/window.cpp \
+    src/rendering/densityrenderercpu.cpp \
+    src/rendering/densityraycastercpu.cpp \
     src/rendering/shaders/densityfsgenerator/densityfsgenerator.cpp \
     \# OpenCL
     \#src/opencl/openclwrapper.cpp \
@@ -89,6 +96,8 @@ HEADERS += \
     include/input/pyramid.h \
     include/input/mesh.h \
     include/input/statisticaldata.h \
+    include/input/shapereconstructioncpu.h \
+    include/input/vertexcacheoptimizer.h \
     include/input/csvcoeffsfile.h \
     include/input/csvpyramidfile.h \
     include/input/csvgeneralfile.h \
@@ -100,11 +109,16 @@ HEADERS += \
     include/input/xmlcalibsfile.h \
     \
     include/opengl/openglwrapper.h \
+    include/opengl/passtimer.h \
+    include/opengl/rendertargetpool.h \
+    include/opengl/programbinarycache.h \
     \
     include/rendering/mainrenderer.h \
     include/rendering/offscreenrenderer.h \
     include/rendering/sharedwindow.h \
     include/rendering/window.h \
+    include/rendering/densityrenderercpu.h \
+    include/rendering/densityraycastercpu.h \
     include/rendering/densityfsgenerator/densityfsgenerator.h \
     \
     \#include/opencl/openclwrapper.h \
@@ -126,6 +140,15 @@ HEADERS += \
 OTHER_FILES += \
     src/rendering/shaders/density.vert \
     src/rendering/shaders/density.geom \
+    src/rendering/shaders/densitybatch.vert \
+    src/rendering/shaders/densitybatch.geom \
+    src/rendering/shaders/densitybasis.frag \
+    src/rendering/shaders/densityvolume.geom \
+    src/rendering/shaders/densityvolumeoccupancy.frag \
+    src/rendering/shaders/densityvolume.frag \
+    src/rendering/shaders/densitypulling.vert \
+    src/rendering/shaders/tetrahedrainverse.vert \
+    src/rendering/shaders/densityclusterbounds.vert \
     \
     src/rendering/shaders/silhouettes.vert \
     src/rendering/shaders/silhouettes.geom \
@@ -133,6 +156,8 @@ OTHER_FILES += \
     \
     src/rendering/shaders/computing.vert \
     src/rendering/shaders/computing.frag \
+    src/rendering/shaders/computingdelta.frag \
+    src/rendering/shaders/positions.vert \
     \
     src/rendering/shaders/pyramid.vert \
     src/rendering/shaders/pyramid.frag \
@@ -146,6 +171,9 @@ OTHER_FILES += \
     src/rendering/shaders/postprocessing.frag \
     src/rendering/shaders/postprocessingsimple.frag \
     \
+    src/rendering/shaders/ssdtiles.frag \
+    src/rendering/shaders/reducetiles.frag \
+    \
     src/metric/shaders/histogram.vert \
     src/metric/shaders/histogram.frag \
     \